@@ -115,6 +115,7 @@
 #include <locale.h>             /* for LC_ALL */
 
 #include "gst.h"
+#include "gstmagazine.h"
 #include "gsttrace.h"
 
 #define GST_CAT_DEFAULT GST_CAT_GST_INIT
@@ -567,6 +568,7 @@ init_post (GOptionContext * context, GOptionGroup * group, gpointer data,
 
   _priv_gst_mini_object_initialize ();
   _priv_gst_quarks_initialize ();
+  _priv_gst_magazine_initialize ();
   _priv_gst_memory_initialize ();
   _priv_gst_format_initialize ();
   _priv_gst_query_initialize ();
@@ -963,7 +965,10 @@ gst_deinit (void)
   gst_object_unref (clock);
   gst_object_unref (clock);
 
+  _priv_gst_caps_cleanup ();
+
   _priv_gst_registry_cleanup ();
+  _priv_gst_magazine_deinit ();
 
 #ifndef GST_DISABLE_TRACE
   _priv_gst_alloc_trace_deinit ();
@@ -77,6 +77,7 @@
 #include <gst/gsturi.h>
 #include <gst/gstutils.h>
 #include <gst/gstvalue.h>
+#include <gst/gstworkertaskpool.h>
 
 #include <gst/gstparse.h>
 
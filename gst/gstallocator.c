@@ -33,6 +33,13 @@
  * gst_allocator_find(). gst_allocator_set_default() can be used to change the
  * default allocator.
  *
+ * The #GST_ALLOCATOR_SYSMEM_HUGE allocator allocates large blocks of system
+ * memory from huge pages on the NUMA node of the calling thread. Smaller
+ * blocks, or blocks on systems without huge pages, are allocated like normal
+ * system memory. The system memory allocator also uses it for blocks
+ * requested with the #GST_MEMORY_FLAG_HUGE_PAGES flag in the
+ * #GstAllocationParams.
+ *
  * New memory can be created with gst_memory_new_wrapped() that wraps the memory
  * allocated elsewhere.
  *
@@ -44,8 +51,20 @@
 #endif
 
 #include "gst_private.h"
+#include "gstmagazine.h"
 #include "gstmemory.h"
 
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+#ifdef __linux__
+#include <errno.h>
+#include <sys/syscall.h>
+#endif
+
 GST_DEBUG_CATEGORY_STATIC (gst_allocator_debug);
 #define GST_CAT_DEFAULT gst_allocator_debug
 
@@ -73,6 +92,7 @@ gsize gst_memory_alignment = 0;
 static GstAllocator *_default_allocator;
 
 static GstAllocator *_sysmem_allocator;
+static GstAllocator *_sysmem_huge_allocator;
 
 /* registered allocators */
 static GRWLock lock;
@@ -266,6 +286,44 @@ gst_allocator_set_default (GstAllocator * allocator)
     gst_object_unref (old);
 }
 
+/**
+ * gst_allocator_get_cache_stats:
+ *
+ * Get the statistics of the per-thread caches that are used for #GstBuffer
+ * structures and for the blocks of the system memory allocator.
+ *
+ * The returned structure contains the boolean field "enabled", %FALSE when
+ * the caches are disabled, for example when running in valgrind, and the
+ * #guint64 fields "thread-hits", "depot-hits" and "misses" with the amount
+ * of allocations that were served from the cache of the calling thread, from
+ * the caches shared by all threads and from the global allocator. The
+ * #guint64 field "depot-bytes" is the amount of memory currently kept in the
+ * shared caches.
+ *
+ * The counters of other threads than the calling one are added in batches,
+ * so they can lag behind a little.
+ *
+ * Returns: (transfer full): a new #GstStructure, free with
+ *     gst_structure_free() after use.
+ *
+ * Since: 1.4
+ */
+GstStructure *
+gst_allocator_get_cache_stats (void)
+{
+  guint64 hits, depot_hits, misses, cached;
+  gboolean enabled;
+
+  enabled = _priv_gst_magazine_get_stats (&hits, &depot_hits, &misses, &cached);
+
+  return gst_structure_new ("GstAllocatorCacheStats",
+      "enabled", G_TYPE_BOOLEAN, enabled,
+      "thread-hits", G_TYPE_UINT64, hits,
+      "depot-hits", G_TYPE_UINT64, depot_hits,
+      "misses", G_TYPE_UINT64, misses,
+      "depot-bytes", G_TYPE_UINT64, cached, NULL);
+}
+
 /**
  * gst_allocator_alloc:
  * @allocator: (transfer none) (allow-none): a #GstAllocator to use
@@ -389,7 +447,7 @@ _sysmem_new (GstMemoryFlags flags,
 
   slice_size = sizeof (GstMemorySystem);
 
-  mem = g_slice_alloc (slice_size);
+  mem = _priv_gst_magazine_alloc (slice_size);
   _sysmem_init (mem, flags, parent, slice_size,
       data, maxsize, align, offset, size, user_data, notify);
 
@@ -412,7 +470,7 @@ _sysmem_new_block (GstMemoryFlags flags,
   /* alloc header and data in one block */
   slice_size = sizeof (GstMemorySystem) + maxsize;
 
-  mem = g_slice_alloc (slice_size);
+  mem = _priv_gst_magazine_alloc (slice_size);
   if (mem == NULL)
     return NULL;
 
@@ -505,12 +563,237 @@ _sysmem_is_span (GstMemorySystem * mem1, GstMemorySystem * mem2, gsize * offset)
       mem2->data + mem2->mem.offset;
 }
 
+/* system memory from huge pages, the mapping is released when the memory is
+ * freed */
+typedef struct
+{
+  GstMemorySystem mem;
+
+  gpointer base;
+  gsize mapped;
+} GstMemorySystemHuge;
+
+typedef struct
+{
+  GstAllocatorSysmem parent;
+} GstAllocatorSysmemHuge;
+
+typedef struct
+{
+  GstAllocatorSysmemClass parent_class;
+} GstAllocatorSysmemHugeClass;
+
+GType gst_allocator_sysmem_huge_get_type (void);
+G_DEFINE_TYPE (GstAllocatorSysmemHuge, gst_allocator_sysmem_huge,
+    gst_allocator_sysmem_get_type ());
+
+#define DEFAULT_HUGE_PAGE_SIZE  (2 * 1024 * 1024)
+
+#ifdef HAVE_MMAP
+/* the size of a huge page, preferably the one used for transparent huge
+ * pages */
+static gsize
+get_huge_page_size (void)
+{
+  static gsize huge_page_size = 0;
+
+  if (g_once_init_enter (&huge_page_size)) {
+    gsize size = 0;
+    gchar *contents, *str;
+
+    if (g_file_get_contents ("/sys/kernel/mm/transparent_hugepage/"
+            "hpage_pmd_size", &contents, NULL, NULL)) {
+      size = g_ascii_strtoull (contents, NULL, 10);
+      g_free (contents);
+    }
+    if (size == 0 && g_file_get_contents ("/proc/meminfo", &contents, NULL,
+            NULL)) {
+      if ((str = strstr (contents, "Hugepagesize:")))
+        size = g_ascii_strtoull (str + 13, NULL, 10) * 1024;
+      g_free (contents);
+    }
+    /* must be a power of two */
+    if (size == 0 || (size & (size - 1)))
+      size = DEFAULT_HUGE_PAGE_SIZE;
+
+    GST_CAT_DEBUG (GST_CAT_MEMORY, "huge page size %" G_GSIZE_FORMAT, size);
+
+    g_once_init_leave (&huge_page_size, size);
+  }
+  return huge_page_size;
+}
+
+/* prefer the NUMA node of the calling thread for the pages of the mapping.
+ * Must be called before the pages are touched. */
+static void
+bind_to_local_node (gpointer addr, gsize len)
+{
+#if defined (__linux__) && defined (SYS_mbind) && defined (SYS_getcpu)
+  unsigned int cpu, node;
+  unsigned long mask;
+
+  if (syscall (SYS_getcpu, &cpu, &node, NULL) < 0)
+    return;
+  if (node >= sizeof (mask) * 8)
+    return;
+
+  mask = 1UL << node;
+  /* 1 is MPOL_PREFERRED, the pages go to another node when this one is full.
+   * The kernel wants the number of bits in the mask plus one. */
+  if (syscall (SYS_mbind, addr, len, 1, &mask, sizeof (mask) * 8 + 1, 0) < 0)
+    GST_CAT_DEBUG (GST_CAT_MEMORY, "mbind failed: %s", g_strerror (errno));
+#endif
+}
+
+/* map @len bytes that start at a huge page boundary */
+static gpointer
+map_huge_pages (gsize len, gsize hpage_size, gsize * mapped)
+{
+  guint8 *base, *start;
+  gsize head, tail;
+
+#ifdef MAP_HUGETLB
+  /* explicit huge pages, only when they were reserved by the admin */
+  if ((len & (hpage_size - 1)) == 0) {
+    base = mmap (NULL, len, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (base != MAP_FAILED) {
+      *mapped = len;
+      return base;
+    }
+  }
+#endif
+
+  /* transparent huge pages, map more so that we can align the start on a huge
+   * page boundary and unmap the rest */
+  base = mmap (NULL, len + hpage_size, PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (base == MAP_FAILED)
+    return NULL;
+
+  start = (guint8 *) (((guintptr) base + hpage_size - 1) & ~(hpage_size - 1));
+  head = start - base;
+  tail = hpage_size - head;
+  if (head)
+    munmap (base, head);
+  if (tail)
+    munmap (start + len, tail);
+
+#if defined (HAVE_MADVISE) && defined (MADV_HUGEPAGE)
+  madvise (start, len, MADV_HUGEPAGE);
+#endif
+
+  *mapped = len;
+  return start;
+}
+#endif
+
+static GstMemory *
+huge_alloc (GstAllocator * allocator, gsize size, GstAllocationParams * params)
+{
+  GstMemoryFlags flags = params->flags & ~GST_MEMORY_FLAG_HUGE_PAGES;
+  gsize maxsize = size + params->prefix + params->padding;
+#ifdef HAVE_MMAP
+  GstMemorySystemHuge *mem;
+  gsize hpage_size, page_size, align, len, mapped;
+  gpointer data;
+
+  hpage_size = get_huge_page_size ();
+  align = params->align | gst_memory_alignment;
+
+  /* not worth it for blocks that would waste more than an eighth of a huge
+   * page */
+  if (maxsize < hpage_size - hpage_size / 8 || align >= hpage_size)
+    goto fallback;
+
+  /* round up to whole huge pages when that wastes at most an eighth, else only
+   * the part that covers whole huge pages uses them */
+  len = (maxsize + hpage_size - 1) & ~(hpage_size - 1);
+  if (len - maxsize > len / 8) {
+#ifdef HAVE_GETPAGESIZE
+    page_size = getpagesize ();
+#else
+    page_size = 4096;
+#endif
+    len = (maxsize + page_size - 1) & ~(page_size - 1);
+  }
+
+  data = map_huge_pages (len, hpage_size, &mapped);
+  if (data == NULL)
+    goto fallback;
+
+  bind_to_local_node (data, mapped);
+
+  mem = _priv_gst_magazine_alloc (sizeof (GstMemorySystemHuge));
+
+  /* anonymous mappings are zero filled so the prefix and padding don't need
+   * to be cleared */
+  gst_memory_init (GST_MEMORY_CAST (mem), flags | GST_MEMORY_FLAG_HUGE_PAGES,
+      _sysmem_huge_allocator, NULL, mapped, align, params->prefix, size);
+  mem->mem.slice_size = sizeof (GstMemorySystemHuge);
+  mem->mem.data = data;
+  mem->mem.user_data = NULL;
+  mem->mem.notify = NULL;
+  mem->base = data;
+  mem->mapped = mapped;
+
+  GST_CAT_DEBUG (GST_CAT_MEMORY, "mapped %" G_GSIZE_FORMAT " bytes at %p "
+      "for %" G_GSIZE_FORMAT " bytes", mapped, data, maxsize);
+
+  return (GstMemory *) mem;
+
+fallback:
+#endif
+  return (GstMemory *) _sysmem_new_block (flags, maxsize, params->align,
+      params->prefix, size);
+}
+
+static void
+huge_free (GstAllocator * allocator, GstMemory * mem)
+{
+#ifdef HAVE_MMAP
+  GstMemorySystemHuge *hmem = (GstMemorySystemHuge *) mem;
+
+  if (hmem->mem.notify)
+    hmem->mem.notify (hmem->mem.user_data);
+
+  munmap (hmem->base, hmem->mapped);
+
+  _priv_gst_magazine_free (sizeof (GstMemorySystemHuge), mem);
+#else
+  g_assert_not_reached ();
+#endif
+}
+
+static void
+gst_allocator_sysmem_huge_class_init (GstAllocatorSysmemHugeClass * klass)
+{
+  GstAllocatorClass *allocator_class;
+
+  allocator_class = (GstAllocatorClass *) klass;
+
+  allocator_class->alloc = huge_alloc;
+  allocator_class->free = huge_free;
+}
+
+static void
+gst_allocator_sysmem_huge_init (GstAllocatorSysmemHuge * allocator)
+{
+  GST_CAT_DEBUG (GST_CAT_MEMORY, "init huge page allocator %p", allocator);
+
+  /* the memory is system memory, the mem_type and the vmethods are set up
+   * by the parent */
+}
+
 static GstMemory *
 default_alloc (GstAllocator * allocator, gsize size,
     GstAllocationParams * params)
 {
   gsize maxsize = size + params->prefix + params->padding;
 
+  if (params->flags & GST_MEMORY_FLAG_HUGE_PAGES)
+    return huge_alloc (_sysmem_huge_allocator, size, params);
+
   return (GstMemory *) _sysmem_new_block (params->flags,
       maxsize, params->align, params->prefix, size);
 }
@@ -531,7 +814,7 @@ default_free (GstAllocator * allocator, GstMemory * mem)
   memset (mem, 0xff, sizeof (GstMemorySystem));
 #endif
 
-  g_slice_free1 (slice_size, mem);
+  _priv_gst_magazine_free (slice_size, mem);
 }
 
 static void
@@ -591,6 +874,12 @@ _priv_gst_memory_initialize (void)
       gst_object_ref (_sysmem_allocator));
 
   _default_allocator = gst_object_ref (_sysmem_allocator);
+
+  _sysmem_huge_allocator =
+      g_object_new (gst_allocator_sysmem_huge_get_type (), NULL);
+
+  gst_allocator_register (GST_ALLOCATOR_SYSMEM_HUGE,
+      gst_object_ref (_sysmem_huge_allocator));
 }
 
 /**
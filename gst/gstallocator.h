@@ -24,6 +24,7 @@
 #define __GST_ALLOCATOR_H__
 
 #include <gst/gstmemory.h>
+#include <gst/gststructure.h>
 
 G_BEGIN_DECLS
 
@@ -58,6 +59,16 @@ GST_EXPORT gsize gst_memory_alignment;
  */
 #define GST_ALLOCATOR_SYSMEM   "SystemMemory"
 
+/**
+ * GST_ALLOCATOR_SYSMEM_HUGE:
+ *
+ * The allocator name for the system memory allocator that allocates large
+ * blocks from huge pages on the NUMA node of the allocating thread.
+ *
+ * Since: 1.4
+ */
+#define GST_ALLOCATOR_SYSMEM_HUGE   "SystemMemoryHuge"
+
 /**
  * GstAllocationParams:
  * @flags: flags to control allocation
@@ -147,6 +158,8 @@ void           gst_allocator_register        (const gchar *name, GstAllocator *a
 GstAllocator * gst_allocator_find            (const gchar *name);
 void           gst_allocator_set_default     (GstAllocator * allocator);
 
+GstStructure * gst_allocator_get_cache_stats (void);
+
 /* allocation parameters */
 void           gst_allocation_params_init    (GstAllocationParams *params);
 GstAllocationParams *
@@ -0,0 +1,963 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * gstbinaryformat.c: Compact binary encoding of structures, caps and
+ * tag lists
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* The encoding starts with a header of the magic "GSTB", a version byte and
+ * a byte with the kind of the data. Integers are written as LEB128 varints,
+ * signed ones zigzag encoded. Strings are written as their length + 1 with
+ * the nul terminator included, so that they can be used directly from the
+ * data, 0 is used for NULL strings. Floating point values are written as
+ * little endian IEEE 754.
+ *
+ * A structure is its name, the number of fields and for each field its name
+ * and its value. A value is a tag byte for its type followed by the type
+ * specific data. Types without a specific encoding are written as their type
+ * name and the string from gst_value_serialize().
+ *
+ * Caps are their flags, the number of structures and for each structure the
+ * structure and its features.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gst_private.h"
+#include "gstbinaryformat.h"
+#include "gstbuffer.h"
+#include "gstvalue.h"
+
+#define BINARY_VERSION 1
+
+/* nesting of lists and structures */
+#define MAX_DEPTH 64
+
+/* quarks are never freed, this many new names can be added by one read */
+#define MAX_NEW_QUARKS 64
+
+typedef enum
+{
+  TAG_NONE = 0,
+  TAG_BOOLEAN,
+  TAG_INT,
+  TAG_UINT,
+  TAG_INT64,
+  TAG_UINT64,
+  TAG_LONG,
+  TAG_ULONG,
+  TAG_CHAR,
+  TAG_UCHAR,
+  TAG_FLOAT,
+  TAG_DOUBLE,
+  TAG_STRING,
+  TAG_ENUM,
+  TAG_FLAGS,
+  TAG_FRACTION,
+  TAG_INT_RANGE,
+  TAG_INT64_RANGE,
+  TAG_DOUBLE_RANGE,
+  TAG_FRACTION_RANGE,
+  TAG_LIST,
+  TAG_ARRAY,
+  TAG_BITMASK,
+  TAG_STRUCTURE,
+  TAG_CAPS,
+  TAG_BUFFER,
+  TAG_DATE,
+  TAG_SERIALIZED = 255
+} ValueTag;
+
+typedef enum
+{
+  FEATURES_NONE = 0,
+  FEATURES_ANY,
+  FEATURES_LIST
+} FeaturesTag;
+
+/* writing */
+
+static inline void
+write_byte (GByteArray * array, guint8 val)
+{
+  g_byte_array_append (array, &val, 1);
+}
+
+void
+_priv_gst_binary_write_uint (GByteArray * array, guint64 val)
+{
+  guint8 buf[10];
+  guint len = 0;
+
+  do {
+    buf[len] = val & 0x7f;
+    val >>= 7;
+    if (val)
+      buf[len] |= 0x80;
+    len++;
+  } while (val);
+
+  g_byte_array_append (array, buf, len);
+}
+
+static inline void
+write_int (GByteArray * array, gint64 val)
+{
+  _priv_gst_binary_write_uint (array, ((guint64) val << 1) ^ (val >> 63));
+}
+
+static void
+write_double (GByteArray * array, gdouble val)
+{
+  union
+  {
+    gdouble d;
+    guint64 i;
+  } u;
+
+  u.d = val;
+  u.i = GUINT64_TO_LE (u.i);
+  g_byte_array_append (array, (const guint8 *) &u.i, 8);
+}
+
+static void
+write_string (GByteArray * array, const gchar * str)
+{
+  gsize len;
+
+  if (str == NULL) {
+    _priv_gst_binary_write_uint (array, 0);
+    return;
+  }
+
+  len = strlen (str) + 1;
+  _priv_gst_binary_write_uint (array, len);
+  g_byte_array_append (array, (const guint8 *) str, len);
+}
+
+void
+_priv_gst_binary_write_header (GByteArray * array, GstBinaryKind kind)
+{
+  g_byte_array_append (array, (const guint8 *) "GSTB", 4);
+  write_byte (array, BINARY_VERSION);
+  write_byte (array, kind);
+}
+
+static gboolean write_structure (GByteArray * array,
+    const GstStructure * structure, guint depth);
+static gboolean write_caps (GByteArray * array, const GstCaps * caps,
+    guint depth);
+
+static gboolean
+write_value (GByteArray * array, const GValue * value, guint depth)
+{
+  GType type = G_VALUE_TYPE (value);
+  guint i, n;
+
+  if (depth > MAX_DEPTH)
+    goto too_deep;
+
+  switch (G_TYPE_FUNDAMENTAL (type)) {
+    case G_TYPE_BOOLEAN:
+      write_byte (array, TAG_BOOLEAN);
+      write_byte (array, g_value_get_boolean (value) ? 1 : 0);
+      return TRUE;
+    case G_TYPE_INT:
+      write_byte (array, TAG_INT);
+      write_int (array, g_value_get_int (value));
+      return TRUE;
+    case G_TYPE_UINT:
+      write_byte (array, TAG_UINT);
+      _priv_gst_binary_write_uint (array, g_value_get_uint (value));
+      return TRUE;
+    case G_TYPE_INT64:
+      write_byte (array, TAG_INT64);
+      write_int (array, g_value_get_int64 (value));
+      return TRUE;
+    case G_TYPE_UINT64:
+      write_byte (array, TAG_UINT64);
+      _priv_gst_binary_write_uint (array, g_value_get_uint64 (value));
+      return TRUE;
+    case G_TYPE_LONG:
+      write_byte (array, TAG_LONG);
+      write_int (array, g_value_get_long (value));
+      return TRUE;
+    case G_TYPE_ULONG:
+      write_byte (array, TAG_ULONG);
+      _priv_gst_binary_write_uint (array, g_value_get_ulong (value));
+      return TRUE;
+    case G_TYPE_CHAR:
+      write_byte (array, TAG_CHAR);
+      write_int (array, g_value_get_schar (value));
+      return TRUE;
+    case G_TYPE_UCHAR:
+      write_byte (array, TAG_UCHAR);
+      write_byte (array, g_value_get_uchar (value));
+      return TRUE;
+    case G_TYPE_FLOAT:
+      write_byte (array, TAG_FLOAT);
+      write_double (array, g_value_get_float (value));
+      return TRUE;
+    case G_TYPE_DOUBLE:
+      write_byte (array, TAG_DOUBLE);
+      write_double (array, g_value_get_double (value));
+      return TRUE;
+    case G_TYPE_STRING:
+      if (type != G_TYPE_STRING)
+        break;
+      write_byte (array, TAG_STRING);
+      write_string (array, g_value_get_string (value));
+      return TRUE;
+    case G_TYPE_ENUM:
+      write_byte (array, TAG_ENUM);
+      write_string (array, g_type_name (type));
+      write_int (array, g_value_get_enum (value));
+      return TRUE;
+    case G_TYPE_FLAGS:
+      write_byte (array, TAG_FLAGS);
+      write_string (array, g_type_name (type));
+      _priv_gst_binary_write_uint (array, g_value_get_flags (value));
+      return TRUE;
+    default:
+      break;
+  }
+
+  if (type == GST_TYPE_FRACTION) {
+    write_byte (array, TAG_FRACTION);
+    write_int (array, gst_value_get_fraction_numerator (value));
+    write_int (array, gst_value_get_fraction_denominator (value));
+  } else if (type == GST_TYPE_INT_RANGE) {
+    write_byte (array, TAG_INT_RANGE);
+    write_int (array, gst_value_get_int_range_min (value));
+    write_int (array, gst_value_get_int_range_max (value));
+    write_int (array, gst_value_get_int_range_step (value));
+  } else if (type == GST_TYPE_INT64_RANGE) {
+    write_byte (array, TAG_INT64_RANGE);
+    write_int (array, gst_value_get_int64_range_min (value));
+    write_int (array, gst_value_get_int64_range_max (value));
+    write_int (array, gst_value_get_int64_range_step (value));
+  } else if (type == GST_TYPE_DOUBLE_RANGE) {
+    write_byte (array, TAG_DOUBLE_RANGE);
+    write_double (array, gst_value_get_double_range_min (value));
+    write_double (array, gst_value_get_double_range_max (value));
+  } else if (type == GST_TYPE_FRACTION_RANGE) {
+    const GValue *min = gst_value_get_fraction_range_min (value);
+    const GValue *max = gst_value_get_fraction_range_max (value);
+
+    write_byte (array, TAG_FRACTION_RANGE);
+    write_int (array, gst_value_get_fraction_numerator (min));
+    write_int (array, gst_value_get_fraction_denominator (min));
+    write_int (array, gst_value_get_fraction_numerator (max));
+    write_int (array, gst_value_get_fraction_denominator (max));
+  } else if (type == GST_TYPE_LIST) {
+    write_byte (array, TAG_LIST);
+    n = gst_value_list_get_size (value);
+    _priv_gst_binary_write_uint (array, n);
+    for (i = 0; i < n; i++) {
+      if (!write_value (array, gst_value_list_get_value (value, i), depth + 1))
+        return FALSE;
+    }
+  } else if (type == GST_TYPE_ARRAY) {
+    write_byte (array, TAG_ARRAY);
+    n = gst_value_array_get_size (value);
+    _priv_gst_binary_write_uint (array, n);
+    for (i = 0; i < n; i++) {
+      if (!write_value (array, gst_value_array_get_value (value, i), depth + 1))
+        return FALSE;
+    }
+  } else if (type == GST_TYPE_BITMASK) {
+    write_byte (array, TAG_BITMASK);
+    _priv_gst_binary_write_uint (array, gst_value_get_bitmask (value));
+  } else if (type == GST_TYPE_STRUCTURE) {
+    const GstStructure *s = gst_value_get_structure (value);
+
+    write_byte (array, TAG_STRUCTURE);
+    write_byte (array, s != NULL);
+    if (s && !write_structure (array, s, depth + 1))
+      return FALSE;
+  } else if (type == GST_TYPE_CAPS) {
+    const GstCaps *caps = gst_value_get_caps (value);
+
+    write_byte (array, TAG_CAPS);
+    write_byte (array, caps != NULL);
+    if (caps && !write_caps (array, caps, depth + 1))
+      return FALSE;
+  } else if (type == GST_TYPE_BUFFER) {
+    GstBuffer *buf = g_value_get_boxed (value);
+    GstMapInfo map;
+
+    write_byte (array, TAG_BUFFER);
+    write_byte (array, buf != NULL);
+    if (buf) {
+      if (!gst_buffer_map (buf, &map, GST_MAP_READ))
+        return FALSE;
+      _priv_gst_binary_write_uint (array, map.size);
+      g_byte_array_append (array, map.data, map.size);
+      gst_buffer_unmap (buf, &map);
+    }
+  } else if (type == G_TYPE_DATE) {
+    const GDate *date = g_value_get_boxed (value);
+
+    write_byte (array, TAG_DATE);
+    _priv_gst_binary_write_uint (array, (date && g_date_valid (date)) ?
+        g_date_get_julian (date) : 0);
+  } else {
+    gchar *str;
+
+    /* anything else that can be serialized as a string */
+    if (!(str = gst_value_serialize (value)))
+      goto not_serializable;
+
+    write_byte (array, TAG_SERIALIZED);
+    write_string (array, g_type_name (type));
+    write_string (array, str);
+    g_free (str);
+  }
+  return TRUE;
+
+  /* ERRORS */
+too_deep:
+  {
+    GST_WARNING ("values are nested too deep");
+    return FALSE;
+  }
+not_serializable:
+  {
+    GST_WARNING ("can't serialize value of type %s", g_type_name (type));
+    return FALSE;
+  }
+}
+
+static gboolean
+write_structure (GByteArray * array, const GstStructure * structure,
+    guint depth)
+{
+  guint i, n;
+
+  write_string (array, gst_structure_get_name (structure));
+
+  n = gst_structure_n_fields (structure);
+  _priv_gst_binary_write_uint (array, n);
+  for (i = 0; i < n; i++) {
+    const gchar *name = gst_structure_nth_field_name (structure, i);
+
+    write_string (array, name);
+    if (!write_value (array, gst_structure_get_value (structure, name), depth))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+static gboolean
+write_caps (GByteArray * array, const GstCaps * caps, guint depth)
+{
+  guint i, j, n;
+
+  _priv_gst_binary_write_uint (array, gst_caps_is_any (caps) ? 1 : 0);
+
+  n = gst_caps_get_size (caps);
+  _priv_gst_binary_write_uint (array, n);
+  for (i = 0; i < n; i++) {
+    GstCapsFeatures *features;
+
+    if (!write_structure (array, gst_caps_get_structure (caps, i), depth))
+      return FALSE;
+
+    features = gst_caps_get_features (caps, i);
+    if (features == NULL || gst_caps_features_is_equal (features,
+            GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY)) {
+      write_byte (array, FEATURES_NONE);
+    } else if (gst_caps_features_is_any (features)) {
+      write_byte (array, FEATURES_ANY);
+    } else {
+      guint n_features = gst_caps_features_get_size (features);
+
+      write_byte (array, FEATURES_LIST);
+      _priv_gst_binary_write_uint (array, n_features);
+      for (j = 0; j < n_features; j++)
+        write_string (array, gst_caps_features_get_nth (features, j));
+    }
+  }
+  return TRUE;
+}
+
+gboolean
+_priv_gst_binary_write_structure (GByteArray * array,
+    const GstStructure * structure)
+{
+  return write_structure (array, structure, 0);
+}
+
+gboolean
+_priv_gst_binary_write_caps (GByteArray * array, const GstCaps * caps)
+{
+  return write_caps (array, caps, 0);
+}
+
+/* reading */
+
+static inline gboolean
+read_byte (GstBinaryReader * reader, guint8 * val)
+{
+  if (reader->pos >= reader->size)
+    return FALSE;
+
+  *val = reader->data[reader->pos++];
+  return TRUE;
+}
+
+gboolean
+_priv_gst_binary_read_uint (GstBinaryReader * reader, guint64 * val)
+{
+  guint64 res = 0;
+  guint shift = 0;
+  guint8 b;
+
+  do {
+    if (shift > 63 || !read_byte (reader, &b))
+      return FALSE;
+    res |= (guint64) (b & 0x7f) << shift;
+    shift += 7;
+  } while (b & 0x80);
+
+  *val = res;
+  return TRUE;
+}
+
+static inline gboolean
+read_int (GstBinaryReader * reader, gint64 * val)
+{
+  guint64 u;
+
+  if (!_priv_gst_binary_read_uint (reader, &u))
+    return FALSE;
+
+  *val = (gint64) (u >> 1) ^ -(gint64) (u & 1);
+  return TRUE;
+}
+
+static gboolean
+read_double (GstBinaryReader * reader, gdouble * val)
+{
+  union
+  {
+    gdouble d;
+    guint64 i;
+  } u;
+
+  if (reader->size - reader->pos < 8)
+    return FALSE;
+
+  memcpy (&u.i, reader->data + reader->pos, 8);
+  u.i = GUINT64_FROM_LE (u.i);
+  reader->pos += 8;
+
+  *val = u.d;
+  return TRUE;
+}
+
+/* the string points into the data */
+static gboolean
+read_string (GstBinaryReader * reader, const gchar ** str)
+{
+  guint64 len;
+
+  if (!_priv_gst_binary_read_uint (reader, &len))
+    return FALSE;
+
+  if (len == 0) {
+    *str = NULL;
+    return TRUE;
+  }
+
+  if (len > reader->size - reader->pos)
+    return FALSE;
+  if (reader->data[reader->pos + len - 1] != '\0')
+    return FALSE;
+
+  *str = (const gchar *) reader->data + reader->pos;
+  reader->pos += len;
+  return TRUE;
+}
+
+/* a string that can't be NULL */
+static inline gboolean
+read_name (GstBinaryReader * reader, const gchar ** str)
+{
+  return read_string (reader, str) && *str != NULL;
+}
+
+/* the same characters that are allowed in names by the string parser */
+static gboolean
+is_valid_name (const gchar * name)
+{
+  const gchar *p;
+
+  if (!g_ascii_isalpha (*name))
+    return FALSE;
+  for (p = name + 1; *p; p++) {
+    if (!g_ascii_isalnum (*p) && !strchr ("/-_.:+", *p))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+/* a name that is turned into a quark. The data is untrusted, so only valid
+ * names are accepted and only a limited number of new ones per read. */
+static gboolean
+read_quark (GstBinaryReader * reader, GQuark * quark)
+{
+  const gchar *name;
+
+  if (!read_name (reader, &name))
+    return FALSE;
+
+  if ((*quark = g_quark_try_string (name)))
+    return TRUE;
+
+  if (!is_valid_name (name)) {
+    GST_WARNING ("invalid name '%s'", name);
+    return FALSE;
+  }
+  if (reader->n_quarks >= MAX_NEW_QUARKS) {
+    GST_WARNING ("too many new names");
+    return FALSE;
+  }
+  reader->n_quarks++;
+  *quark = g_quark_from_string (name);
+  return TRUE;
+}
+
+/* the number of items of a list, each item takes at least a byte */
+static inline gboolean
+read_count (GstBinaryReader * reader, guint * count)
+{
+  guint64 n;
+
+  if (!_priv_gst_binary_read_uint (reader, &n))
+    return FALSE;
+  if (n > reader->size - reader->pos)
+    return FALSE;
+
+  *count = n;
+  return TRUE;
+}
+
+gboolean
+_priv_gst_binary_read_header (GstBinaryReader * reader, GstBinaryKind kind)
+{
+  if (reader->size - reader->pos < 6)
+    goto invalid;
+  if (memcmp (reader->data + reader->pos, "GSTB", 4) != 0)
+    goto invalid;
+  if (reader->data[reader->pos + 4] != BINARY_VERSION)
+    goto wrong_version;
+  if (reader->data[reader->pos + 5] != kind)
+    goto invalid;
+
+  reader->pos += 6;
+  return TRUE;
+
+  /* ERRORS */
+invalid:
+  {
+    GST_WARNING ("invalid header");
+    return FALSE;
+  }
+wrong_version:
+  {
+    GST_WARNING ("unsupported version %d", reader->data[reader->pos + 4]);
+    return FALSE;
+  }
+}
+
+static GstStructure *read_structure (GstBinaryReader * reader, guint depth);
+static GstCaps *read_caps (GstBinaryReader * reader, guint depth);
+
+#define IN_RANGE(v,min,max) ((v) >= (min) && (v) <= (max))
+/* the sign of the fraction is normalized by negating, G_MININT can't be */
+#define IS_FRACTION(n,d) (IN_RANGE (n, -G_MAXINT, G_MAXINT) && \
+    IN_RANGE (d, -G_MAXINT, G_MAXINT) && (d) != 0)
+#define IS_RANGE(start,end,step) ((start) < (end) && \
+    (start) % (step) == 0 && (end) % (step) == 0)
+
+/* reads the value into the uninitialized @value */
+static gboolean
+read_value (GstBinaryReader * reader, GValue * value, guint depth)
+{
+  gint64 i1, i2, i3, i4;
+  guint64 u;
+  gdouble d1, d2;
+  const gchar *str, *type_name = NULL;
+  guint8 tag, b;
+  GType type;
+  guint i, n;
+
+  if (depth > MAX_DEPTH)
+    return FALSE;
+
+  if (!read_byte (reader, &tag))
+    return FALSE;
+
+  switch (tag) {
+    case TAG_BOOLEAN:
+      if (!read_byte (reader, &b))
+        return FALSE;
+      g_value_init (value, G_TYPE_BOOLEAN);
+      g_value_set_boolean (value, b != 0);
+      break;
+    case TAG_INT:
+      if (!read_int (reader, &i1) || !IN_RANGE (i1, G_MININT, G_MAXINT))
+        return FALSE;
+      g_value_init (value, G_TYPE_INT);
+      g_value_set_int (value, i1);
+      break;
+    case TAG_UINT:
+      if (!_priv_gst_binary_read_uint (reader, &u) || u > G_MAXUINT)
+        return FALSE;
+      g_value_init (value, G_TYPE_UINT);
+      g_value_set_uint (value, u);
+      break;
+    case TAG_INT64:
+      if (!read_int (reader, &i1))
+        return FALSE;
+      g_value_init (value, G_TYPE_INT64);
+      g_value_set_int64 (value, i1);
+      break;
+    case TAG_UINT64:
+      if (!_priv_gst_binary_read_uint (reader, &u))
+        return FALSE;
+      g_value_init (value, G_TYPE_UINT64);
+      g_value_set_uint64 (value, u);
+      break;
+    case TAG_LONG:
+      if (!read_int (reader, &i1) || !IN_RANGE (i1, G_MINLONG, G_MAXLONG))
+        return FALSE;
+      g_value_init (value, G_TYPE_LONG);
+      g_value_set_long (value, i1);
+      break;
+    case TAG_ULONG:
+      if (!_priv_gst_binary_read_uint (reader, &u) || u > G_MAXULONG)
+        return FALSE;
+      g_value_init (value, G_TYPE_ULONG);
+      g_value_set_ulong (value, u);
+      break;
+    case TAG_CHAR:
+      if (!read_int (reader, &i1) || !IN_RANGE (i1, G_MININT8, G_MAXINT8))
+        return FALSE;
+      g_value_init (value, G_TYPE_CHAR);
+      g_value_set_schar (value, i1);
+      break;
+    case TAG_UCHAR:
+      if (!read_byte (reader, &b))
+        return FALSE;
+      g_value_init (value, G_TYPE_UCHAR);
+      g_value_set_uchar (value, b);
+      break;
+    case TAG_FLOAT:
+      /* out of range values can't be converted */
+      if (!read_double (reader, &d1) || (d1 > G_MAXFLOAT || d1 < -G_MAXFLOAT))
+        return FALSE;
+      g_value_init (value, G_TYPE_FLOAT);
+      g_value_set_float (value, d1);
+      break;
+    case TAG_DOUBLE:
+      if (!read_double (reader, &d1))
+        return FALSE;
+      g_value_init (value, G_TYPE_DOUBLE);
+      g_value_set_double (value, d1);
+      break;
+    case TAG_STRING:
+      if (!read_string (reader, &str))
+        return FALSE;
+      g_value_init (value, G_TYPE_STRING);
+      g_value_set_string (value, str);
+      break;
+    case TAG_ENUM:
+      if (!read_name (reader, &type_name) || !read_int (reader, &i1)
+          || !IN_RANGE (i1, G_MININT, G_MAXINT))
+        return FALSE;
+      type = g_type_from_name (type_name);
+      if (!G_TYPE_IS_ENUM (type))
+        goto unknown_type;
+      g_value_init (value, type);
+      g_value_set_enum (value, i1);
+      break;
+    case TAG_FLAGS:
+      if (!read_name (reader, &type_name)
+          || !_priv_gst_binary_read_uint (reader, &u) || u > G_MAXUINT)
+        return FALSE;
+      type = g_type_from_name (type_name);
+      if (!G_TYPE_IS_FLAGS (type))
+        goto unknown_type;
+      g_value_init (value, type);
+      g_value_set_flags (value, u);
+      break;
+    case TAG_FRACTION:
+      if (!read_int (reader, &i1) || !read_int (reader, &i2)
+          || !IS_FRACTION (i1, i2))
+        return FALSE;
+      g_value_init (value, GST_TYPE_FRACTION);
+      gst_value_set_fraction (value, i1, i2);
+      break;
+    case TAG_INT_RANGE:
+      if (!read_int (reader, &i1) || !read_int (reader, &i2)
+          || !read_int (reader, &i3) || !IN_RANGE (i1, G_MININT, G_MAXINT)
+          || !IN_RANGE (i2, G_MININT, G_MAXINT)
+          || !IN_RANGE (i3, 1, G_MAXINT) || !IS_RANGE (i1, i2, i3))
+        return FALSE;
+      g_value_init (value, GST_TYPE_INT_RANGE);
+      gst_value_set_int_range_step (value, i1, i2, i3);
+      break;
+    case TAG_INT64_RANGE:
+      if (!read_int (reader, &i1) || !read_int (reader, &i2)
+          || !read_int (reader, &i3) || i3 <= 0 || !IS_RANGE (i1, i2, i3))
+        return FALSE;
+      g_value_init (value, GST_TYPE_INT64_RANGE);
+      gst_value_set_int64_range_step (value, i1, i2, i3);
+      break;
+    case TAG_DOUBLE_RANGE:
+      if (!read_double (reader, &d1) || !read_double (reader, &d2)
+          || !(d1 < d2))
+        return FALSE;
+      g_value_init (value, GST_TYPE_DOUBLE_RANGE);
+      gst_value_set_double_range (value, d1, d2);
+      break;
+    case TAG_FRACTION_RANGE:
+      if (!read_int (reader, &i1) || !read_int (reader, &i2)
+          || !read_int (reader, &i3) || !read_int (reader, &i4)
+          || !IS_FRACTION (i1, i2) || !IS_FRACTION (i3, i4)
+          || gst_util_fraction_compare (i1, i2, i3, i4) >= 0)
+        return FALSE;
+      g_value_init (value, GST_TYPE_FRACTION_RANGE);
+      gst_value_set_fraction_range_full (value, i1, i2, i3, i4);
+      break;
+    case TAG_LIST:
+    case TAG_ARRAY:
+      if (!read_count (reader, &n))
+        return FALSE;
+      g_value_init (value, tag == TAG_LIST ? GST_TYPE_LIST : GST_TYPE_ARRAY);
+      for (i = 0; i < n; i++) {
+        GValue item = { 0, };
+
+        if (!read_value (reader, &item, depth + 1)) {
+          g_value_unset (value);
+          return FALSE;
+        }
+        if (tag == TAG_LIST)
+          gst_value_list_append_and_take_value (value, &item);
+        else
+          gst_value_array_append_and_take_value (value, &item);
+      }
+      break;
+    case TAG_BITMASK:
+      if (!_priv_gst_binary_read_uint (reader, &u))
+        return FALSE;
+      g_value_init (value, GST_TYPE_BITMASK);
+      gst_value_set_bitmask (value, u);
+      break;
+    case TAG_STRUCTURE:
+    {
+      GstStructure *s = NULL;
+
+      if (!read_byte (reader, &b))
+        return FALSE;
+      if (b && !(s = read_structure (reader, depth + 1)))
+        return FALSE;
+      g_value_init (value, GST_TYPE_STRUCTURE);
+      g_value_take_boxed (value, s);
+      break;
+    }
+    case TAG_CAPS:
+    {
+      GstCaps *caps = NULL;
+
+      if (!read_byte (reader, &b))
+        return FALSE;
+      if (b && !(caps = read_caps (reader, depth + 1)))
+        return FALSE;
+      g_value_init (value, GST_TYPE_CAPS);
+      g_value_take_boxed (value, caps);
+      break;
+    }
+    case TAG_BUFFER:
+    {
+      GstBuffer *buf = NULL;
+
+      if (!read_byte (reader, &b))
+        return FALSE;
+      if (b) {
+        if (!_priv_gst_binary_read_uint (reader, &u)
+            || u > reader->size - reader->pos)
+          return FALSE;
+        buf = gst_buffer_new_allocate (NULL, u, NULL);
+        gst_buffer_fill (buf, 0, reader->data + reader->pos, u);
+        reader->pos += u;
+      }
+      g_value_init (value, GST_TYPE_BUFFER);
+      g_value_take_boxed (value, buf);
+      break;
+    }
+    case TAG_DATE:
+      if (!_priv_gst_binary_read_uint (reader, &u) || u > G_MAXUINT32)
+        return FALSE;
+      g_value_init (value, G_TYPE_DATE);
+      if (u && g_date_valid_julian (u))
+        g_value_take_boxed (value, g_date_new_julian (u));
+      break;
+    case TAG_SERIALIZED:
+      if (!read_name (reader, &type_name) || !read_name (reader, &str))
+        return FALSE;
+      type = g_type_from_name (type_name);
+      if (type == G_TYPE_INVALID)
+        goto unknown_type;
+      /* only types that can be instantiated in a GValue */
+      if (!G_TYPE_IS_VALUE_TYPE (type) || G_TYPE_IS_ABSTRACT (type)
+          || G_TYPE_IS_INTERFACE (type))
+        goto invalid_type;
+      g_value_init (value, type);
+      if (!gst_value_deserialize (value, str)) {
+        g_value_unset (value);
+        GST_WARNING ("can't deserialize %s value '%s'", type_name, str);
+        return FALSE;
+      }
+      break;
+    default:
+      GST_WARNING ("unknown value tag %d", tag);
+      return FALSE;
+  }
+  return TRUE;
+
+  /* ERRORS */
+unknown_type:
+  {
+    GST_WARNING ("unknown type %s", type_name);
+    return FALSE;
+  }
+invalid_type:
+  {
+    GST_WARNING ("can't create a value of type %s", type_name);
+    return FALSE;
+  }
+}
+
+static GstStructure *
+read_structure (GstBinaryReader * reader, guint depth)
+{
+  GstStructure *structure;
+  GQuark name;
+  guint i, n;
+
+  if (!read_quark (reader, &name) || !read_count (reader, &n))
+    return NULL;
+
+  structure = gst_structure_new_id_empty (name);
+  for (i = 0; i < n; i++) {
+    GValue value = { 0, };
+
+    if (!read_quark (reader, &name) || !read_value (reader, &value, depth))
+      goto error;
+    gst_structure_id_take_value (structure, name, &value);
+  }
+  return structure;
+
+error:
+  gst_structure_free (structure);
+  return NULL;
+}
+
+static GstCaps *
+read_caps (GstBinaryReader * reader, guint depth)
+{
+  GstCaps *caps;
+  guint64 flags;
+  guint i, j, n, n_features;
+
+  if (!_priv_gst_binary_read_uint (reader, &flags) || !read_count (reader, &n))
+    return NULL;
+
+  if (flags & 1)
+    caps = gst_caps_new_any ();
+  else
+    caps = gst_caps_new_empty ();
+
+  for (i = 0; i < n; i++) {
+    GstStructure *s;
+    GstCapsFeatures *features = NULL;
+    GQuark name;
+    guint8 tag;
+
+    if (!(s = read_structure (reader, depth)))
+      goto error;
+
+    if (!read_byte (reader, &tag)) {
+      gst_structure_free (s);
+      goto error;
+    }
+
+    switch (tag) {
+      case FEATURES_NONE:
+        break;
+      case FEATURES_ANY:
+        features = gst_caps_features_new_any ();
+        break;
+      case FEATURES_LIST:
+        if (!read_count (reader, &n_features)) {
+          gst_structure_free (s);
+          goto error;
+        }
+        features = gst_caps_features_new_empty ();
+        for (j = 0; j < n_features; j++) {
+          /* gst_caps_features_add_id() warns about invalid names */
+          if (!read_quark (reader, &name) ||
+              !priv_gst_caps_feature_name_is_valid (g_quark_to_string (name))) {
+            gst_caps_features_free (features);
+            gst_structure_free (s);
+            goto error;
+          }
+          gst_caps_features_add_id (features, name);
+        }
+        break;
+      default:
+        gst_structure_free (s);
+        goto error;
+    }
+    gst_caps_append_structure_full (caps, s, features);
+  }
+  return caps;
+
+error:
+  gst_caps_unref (caps);
+  return NULL;
+}
+
+GstStructure *
+_priv_gst_binary_read_structure (GstBinaryReader * reader)
+{
+  return read_structure (reader, 0);
+}
+
+GstCaps *
+_priv_gst_binary_read_caps (GstBinaryReader * reader)
+{
+  return read_caps (reader, 0);
+}
@@ -0,0 +1,60 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * gstbinaryformat.h: Compact binary encoding of structures, caps and
+ * tag lists. Private header.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef __GST_BINARY_FORMAT_H__
+#define __GST_BINARY_FORMAT_H__
+
+#include <glib.h>
+#include <gst/gststructure.h>
+#include <gst/gstcaps.h>
+
+G_BEGIN_DECLS
+
+/* what follows the header */
+typedef enum {
+  GST_BINARY_KIND_STRUCTURE = 'S',
+  GST_BINARY_KIND_CAPS      = 'C',
+  GST_BINARY_KIND_TAG_LIST  = 'T'
+} GstBinaryKind;
+
+/* reads from memory owned by the caller, nothing is copied until the values
+ * are created. n_quarks counts the names that the read added to the quark
+ * table. */
+typedef struct {
+  const guint8 *data;
+  gsize size;
+  gsize pos;
+  guint n_quarks;
+} GstBinaryReader;
+
+G_GNUC_INTERNAL void           _priv_gst_binary_write_header    (GByteArray * array, GstBinaryKind kind);
+G_GNUC_INTERNAL void           _priv_gst_binary_write_uint      (GByteArray * array, guint64 val);
+G_GNUC_INTERNAL gboolean       _priv_gst_binary_write_structure (GByteArray * array, const GstStructure * structure);
+G_GNUC_INTERNAL gboolean       _priv_gst_binary_write_caps      (GByteArray * array, const GstCaps * caps);
+
+G_GNUC_INTERNAL gboolean       _priv_gst_binary_read_header     (GstBinaryReader * reader, GstBinaryKind kind);
+G_GNUC_INTERNAL gboolean       _priv_gst_binary_read_uint       (GstBinaryReader * reader, guint64 * val);
+G_GNUC_INTERNAL GstStructure * _priv_gst_binary_read_structure  (GstBinaryReader * reader);
+G_GNUC_INTERNAL GstCaps *      _priv_gst_binary_read_caps       (GstBinaryReader * reader);
+
+G_END_DECLS
+
+#endif /* __GST_BINARY_FORMAT_H__ */
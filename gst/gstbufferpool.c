@@ -75,7 +75,6 @@
 #include <sys/types.h>
 
 #include "gstatomicqueue.h"
-#include "gstpoll.h"
 #include "gstinfo.h"
 #include "gstquark.h"
 #include "gstvalue.h"
@@ -91,10 +90,22 @@ GST_DEBUG_CATEGORY_STATIC (gst_buffer_pool_debug);
 #define GST_BUFFER_POOL_LOCK(pool)   (g_rec_mutex_lock(&pool->priv->rec_lock))
 #define GST_BUFFER_POOL_UNLOCK(pool) (g_rec_mutex_unlock(&pool->priv->rec_lock))
 
+/* max number of queues for the free buffers */
+#define MAX_QUEUES 8
+
 struct _GstBufferPoolPrivate
 {
-  GstAtomicQueue *queue;
-  GstPoll *poll;
+  /* the free buffers, spread over a queue per CPU (up to MAX_QUEUES) so that
+   * threads that share the pool don't all contend on the same queue. A thread
+   * releases to its own queue and acquires from it first. */
+  GstAtomicQueue *queues[MAX_QUEUES];
+  guint n_queues;
+
+  /* for waiting on a free buffer or flushing. Releasing only takes the lock
+   * when there are waiters. */
+  GMutex wait_lock;
+  GCond wait_cond;
+  gint waiters;
 
   GRecMutex rec_lock;
 
@@ -129,6 +140,78 @@ static void default_reset_buffer (GstBufferPool * pool, GstBuffer * buffer);
 static void default_free_buffer (GstBufferPool * pool, GstBuffer * buffer);
 static void default_release_buffer (GstBufferPool * pool, GstBuffer * buffer);
 
+static GPrivate thread_index;
+static gint n_thread_indexes = 0;
+
+/* a small number that identifies the current thread */
+static inline guint
+get_thread_index (void)
+{
+  gint idx;
+
+  if (G_UNLIKELY (!(idx = GPOINTER_TO_INT (g_private_get (&thread_index))))) {
+    idx = g_atomic_int_add (&n_thread_indexes, 1) + 1;
+    g_private_set (&thread_index, GINT_TO_POINTER (idx));
+  }
+  return idx - 1;
+}
+
+static guint
+get_num_processors (void)
+{
+#if GLIB_CHECK_VERSION(2,36,0)
+  return g_get_num_processors ();
+#elif defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+  long n = sysconf (_SC_NPROCESSORS_ONLN);
+
+  return n > 0 ? (guint) n : 1;
+#else
+  return 1;
+#endif
+}
+
+/* the queue of free buffers of the current thread */
+static inline GstAtomicQueue *
+get_thread_queue (GstBufferPoolPrivate * priv)
+{
+  if (priv->n_queues == 1)
+    return priv->queues[0];
+
+  return priv->queues[get_thread_index () % priv->n_queues];
+}
+
+/* get a free buffer from the queue of the current thread or else from one
+ * of the other queues */
+static GstBuffer *
+pop_free_buffer (GstBufferPoolPrivate * priv)
+{
+  GstBuffer *buffer;
+  guint i, idx;
+
+  if (priv->n_queues == 1)
+    return gst_atomic_queue_pop (priv->queues[0]);
+
+  idx = get_thread_index ();
+  for (i = 0; i < priv->n_queues; i++) {
+    buffer = gst_atomic_queue_pop (priv->queues[(idx + i) % priv->n_queues]);
+    if (buffer)
+      return buffer;
+  }
+  return NULL;
+}
+
+static gboolean
+has_free_buffers (GstBufferPoolPrivate * priv)
+{
+  guint i;
+
+  for (i = 0; i < priv->n_queues; i++) {
+    if (gst_atomic_queue_length (priv->queues[i]) > 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
 static void
 gst_buffer_pool_class_init (GstBufferPoolClass * klass)
 {
@@ -155,13 +238,17 @@ static void
 gst_buffer_pool_init (GstBufferPool * pool)
 {
   GstBufferPoolPrivate *priv;
+  guint i;
 
   priv = pool->priv = GST_BUFFER_POOL_GET_PRIVATE (pool);
 
   g_rec_mutex_init (&priv->rec_lock);
+  g_mutex_init (&priv->wait_lock);
+  g_cond_init (&priv->wait_cond);
 
-  priv->poll = gst_poll_new_timer ();
-  priv->queue = gst_atomic_queue_new (16);
+  priv->n_queues = MIN (get_num_processors (), MAX_QUEUES);
+  for (i = 0; i < priv->n_queues; i++)
+    priv->queues[i] = gst_atomic_queue_new (16);
   pool->flushing = 1;
   priv->active = FALSE;
   priv->configured = FALSE;
@@ -172,10 +259,6 @@ gst_buffer_pool_init (GstBufferPool * pool)
   gst_allocation_params_init (&priv->params);
   gst_buffer_pool_config_set_allocator (priv->config, priv->allocator,
       &priv->params);
-  /* 1 control write for flushing */
-  gst_poll_write_control (priv->poll);
-  /* 1 control write for marking that we are not waiting for poll */
-  gst_poll_write_control (priv->poll);
 
   GST_DEBUG_OBJECT (pool, "created");
 }
@@ -185,6 +268,7 @@ gst_buffer_pool_finalize (GObject * object)
 {
   GstBufferPool *pool;
   GstBufferPoolPrivate *priv;
+  guint i;
 
   pool = GST_BUFFER_POOL_CAST (object);
   priv = pool->priv;
@@ -192,9 +276,11 @@ gst_buffer_pool_finalize (GObject * object)
   GST_DEBUG_OBJECT (pool, "finalize");
 
   gst_buffer_pool_set_active (pool, FALSE);
-  gst_atomic_queue_unref (priv->queue);
-  gst_poll_free (priv->poll);
+  for (i = 0; i < priv->n_queues; i++)
+    gst_atomic_queue_unref (priv->queues[i]);
   gst_structure_free (priv->config);
+  g_cond_clear (&priv->wait_cond);
+  g_mutex_clear (&priv->wait_lock);
   g_rec_mutex_clear (&priv->rec_lock);
   if (priv->allocator)
     gst_object_unref (priv->allocator);
@@ -370,9 +456,8 @@ default_stop (GstBufferPool * pool)
   pclass = GST_BUFFER_POOL_GET_CLASS (pool);
 
   /* clear the pool */
-  while ((buffer = gst_atomic_queue_pop (priv->queue))) {
+  while ((buffer = pop_free_buffer (priv))) {
     GST_LOG_OBJECT (pool, "freeing buffer %p", buffer);
-    gst_poll_read_control (priv->poll);
 
     if (G_LIKELY (pclass->free_buffer))
       pclass->free_buffer (pool, buffer);
@@ -447,14 +532,15 @@ gst_buffer_pool_set_active (GstBufferPool * pool, gboolean active)
       goto start_failed;
 
     /* unset the flushing state now */
-    gst_poll_read_control (priv->poll);
     g_atomic_int_set (&pool->flushing, 0);
   } else {
     gint outstanding;
 
-    /* set to flushing first */
+    /* set to flushing first and wake up the waiters */
     g_atomic_int_set (&pool->flushing, 1);
-    gst_poll_write_control (priv->poll);
+    g_mutex_lock (&priv->wait_lock);
+    g_cond_broadcast (&priv->wait_cond);
+    g_mutex_unlock (&priv->wait_lock);
 
     /* when all buffers are in the pool, free them. Else they will be
      * freed when they are released */
@@ -980,10 +1066,9 @@ default_acquire_buffer (GstBufferPool * pool, GstBuffer ** buffer,
     if (G_UNLIKELY (GST_BUFFER_POOL_IS_FLUSHING (pool)))
       goto flushing;
 
-    /* try to get a buffer from the queue */
-    *buffer = gst_atomic_queue_pop (priv->queue);
+    /* try to get a free buffer */
+    *buffer = pop_free_buffer (priv);
     if (G_LIKELY (*buffer)) {
-      gst_poll_read_control (priv->poll);
       result = GST_FLOW_OK;
       GST_LOG_OBJECT (pool, "acquired buffer %p", *buffer);
       break;
@@ -1006,12 +1091,15 @@ default_acquire_buffer (GstBufferPool * pool, GstBuffer ** buffer,
       break;
     }
 
-    /* now we release the control socket, we wait for a buffer release or
-     * flushing */
-    gst_poll_read_control (pool->priv->poll);
+    /* wait for a buffer release or flushing. After announcing ourselves as
+     * a waiter, a release will signal us so we check again before waiting */
     GST_LOG_OBJECT (pool, "waiting for free buffers or flushing");
-    gst_poll_wait (priv->poll, GST_CLOCK_TIME_NONE);
-    gst_poll_write_control (pool->priv->poll);
+    g_mutex_lock (&priv->wait_lock);
+    g_atomic_int_inc (&priv->waiters);
+    if (!GST_BUFFER_POOL_IS_FLUSHING (pool) && !has_free_buffers (priv))
+      g_cond_wait (&priv->wait_cond, &priv->wait_lock);
+    g_atomic_int_add (&priv->waiters, -1);
+    g_mutex_unlock (&priv->wait_lock);
   }
 
   return result;
@@ -1117,10 +1205,18 @@ gst_buffer_pool_acquire_buffer (GstBufferPool * pool, GstBuffer ** buffer,
 static void
 default_release_buffer (GstBufferPool * pool, GstBuffer * buffer)
 {
+  GstBufferPoolPrivate *priv = pool->priv;
+
   /* keep it around in our queue */
   GST_LOG_OBJECT (pool, "released buffer %p", buffer);
-  gst_atomic_queue_push (pool->priv->queue, buffer);
-  gst_poll_write_control (pool->priv->poll);
+  gst_atomic_queue_push (get_thread_queue (priv), buffer);
+
+  /* only wake up when someone is waiting for a buffer */
+  if (G_UNLIKELY (g_atomic_int_get (&priv->waiters) > 0)) {
+    g_mutex_lock (&priv->wait_lock);
+    g_cond_signal (&priv->wait_cond);
+    g_mutex_unlock (&priv->wait_lock);
+  }
 }
 
 /**
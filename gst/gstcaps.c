@@ -56,6 +56,17 @@
  * Various methods exist to work with the media types such as subtracting
  * or intersecting.
  *
+ * The results of gst_caps_intersect(), gst_caps_intersect_full(),
+ * gst_caps_can_intersect() and gst_caps_is_subset() on caps that are not
+ * writable, like the caps of pad templates, can be kept in a cache of a fixed
+ * size so that negotiating the same caps again doesn't need to redo the work.
+ * The cache is disabled by default and can be enabled with
+ * gst_caps_cache_set_size() or the GST_CAPS_CACHE_SIZE environment variable.
+ *
+ * Fixed caps that are used a lot, for example in caps events, can be interned
+ * with gst_caps_intern(). All interned caps that are equal are the same
+ * #GstCaps, so that comparing them is a pointer comparison.
+ *
  * Be aware that the current #GstCaps / #GstStructure serialization into string
  * has limited support for nested #GstCaps / #GstStructure fields. It can only
  * support one level of nesting. Using more levels will lead to unexpected
@@ -72,6 +83,7 @@
 #include <signal.h>
 
 #include "gst_private.h"
+#include "gstbinaryformat.h"
 #include <gst/gst.h>
 #include <gobject/gvaluecollector.h>
 
@@ -88,10 +100,17 @@ typedef struct _GstCapsImpl
   GstCaps caps;
 
   GArray *array;
+
+  /* set for caps returned by gst_caps_intern() */
+  gboolean interned;
+  guint hash;
 } GstCapsImpl;
 
 #define GST_CAPS_ARRAY(c) (((GstCapsImpl *)(c))->array)
 
+#define GST_CAPS_INTERNED(c) (((GstCapsImpl *)(c))->interned)
+#define GST_CAPS_HASH(c)     (((GstCapsImpl *)(c))->hash)
+
 #define GST_CAPS_LEN(c)   (GST_CAPS_ARRAY(c)->len)
 
 #define IS_WRITABLE(caps) \
@@ -140,9 +159,442 @@ GstCaps *_gst_caps_none;
 
 GST_DEFINE_MINI_OBJECT_TYPE (GstCaps, gst_caps);
 
+/* cache for the results of operations on caps that can't change anymore.
+ * The entries keep a ref on the caps, so caps that were not writable when they
+ * were added can't become writable again and their pointer identifies their
+ * content. Writable copies get a new pointer and miss the cache. */
+typedef enum
+{
+  CACHE_OP_INTERSECT_ZIG_ZAG,
+  CACHE_OP_INTERSECT_FIRST,
+  CACHE_OP_CAN_INTERSECT,
+  CACHE_OP_IS_SUBSET
+} GstCapsCacheOp;
+
+typedef struct
+{
+  GstCaps *caps1;
+  GstCaps *caps2;
+  GstCapsCacheOp op;
+  /* the intersection or NULL for the boolean operations */
+  GstCaps *result;
+  gboolean res;
+} GstCapsCacheEntry;
+
+static GMutex caps_cache_lock;
+static GstCapsCacheEntry *caps_cache;
+static gint caps_cache_size = 0;
+static guint64 caps_cache_hits;
+static guint64 caps_cache_misses;
+
+#define CAPS_CACHE_ENABLED() (g_atomic_int_get (&caps_cache_size) > 0)
+
+/* only caps that are shared can be cached, the cache then keeps them from
+ * becoming writable */
+#define CAPS_CACHE_CAN_CACHE(c1,c2) \
+  ((c1) != (c2) && !IS_WRITABLE (c1) && !IS_WRITABLE (c2))
+
+static inline guint
+caps_cache_index (const GstCaps * caps1, const GstCaps * caps2,
+    GstCapsCacheOp op)
+{
+  guint h;
+
+  h = (guint) (((guintptr) caps1) >> 4) * 2654435761u;
+  h ^= (guint) (((guintptr) caps2) >> 4) * 40503u;
+  h ^= op * 97;
+
+  return (h ^ (h >> 15)) % caps_cache_size;
+}
+
+/* returns TRUE and the result in @result or @res when the operation is in the
+ * cache */
+static gboolean
+caps_cache_lookup (const GstCaps * caps1, const GstCaps * caps2,
+    GstCapsCacheOp op, GstCaps ** result, gboolean * res)
+{
+  GstCapsCacheEntry *entry;
+  gboolean found = FALSE;
+
+  g_mutex_lock (&caps_cache_lock);
+  if (G_UNLIKELY (caps_cache == NULL))
+    goto done;
+
+  entry = &caps_cache[caps_cache_index (caps1, caps2, op)];
+  if (entry->caps1 == caps1 && entry->caps2 == caps2 && entry->op == op) {
+    if (result)
+      *result = gst_caps_ref (entry->result);
+    if (res)
+      *res = entry->res;
+    caps_cache_hits++;
+    found = TRUE;
+  } else {
+    caps_cache_misses++;
+  }
+done:
+  g_mutex_unlock (&caps_cache_lock);
+
+  return found;
+}
+
+static void
+caps_cache_insert (const GstCaps * caps1, const GstCaps * caps2,
+    GstCapsCacheOp op, GstCaps * result, gboolean res)
+{
+  GstCapsCacheEntry *entry, old = { NULL, };
+
+  g_mutex_lock (&caps_cache_lock);
+  if (G_UNLIKELY (caps_cache == NULL)) {
+    g_mutex_unlock (&caps_cache_lock);
+    return;
+  }
+
+  entry = &caps_cache[caps_cache_index (caps1, caps2, op)];
+  old = *entry;
+
+  entry->caps1 = gst_caps_ref ((GstCaps *) caps1);
+  entry->caps2 = gst_caps_ref ((GstCaps *) caps2);
+  entry->op = op;
+  entry->result = result ? gst_caps_ref (result) : NULL;
+  entry->res = res;
+  g_mutex_unlock (&caps_cache_lock);
+
+  /* the old caps might be freed, do that without the lock */
+  if (old.caps1) {
+    gst_caps_unref (old.caps1);
+    gst_caps_unref (old.caps2);
+    if (old.result)
+      gst_caps_unref (old.result);
+  }
+}
+
+static void
+caps_cache_free_entries (GstCapsCacheEntry * entries, guint size)
+{
+  guint i;
+
+  for (i = 0; i < size; i++) {
+    if (entries[i].caps1 == NULL)
+      continue;
+    gst_caps_unref (entries[i].caps1);
+    gst_caps_unref (entries[i].caps2);
+    if (entries[i].result)
+      gst_caps_unref (entries[i].result);
+  }
+  g_free (entries);
+}
+
+/**
+ * gst_caps_cache_set_size:
+ * @size: the number of results to keep, 0 disables the cache
+ *
+ * Sets the number of results of caps intersections and subset checks that are
+ * remembered. Only the results for caps that are not writable are cached. The
+ * cache keeps a reference to the caps and the results of the cached
+ * operations. Changing the size clears the cache.
+ *
+ * This is mostly useful for applications that build the same pipelines many
+ * times, the cache is disabled by default.
+ *
+ * Since: 1.4
+ */
+void
+gst_caps_cache_set_size (guint size)
+{
+  GstCapsCacheEntry *old;
+  guint old_size;
+
+  g_mutex_lock (&caps_cache_lock);
+  old = caps_cache;
+  old_size = caps_cache_size;
+  caps_cache = size ? g_new0 (GstCapsCacheEntry, size) : NULL;
+  g_atomic_int_set (&caps_cache_size, size);
+  caps_cache_hits = caps_cache_misses = 0;
+  g_mutex_unlock (&caps_cache_lock);
+
+  if (old)
+    caps_cache_free_entries (old, old_size);
+
+  GST_CAT_DEBUG (GST_CAT_CAPS, "caps cache size set to %u", size);
+}
+
+/**
+ * gst_caps_cache_clear:
+ *
+ * Removes all entries from the caps cache, releasing the references to the
+ * caps it holds.
+ *
+ * Since: 1.4
+ */
+void
+gst_caps_cache_clear (void)
+{
+  GstCapsCacheEntry *old;
+  guint size;
+
+  g_mutex_lock (&caps_cache_lock);
+  old = caps_cache;
+  size = caps_cache_size;
+  caps_cache = size ? g_new0 (GstCapsCacheEntry, size) : NULL;
+  g_mutex_unlock (&caps_cache_lock);
+
+  if (old)
+    caps_cache_free_entries (old, size);
+}
+
+/**
+ * gst_caps_cache_get_stats:
+ * @hits: (out) (allow-none): location for the number of cache hits
+ * @misses: (out) (allow-none): location for the number of cache misses
+ *
+ * Gets the number of operations that were answered from the caps cache and
+ * the number of cacheable operations that had to be computed since the cache
+ * size was last set.
+ *
+ * Since: 1.4
+ */
+void
+gst_caps_cache_get_stats (guint64 * hits, guint64 * misses)
+{
+  g_mutex_lock (&caps_cache_lock);
+  if (hits)
+    *hits = caps_cache_hits;
+  if (misses)
+    *misses = caps_cache_misses;
+  g_mutex_unlock (&caps_cache_lock);
+}
+
+/* interned caps, the table keeps a ref on the caps so that they stay
+ * immutable */
+static GMutex intern_lock;
+static GHashTable *intern_table;
+/* the size of the table after the last purge */
+static guint intern_purge_size;
+
+#define INTERN_MIN_PURGE_SIZE 64
+
+/* hashes @value so that values that gst_value_compare() considers equal get
+ * the same hash. Types that can't be hashed that way don't add anything. */
+static guint
+gst_caps_hash_value (const GValue * value)
+{
+  GType type = G_VALUE_TYPE (value);
+  const gchar *str;
+  guint h, i, n;
+
+  switch (G_TYPE_FUNDAMENTAL (type)) {
+    case G_TYPE_BOOLEAN:
+      return g_value_get_boolean (value) != FALSE;
+    case G_TYPE_INT:
+      return (guint) g_value_get_int (value);
+    case G_TYPE_UINT:
+      return g_value_get_uint (value);
+    case G_TYPE_ENUM:
+      return (guint) g_value_get_enum (value);
+    case G_TYPE_FLAGS:
+      return g_value_get_flags (value);
+    case G_TYPE_CHAR:
+      return (guint) g_value_get_schar (value);
+    case G_TYPE_UCHAR:
+      return g_value_get_uchar (value);
+    case G_TYPE_LONG:
+      return (guint) g_value_get_long (value);
+    case G_TYPE_ULONG:
+      return (guint) g_value_get_ulong (value);
+    case G_TYPE_INT64:
+    case G_TYPE_UINT64:
+      return g_int64_hash (&value->data[0].v_int64);
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:{
+      gdouble d = G_TYPE_FUNDAMENTAL (type) == G_TYPE_FLOAT ?
+          g_value_get_float (value) : g_value_get_double (value);
+
+      /* 0.0 and -0.0 compare equal */
+      if (d == 0.0)
+        d = 0.0;
+      return g_double_hash (&d);
+    }
+    case G_TYPE_STRING:
+      str = g_value_get_string (value);
+      return str ? g_str_hash (str) : 0;
+    default:
+      break;
+  }
+
+  /* fractions are reduced when set */
+  if (type == GST_TYPE_FRACTION)
+    return (guint) value->data[0].v_int * 31 + (guint) value->data[1].v_int;
+
+  if (type == GST_TYPE_ARRAY) {
+    n = gst_value_array_get_size (value);
+    for (i = 0, h = n; i < n; i++)
+      h = h * 31 + gst_caps_hash_value (gst_value_array_get_value (value, i));
+    return h;
+  }
+
+  return 0;
+}
+
+/* a hash that does not depend on the order of the fields and that is the
+ * same for caps that are equal with gst_caps_is_equal_fixed() */
+static guint
+gst_caps_hash_fixed (const GstCaps * caps)
+{
+  GstStructure *structure;
+  GstCapsFeatures *features;
+  guint h, i, n;
+
+  structure = gst_caps_get_structure_unchecked (caps, 0);
+  features = gst_caps_get_features_unchecked (caps, 0);
+
+  h = g_str_hash (gst_structure_get_name (structure));
+
+  n = gst_structure_n_fields (structure);
+  for (i = 0; i < n; i++) {
+    const gchar *name = gst_structure_nth_field_name (structure, i);
+
+    h ^= g_str_hash (name) * 31 +
+        gst_caps_hash_value (gst_structure_get_value (structure, name));
+  }
+
+  /* the features are compared without looking at their order */
+  if (features && !gst_caps_features_is_equal (features,
+          GST_CAPS_FEATURES_MEMORY_SYSTEM_MEMORY)) {
+    n = gst_caps_features_get_size (features);
+    for (i = 0; i < n; i++)
+      h ^= g_str_hash (gst_caps_features_get_nth (features, i)) * 17;
+  }
+
+  return h;
+}
+
+static guint
+intern_hash (gconstpointer key)
+{
+  return GST_CAPS_HASH (key);
+}
+
+static gboolean
+intern_equal (gconstpointer a, gconstpointer b)
+{
+  return gst_caps_is_equal_fixed (a, b);
+}
+
+static gboolean
+intern_is_unused (gpointer key, gpointer value, gpointer user_data)
+{
+  GstCaps *caps = key;
+
+  /* only the table has a ref, nobody else can get to these caps */
+  if (GST_CAPS_REFCOUNT_VALUE (caps) == 1) {
+    gst_caps_unref (caps);
+    return TRUE;
+  }
+  return FALSE;
+}
+
+/**
+ * gst_caps_intern:
+ * @caps: (transfer full): fixed #GstCaps
+ *
+ * Gets the canonical instance of @caps. All interned caps that are equal are
+ * the same #GstCaps, which makes gst_caps_is_equal() on them a pointer
+ * comparison and keeps only one copy of them in memory. The interned caps are
+ * not writable, gst_caps_make_writable() makes a copy that is not interned.
+ *
+ * Interning takes some time to look up the caps, it is only worth it for caps
+ * that are compared or kept around a lot. Caps that are not fixed are
+ * returned unchanged.
+ *
+ * Returns: (transfer full): the interned caps equal to @caps.
+ *
+ * Since: 1.4
+ */
+GstCaps *
+gst_caps_intern (GstCaps * caps)
+{
+  GstCaps *interned;
+
+  g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
+
+  if (GST_CAPS_INTERNED (caps) || !gst_caps_is_fixed (caps))
+    return caps;
+
+  /* this is done outside of the lock, the caps can't change because we own
+   * a ref and nobody else may modify them while we use them */
+  GST_CAPS_HASH (caps) = gst_caps_hash_fixed (caps);
+
+  g_mutex_lock (&intern_lock);
+  if (G_UNLIKELY (intern_table == NULL))
+    intern_table = g_hash_table_new (intern_hash, intern_equal);
+
+  interned = g_hash_table_lookup (intern_table, caps);
+  if (interned) {
+    gst_caps_ref (interned);
+    g_mutex_unlock (&intern_lock);
+
+    GST_CAT_TRACE (GST_CAT_CAPS, "caps %p interned as %p", caps, interned);
+    gst_caps_unref (caps);
+    return interned;
+  }
+
+  /* drop the caps that are not used anymore once the table doubled */
+  if (g_hash_table_size (intern_table) >=
+      MAX (INTERN_MIN_PURGE_SIZE, 2 * intern_purge_size)) {
+    g_hash_table_foreach_remove (intern_table, intern_is_unused, NULL);
+    intern_purge_size = g_hash_table_size (intern_table);
+    GST_CAT_DEBUG (GST_CAT_CAPS, "%u interned caps left after purge",
+        intern_purge_size);
+  }
+
+  GST_CAPS_INTERNED (caps) = TRUE;
+  g_hash_table_add (intern_table, gst_caps_ref (caps));
+  g_mutex_unlock (&intern_lock);
+
+  GST_CAT_TRACE (GST_CAT_CAPS, "interned caps %p", caps);
+
+  return caps;
+}
+
+/**
+ * gst_caps_is_interned:
+ * @caps: a #GstCaps
+ *
+ * Checks if @caps was returned by gst_caps_intern().
+ *
+ * Returns: %TRUE if @caps are interned
+ *
+ * Since: 1.4
+ */
+gboolean
+gst_caps_is_interned (const GstCaps * caps)
+{
+  g_return_val_if_fail (GST_IS_CAPS (caps), FALSE);
+
+  return GST_CAPS_INTERNED (caps);
+}
+
+void
+_priv_gst_caps_cleanup (void)
+{
+  /* release the caps held by the caps cache */
+  gst_caps_cache_set_size (0);
+
+  g_mutex_lock (&intern_lock);
+  if (intern_table) {
+    g_hash_table_foreach (intern_table, (GHFunc) gst_caps_unref, NULL);
+    g_hash_table_destroy (intern_table);
+    intern_table = NULL;
+    intern_purge_size = 0;
+  }
+  g_mutex_unlock (&intern_lock);
+}
+
 void
 _priv_gst_caps_initialize (void)
 {
+  const gchar *env;
+
   _gst_caps_type = gst_caps_get_type ();
 
   _gst_caps_any = gst_caps_new_any ();
@@ -150,6 +602,9 @@ _priv_gst_caps_initialize (void)
 
   g_value_register_transform_func (_gst_caps_type,
       G_TYPE_STRING, gst_caps_transform_to_string);
+
+  if ((env = g_getenv ("GST_CAPS_CACHE_SIZE")) != NULL)
+    gst_caps_cache_set_size (atoi (env));
 }
 
 static GstCaps *
@@ -224,6 +679,8 @@ gst_caps_init (GstCaps * caps)
    */
   GST_CAPS_ARRAY (caps) =
       g_array_new (FALSE, TRUE, sizeof (GstCapsArrayElement));
+  GST_CAPS_INTERNED (caps) = FALSE;
+  GST_CAPS_HASH (caps) = 0;
 }
 
 /**
@@ -1151,6 +1608,10 @@ gst_caps_is_equal_fixed (const GstCaps * caps1, const GstCaps * caps2)
   g_return_val_if_fail (gst_caps_is_fixed (caps1), FALSE);
   g_return_val_if_fail (gst_caps_is_fixed (caps2), FALSE);
 
+  /* equal interned caps are the same caps */
+  if (GST_CAPS_INTERNED (caps1) && GST_CAPS_INTERNED (caps2))
+    return caps1 == caps2;
+
   struct1 = gst_caps_get_structure_unchecked (caps1, 0);
   features1 = gst_caps_get_features_unchecked (caps1, 0);
   if (!features1)
@@ -1209,6 +1670,13 @@ gst_caps_is_subset (const GstCaps * subset, const GstCaps * superset)
   if (CAPS_IS_ANY (subset) || CAPS_IS_EMPTY (superset))
     return FALSE;
 
+  if (G_UNLIKELY (CAPS_CACHE_ENABLED ())
+      && CAPS_CACHE_CAN_CACHE (subset, superset)) {
+    if (caps_cache_lookup (subset, superset, CACHE_OP_IS_SUBSET, NULL, &ret))
+      return ret;
+    ret = TRUE;
+  }
+
   for (i = GST_CAPS_LEN (subset) - 1; i >= 0; i--) {
     for (j = GST_CAPS_LEN (superset) - 1; j >= 0; j--) {
       s1 = gst_caps_get_structure_unchecked (subset, i);
@@ -1235,6 +1703,10 @@ gst_caps_is_subset (const GstCaps * subset, const GstCaps * superset)
     }
   }
 
+  if (G_UNLIKELY (CAPS_CACHE_ENABLED ())
+      && CAPS_CACHE_CAN_CACHE (subset, superset))
+    caps_cache_insert (subset, superset, CACHE_OP_IS_SUBSET, NULL, ret);
+
   return ret;
 }
 
@@ -1340,6 +1812,10 @@ gst_caps_is_equal (const GstCaps * caps1, const GstCaps * caps2)
   if (G_UNLIKELY (caps1 == caps2))
     return TRUE;
 
+  /* equal interned caps are the same caps */
+  if (GST_CAPS_INTERNED (caps1) && GST_CAPS_INTERNED (caps2))
+    return FALSE;
+
   if (G_UNLIKELY (gst_caps_is_fixed (caps1) && gst_caps_is_fixed (caps2)))
     return gst_caps_is_equal_fixed (caps1, caps2);
 
@@ -1368,6 +1844,9 @@ gst_caps_is_strictly_equal (const GstCaps * caps1, const GstCaps * caps2)
   if (G_UNLIKELY (caps1 == caps2))
     return TRUE;
 
+  if (GST_CAPS_INTERNED (caps1) && GST_CAPS_INTERNED (caps2))
+    return FALSE;
+
   if (GST_CAPS_LEN (caps1) != GST_CAPS_LEN (caps2))
     return FALSE;
 
@@ -1402,8 +1881,29 @@ gst_caps_is_strictly_equal (const GstCaps * caps1, const GstCaps * caps2)
  *
  * Returns: %TRUE if intersection would be not empty
  */
+static gboolean gst_caps_can_intersect_uncached (const GstCaps * caps1,
+    const GstCaps * caps2);
+
 gboolean
 gst_caps_can_intersect (const GstCaps * caps1, const GstCaps * caps2)
+{
+  gboolean res;
+
+  if (G_UNLIKELY (CAPS_CACHE_ENABLED ()) && GST_IS_CAPS (caps1)
+      && GST_IS_CAPS (caps2) && CAPS_CACHE_CAN_CACHE (caps1, caps2)) {
+    if (caps_cache_lookup (caps1, caps2, CACHE_OP_CAN_INTERSECT, NULL, &res))
+      return res;
+
+    res = gst_caps_can_intersect_uncached (caps1, caps2);
+    caps_cache_insert (caps1, caps2, CACHE_OP_CAN_INTERSECT, NULL, res);
+    return res;
+  }
+
+  return gst_caps_can_intersect_uncached (caps1, caps2);
+}
+
+static gboolean
+gst_caps_can_intersect_uncached (const GstCaps * caps1, const GstCaps * caps2)
 {
   guint64 i;                    /* index can be up to 2 * G_MAX_UINT */
   guint j, k, len1, len2;
@@ -1655,6 +2155,27 @@ gst_caps_intersect_full (GstCaps * caps1, GstCaps * caps2,
   g_return_val_if_fail (GST_IS_CAPS (caps1), NULL);
   g_return_val_if_fail (GST_IS_CAPS (caps2), NULL);
 
+  if (G_UNLIKELY (CAPS_CACHE_ENABLED ()) && CAPS_CACHE_CAN_CACHE (caps1, caps2)
+      && (mode == GST_CAPS_INTERSECT_FIRST
+          || mode == GST_CAPS_INTERSECT_ZIG_ZAG)) {
+    GstCapsCacheOp op;
+    GstCaps *res;
+
+    op = mode == GST_CAPS_INTERSECT_FIRST ? CACHE_OP_INTERSECT_FIRST :
+        CACHE_OP_INTERSECT_ZIG_ZAG;
+
+    if (caps_cache_lookup (caps1, caps2, op, &res, NULL))
+      return res;
+
+    if (mode == GST_CAPS_INTERSECT_FIRST)
+      res = gst_caps_intersect_first (caps1, caps2);
+    else
+      res = gst_caps_intersect_zig_zag (caps1, caps2);
+
+    caps_cache_insert (caps1, caps2, op, res, FALSE);
+    return res;
+  }
+
   switch (mode) {
     case GST_CAPS_INTERSECT_FIRST:
       return gst_caps_intersect_first (caps1, caps2);
@@ -2348,6 +2869,70 @@ gst_caps_from_string (const gchar * string)
   }
 }
 
+/**
+ * gst_caps_to_bytes:
+ * @caps: a #GstCaps
+ *
+ * Serializes @caps, including the caps features, into a compact, versioned
+ * binary representation that can be turned back into caps with
+ * gst_caps_from_bytes(). This is considerably faster to create and to parse
+ * than the string representation of gst_caps_to_string().
+ *
+ * Returns: (transfer full): a new #GBytes or NULL when a field could not be
+ *     serialized. Free with g_bytes_unref() after use.
+ *
+ * Since: 1.4
+ */
+GBytes *
+gst_caps_to_bytes (const GstCaps * caps)
+{
+  GByteArray *array;
+
+  g_return_val_if_fail (GST_IS_CAPS (caps), NULL);
+
+  array = g_byte_array_sized_new (256);
+  _priv_gst_binary_write_header (array, GST_BINARY_KIND_CAPS);
+  if (!_priv_gst_binary_write_caps (array, caps)) {
+    g_byte_array_unref (array);
+    return NULL;
+  }
+  return g_byte_array_free_to_bytes (array);
+}
+
+/**
+ * gst_caps_from_bytes:
+ * @data: (array length=size): data created with gst_caps_to_bytes()
+ * @size: the size of @data
+ * @consumed: (out) (allow-none): the number of bytes that were parsed
+ *
+ * Creates a #GstCaps from the binary representation created with
+ * gst_caps_to_bytes(). The data is parsed in place, for example directly
+ * from a mapped #GstBuffer. Since the data can be followed by other data,
+ * the number of bytes that were used can be retrieved with @consumed.
+ *
+ * Returns: (transfer full): a new #GstCaps or NULL when the data could not
+ *     be parsed.
+ *
+ * Since: 1.4
+ */
+GstCaps *
+gst_caps_from_bytes (const guint8 * data, gsize size, gsize * consumed)
+{
+  GstBinaryReader reader = { data, size, 0 };
+  GstCaps *caps;
+
+  g_return_val_if_fail (data != NULL || size == 0, NULL);
+
+  if (!_priv_gst_binary_read_header (&reader, GST_BINARY_KIND_CAPS))
+    return NULL;
+
+  caps = _priv_gst_binary_read_caps (&reader);
+  if (caps && consumed)
+    *consumed = reader.pos;
+
+  return caps;
+}
+
 static void
 gst_caps_transform_to_string (const GValue * src_value, GValue * dest_value)
 {
@@ -456,6 +456,20 @@ GstCaps *         gst_caps_fixate                  (GstCaps *caps) G_GNUC_WARN_U
 /* utility */
 gchar *           gst_caps_to_string               (const GstCaps *caps) G_GNUC_MALLOC;
 GstCaps *         gst_caps_from_string             (const gchar   *string) G_GNUC_WARN_UNUSED_RESULT;
+GBytes *          gst_caps_to_bytes                (const GstCaps *caps) G_GNUC_MALLOC;
+GstCaps *         gst_caps_from_bytes              (const guint8  *data,
+                                                    gsize          size,
+                                                    gsize         *consumed) G_GNUC_WARN_UNUSED_RESULT;
+
+/* interning */
+GstCaps *         gst_caps_intern                  (GstCaps *caps) G_GNUC_WARN_UNUSED_RESULT;
+gboolean          gst_caps_is_interned             (const GstCaps *caps);
+
+/* operation cache */
+void              gst_caps_cache_set_size          (guint size);
+void              gst_caps_cache_clear             (void);
+void              gst_caps_cache_get_stats         (guint64 *hits,
+                                                    guint64 *misses);
 
 G_END_DECLS
 
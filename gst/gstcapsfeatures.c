@@ -113,8 +113,8 @@ gst_is_caps_features (gconstpointer obj)
   return (obj != NULL && features->type == _gst_caps_features_type);
 }
 
-static gboolean
-gst_caps_feature_name_is_valid (const gchar * feature)
+gboolean
+priv_gst_caps_feature_name_is_valid (const gchar * feature)
 {
 #ifndef G_DISABLE_CHECKS
   while (TRUE) {
@@ -781,7 +781,7 @@ gst_caps_features_add_id (GstCapsFeatures * features, GQuark feature)
   g_return_if_fail (feature != 0);
   g_return_if_fail (!features->is_any);
 
-  if (!gst_caps_feature_name_is_valid (g_quark_to_string (feature))) {
+  if (!priv_gst_caps_feature_name_is_valid (g_quark_to_string (feature))) {
     g_warning ("Invalid caps feature name: %s", g_quark_to_string (feature));
     return;
   }
@@ -0,0 +1,504 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * gstmagazine.c: Per-thread caches of memory blocks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Small memory blocks, such as the GstBuffer structures and the system memory
+ * blocks, are allocated and freed at a high rate from many streaming threads.
+ * Instead of going to the global allocator for each of them, the blocks are
+ * kept in per-thread magazines: fixed size stacks of free blocks of one size
+ * class.
+ *
+ * Each thread has a loaded and a previous magazine per size class. Allocations
+ * and frees use the loaded magazine and swap it with the previous one when it
+ * runs empty or full. Only when both are empty or full, a full or an empty
+ * magazine is exchanged with the global depot of the size class. Blocks freed
+ * by another thread than the one that allocated them end up in a magazine of
+ * the freeing thread and travel back through the depot.
+ *
+ * Blocks larger than the biggest size class go straight to g_slice. The cache
+ * is disabled when running in valgrind or when G_SLICE=always-malloc is set so
+ * that memory debugging tools see every allocation.
+ *
+ * The cached memory is bounded. A thread that caches more than
+ * THREAD_BYTES_MAX hands magazines to the depot until it is below half of
+ * that, and the depot frees the blocks of magazines that would take it over
+ * DEPOT_BYTES_MAX. The magazines of exiting threads go to the depot too, so
+ * they are subject to the same limit.
+ *
+ * The amount of allocations that were served from the thread magazines, from
+ * the depot and from g_slice can be retrieved with
+ * gst_allocator_get_cache_stats() and are logged in the GST_PERFORMANCE
+ * category when GStreamer is deinitialized. Threads add their counters to the
+ * totals in batches, so the totals lag behind by a few allocations per
+ * thread.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "gst_private.h"
+#include "gstmagazine.h"
+
+#define GST_CAT_DEFAULT GST_CAT_MEMORY
+
+/* the size classes, 4 classes for each power of 2 between the smallest and
+ * the largest size */
+#define MIN_SIZE_BITS       6
+#define MAX_SIZE_BITS       16
+#define MIN_SIZE            (1 << MIN_SIZE_BITS)
+#define MAX_SIZE            (1 << MAX_SIZE_BITS)
+#define N_SUBCLASSES        4
+#define N_CLASSES           (1 + (MAX_SIZE_BITS - MIN_SIZE_BITS) * N_SUBCLASSES)
+
+/* the amount of memory in one magazine, limited by the min and max amount of
+ * blocks in a magazine */
+#define MAGAZINE_BYTES      (64 * 1024)
+#define MAGAZINE_MIN        4
+#define MAGAZINE_MAX        64
+
+/* max amount of full and empty magazines in the depot of a size class */
+#define DEPOT_MAX           16
+
+/* max amount of memory in the blocks of the depot and of the magazines of
+ * one thread */
+#define DEPOT_BYTES_MAX     (4 * 1024 * 1024)
+#define THREAD_BYTES_MAX    (1024 * 1024)
+
+/* thread counters are added to the totals after this many hits */
+#define STATS_FLUSH         1024
+
+typedef struct _GstMagazine GstMagazine;
+
+struct _GstMagazine
+{
+  GstMagazine *next;
+  guint n_blocks;
+  gpointer blocks[1];
+};
+
+typedef struct
+{
+  GMutex lock;
+  GstMagazine *full;
+  guint n_full;
+  GstMagazine *empty;
+  guint n_empty;
+} GstMagazineDepot;
+
+typedef struct
+{
+  GstMagazine *loaded[N_CLASSES];
+  GstMagazine *previous[N_CLASSES];
+  /* bytes in the blocks of the magazines above */
+  gsize cached;
+
+  /* counters since the last flush to the global counters */
+  guint64 hits;
+  guint64 depot_hits;
+  guint64 misses;
+} GstMagazineThread;
+
+static void magazine_thread_free (GstMagazineThread * thread);
+
+static gboolean magazines_enabled = FALSE;
+static gsize class_size[N_CLASSES];
+static guint class_capacity[N_CLASSES];
+static GstMagazineDepot depots[N_CLASSES];
+/* bytes in the blocks of all depots, updated atomically */
+static gint depot_bytes;
+static GPrivate magazine_thread =
+G_PRIVATE_INIT ((GDestroyNotify) magazine_thread_free);
+
+static GMutex stats_lock;
+static guint64 total_hits;
+static guint64 total_depot_hits;
+static guint64 total_misses;
+
+/* get the size class of @size, -1 when it is too big to be cached */
+static inline gint
+size_to_class (gsize size)
+{
+  guint bits;
+
+  if (size <= MIN_SIZE)
+    return 0;
+  if (size > MAX_SIZE)
+    return -1;
+
+  /* 2^bits < size <= 2^(bits + 1) */
+  bits = g_bit_storage (size - 1) - 1;
+
+  return 1 + (bits - MIN_SIZE_BITS) * N_SUBCLASSES +
+      (size - 1 - ((gsize) 1 << bits)) / ((gsize) 1 << (bits - 2));
+}
+
+static void
+magazine_thread_flush_stats (GstMagazineThread * thread)
+{
+  g_mutex_lock (&stats_lock);
+  total_hits += thread->hits;
+  total_depot_hits += thread->depot_hits;
+  total_misses += thread->misses;
+  g_mutex_unlock (&stats_lock);
+
+  thread->hits = thread->depot_hits = thread->misses = 0;
+}
+
+static void
+magazine_free_blocks (gint c, GstMagazine * mag)
+{
+  while (mag->n_blocks)
+    g_slice_free1 (class_size[c], mag->blocks[--mag->n_blocks]);
+}
+
+/* get a magazine with blocks from the depot, NULL when there is none */
+static GstMagazine *
+depot_get_full (gint c)
+{
+  GstMagazineDepot *depot = &depots[c];
+  GstMagazine *mag;
+
+  g_mutex_lock (&depot->lock);
+  if ((mag = depot->full)) {
+    depot->full = mag->next;
+    depot->n_full--;
+  }
+  g_mutex_unlock (&depot->lock);
+
+  if (mag)
+    g_atomic_int_add (&depot_bytes, -(gint) (mag->n_blocks * class_size[c]));
+
+  return mag;
+}
+
+/* get an empty magazine from the depot or make a new one */
+static GstMagazine *
+depot_get_empty (gint c)
+{
+  GstMagazineDepot *depot = &depots[c];
+  GstMagazine *mag;
+
+  g_mutex_lock (&depot->lock);
+  if ((mag = depot->empty)) {
+    depot->empty = mag->next;
+    depot->n_empty--;
+  }
+  g_mutex_unlock (&depot->lock);
+
+  if (mag == NULL) {
+    mag = g_malloc (G_STRUCT_OFFSET (GstMagazine, blocks) +
+        class_capacity[c] * sizeof (gpointer));
+    mag->n_blocks = 0;
+  }
+  mag->next = NULL;
+
+  return mag;
+}
+
+/* give @mag back to the depot, blocks that don't fit in the depot are freed.
+ * Concurrent puts can take the depot slightly over DEPOT_BYTES_MAX. */
+static void
+depot_put (gint c, GstMagazine * mag)
+{
+  GstMagazineDepot *depot = &depots[c];
+  gint bytes = mag->n_blocks * class_size[c];
+
+  g_mutex_lock (&depot->lock);
+  if (mag->n_blocks > 0) {
+    if (depot->n_full < DEPOT_MAX &&
+        g_atomic_int_get (&depot_bytes) + bytes <= DEPOT_BYTES_MAX) {
+      mag->next = depot->full;
+      depot->full = mag;
+      depot->n_full++;
+      g_atomic_int_add (&depot_bytes, bytes);
+      mag = NULL;
+    } else {
+      g_mutex_unlock (&depot->lock);
+      GST_CAT_LOG (GST_CAT_PERFORMANCE, "depot of size %" G_GSIZE_FORMAT
+          " full, freeing %u blocks", class_size[c], mag->n_blocks);
+      magazine_free_blocks (c, mag);
+      g_mutex_lock (&depot->lock);
+    }
+  }
+  if (mag != NULL) {
+    if (depot->n_empty < DEPOT_MAX) {
+      mag->next = depot->empty;
+      depot->empty = mag;
+      depot->n_empty++;
+      mag = NULL;
+    }
+  }
+  g_mutex_unlock (&depot->lock);
+
+  g_free (mag);
+}
+
+static GstMagazineThread *
+magazine_thread_get (void)
+{
+  GstMagazineThread *thread;
+
+  if (G_UNLIKELY ((thread = g_private_get (&magazine_thread)) == NULL)) {
+    thread = g_new0 (GstMagazineThread, 1);
+    g_private_set (&magazine_thread, thread);
+  }
+  return thread;
+}
+
+/* hand magazines over to the depot until the thread caches less than half
+ * of THREAD_BYTES_MAX. The magazines that are not loaded go first, the
+ * loaded magazine of @current is kept. */
+static void
+magazine_thread_trim (GstMagazineThread * thread, gint current)
+{
+  gint c;
+
+  GST_CAT_LOG (GST_CAT_PERFORMANCE, "thread caches %" G_GSIZE_FORMAT
+      " bytes, trimming", thread->cached);
+
+  for (c = 0; c < N_CLASSES && thread->cached > THREAD_BYTES_MAX / 2; c++) {
+    if (thread->previous[c] && thread->previous[c]->n_blocks > 0) {
+      thread->cached -= thread->previous[c]->n_blocks * class_size[c];
+      depot_put (c, thread->previous[c]);
+      thread->previous[c] = NULL;
+    }
+  }
+  for (c = 0; c < N_CLASSES && thread->cached > THREAD_BYTES_MAX / 2; c++) {
+    if (c != current && thread->loaded[c] && thread->loaded[c]->n_blocks > 0) {
+      thread->cached -= thread->loaded[c]->n_blocks * class_size[c];
+      depot_put (c, thread->loaded[c]);
+      thread->loaded[c] = NULL;
+    }
+  }
+}
+
+/* called when the thread exits, hand all blocks over to the depot */
+static void
+magazine_thread_free (GstMagazineThread * thread)
+{
+  gint c;
+
+  for (c = 0; c < N_CLASSES; c++) {
+    if (thread->loaded[c])
+      depot_put (c, thread->loaded[c]);
+    if (thread->previous[c])
+      depot_put (c, thread->previous[c]);
+  }
+  magazine_thread_flush_stats (thread);
+  g_free (thread);
+}
+
+/*
+ * _priv_gst_magazine_alloc:
+ * @size: the size of the block
+ *
+ * Allocate a block of @size bytes, free with _priv_gst_magazine_free() and
+ * the same @size.
+ *
+ * Returns: a new block of memory.
+ */
+gpointer
+_priv_gst_magazine_alloc (gsize size)
+{
+  GstMagazineThread *thread;
+  GstMagazine *mag;
+  gint c;
+
+  if (!magazines_enabled || (c = size_to_class (size)) < 0)
+    return g_slice_alloc (size);
+
+  thread = magazine_thread_get ();
+
+  mag = thread->loaded[c];
+  if (G_LIKELY (mag != NULL && mag->n_blocks > 0)) {
+    if (G_UNLIKELY (++thread->hits >= STATS_FLUSH))
+      magazine_thread_flush_stats (thread);
+  } else if ((mag = thread->previous[c]) && mag->n_blocks > 0) {
+    thread->previous[c] = thread->loaded[c];
+    thread->loaded[c] = mag;
+    if (G_UNLIKELY (++thread->hits >= STATS_FLUSH))
+      magazine_thread_flush_stats (thread);
+  } else if ((mag = depot_get_full (c))) {
+    /* exchange the empty loaded magazine for a full one */
+    if (thread->loaded[c])
+      depot_put (c, thread->loaded[c]);
+    thread->loaded[c] = mag;
+    thread->cached += mag->n_blocks * class_size[c];
+    thread->depot_hits++;
+    magazine_thread_flush_stats (thread);
+  } else {
+    if (G_UNLIKELY (++thread->misses >= MAGAZINE_MAX))
+      magazine_thread_flush_stats (thread);
+    return g_slice_alloc (class_size[c]);
+  }
+  thread->cached -= class_size[c];
+  return mag->blocks[--mag->n_blocks];
+}
+
+/*
+ * _priv_gst_magazine_free:
+ * @size: the size of the block
+ * @mem: a block of @size bytes from _priv_gst_magazine_alloc()
+ *
+ * Free @mem. This can be called from another thread than the one that
+ * allocated @mem.
+ */
+void
+_priv_gst_magazine_free (gsize size, gpointer mem)
+{
+  GstMagazineThread *thread;
+  GstMagazine *mag;
+  gint c;
+
+  if (!magazines_enabled || (c = size_to_class (size)) < 0) {
+    g_slice_free1 (size, mem);
+    return;
+  }
+
+  thread = magazine_thread_get ();
+
+  mag = thread->loaded[c];
+  if (G_UNLIKELY (mag == NULL || mag->n_blocks == class_capacity[c])) {
+    if ((mag = thread->previous[c]) && mag->n_blocks < class_capacity[c]) {
+      thread->previous[c] = thread->loaded[c];
+      thread->loaded[c] = mag;
+    } else {
+      /* both are full, the previous one goes to the depot and we continue
+       * with an empty one */
+      if (thread->previous[c]) {
+        thread->cached -= thread->previous[c]->n_blocks * class_size[c];
+        depot_put (c, thread->previous[c]);
+      }
+      thread->previous[c] = thread->loaded[c];
+      thread->loaded[c] = mag = depot_get_empty (c);
+    }
+  }
+  mag->blocks[mag->n_blocks++] = mem;
+  thread->cached += class_size[c];
+
+  if (G_UNLIKELY (thread->cached > THREAD_BYTES_MAX))
+    magazine_thread_trim (thread, c);
+}
+
+/*
+ * _priv_gst_magazine_get_stats:
+ * @hits: (out): allocations served from the thread magazines
+ * @depot_hits: (out): allocations served from the depot
+ * @misses: (out): allocations that went to g_slice
+ * @cached: (out): bytes in the blocks of the depot
+ *
+ * Get the counters of all threads. The counters of the calling thread are
+ * up to date, those of other threads lag behind a bit.
+ *
+ * Returns: %TRUE when the magazines are enabled.
+ */
+gboolean
+_priv_gst_magazine_get_stats (guint64 * hits, guint64 * depot_hits,
+    guint64 * misses, guint64 * cached)
+{
+  GstMagazineThread *thread;
+
+  if (magazines_enabled && (thread = g_private_get (&magazine_thread)))
+    magazine_thread_flush_stats (thread);
+
+  g_mutex_lock (&stats_lock);
+  *hits = total_hits;
+  *depot_hits = total_depot_hits;
+  *misses = total_misses;
+  g_mutex_unlock (&stats_lock);
+  *cached = g_atomic_int_get (&depot_bytes);
+
+  return magazines_enabled;
+}
+
+void
+_priv_gst_magazine_initialize (void)
+{
+  const gchar *env;
+  gint c;
+
+  /* memory debuggers want to see all allocations */
+  env = g_getenv ("G_SLICE");
+  magazines_enabled = !_priv_gst_in_valgrind () &&
+      !(env && strstr (env, "always-malloc"));
+
+  for (c = 0; c < N_CLASSES; c++) {
+    if (c == 0) {
+      class_size[c] = MIN_SIZE;
+    } else {
+      guint bits = MIN_SIZE_BITS + (c - 1) / N_SUBCLASSES;
+      gsize step = (gsize) 1 << (bits - 2);
+
+      class_size[c] = ((gsize) 1 << bits) + ((c - 1) % N_SUBCLASSES + 1) * step;
+    }
+    class_capacity[c] =
+        CLAMP (MAGAZINE_BYTES / class_size[c], MAGAZINE_MIN, MAGAZINE_MAX);
+  }
+
+  GST_DEBUG ("magazines %s, %d size classes up to %d bytes",
+      magazines_enabled ? "enabled" : "disabled", N_CLASSES, MAX_SIZE);
+}
+
+void
+_priv_gst_magazine_deinit (void)
+{
+  GstMagazineThread *thread;
+  guint64 total;
+  gint c;
+
+  if (!magazines_enabled)
+    return;
+
+  if ((thread = g_private_get (&magazine_thread)))
+    magazine_thread_flush_stats (thread);
+
+  g_mutex_lock (&stats_lock);
+  total = total_hits + total_depot_hits + total_misses;
+  GST_CAT_INFO (GST_CAT_PERFORMANCE, "magazine allocations: %" G_GUINT64_FORMAT
+      " thread hits, %" G_GUINT64_FORMAT " depot hits, %" G_GUINT64_FORMAT
+      " misses, hit rate %.2f%%", total_hits, total_depot_hits, total_misses,
+      total ? 100.0 * (total_hits + total_depot_hits) / total : 0.0);
+  g_mutex_unlock (&stats_lock);
+
+  /* free the blocks in the depots, the magazines of threads that are still
+   * running are returned to the depot when they exit */
+  for (c = 0; c < N_CLASSES; c++) {
+    GstMagazineDepot *depot = &depots[c];
+    GstMagazine *mag;
+
+    g_mutex_lock (&depot->lock);
+    while ((mag = depot->full)) {
+      depot->full = mag->next;
+      magazine_free_blocks (c, mag);
+      g_free (mag);
+    }
+    depot->n_full = 0;
+    while ((mag = depot->empty)) {
+      depot->empty = mag->next;
+      g_free (mag);
+    }
+    depot->n_empty = 0;
+    g_mutex_unlock (&depot->lock);
+  }
+  g_atomic_int_set (&depot_bytes, 0);
+}
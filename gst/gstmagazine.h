@@ -0,0 +1,39 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * gstmagazine.h: Per-thread caches of memory blocks. Private header.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+#ifndef __GST_MAGAZINE_H__
+#define __GST_MAGAZINE_H__
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+G_GNUC_INTERNAL void      _priv_gst_magazine_initialize (void);
+G_GNUC_INTERNAL void      _priv_gst_magazine_deinit     (void);
+
+G_GNUC_INTERNAL gpointer  _priv_gst_magazine_alloc      (gsize size);
+G_GNUC_INTERNAL void      _priv_gst_magazine_free       (gsize size, gpointer mem);
+
+G_GNUC_INTERNAL gboolean  _priv_gst_magazine_get_stats  (guint64 * hits, guint64 * depot_hits,
+                                                         guint64 * misses, guint64 * cached);
+
+G_END_DECLS
+
+#endif /* __GST_MAGAZINE_H__ */
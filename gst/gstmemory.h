@@ -47,6 +47,7 @@ typedef struct _GstAllocator GstAllocator;
  * @GST_MEMORY_FLAG_ZERO_PADDED: the memory padding is filled with 0 bytes
  * @GST_MEMORY_FLAG_PHYSICALLY_CONTIGUOUS: the memory is physically contiguous. Since 1.2
  * @GST_MEMORY_FLAG_NOT_MAPPABLE: the memory can't be mapped via gst_memory_map() without any preconditions. Since 1.2
+ * @GST_MEMORY_FLAG_HUGE_PAGES: the memory is backed by huge pages where the system provides them and prefers the NUMA node of the allocating thread. In #GstAllocationParams for the system memory allocator, large blocks are allocated with the #GST_ALLOCATOR_SYSMEM_HUGE allocator. Since 1.4
  * @GST_MEMORY_FLAG_LAST: first flag that can be used for custom purposes
  *
  * Flags for wrapped memory.
@@ -58,6 +59,7 @@ typedef enum {
   GST_MEMORY_FLAG_ZERO_PADDED   = (GST_MINI_OBJECT_FLAG_LAST << 2),
   GST_MEMORY_FLAG_PHYSICALLY_CONTIGUOUS = (GST_MINI_OBJECT_FLAG_LAST << 3),
   GST_MEMORY_FLAG_NOT_MAPPABLE  = (GST_MINI_OBJECT_FLAG_LAST << 4),
+  GST_MEMORY_FLAG_HUGE_PAGES    = (GST_MINI_OBJECT_FLAG_LAST << 5),
 
   GST_MEMORY_FLAG_LAST          = (GST_MINI_OBJECT_FLAG_LAST << 16)
 } GstMemoryFlags;
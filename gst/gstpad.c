@@ -141,8 +141,20 @@ struct _GstPadPrivate
   gint using;
   guint probe_list_cookie;
   guint probe_cookie;
+  /* the union of the masks of all installed probes */
+  GstPadProbeType probe_mask;
+
+  /* histogram of the time spent downstream of the pad, indexed by the
+   * number of bits of the time in nanoseconds */
+  guint64 *latency;
+  guint64 latency_count;
+  GstClockTime latency_total;
 };
 
+#define LATENCY_BUCKETS 40
+/* number of pushes after which the histogram is logged again */
+#define LATENCY_LOG_INTERVAL (1 << 16)
+
 typedef struct
 {
   GHook hook;
@@ -182,6 +194,9 @@ static guint gst_pad_signals[LAST_SIGNAL] = { 0 };
 
 static GParamSpec *pspec_caps = NULL;
 
+/* GST_PAD_LATENCY_HISTOGRAM is set */
+static gboolean latency_histogram = FALSE;
+
 /* quarks for probe signals */
 static GQuark buffer_quark;
 static GQuark buffer_list_quark;
@@ -281,6 +296,8 @@ gst_pad_class_init (GstPadClass * klass)
 
   g_type_class_add_private (klass, sizeof (GstPadPrivate));
 
+  latency_histogram = (g_getenv ("GST_PAD_LATENCY_HISTOGRAM") != NULL);
+
   gobject_class->dispose = gst_pad_dispose;
   gobject_class->finalize = gst_pad_finalize;
   gobject_class->set_property = gst_pad_set_property;
@@ -633,6 +650,50 @@ gst_pad_dispose (GObject * object)
   G_OBJECT_CLASS (parent_class)->dispose (object);
 }
 
+/* logs the latency histogram of @pad to the GST_PERFORMANCE category. Does
+ * not use the _OBJECT variants because it can be called with pad LOCK */
+static void
+log_latency (GstPad * pad)
+{
+  GstPadPrivate *priv = pad->priv;
+  guint i;
+
+  GST_CAT_INFO (GST_CAT_PERFORMANCE, "%s:%s: %" G_GUINT64_FORMAT
+      " pushes, average %" G_GUINT64_FORMAT " ns", GST_DEBUG_PAD_NAME (pad),
+      priv->latency_count, priv->latency_total / priv->latency_count);
+
+  for (i = 0; i < LATENCY_BUCKETS; i++) {
+    if (priv->latency[i] == 0)
+      continue;
+    GST_CAT_INFO (GST_CAT_PERFORMANCE, "%s:%s:   < %12" G_GUINT64_FORMAT
+        " ns: %" G_GUINT64_FORMAT, GST_DEBUG_PAD_NAME (pad),
+        G_GUINT64_CONSTANT (1) << i, priv->latency[i]);
+  }
+}
+
+/* should be called with pad LOCK */
+static void
+record_latency (GstPad * pad, GstClockTime time)
+{
+  GstPadPrivate *priv = pad->priv;
+  GstClockTime t;
+  guint bucket = 0;
+
+  if (G_UNLIKELY (priv->latency == NULL))
+    priv->latency = g_new0 (guint64, LATENCY_BUCKETS);
+
+  for (t = time; t && bucket < LATENCY_BUCKETS - 1; t >>= 1)
+    bucket++;
+
+  priv->latency[bucket]++;
+  priv->latency_count++;
+  priv->latency_total += time;
+
+  /* log periodically so that long running and leaked pads can be inspected */
+  if (priv->latency_count % LATENCY_LOG_INTERVAL == 0)
+    log_latency (pad);
+}
+
 static void
 gst_pad_finalize (GObject * object)
 {
@@ -671,6 +732,11 @@ gst_pad_finalize (GObject * object)
   g_cond_clear (&pad->block_cond);
   g_array_free (pad->priv->events, TRUE);
 
+  if (pad->priv->latency) {
+    log_latency (pad);
+    g_free (pad->priv->latency);
+  }
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -1208,6 +1274,12 @@ cleanup_hook (GstPad * pad, GHook * hook)
   }
   g_hook_destroy_link (&pad->probes, hook);
   pad->num_probes--;
+
+  /* recalculate the mask from the remaining probes */
+  pad->priv->probe_mask = 0;
+  for (hook = g_hook_first_valid (&pad->probes, TRUE); hook;
+      hook = g_hook_next_valid (&pad->probes, hook, TRUE))
+    pad->priv->probe_mask |= (hook->flags) >> G_HOOK_FLAG_USER_SHIFT;
 }
 
 /**
@@ -1263,6 +1335,7 @@ gst_pad_add_probe (GstPad * pad, GstPadProbeType mask,
   /* add the probe */
   g_hook_prepend (&pad->probes, hook);
   pad->num_probes++;
+  pad->priv->probe_mask |= mask;
   /* incremenent cookie so that the new hook get's called */
   pad->priv->probe_list_cookie++;
 
@@ -3147,10 +3220,35 @@ no_match:
   }
 }
 
+/* check if any of the installed probes could match @type. This is only a
+ * quick check against the union of all probe masks, probe_hook_marshal()
+ * does the real matching. When nothing can match, the probes are skipped
+ * without marshalling the hook list. */
+static inline gboolean
+probe_may_match (GstPad * pad, GstPadProbeType type)
+{
+  GstPadProbeType mask = pad->priv->probe_mask;
+
+  /* one of the data types for non-idle probes */
+  if ((type & GST_PAD_PROBE_TYPE_IDLE) == 0
+      && (mask & GST_PAD_PROBE_TYPE_ALL_BOTH & type) == 0)
+    return FALSE;
+  /* one of the scheduling types */
+  if ((mask & GST_PAD_PROBE_TYPE_SCHEDULING & type) == 0)
+    return FALSE;
+  /* one of the blocking types */
+  if ((type & GST_PAD_PROBE_TYPE_BLOCKING) &&
+      (mask & GST_PAD_PROBE_TYPE_BLOCKING & type) == 0)
+    return FALSE;
+
+  return TRUE;
+}
+
 /* a probe that does not take or return any data */
 #define PROBE_NO_DATA(pad,mask,label,defaultval)                \
   G_STMT_START {						\
-    if (G_UNLIKELY (pad->num_probes)) {				\
+    if (G_UNLIKELY (pad->num_probes) &&                         \
+        probe_may_match (pad, mask)) {                          \
       /* pass NULL as the data item */                          \
       GstPadProbeInfo info = { mask, 0, NULL, 0, 0 };           \
       ret = do_probe_callbacks (pad, &info, defaultval);	\
@@ -3161,7 +3259,8 @@ no_match:
 
 #define PROBE_FULL(pad,mask,data,offs,size,label)               \
   G_STMT_START {						\
-    if (G_UNLIKELY (pad->num_probes)) {				\
+    if (G_UNLIKELY (pad->num_probes) &&                         \
+        probe_may_match (pad, mask)) {                          \
       /* pass the data item */                                  \
       GstPadProbeInfo info = { mask, 0, data, offs, size };     \
       ret = do_probe_callbacks (pad, &info, GST_FLOW_OK);	\
@@ -3423,6 +3522,23 @@ push_sticky (GstPad * pad, PadEvent * ev, gpointer user_data)
   return data->ret == GST_FLOW_OK;
 }
 
+/* should be called with pad LOCK */
+static gboolean
+has_unreceived_events (GstPad * pad)
+{
+  GArray *events = pad->priv->events;
+  guint i, len;
+
+  len = events->len;
+  for (i = 0; i < len; i++) {
+    PadEvent *ev = &g_array_index (events, PadEvent, i);
+
+    if (ev->event && !ev->received)
+      return TRUE;
+  }
+  return FALSE;
+}
+
 /* check sticky events and push them when needed. should be called
  * with pad LOCK */
 static inline GstFlowReturn
@@ -3433,6 +3549,11 @@ check_sticky (GstPad * pad, GstEvent * event)
   if (G_UNLIKELY (GST_PAD_HAS_PENDING_EVENTS (pad))) {
     GST_OBJECT_FLAG_UNSET (pad, GST_PAD_FLAG_PENDING_EVENTS);
 
+    /* the flag is set conservatively, avoid taking a ref on every event
+     * when all of them were received already */
+    if (!has_unreceived_events (pad))
+      return GST_FLOW_OK;
+
     GST_DEBUG_OBJECT (pad, "pushing all sticky events");
     events_foreach (pad, push_sticky, &data);
 
@@ -3724,11 +3845,14 @@ gst_pad_chain_data_unchecked (GstPad * pad, GstPadProbeType type, void *data)
   GST_PAD_STREAM_LOCK (pad);
 
   GST_OBJECT_LOCK (pad);
-  if (G_UNLIKELY (GST_PAD_IS_FLUSHING (pad)))
-    goto flushing;
+  if (G_UNLIKELY (GST_OBJECT_FLAGS (pad) & (GST_PAD_FLAG_FLUSHING |
+              GST_PAD_FLAG_EOS))) {
+    if (G_UNLIKELY (GST_PAD_IS_FLUSHING (pad)))
+      goto flushing;
 
-  if (G_UNLIKELY (GST_PAD_IS_EOS (pad)))
-    goto eos;
+    if (G_UNLIKELY (GST_PAD_IS_EOS (pad)))
+      goto eos;
+  }
 
   if (G_UNLIKELY (GST_PAD_MODE (pad) != GST_PAD_MODE_PUSH))
     goto wrong_mode;
@@ -3956,13 +4080,18 @@ gst_pad_push_data (GstPad * pad, GstPadProbeType type, void *data)
 {
   GstPad *peer;
   GstFlowReturn ret;
+  GstClockTime start = 0;
 
   GST_OBJECT_LOCK (pad);
-  if (G_UNLIKELY (GST_PAD_IS_FLUSHING (pad)))
-    goto flushing;
+  /* a flowing pad has none of these flags set, check them at once */
+  if (G_UNLIKELY (GST_OBJECT_FLAGS (pad) & (GST_PAD_FLAG_FLUSHING |
+              GST_PAD_FLAG_EOS))) {
+    if (G_UNLIKELY (GST_PAD_IS_FLUSHING (pad)))
+      goto flushing;
 
-  if (G_UNLIKELY (GST_PAD_IS_EOS (pad)))
-    goto eos;
+    if (G_UNLIKELY (GST_PAD_IS_EOS (pad)))
+      goto eos;
+  }
 
   if (G_UNLIKELY (GST_PAD_MODE (pad) != GST_PAD_MODE_PUSH))
     goto wrong_mode;
@@ -3983,6 +4112,7 @@ gst_pad_push_data (GstPad * pad, GstPadProbeType type, void *data)
   }
 #endif
 
+  /* only walks the sticky events on the first push after they changed */
   if (G_UNLIKELY ((ret = check_sticky (pad, NULL))) != GST_FLOW_OK)
     goto events_error;
 
@@ -4004,11 +4134,16 @@ gst_pad_push_data (GstPad * pad, GstPadProbeType type, void *data)
   pad->priv->using++;
   GST_OBJECT_UNLOCK (pad);
 
+  if (G_UNLIKELY (latency_histogram))
+    start = gst_util_get_timestamp ();
+
   ret = gst_pad_chain_data_unchecked (peer, type, data);
 
   gst_object_unref (peer);
 
   GST_OBJECT_LOCK (pad);
+  if (G_UNLIKELY (latency_histogram))
+    record_latency (pad, gst_util_get_timestamp () - start);
   pad->priv->using--;
   if (pad->priv->using == 0) {
     /* pad is not active anymore, trigger idle callbacks */
@@ -50,6 +50,11 @@
  * descriptor, and gst_poll_fd_can_write() to see if it is possible to
  * write to it.
  *
+ * On Linux, non-timer sets can use epoll instead of poll() by setting the
+ * GST_POLL_MODE environment variable to "epoll". With epoll, adding, removing
+ * and changing file descriptors is applied to the kernel right away and a
+ * wait only returns the descriptors with activity, so the cost of a wait does
+ * not grow with the number of file descriptors in the set.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -67,6 +72,7 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <stdlib.h>
 
 #include <glib.h>
 
@@ -82,6 +88,12 @@
 #endif
 #include <sys/time.h>
 #include <sys/socket.h>
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#endif
+#ifdef HAVE_SYS_EVENTFD_H
+#include <sys/eventfd.h>
+#endif
 #endif
 
 /* OS/X needs this because of bad headers */
@@ -117,6 +129,7 @@ typedef enum
   GST_POLL_MODE_PSELECT,
   GST_POLL_MODE_POLL,
   GST_POLL_MODE_PPOLL,
+  GST_POLL_MODE_EPOLL,
   GST_POLL_MODE_WINDOWS
 } GstPollMode;
 
@@ -134,8 +147,17 @@ struct _GstPoll
 
 #ifndef G_OS_WIN32
   gchar buf[1];
+  /* the same fd when the control is an eventfd */
   GstPollFD control_read_fd;
   GstPollFD control_write_fd;
+#ifdef HAVE_SYS_EPOLL_H
+  /* the epoll instance, updated together with fds */
+  gint epfd;
+  /* events of epoll_wait(), only used from the waiting thread */
+  GArray *epoll_events;
+  /* active_fds only contains the fds with activity, sorted on fd */
+  gboolean active_sorted;
+#endif
 #else
   GArray *active_fds_ignored;
   GArray *events;
@@ -167,8 +189,35 @@ static gboolean gst_poll_add_fd_unlocked (GstPoll * set, GstPollFD * fd);
 #define MARK_REBUILD(s)     (g_atomic_int_set(&(s)->rebuild, 1))
 
 #ifndef G_OS_WIN32
-#define WAKE_EVENT(s)       (write ((s)->control_write_fd.fd, "W", 1) == 1)
-#define RELEASE_EVENT(s)    (read ((s)->control_read_fd.fd, (s)->buf, 1) == 1)
+static inline gboolean
+wake_event (GstPoll * set)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  if (set->control_write_fd.fd == set->control_read_fd.fd) {
+    guint64 val = 1;
+
+    return write (set->control_write_fd.fd, &val, sizeof (val)) == sizeof (val);
+  }
+#endif
+  return write (set->control_write_fd.fd, "W", 1) == 1;
+}
+
+static inline gboolean
+release_event (GstPoll * set)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+  if (set->control_write_fd.fd == set->control_read_fd.fd) {
+    guint64 val;
+
+    /* this resets the eventfd counter to 0 */
+    return read (set->control_read_fd.fd, &val, sizeof (val)) == sizeof (val);
+  }
+#endif
+  return read (set->control_read_fd.fd, set->buf, 1) == 1;
+}
+
+#define WAKE_EVENT(s)       (wake_event (s))
+#define RELEASE_EVENT(s)    (release_event (s))
 #else
 #define WAKE_EVENT(s)       (SetEvent ((s)->wakeup_event), errno = GetLastError () == NO_ERROR ? 0 : EACCES, errno == 0 ? 1 : 0)
 #define RELEASE_EVENT(s)    (ResetEvent ((s)->wakeup_event))
@@ -268,6 +317,165 @@ find_index (GArray * array, GstPollFD * fd)
   return fd->idx;
 }
 
+#ifndef G_OS_WIN32
+/* the GST_POLL_MODE environment variable can be used to force a mode. It is
+ * read for every new set so that it can be changed at runtime, such as in the
+ * unit tests. */
+static GstPollMode
+gst_poll_get_default_mode (void)
+{
+  const gchar *env = g_getenv ("GST_POLL_MODE");
+  GstPollMode mode = GST_POLL_MODE_AUTO;
+
+  if (env == NULL || !strcmp (env, "auto"))
+    mode = GST_POLL_MODE_AUTO;
+#ifdef HAVE_SYS_EPOLL_H
+  else if (!strcmp (env, "epoll"))
+    mode = GST_POLL_MODE_EPOLL;
+#endif
+#ifdef HAVE_PPOLL
+  else if (!strcmp (env, "ppoll"))
+    mode = GST_POLL_MODE_PPOLL;
+#endif
+#ifdef HAVE_POLL
+  else if (!strcmp (env, "poll"))
+    mode = GST_POLL_MODE_POLL;
+#endif
+#ifdef HAVE_PSELECT
+  else if (!strcmp (env, "pselect"))
+    mode = GST_POLL_MODE_PSELECT;
+#endif
+  else if (!strcmp (env, "select"))
+    mode = GST_POLL_MODE_SELECT;
+  else
+    GST_WARNING ("unknown or unsupported poll mode '%s'", env);
+
+  GST_DEBUG ("using poll mode %d", mode);
+
+  return mode;
+}
+#endif
+
+#ifdef HAVE_SYS_EPOLL_H
+static guint32
+pollfd_to_epoll_events (gshort events)
+{
+  guint32 res = 0;
+
+  /* EPOLLERR and EPOLLHUP are always reported */
+  if (events & POLLIN)
+    res |= EPOLLIN;
+  if (events & POLLPRI)
+    res |= EPOLLPRI;
+  if (events & POLLOUT)
+    res |= EPOLLOUT;
+
+  return res;
+}
+
+static gshort
+epoll_to_pollfd_events (guint32 events)
+{
+  gshort res = 0;
+
+  if (events & EPOLLIN)
+    res |= POLLIN;
+  if (events & EPOLLPRI)
+    res |= POLLPRI;
+  if (events & EPOLLOUT)
+    res |= POLLOUT;
+  if (events & EPOLLERR)
+    res |= POLLERR;
+  if (events & EPOLLHUP)
+    res |= POLLHUP;
+
+  return res;
+}
+
+static gint
+compare_pollfd (gconstpointer a, gconstpointer b)
+{
+  return ((const struct pollfd *) a)->fd - ((const struct pollfd *) b)->fd;
+}
+
+/* apply a change of @pfd to the epoll instance, must be called with the
+ * lock */
+static void
+gst_poll_epoll_update (GstPoll * set, gint op, const struct pollfd *pfd)
+{
+  struct epoll_event ev;
+
+  if (set->mode != GST_POLL_MODE_EPOLL)
+    return;
+
+  memset (&ev, 0, sizeof (ev));
+  ev.events = pollfd_to_epoll_events (pfd->events);
+  ev.data.fd = pfd->fd;
+
+  if (epoll_ctl (set->epfd, op, pfd->fd, &ev) == 0)
+    return;
+
+  switch (errno) {
+    case EPERM:
+      /* regular files can't be used with epoll, poll() reports them as always
+       * ready. Fall back to poll() for the complete set. */
+      GST_INFO ("%p: fd %d does not support epoll, falling back", set,
+          pfd->fd);
+      set->mode = GST_POLL_MODE_AUTO;
+      MARK_REBUILD (set);
+      break;
+    case EEXIST:
+      /* still registered through a dup() of a closed fd */
+      epoll_ctl (set->epfd, EPOLL_CTL_MOD, pfd->fd, &ev);
+      break;
+    case ENOENT:
+      /* the fd was closed and a new one with the same number was added */
+      if (op == EPOLL_CTL_MOD)
+        epoll_ctl (set->epfd, EPOLL_CTL_ADD, pfd->fd, &ev);
+      break;
+    case EBADF:
+      /* closed before it was removed, the kernel already removed it */
+      GST_LOG ("%p: fd %d was closed", set, pfd->fd);
+      break;
+    default:
+      GST_WARNING ("%p: epoll_ctl %d on fd %d failed: %s", set, op, pfd->fd,
+          g_strerror (errno));
+      break;
+  }
+}
+#endif
+
+#ifndef G_OS_WIN32
+/* get the result of the last wait for @fd or %NULL when it is not in the
+ * set, must be called with the lock */
+static const struct pollfd *
+find_active_pollfd (const GstPoll * set, GstPollFD * fd)
+{
+  gint idx;
+
+#ifdef HAVE_SYS_EPOLL_H
+  if (set->active_sorted) {
+    static const struct pollfd no_events = { -1, 0, 0 };
+    const struct pollfd *res;
+    struct pollfd key;
+
+    /* only the fds with activity are in the array */
+    key.fd = fd->fd;
+    res = bsearch (&key, set->active_fds->data, set->active_fds->len,
+        sizeof (struct pollfd), compare_pollfd);
+
+    return res ? res : &no_events;
+  }
+#endif
+
+  idx = find_index (set->active_fds, fd);
+  if (idx < 0)
+    return NULL;
+
+  return &g_array_index (set->active_fds, struct pollfd, idx);
+}
+#endif
+
 #if !defined(HAVE_PPOLL) && defined(HAVE_POLL)
 /* check if all file descriptors will fit in an fd_set */
 static gboolean
@@ -535,21 +743,8 @@ gst_poll_collect_winsock_events (GstPoll * set)
 }
 #endif
 
-/**
- * gst_poll_new: (skip)
- * @controllable: whether it should be possible to control a wait.
- *
- * Create a new file descriptor set. If @controllable, it
- * is possible to restart or flush a call to gst_poll_wait() with
- * gst_poll_restart() and gst_poll_set_flushing() respectively.
- *
- * Free-function: gst_poll_free
- *
- * Returns: (transfer full): a new #GstPoll, or %NULL in case of an error.
- *     Free with gst_poll_free().
- */
-GstPoll *
-gst_poll_new (gboolean controllable)
+static GstPoll *
+gst_poll_new_internal (gboolean controllable, gboolean timer)
 {
   GstPoll *nset;
 
@@ -557,11 +752,35 @@ gst_poll_new (gboolean controllable)
   GST_DEBUG ("%p: new controllable : %d", nset, controllable);
   g_mutex_init (&nset->lock);
 #ifndef G_OS_WIN32
-  nset->mode = GST_POLL_MODE_AUTO;
+  nset->mode = gst_poll_get_default_mode ();
   nset->fds = g_array_new (FALSE, FALSE, sizeof (struct pollfd));
   nset->active_fds = g_array_new (FALSE, FALSE, sizeof (struct pollfd));
   nset->control_read_fd.fd = -1;
   nset->control_write_fd.fd = -1;
+#ifdef HAVE_SYS_EPOLL_H
+  nset->epfd = -1;
+  nset->epoll_events = g_array_new (FALSE, FALSE, sizeof (struct epoll_event));
+  if (nset->mode == GST_POLL_MODE_EPOLL) {
+    /* timers are waited on from multiple threads and epoll only wakes up one
+     * of them for an event */
+    if (!timer)
+      nset->epfd = epoll_create1 (EPOLL_CLOEXEC);
+    if (nset->epfd < 0)
+      nset->mode = GST_POLL_MODE_AUTO;
+  }
+#endif
+#ifdef HAVE_SYS_EVENTFD_H
+  {
+    gint efd;
+
+    /* one fd instead of a socket pair, signaled with a counter */
+    if ((efd = eventfd (0, EFD_CLOEXEC | EFD_NONBLOCK)) >= 0) {
+      nset->control_read_fd.fd = efd;
+      nset->control_write_fd.fd = efd;
+    }
+  }
+  if (nset->control_read_fd.fd < 0)
+#endif
   {
     gint control_sock[2];
 
@@ -573,10 +792,9 @@ gst_poll_new (gboolean controllable)
 
     nset->control_read_fd.fd = control_sock[0];
     nset->control_write_fd.fd = control_sock[1];
-
-    gst_poll_add_fd_unlocked (nset, &nset->control_read_fd);
-    gst_poll_fd_ctl_read_unlocked (nset, &nset->control_read_fd, TRUE);
   }
+  gst_poll_add_fd_unlocked (nset, &nset->control_read_fd);
+  gst_poll_fd_ctl_read_unlocked (nset, &nset->control_read_fd, TRUE);
 #else
   nset->mode = GST_POLL_MODE_WINDOWS;
   nset->fds = g_array_new (FALSE, FALSE, sizeof (WinsockFd));
@@ -592,6 +810,7 @@ gst_poll_new (gboolean controllable)
   MARK_REBUILD (nset);
 
   nset->controllable = controllable;
+  nset->timer = timer;
 
   return nset;
 
@@ -606,6 +825,25 @@ no_socket_pair:
 #endif
 }
 
+/**
+ * gst_poll_new: (skip)
+ * @controllable: whether it should be possible to control a wait.
+ *
+ * Create a new file descriptor set. If @controllable, it
+ * is possible to restart or flush a call to gst_poll_wait() with
+ * gst_poll_restart() and gst_poll_set_flushing() respectively.
+ *
+ * Free-function: gst_poll_free
+ *
+ * Returns: (transfer full): a new #GstPoll, or %NULL in case of an error.
+ *     Free with gst_poll_free().
+ */
+GstPoll *
+gst_poll_new (gboolean controllable)
+{
+  return gst_poll_new_internal (controllable, FALSE);
+}
+
 /**
  * gst_poll_new_timer: (skip)
  *
@@ -623,17 +861,8 @@ no_socket_pair:
 GstPoll *
 gst_poll_new_timer (void)
 {
-  GstPoll *poll;
-
-  /* make a new controllable poll set */
-  if (!(poll = gst_poll_new (TRUE)))
-    goto done;
-
-  /* we are a timer */
-  poll->timer = TRUE;
-
-done:
-  return poll;
+  /* make a new controllable poll set, we are a timer */
+  return gst_poll_new_internal (TRUE, TRUE);
 }
 
 /**
@@ -650,10 +879,16 @@ gst_poll_free (GstPoll * set)
   GST_DEBUG ("%p: freeing", set);
 
 #ifndef G_OS_WIN32
-  if (set->control_write_fd.fd >= 0)
+  if (set->control_write_fd.fd >= 0 &&
+      set->control_write_fd.fd != set->control_read_fd.fd)
     close (set->control_write_fd.fd);
   if (set->control_read_fd.fd >= 0)
     close (set->control_read_fd.fd);
+#ifdef HAVE_SYS_EPOLL_H
+  if (set->epfd >= 0)
+    close (set->epfd);
+  g_array_free (set->epoll_events, TRUE);
+#endif
 #else
   CloseHandle (set->wakeup_event);
 
@@ -737,6 +972,9 @@ gst_poll_add_fd_unlocked (GstPoll * set, GstPollFD * fd)
     g_array_append_val (set->fds, nfd);
 
     fd->idx = set->fds->len - 1;
+#ifdef HAVE_SYS_EPOLL_H
+    gst_poll_epoll_update (set, EPOLL_CTL_ADD, &nfd);
+#endif
 #else
     WinsockFd wfd;
     HANDLE event;
@@ -816,6 +1054,9 @@ gst_poll_remove_fd (GstPoll * set, GstPollFD * fd)
 #ifdef G_OS_WIN32
     gst_poll_free_winsock_event (set, idx);
     g_array_remove_index_fast (set->events, idx);
+#elif defined (HAVE_SYS_EPOLL_H)
+    gst_poll_epoll_update (set, EPOLL_CTL_DEL,
+        &g_array_index (set->fds, struct pollfd, idx));
 #endif
 
     /* remove the fd at index, we use _remove_index_fast, which copies the last
@@ -870,6 +1111,9 @@ gst_poll_fd_ctl_write (GstPoll * set, GstPollFD * fd, gboolean active)
       pfd->events &= ~POLLOUT;
 
     GST_LOG ("%p: pfd->events now %d (POLLOUT:%d)", set, pfd->events, POLLOUT);
+#ifdef HAVE_SYS_EPOLL_H
+    gst_poll_epoll_update (set, EPOLL_CTL_MOD, pfd);
+#endif
 #else
     gst_poll_update_winsock_event_mask (set, idx, FD_WRITE | FD_CONNECT,
         active);
@@ -902,6 +1146,9 @@ gst_poll_fd_ctl_read_unlocked (GstPoll * set, GstPollFD * fd, gboolean active)
       pfd->events |= (POLLIN | POLLPRI);
     else
       pfd->events &= ~(POLLIN | POLLPRI);
+#ifdef HAVE_SYS_EPOLL_H
+    gst_poll_epoll_update (set, EPOLL_CTL_MOD, pfd);
+#endif
 #else
     gst_poll_update_winsock_event_mask (set, idx, FD_READ | FD_ACCEPT, active);
 #endif
@@ -993,7 +1240,11 @@ gboolean
 gst_poll_fd_has_closed (const GstPoll * set, GstPollFD * fd)
 {
   gboolean res = FALSE;
+#ifndef G_OS_WIN32
+  const struct pollfd *pfd;
+#else
   gint idx;
+#endif
 
   g_return_val_if_fail (set != NULL, FALSE);
   g_return_val_if_fail (fd != NULL, FALSE);
@@ -1001,13 +1252,13 @@ gst_poll_fd_has_closed (const GstPoll * set, GstPollFD * fd)
 
   g_mutex_lock (&((GstPoll *) set)->lock);
 
-  idx = find_index (set->active_fds, fd);
-  if (idx >= 0) {
 #ifndef G_OS_WIN32
-    struct pollfd *pfd = &g_array_index (set->active_fds, struct pollfd, idx);
-
+  pfd = find_active_pollfd (set, fd);
+  if (pfd != NULL) {
     res = (pfd->revents & POLLHUP) != 0;
 #else
+  idx = find_index (set->active_fds, fd);
+  if (idx >= 0) {
     WinsockFd *wfd = &g_array_index (set->active_fds, WinsockFd, idx);
 
     res = (wfd->events.lNetworkEvents & FD_CLOSE) != 0;
@@ -1035,7 +1286,11 @@ gboolean
 gst_poll_fd_has_error (const GstPoll * set, GstPollFD * fd)
 {
   gboolean res = FALSE;
+#ifndef G_OS_WIN32
+  const struct pollfd *pfd;
+#else
   gint idx;
+#endif
 
   g_return_val_if_fail (set != NULL, FALSE);
   g_return_val_if_fail (fd != NULL, FALSE);
@@ -1043,13 +1298,13 @@ gst_poll_fd_has_error (const GstPoll * set, GstPollFD * fd)
 
   g_mutex_lock (&((GstPoll *) set)->lock);
 
-  idx = find_index (set->active_fds, fd);
-  if (idx >= 0) {
 #ifndef G_OS_WIN32
-    struct pollfd *pfd = &g_array_index (set->active_fds, struct pollfd, idx);
-
+  pfd = find_active_pollfd (set, fd);
+  if (pfd != NULL) {
     res = (pfd->revents & (POLLERR | POLLNVAL)) != 0;
 #else
+  idx = find_index (set->active_fds, fd);
+  if (idx >= 0) {
     WinsockFd *wfd = &g_array_index (set->active_fds, WinsockFd, idx);
 
     res = (wfd->events.iErrorCode[FD_CLOSE_BIT] != 0) ||
@@ -1072,15 +1327,19 @@ static gboolean
 gst_poll_fd_can_read_unlocked (const GstPoll * set, GstPollFD * fd)
 {
   gboolean res = FALSE;
+#ifndef G_OS_WIN32
+  const struct pollfd *pfd;
+#else
   gint idx;
+#endif
 
-  idx = find_index (set->active_fds, fd);
-  if (idx >= 0) {
 #ifndef G_OS_WIN32
-    struct pollfd *pfd = &g_array_index (set->active_fds, struct pollfd, idx);
-
+  pfd = find_active_pollfd (set, fd);
+  if (pfd != NULL) {
     res = (pfd->revents & (POLLIN | POLLPRI)) != 0;
 #else
+  idx = find_index (set->active_fds, fd);
+  if (idx >= 0) {
     WinsockFd *wfd = &g_array_index (set->active_fds, WinsockFd, idx);
 
     res = (wfd->events.lNetworkEvents & (FD_READ | FD_ACCEPT)) != 0;
@@ -1133,7 +1392,11 @@ gboolean
 gst_poll_fd_can_write (const GstPoll * set, GstPollFD * fd)
 {
   gboolean res = FALSE;
+#ifndef G_OS_WIN32
+  const struct pollfd *pfd;
+#else
   gint idx;
+#endif
 
   g_return_val_if_fail (set != NULL, FALSE);
   g_return_val_if_fail (fd != NULL, FALSE);
@@ -1141,13 +1404,13 @@ gst_poll_fd_can_write (const GstPoll * set, GstPollFD * fd)
 
   g_mutex_lock (&((GstPoll *) set)->lock);
 
-  idx = find_index (set->active_fds, fd);
-  if (idx >= 0) {
 #ifndef G_OS_WIN32
-    struct pollfd *pfd = &g_array_index (set->active_fds, struct pollfd, idx);
-
+  pfd = find_active_pollfd (set, fd);
+  if (pfd != NULL) {
     res = (pfd->revents & POLLOUT) != 0;
 #else
+  idx = find_index (set->active_fds, fd);
+  if (idx >= 0) {
     WinsockFd *wfd = &g_array_index (set->active_fds, WinsockFd, idx);
 
     res = (wfd->events.lNetworkEvents & FD_WRITE) != 0;
@@ -1215,12 +1478,16 @@ gst_poll_wait (GstPoll * set, GstClockTime timeout)
 
     mode = choose_mode (set, timeout);
 
-    if (TEST_REBUILD (set)) {
+    /* epoll keeps its own copy of the set */
+    if (mode != GST_POLL_MODE_EPOLL && TEST_REBUILD (set)) {
       g_mutex_lock (&set->lock);
 #ifndef G_OS_WIN32
       g_array_set_size (set->active_fds, set->fds->len);
       memcpy (set->active_fds->data, set->fds->data,
           set->fds->len * sizeof (struct pollfd));
+#ifdef HAVE_SYS_EPOLL_H
+      set->active_sorted = FALSE;
+#endif
 #else
       if (!gst_poll_prepare_winsock_active_sets (set))
         goto winsock_error;
@@ -1271,6 +1538,50 @@ gst_poll_wait (GstPoll * set, GstClockTime timeout)
 #else
         g_assert_not_reached ();
         errno = ENOSYS;
+#endif
+        break;
+      }
+      case GST_POLL_MODE_EPOLL:
+      {
+#ifdef HAVE_SYS_EPOLL_H
+        struct epoll_event *events;
+        gint t, max_events, i;
+
+        if (timeout != GST_CLOCK_TIME_NONE) {
+          /* round up, we would spin until the timeout otherwise */
+          t = (gint) MIN ((timeout + GST_MSECOND - 1) / GST_MSECOND, G_MAXINT);
+        } else {
+          t = -1;
+        }
+
+        g_mutex_lock (&set->lock);
+        max_events = MAX (set->fds->len, 1);
+        g_mutex_unlock (&set->lock);
+
+        g_array_set_size (set->epoll_events, max_events);
+        events = (struct epoll_event *) set->epoll_events->data;
+
+        res = epoll_wait (set->epfd, events, max_events, t);
+
+        if (res >= 0) {
+          g_mutex_lock (&set->lock);
+          g_array_set_size (set->active_fds, res);
+          for (i = 0; i < res; i++) {
+            struct pollfd *pfd =
+                &g_array_index (set->active_fds, struct pollfd, i);
+
+            pfd->fd = events[i].data.fd;
+            pfd->events = 0;
+            pfd->revents = epoll_to_pollfd_events (events[i].events);
+          }
+          qsort (set->active_fds->data, res, sizeof (struct pollfd),
+              compare_pollfd);
+          set->active_sorted = TRUE;
+          g_mutex_unlock (&set->lock);
+        }
+#else
+        g_assert_not_reached ();
+        errno = ENOSYS;
 #endif
         break;
       }
@@ -70,6 +70,7 @@
 
 #include "gst_private.h"
 #include "gstquark.h"
+#include "gstbinaryformat.h"
 #include <gst/gst.h>
 #include <gobject/gvaluecollector.h>
 
@@ -84,6 +85,10 @@ struct _GstStructureField
   GValue value;
 };
 
+/* the fields are kept in the order they were added. Small structures keep
+ * them in the same allocation as the structure. Structures with more than
+ * INDEX_MIN_FIELDS fields also keep an index of the field positions sorted on
+ * the field name so that they can be found with a binary search. */
 typedef struct
 {
   GstStructure s;
@@ -91,14 +96,30 @@ typedef struct
   /* owned by parent structure, NULL if no parent */
   gint *parent_refcount;
 
-  GArray *fields;
+  guint fields_len;
+  guint fields_alloc;
+  /* points to arr unless the fields outgrew it */
+  GstStructureField *fields;
+  /* NULL for small structures */
+  guint *index;
+
+  /* the number of fields that fit in arr */
+  guint arr_len;
+  GstStructureField arr[1];
 } GstStructureImpl;
 
+#define INDEX_MIN_FIELDS 16
+#define DEFAULT_PREALLOC 4
+
 #define GST_STRUCTURE_REFCOUNT(s) (((GstStructureImpl*)(s))->parent_refcount)
-#define GST_STRUCTURE_FIELDS(s) (((GstStructureImpl*)(s))->fields)
+#define GST_STRUCTURE_LEN(s) (((GstStructureImpl*)(s))->fields_len)
+#define GST_STRUCTURE_INDEX(s) (((GstStructureImpl*)(s))->index)
 
 #define GST_STRUCTURE_FIELD(structure, index) \
-    &g_array_index(GST_STRUCTURE_FIELDS(structure), GstStructureField, (index))
+    (&((GstStructureImpl*)(structure))->fields[(index)])
+
+#define GST_STRUCTURE_USES_ARR(s) \
+    (((GstStructureImpl*)(s))->fields == ((GstStructureImpl*)(s))->arr)
 
 #define IS_MUTABLE(structure) \
     (!GST_STRUCTURE_REFCOUNT(structure) || \
@@ -139,23 +160,168 @@ _priv_gst_structure_initialize (void)
       "GstStructure debug");
 }
 
+#define STRUCTURE_SIZE(n) \
+    (sizeof (GstStructureImpl) + ((n) - 1) * sizeof (GstStructureField))
+
 static GstStructure *
 gst_structure_new_id_empty_with_size (GQuark quark, guint prealloc)
 {
   GstStructureImpl *structure;
 
-  structure = g_slice_new (GstStructureImpl);
+  if (prealloc == 0)
+    prealloc = DEFAULT_PREALLOC;
+
+  structure = g_slice_alloc (STRUCTURE_SIZE (prealloc));
   ((GstStructure *) structure)->type = _gst_structure_type;
   ((GstStructure *) structure)->name = quark;
   GST_STRUCTURE_REFCOUNT (structure) = NULL;
-  GST_STRUCTURE_FIELDS (structure) =
-      g_array_sized_new (FALSE, FALSE, sizeof (GstStructureField), prealloc);
+  structure->fields_len = 0;
+  structure->fields_alloc = prealloc;
+  structure->fields = structure->arr;
+  structure->index = NULL;
+  structure->arr_len = prealloc;
 
   GST_TRACE ("created structure %p", structure);
 
   return GST_STRUCTURE_CAST (structure);
 }
 
+/* index of the field positions sorted on the field name */
+static gint
+gst_structure_index_compare (const GstStructure * structure, guint pos,
+    GQuark name)
+{
+  GQuark n = GST_STRUCTURE_FIELD (structure, pos)->name;
+
+  return n < name ? -1 : (n > name ? 1 : 0);
+}
+
+/* the position in the index where @name is or should be inserted */
+static guint
+gst_structure_index_search (const GstStructure * structure, GQuark name,
+    gboolean * found)
+{
+  const guint *index = GST_STRUCTURE_INDEX (structure);
+  guint lo = 0, hi = GST_STRUCTURE_LEN (structure);
+
+  *found = FALSE;
+  while (lo < hi) {
+    guint mid = (lo + hi) / 2;
+    gint cmp = gst_structure_index_compare (structure, index[mid], name);
+
+    if (cmp == 0) {
+      *found = TRUE;
+      return mid;
+    } else if (cmp < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+static gint
+gst_structure_index_sort_func (gconstpointer a, gconstpointer b,
+    gpointer user_data)
+{
+  const GstStructure *structure = user_data;
+  GQuark na = GST_STRUCTURE_FIELD (structure, *(const guint *) a)->name;
+  GQuark nb = GST_STRUCTURE_FIELD (structure, *(const guint *) b)->name;
+
+  return na < nb ? -1 : (na > nb ? 1 : 0);
+}
+
+static void
+gst_structure_index_build (GstStructure * structure)
+{
+  GstStructureImpl *impl = (GstStructureImpl *) structure;
+  guint i;
+
+  impl->index = g_renew (guint, impl->index, impl->fields_alloc);
+  for (i = 0; i < impl->fields_len; i++)
+    impl->index[i] = i;
+  g_qsort_with_data (impl->index, impl->fields_len, sizeof (guint),
+      gst_structure_index_sort_func, structure);
+}
+
+/* make room for one more field */
+static void
+gst_structure_grow (GstStructure * structure)
+{
+  GstStructureImpl *impl = (GstStructureImpl *) structure;
+  guint alloc = impl->fields_alloc * 2;
+
+  if (GST_STRUCTURE_USES_ARR (impl)) {
+    impl->fields = g_new (GstStructureField, alloc);
+    memcpy (impl->fields, impl->arr, impl->fields_len *
+        sizeof (GstStructureField));
+  } else {
+    impl->fields = g_renew (GstStructureField, impl->fields, alloc);
+  }
+  impl->fields_alloc = alloc;
+
+  if (impl->index)
+    impl->index = g_renew (guint, impl->index, alloc);
+}
+
+/* append a field that is not in the structure yet */
+static void
+gst_structure_append_field (GstStructure * structure,
+    const GstStructureField * field)
+{
+  GstStructureImpl *impl = (GstStructureImpl *) structure;
+  guint pos;
+
+  if (G_UNLIKELY (impl->fields_len == impl->fields_alloc))
+    gst_structure_grow (structure);
+
+  pos = impl->fields_len;
+  impl->fields[pos] = *field;
+
+  if (impl->index) {
+    gboolean found;
+    guint i = gst_structure_index_search (structure, field->name, &found);
+
+    memmove (&impl->index[i + 1], &impl->index[i],
+        (impl->fields_len - i) * sizeof (guint));
+    impl->index[i] = pos;
+    impl->fields_len++;
+  } else {
+    impl->fields_len++;
+    if (impl->fields_len > INDEX_MIN_FIELDS)
+      gst_structure_index_build (structure);
+  }
+}
+
+/* remove the field at @pos, the value must be unset already */
+static void
+gst_structure_remove_field_at (GstStructure * structure, guint pos)
+{
+  GstStructureImpl *impl = (GstStructureImpl *) structure;
+  guint i, j;
+
+  if (impl->index) {
+    /* drop the position from the index and move down the ones after it */
+    for (i = 0, j = 0; i < impl->fields_len; i++) {
+      guint p = impl->index[i];
+
+      if (p == pos)
+        continue;
+      impl->index[j++] = p > pos ? p - 1 : p;
+    }
+  }
+
+  impl->fields_len--;
+  memmove (&impl->fields[pos], &impl->fields[pos + 1],
+      (impl->fields_len - pos) * sizeof (GstStructureField));
+
+  if (impl->index && impl->fields_len <= INDEX_MIN_FIELDS) {
+    g_free (impl->index);
+    impl->index = NULL;
+  }
+}
+
 /**
  * gst_structure_new_id_empty:
  * @quark: name of new structure
@@ -343,18 +509,24 @@ gst_structure_copy (const GstStructure * structure)
 
   g_return_val_if_fail (structure != NULL, NULL);
 
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  len = GST_STRUCTURE_LEN (structure);
   new_structure = gst_structure_new_id_empty_with_size (structure->name, len);
 
   for (i = 0; i < len; i++) {
-    GstStructureField new_field = { 0 };
+    GstStructureField *new_field = GST_STRUCTURE_FIELD (new_structure, i);
 
     field = GST_STRUCTURE_FIELD (structure, i);
 
-    new_field.name = field->name;
-    gst_value_init_and_copy (&new_field.value, &field->value);
-    g_array_append_val (GST_STRUCTURE_FIELDS (new_structure), new_field);
+    new_field->name = field->name;
+    memset (&new_field->value, 0, sizeof (GValue));
+    gst_value_init_and_copy (&new_field->value, &field->value);
   }
+  GST_STRUCTURE_LEN (new_structure) = len;
+
+  /* the positions stay the same */
+  if (GST_STRUCTURE_INDEX (structure))
+    GST_STRUCTURE_INDEX (new_structure) =
+        g_memdup (GST_STRUCTURE_INDEX (structure), len * sizeof (guint));
   GST_CAT_TRACE (GST_CAT_PERFORMANCE, "doing copy %p -> %p",
       structure, new_structure);
 
@@ -377,7 +549,7 @@ gst_structure_free (GstStructure * structure)
   g_return_if_fail (structure != NULL);
   g_return_if_fail (GST_STRUCTURE_REFCOUNT (structure) == NULL);
 
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  len = GST_STRUCTURE_LEN (structure);
   for (i = 0; i < len; i++) {
     field = GST_STRUCTURE_FIELD (structure, i);
 
@@ -385,13 +557,16 @@ gst_structure_free (GstStructure * structure)
       g_value_unset (&field->value);
     }
   }
-  g_array_free (GST_STRUCTURE_FIELDS (structure), TRUE);
+  if (!GST_STRUCTURE_USES_ARR (structure))
+    g_free (((GstStructureImpl *) structure)->fields);
+  g_free (GST_STRUCTURE_INDEX (structure));
 #ifdef USE_POISONING
   memset (structure, 0xff, sizeof (GstStructure));
 #endif
   GST_TRACE ("free structure %p", structure);
 
-  g_slice_free1 (sizeof (GstStructureImpl), structure);
+  g_slice_free1 (STRUCTURE_SIZE (((GstStructureImpl *) structure)->arr_len),
+      structure);
 }
 
 /**
@@ -777,7 +952,6 @@ static void
 gst_structure_set_field (GstStructure * structure, GstStructureField * field)
 {
   GstStructureField *f;
-  guint i, len = GST_STRUCTURE_FIELDS (structure)->len;
 
   if (G_UNLIKELY (G_VALUE_HOLDS_STRING (&field->value))) {
     const gchar *s;
@@ -827,17 +1001,14 @@ gst_structure_set_field (GstStructure * structure, GstStructureField * field)
     }
   }
 
-  for (i = 0; i < len; i++) {
-    f = GST_STRUCTURE_FIELD (structure, i);
-
-    if (G_UNLIKELY (f->name == field->name)) {
-      g_value_unset (&f->value);
-      memcpy (f, field, sizeof (GstStructureField));
-      return;
-    }
+  f = gst_structure_id_get_field (structure, field->name);
+  if (G_UNLIKELY (f != NULL)) {
+    g_value_unset (&f->value);
+    memcpy (f, field, sizeof (GstStructureField));
+    return;
   }
 
-  g_array_append_val (GST_STRUCTURE_FIELDS (structure), *field);
+  gst_structure_append_field (structure, field);
 }
 
 /* If there is no field with the given ID, NULL is returned.
@@ -848,7 +1019,17 @@ gst_structure_id_get_field (const GstStructure * structure, GQuark field_id)
   GstStructureField *field;
   guint i, len;
 
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  if (G_UNLIKELY (GST_STRUCTURE_INDEX (structure) != NULL)) {
+    gboolean found;
+
+    i = gst_structure_index_search (structure, field_id, &found);
+    if (!found)
+      return NULL;
+
+    return GST_STRUCTURE_FIELD (structure, GST_STRUCTURE_INDEX (structure)[i]);
+  }
+
+  len = GST_STRUCTURE_LEN (structure);
 
   for (i = 0; i < len; i++) {
     field = GST_STRUCTURE_FIELD (structure, i);
@@ -866,11 +1047,17 @@ static GstStructureField *
 gst_structure_get_field (const GstStructure * structure,
     const gchar * fieldname)
 {
+  GQuark field_id;
+
   g_return_val_if_fail (structure != NULL, NULL);
   g_return_val_if_fail (fieldname != NULL, NULL);
 
-  return gst_structure_id_get_field (structure,
-      g_quark_from_string (fieldname));
+  /* a field name that was never used can't be in the structure */
+  field_id = g_quark_try_string (fieldname);
+  if (G_UNLIKELY (field_id == 0))
+    return NULL;
+
+  return gst_structure_id_get_field (structure, field_id);
 }
 
 /**
@@ -935,26 +1122,22 @@ gst_structure_remove_field (GstStructure * structure, const gchar * fieldname)
 {
   GstStructureField *field;
   GQuark id;
-  guint i, len;
 
   g_return_if_fail (structure != NULL);
   g_return_if_fail (fieldname != NULL);
   g_return_if_fail (IS_MUTABLE (structure));
 
-  id = g_quark_from_string (fieldname);
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  id = g_quark_try_string (fieldname);
+  if (id == 0)
+    return;
 
-  for (i = 0; i < len; i++) {
-    field = GST_STRUCTURE_FIELD (structure, i);
-
-    if (field->name == id) {
-      if (G_IS_VALUE (&field->value)) {
-        g_value_unset (&field->value);
-      }
-      GST_STRUCTURE_FIELDS (structure) =
-          g_array_remove_index (GST_STRUCTURE_FIELDS (structure), i);
-      return;
+  field = gst_structure_id_get_field (structure, id);
+  if (field) {
+    if (G_IS_VALUE (&field->value)) {
+      g_value_unset (&field->value);
     }
+    gst_structure_remove_field_at (structure,
+        field - ((GstStructureImpl *) structure)->fields);
   }
 }
 
@@ -1021,15 +1204,16 @@ gst_structure_remove_all_fields (GstStructure * structure)
   g_return_if_fail (structure != NULL);
   g_return_if_fail (IS_MUTABLE (structure));
 
-  for (i = GST_STRUCTURE_FIELDS (structure)->len - 1; i >= 0; i--) {
+  for (i = GST_STRUCTURE_LEN (structure) - 1; i >= 0; i--) {
     field = GST_STRUCTURE_FIELD (structure, i);
 
     if (G_IS_VALUE (&field->value)) {
       g_value_unset (&field->value);
     }
-    GST_STRUCTURE_FIELDS (structure) =
-        g_array_remove_index (GST_STRUCTURE_FIELDS (structure), i);
   }
+  GST_STRUCTURE_LEN (structure) = 0;
+  g_free (GST_STRUCTURE_INDEX (structure));
+  GST_STRUCTURE_INDEX (structure) = NULL;
 }
 
 /**
@@ -1072,7 +1256,7 @@ gst_structure_n_fields (const GstStructure * structure)
 {
   g_return_val_if_fail (structure != NULL, 0);
 
-  return GST_STRUCTURE_FIELDS (structure)->len;
+  return GST_STRUCTURE_LEN (structure);
 }
 
 /**
@@ -1090,7 +1274,7 @@ gst_structure_nth_field_name (const GstStructure * structure, guint index)
   GstStructureField *field;
 
   g_return_val_if_fail (structure != NULL, NULL);
-  g_return_val_if_fail (index < GST_STRUCTURE_FIELDS (structure)->len, NULL);
+  g_return_val_if_fail (index < GST_STRUCTURE_LEN (structure), NULL);
 
   field = GST_STRUCTURE_FIELD (structure, index);
 
@@ -1120,7 +1304,7 @@ gst_structure_foreach (const GstStructure * structure,
   g_return_val_if_fail (structure != NULL, FALSE);
   g_return_val_if_fail (func != NULL, FALSE);
 
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  len = GST_STRUCTURE_LEN (structure);
 
   for (i = 0; i < len; i++) {
     field = GST_STRUCTURE_FIELD (structure, i);
@@ -1157,7 +1341,7 @@ gst_structure_map_in_place (GstStructure * structure,
   g_return_val_if_fail (structure != NULL, FALSE);
   g_return_val_if_fail (IS_MUTABLE (structure), FALSE);
   g_return_val_if_fail (func != NULL, FALSE);
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  len = GST_STRUCTURE_LEN (structure);
 
   for (i = 0; i < len; i++) {
     field = GST_STRUCTURE_FIELD (structure, i);
@@ -1208,8 +1392,7 @@ gst_structure_has_field (const GstStructure * structure,
   g_return_val_if_fail (structure != NULL, FALSE);
   g_return_val_if_fail (fieldname != NULL, FALSE);
 
-  return gst_structure_id_has_field (structure,
-      g_quark_from_string (fieldname));
+  return gst_structure_get_field (structure, fieldname) != NULL;
 }
 
 /**
@@ -1787,7 +1970,7 @@ priv_gst_structure_append_to_gstring (const GstStructure * structure,
 
   g_return_val_if_fail (s != NULL, FALSE);
 
-  len = GST_STRUCTURE_FIELDS (structure)->len;
+  len = GST_STRUCTURE_LEN (structure);
   for (i = 0; i < len; i++) {
     char *t;
     GType type;
@@ -2399,6 +2582,75 @@ error:
   return NULL;
 }
 
+/**
+ * gst_structure_to_bytes:
+ * @structure: a #GstStructure
+ *
+ * Serializes @structure into a compact, versioned binary representation
+ * that can be turned back into a structure with gst_structure_from_bytes().
+ * This is considerably faster to create and to parse than the string
+ * representation of gst_structure_to_string().
+ *
+ * Fields of types that have no binary representation are stored with
+ * their string serialization.
+ *
+ * Returns: (transfer full): a new #GBytes or NULL when a field could not be
+ *     serialized. Free with g_bytes_unref() after use.
+ *
+ * Since: 1.4
+ */
+GBytes *
+gst_structure_to_bytes (const GstStructure * structure)
+{
+  GByteArray *array;
+
+  g_return_val_if_fail (GST_IS_STRUCTURE (structure), NULL);
+
+  array = g_byte_array_sized_new (128);
+  _priv_gst_binary_write_header (array, GST_BINARY_KIND_STRUCTURE);
+  if (!_priv_gst_binary_write_structure (array, structure)) {
+    g_byte_array_unref (array);
+    return NULL;
+  }
+  return g_byte_array_free_to_bytes (array);
+}
+
+/**
+ * gst_structure_from_bytes:
+ * @data: (array length=size): data created with gst_structure_to_bytes()
+ * @size: the size of @data
+ * @consumed: (out) (allow-none): the number of bytes that were parsed
+ *
+ * Creates a #GstStructure from the binary representation created with
+ * gst_structure_to_bytes(). The data is parsed in place, for example
+ * directly from a mapped #GstBuffer. Since the data can be followed by other
+ * data, the number of bytes that were used can be retrieved with @consumed.
+ *
+ * Free-function: gst_structure_free
+ *
+ * Returns: (transfer full): a new #GstStructure or NULL when the data could
+ *     not be parsed. Free with gst_structure_free() after use.
+ *
+ * Since: 1.4
+ */
+GstStructure *
+gst_structure_from_bytes (const guint8 * data, gsize size, gsize * consumed)
+{
+  GstBinaryReader reader = { data, size, 0 };
+  GstStructure *structure;
+
+  g_return_val_if_fail (data != NULL || size == 0, NULL);
+
+  if (!_priv_gst_binary_read_header (&reader, GST_BINARY_KIND_STRUCTURE))
+    return NULL;
+
+  structure = _priv_gst_binary_read_structure (&reader);
+  if (structure && consumed)
+    *consumed = reader.pos;
+
+  return structure;
+}
+
 static void
 gst_structure_transform_to_string (const GValue * src_value,
     GValue * dest_value)
@@ -3062,8 +3314,7 @@ gst_structure_is_equal (const GstStructure * structure1,
   if (structure1->name != structure2->name) {
     return FALSE;
   }
-  if (GST_STRUCTURE_FIELDS (structure1)->len !=
-      GST_STRUCTURE_FIELDS (structure2)->len) {
+  if (GST_STRUCTURE_LEN (structure1) != GST_STRUCTURE_LEN (structure2)) {
     return FALSE;
   }
 
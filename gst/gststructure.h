@@ -264,6 +264,12 @@ gchar *               gst_structure_to_string    (const GstStructure * structure
 GstStructure *        gst_structure_from_string  (const gchar * string,
                                                   gchar      ** end) G_GNUC_MALLOC;
 
+GBytes *              gst_structure_to_bytes     (const GstStructure * structure) G_GNUC_MALLOC;
+
+GstStructure *        gst_structure_from_bytes   (const guint8 * data,
+                                                  gsize          size,
+                                                  gsize        * consumed) G_GNUC_MALLOC;
+
 gboolean              gst_structure_fixate_field_nearest_int      (GstStructure * structure,
                                                                    const char   * field_name,
                                                                    int            target);
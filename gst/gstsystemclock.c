@@ -42,19 +42,13 @@
 #include "gstinfo.h"
 #include "gstsystemclock.h"
 #include "gstenumtypes.h"
-#include "gstpoll.h"
 #include "gstutils.h"
 #include "glib-compat-private.h"
 
-#include <errno.h>
-
 #ifdef G_OS_WIN32
 #  define WIN32_LEAN_AND_MEAN   /* prevents from including too many things */
 #  include <windows.h>          /* QueryPerformance* stuff */
 #  undef WIN32_LEAN_AND_MEAN
-#  ifndef EWOULDBLOCK
-#  define EWOULDBLOCK EAGAIN    /* This is just to placate gcc */
-#  endif
 #endif /* G_OS_WIN32 */
 
 #define GET_ENTRY_STATUS(e)          ((GstClockReturn) g_atomic_int_get(&GST_CLOCK_ENTRY_STATUS(e)))
@@ -62,26 +56,52 @@
 #define CAS_ENTRY_STATUS(e,old,val)  (g_atomic_int_compare_and_exchange(\
                                        (&GST_CLOCK_ENTRY_STATUS(e)), (old), (val)))
 
+/* the waiter of the thread that marked the entry BUSY, we keep it in the
+ * private part of the entry */
+#define GET_ENTRY_WAITER(e)          ((GstClockWaiter *) (e)->_gst_reserved[0])
+#define SET_ENTRY_WAITER(e,w)        ((e)->_gst_reserved[0] = (gpointer) (w))
+
 /* Define this to get some extra debug about jitter from each clock_wait */
 #undef WAIT_DEBUGGING
 
 #define GST_SYSTEM_CLOCK_GET_COND(clock)        (&GST_SYSTEM_CLOCK_CAST(clock)->priv->entries_changed)
 #define GST_SYSTEM_CLOCK_WAIT(clock)            g_cond_wait(GST_SYSTEM_CLOCK_GET_COND(clock),GST_OBJECT_GET_LOCK(clock))
-#define GST_SYSTEM_CLOCK_TIMED_WAIT(clock,tv)   g_cond_timed_wait(GST_SYSTEM_CLOCK_GET_COND(clock),GST_OBJECT_GET_LOCK(clock),tv)
 #define GST_SYSTEM_CLOCK_BROADCAST(clock)       g_cond_broadcast(GST_SYSTEM_CLOCK_GET_COND(clock))
 
+/* each thread that waits on an entry has a waiter. Unscheduling an entry
+ * only wakes up the thread that is waiting on it. */
+typedef struct
+{
+  GMutex lock;
+  GCond cond;
+  gboolean wakeup;              /* wakeup without unschedule, used to make the
+                                 * async thread look at a new head entry */
+} GstClockWaiter;
+
+/* a pending async entry. Entries with the same time are ordered on seq so
+ * that they fire in the order they were added. */
+typedef struct
+{
+  GstClockEntry *entry;
+  GstClockTime time;
+  guint64 seq;
+} GstClockHeapItem;
+
 struct _GstSystemClockPrivate
 {
   GThread *thread;              /* thread for async notify */
   gboolean stopping;
 
-  GList *entries;
+  /* pending async entries, a binary min-heap of GstClockHeapItem */
+  GArray *entries;
+  guint64 entries_seq;
   GCond entries_changed;
 
+  /* the entry the async thread is handling, it's not in the heap */
+  GstClockEntry *async_entry;
+  GstClockWaiter *async_waiter;
+
   GstClockType clock_type;
-  GstPoll *timer;
-  gint wakeup_count;            /* the number of entries with a pending wakeup */
-  gboolean async_wakeup;        /* if the wakeup was because of a async list change */
 
 #ifdef G_OS_WIN32
   LARGE_INTEGER start;
@@ -133,10 +153,15 @@ static void gst_system_clock_id_unschedule (GstClock * clock,
     GstClockEntry * entry);
 static void gst_system_clock_async_thread (GstClock * clock);
 static gboolean gst_system_clock_start_async (GstSystemClock * clock);
-static void gst_system_clock_add_wakeup (GstSystemClock * sysclock);
+static void gst_clock_waiter_free (GstClockWaiter * waiter);
+static void gst_clock_waiter_signal (GstClockWaiter * waiter,
+    gboolean wakeup);
 
 static GMutex _gst_sysclock_mutex;
 
+static GPrivate _gst_clock_waiter =
+G_PRIVATE_INIT ((GDestroyNotify) gst_clock_waiter_free);
+
 /* static guint gst_system_clock_signals[LAST_SIGNAL] = { 0 }; */
 
 #define gst_system_clock_parent_class parent_class
@@ -184,9 +209,8 @@ gst_system_clock_init (GstSystemClock * clock)
   clock->priv = priv = GST_SYSTEM_CLOCK_GET_PRIVATE (clock);
 
   priv->clock_type = DEFAULT_CLOCK_TYPE;
-  priv->timer = gst_poll_new_timer ();
 
-  priv->entries = NULL;
+  priv->entries = g_array_new (FALSE, FALSE, sizeof (GstClockHeapItem));
   g_cond_init (&priv->entries_changed);
 
 #ifdef G_OS_WIN32
@@ -211,20 +235,25 @@ gst_system_clock_dispose (GObject * object)
   GstClock *clock = (GstClock *) object;
   GstSystemClock *sysclock = GST_SYSTEM_CLOCK_CAST (clock);
   GstSystemClockPrivate *priv = sysclock->priv;
-  GList *entries;
+  guint i;
 
   /* else we have to stop the thread */
   GST_OBJECT_LOCK (clock);
   priv->stopping = TRUE;
   /* unschedule all entries */
-  for (entries = priv->entries; entries; entries = g_list_next (entries)) {
-    GstClockEntry *entry = (GstClockEntry *) entries->data;
+  for (i = 0; i < priv->entries->len; i++) {
+    GstClockEntry *entry =
+        g_array_index (priv->entries, GstClockHeapItem, i).entry;
 
     GST_CAT_DEBUG (GST_CAT_CLOCK, "unscheduling entry %p", entry);
     SET_ENTRY_STATUS (entry, GST_CLOCK_UNSCHEDULED);
   }
+  if (priv->async_entry) {
+    GST_CAT_DEBUG (GST_CAT_CLOCK, "unscheduling entry %p", priv->async_entry);
+    SET_ENTRY_STATUS (priv->async_entry, GST_CLOCK_UNSCHEDULED);
+    gst_clock_waiter_signal (priv->async_waiter, TRUE);
+  }
   GST_SYSTEM_CLOCK_BROADCAST (clock);
-  gst_system_clock_add_wakeup (sysclock);
   GST_OBJECT_UNLOCK (clock);
 
   if (priv->thread)
@@ -232,11 +261,14 @@ gst_system_clock_dispose (GObject * object)
   priv->thread = NULL;
   GST_CAT_DEBUG (GST_CAT_CLOCK, "joined thread");
 
-  g_list_foreach (priv->entries, (GFunc) gst_clock_id_unref, NULL);
-  g_list_free (priv->entries);
-  priv->entries = NULL;
+  if (priv->entries) {
+    for (i = 0; i < priv->entries->len; i++)
+      gst_clock_id_unref (g_array_index (priv->entries, GstClockHeapItem,
+              i).entry);
+    g_array_free (priv->entries, TRUE);
+    priv->entries = NULL;
+  }
 
-  gst_poll_free (priv->timer);
   g_cond_clear (&priv->entries_changed);
 
   G_OBJECT_CLASS (parent_class)->dispose (object);
@@ -360,64 +392,126 @@ gst_system_clock_obtain (void)
 }
 
 static void
-gst_system_clock_remove_wakeup (GstSystemClock * sysclock)
+gst_clock_waiter_free (GstClockWaiter * waiter)
 {
-  g_return_if_fail (sysclock->priv->wakeup_count > 0);
-
-  sysclock->priv->wakeup_count--;
-  if (sysclock->priv->wakeup_count == 0) {
-    /* read the control socket byte when we removed the last wakeup count */
-    GST_CAT_DEBUG (GST_CAT_CLOCK, "reading control");
-    while (!gst_poll_read_control (sysclock->priv->timer)) {
-      g_warning ("gstsystemclock: read control failed, trying again\n");
-    }
-    GST_SYSTEM_CLOCK_BROADCAST (sysclock);
+  g_mutex_clear (&waiter->lock);
+  g_cond_clear (&waiter->cond);
+  g_slice_free (GstClockWaiter, waiter);
+}
+
+/* get the waiter of the current thread, it is freed when the thread exits */
+static GstClockWaiter *
+gst_clock_waiter_get (void)
+{
+  GstClockWaiter *waiter;
+
+  waiter = g_private_get (&_gst_clock_waiter);
+  if (G_UNLIKELY (waiter == NULL)) {
+    waiter = g_slice_new (GstClockWaiter);
+    g_mutex_init (&waiter->lock);
+    g_cond_init (&waiter->cond);
+    waiter->wakeup = FALSE;
+    g_private_set (&_gst_clock_waiter, waiter);
   }
-  GST_CAT_DEBUG (GST_CAT_CLOCK, "wakeup count %d",
-      sysclock->priv->wakeup_count);
+  return waiter;
 }
 
+/* wake up the thread of @waiter so that it rechecks the status of its entry.
+ * When @wakeup is TRUE, the wait is also interrupted when the entry was not
+ * unscheduled. */
 static void
-gst_system_clock_add_wakeup (GstSystemClock * sysclock)
+gst_clock_waiter_signal (GstClockWaiter * waiter, gboolean wakeup)
 {
-  /* only write the control socket for the first wakeup */
-  if (sysclock->priv->wakeup_count == 0) {
-    GST_CAT_DEBUG (GST_CAT_CLOCK, "writing control");
-    while (!gst_poll_write_control (sysclock->priv->timer)) {
-      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
-        g_warning
-            ("gstsystemclock: write control failed in wakeup_async, trying again: %d:%s\n",
-            errno, g_strerror (errno));
-      } else {
-        g_critical
-            ("gstsystemclock: write control failed in wakeup_async: %d:%s\n",
-            errno, g_strerror (errno));
-        return;
-      }
-    }
-  }
-  sysclock->priv->wakeup_count++;
-  GST_CAT_DEBUG (GST_CAT_CLOCK, "wakeup count %d",
-      sysclock->priv->wakeup_count);
+  g_mutex_lock (&waiter->lock);
+  if (wakeup)
+    waiter->wakeup = TRUE;
+  g_cond_signal (&waiter->cond);
+  g_mutex_unlock (&waiter->lock);
 }
 
+static inline gboolean
+heap_item_before (const GstClockHeapItem * a, const GstClockHeapItem * b)
+{
+  if (a->time != b->time)
+    return a->time < b->time;
+  return a->seq < b->seq;
+}
+
+/* add @entry to the heap of pending async entries, takes ownership of the
+ * ref. Must be called with the object lock. */
 static void
-gst_system_clock_wait_wakeup (GstSystemClock * sysclock)
+gst_system_clock_push_entry (GstSystemClock * sysclock, GstClockEntry * entry)
+{
+  GstSystemClockPrivate *priv = sysclock->priv;
+  GstClockHeapItem item, *items;
+  guint i;
+
+  item.entry = entry;
+  item.time = GST_CLOCK_ENTRY_TIME (entry);
+  item.seq = priv->entries_seq++;
+
+  g_array_set_size (priv->entries, priv->entries->len + 1);
+  items = (GstClockHeapItem *) priv->entries->data;
+
+  /* move the new item up from the end */
+  i = priv->entries->len - 1;
+  while (i > 0) {
+    guint parent = (i - 1) / 2;
+
+    if (!heap_item_before (&item, &items[parent]))
+      break;
+    items[i] = items[parent];
+    i = parent;
+  }
+  items[i] = item;
+}
+
+/* remove the first entry from the heap of pending async entries, the ref
+ * is transfered to the caller. Must be called with the object lock. */
+static GstClockEntry *
+gst_system_clock_pop_entry (GstSystemClock * sysclock)
 {
-  while (sysclock->priv->wakeup_count > 0) {
-    GST_SYSTEM_CLOCK_WAIT (sysclock);
+  GstSystemClockPrivate *priv = sysclock->priv;
+  GstClockHeapItem last, *items;
+  GstClockEntry *entry;
+  guint i, len;
+
+  items = (GstClockHeapItem *) priv->entries->data;
+  entry = items[0].entry;
+
+  len = priv->entries->len - 1;
+  last = items[len];
+  g_array_set_size (priv->entries, len);
+
+  /* move the last item down from the top */
+  i = 0;
+  while (2 * i + 1 < len) {
+    guint child = 2 * i + 1;
+
+    if (child + 1 < len && heap_item_before (&items[child + 1], &items[child]))
+      child++;
+    if (!heap_item_before (&items[child], &last))
+      break;
+    items[i] = items[child];
+    i = child;
   }
+  if (len > 0)
+    items[i] = last;
+
+  return entry;
 }
 
-/* this thread reads the sorted clock entries from the queue.
+/* this thread takes the first entry from the heap of pending entries.
  *
  * It waits on each of them and fires the callback when the timeout occurs.
  *
- * When an entry in the queue was canceled before we wait for it, it is
+ * When an entry in the heap was canceled before we wait for it, it is
  * simply skipped.
  *
  * When waiting for an entry, it can become canceled, in that case we don't
- * call the callback but move to the next item in the queue.
+ * call the callback but move to the next item in the heap. When an entry is
+ * added before the one we are waiting for, we put our entry back and start
+ * waiting on the new first entry.
  *
  * MT safe.
  */
@@ -429,6 +523,7 @@ gst_system_clock_async_thread (GstClock * clock)
 
   GST_CAT_DEBUG (GST_CAT_CLOCK, "enter system clock thread");
   GST_OBJECT_LOCK (clock);
+  priv->async_waiter = gst_clock_waiter_get ();
   /* signal spinup */
   GST_SYSTEM_CLOCK_BROADCAST (clock);
   /* now enter our (almost) infinite loop */
@@ -438,7 +533,7 @@ gst_system_clock_async_thread (GstClock * clock)
     GstClockReturn res;
 
     /* check if something to be done */
-    while (priv->entries == NULL) {
+    while (priv->entries->len == 0) {
       GST_CAT_DEBUG (GST_CAT_CLOCK, "no clock entries, waiting..");
       /* wait for work to do */
       GST_SYSTEM_CLOCK_WAIT (clock);
@@ -448,26 +543,20 @@ gst_system_clock_async_thread (GstClock * clock)
         goto exit;
     }
 
-    /* see if we have a pending wakeup because the order of the list
-     * changed. */
-    if (priv->async_wakeup) {
-      GST_CAT_DEBUG (GST_CAT_CLOCK, "clear async wakeup");
-      gst_system_clock_remove_wakeup (sysclock);
-      priv->async_wakeup = FALSE;
-    }
-
-    /* pick the next entry */
-    entry = priv->entries->data;
+    /* take the next entry, we now own the ref of the heap */
+    entry = gst_system_clock_pop_entry (sysclock);
+    priv->async_entry = entry;
     GST_OBJECT_UNLOCK (clock);
 
     requested = entry->time;
 
-    /* now wait for the entry, we already hold the lock */
+    /* now wait for the entry */
     res =
         gst_system_clock_id_wait_jitter_unlocked (clock, (GstClockID) entry,
         NULL, FALSE);
 
     GST_OBJECT_LOCK (clock);
+    priv->async_entry = NULL;
 
     switch (res) {
       case GST_CLOCK_UNSCHEDULED:
@@ -491,10 +580,8 @@ gst_system_clock_async_thread (GstClock * clock)
           GST_CAT_DEBUG (GST_CAT_CLOCK, "updating periodic entry %p", entry);
           /* adjust time now */
           entry->time = requested + entry->interval;
-          /* and resort the list now */
-          priv->entries =
-              g_list_sort (priv->entries, gst_clock_id_compare_func);
-          /* and restart */
+          /* and put it back in the heap */
+          gst_system_clock_push_entry (sysclock, entry);
           continue;
         } else {
           GST_CAT_DEBUG (GST_CAT_CLOCK, "moving to next entry");
@@ -502,16 +589,16 @@ gst_system_clock_async_thread (GstClock * clock)
         }
       }
       case GST_CLOCK_BUSY:
-        /* somebody unlocked the entry but is was not canceled, This means that
-         * either a new entry was added in front of the queue or some other entry
-         * was canceled. Whatever it is, pick the head entry of the list and
-         * continue waiting. */
+        /* we were woken up because an entry was added before the one we were
+         * waiting for. Put the entry back and pick the first entry of the
+         * heap again. */
         GST_CAT_DEBUG (GST_CAT_CLOCK, "async entry %p needs restart", entry);
 
         /* we set the entry back to the OK state. This is needed so that the
          * _unschedule() code can see if an entry is currently being waited
          * on (when its state is BUSY). */
         SET_ENTRY_STATUS (entry, GST_CLOCK_OK);
+        gst_system_clock_push_entry (sysclock, entry);
         continue;
       default:
         GST_CAT_DEBUG (GST_CAT_CLOCK,
@@ -521,11 +608,12 @@ gst_system_clock_async_thread (GstClock * clock)
         goto next_entry;
     }
   next_entry:
-    /* we remove the current entry and unref it */
-    priv->entries = g_list_remove (priv->entries, entry);
+    /* we unref the current entry */
     gst_clock_id_unref ((GstClockID) entry);
   }
 exit:
+  /* our waiter is freed when the thread exits */
+  priv->async_waiter = NULL;
   /* signal exit */
   GST_SYSTEM_CLOCK_BROADCAST (clock);
   GST_OBJECT_UNLOCK (clock);
@@ -618,12 +706,13 @@ gst_system_clock_get_resolution (GstClock * clock)
 
 /* synchronously wait on the given GstClockEntry.
  *
- * We do this by blocking on the global GstPoll timer with
- * the requested timeout. This allows us to unblock the
- * entry by writing on the control fd.
+ * We do this by blocking on the condition of the waiter of the current
+ * thread with the requested timeout. Unscheduling the entry signals this
+ * waiter, other waiting threads are not woken up.
  *
- * Note that writing the global GstPoll unlocks all waiting entries. So
- * we need to check if an unlocked entry has changed when it unlocks.
+ * The async thread is also woken up when an entry is added before the one
+ * it is waiting on. When @restart is FALSE, GST_CLOCK_BUSY is returned in
+ * that case.
  *
  * Entries that arrive too late are simply not waited on and a
  * GST_CLOCK_EARLY result is returned.
@@ -662,12 +751,19 @@ gst_system_clock_id_wait_jitter_unlocked (GstClock * clock,
       entry, GST_TIME_ARGS (entryt), GST_TIME_ARGS (now), diff);
 
   if (G_LIKELY (diff > 0)) {
+    GstClockWaiter *waiter;
 #ifdef WAIT_DEBUGGING
     GstClockTime final;
 #endif
 
+    waiter = gst_clock_waiter_get ();
+
     while (TRUE) {
-      gint pollret;
+      gint64 end_time;
+      gboolean woken;
+
+      /* the unschedule function signals the waiter of a BUSY entry */
+      SET_ENTRY_WAITER (entry, waiter);
 
       do {
         status = GET_ENTRY_STATUS (entry);
@@ -680,13 +776,23 @@ gst_system_clock_id_wait_jitter_unlocked (GstClock * clock,
          * statuses */
       } while (G_UNLIKELY (!CAS_ENTRY_STATUS (entry, status, GST_CLOCK_BUSY)));
 
-      /* now wait on the entry, it either times out or the fd is written. The
-       * status of the entry is only BUSY around the poll. */
-      pollret = gst_poll_wait (sysclock->priv->timer, diff);
+      /* round up, we don't want to wake up before the entry time */
+      end_time = g_get_monotonic_time () + (diff + GST_USECOND - 1) / GST_USECOND;
+
+      /* now wait on the entry, it either times out or our waiter is signalled.
+       * The status of the entry is only BUSY around the wait. */
+      g_mutex_lock (&waiter->lock);
+      while (GET_ENTRY_STATUS (entry) == GST_CLOCK_BUSY && !waiter->wakeup) {
+        if (!g_cond_wait_until (&waiter->cond, &waiter->lock, end_time))
+          break;
+      }
+      woken = waiter->wakeup;
+      waiter->wakeup = FALSE;
+      g_mutex_unlock (&waiter->lock);
 
       /* get the new status, mark as DONE. We do this so that the unschedule
-       * function knows when we left the poll and doesn't need to wakeup the
-       * poll anymore. */
+       * function knows when we left the wait and doesn't need to signal the
+       * waiter anymore. */
       do {
         status = GET_ENTRY_STATUS (entry);
         /* we were unscheduled, exit immediately */
@@ -694,37 +800,26 @@ gst_system_clock_id_wait_jitter_unlocked (GstClock * clock,
           break;
       } while (G_UNLIKELY (!CAS_ENTRY_STATUS (entry, status, GST_CLOCK_DONE)));
 
-      GST_CAT_DEBUG (GST_CAT_CLOCK, "entry %p unlocked, status %d, ret %d",
-          entry, status, pollret);
+      GST_CAT_DEBUG (GST_CAT_CLOCK, "entry %p unlocked, status %d, woken %d",
+          entry, status, woken);
 
       if (G_UNLIKELY (status == GST_CLOCK_UNSCHEDULED)) {
-        /* try to clean up The unschedule function managed to set the status to
-         * unscheduled. We now take the lock and mark the entry as unscheduled.
-         * This makes sure that the unschedule function doesn't perform a
-         * wakeup anymore. If the unschedule function has a change to perform
-         * the wakeup before us, we clean up here */
+        /* The unschedule function managed to set the status to unscheduled
+         * and signals our waiter with the object lock held. Take the lock to
+         * make sure it is done with our waiter and mark the entry as
+         * unscheduled. */
         GST_OBJECT_LOCK (sysclock);
         entry->unscheduled = TRUE;
-        if (entry->woken_up) {
-          gst_system_clock_remove_wakeup (sysclock);
-        }
         GST_OBJECT_UNLOCK (sysclock);
         goto done;
       } else {
-        if (G_UNLIKELY (pollret != 0)) {
-          /* some other id got unlocked */
+        if (G_UNLIKELY (woken)) {
           if (!restart) {
             /* this can happen if the entry got unlocked because of an async
-             * entry was added to the head of the async queue. */
+             * entry was added before it. */
             GST_CAT_DEBUG (GST_CAT_CLOCK, "wakeup waiting for entry %p", entry);
             goto done;
           }
-
-          /* wait till all the entries got woken up */
-          GST_OBJECT_LOCK (sysclock);
-          gst_system_clock_wait_wakeup (sysclock);
-          GST_OBJECT_UNLOCK (sysclock);
-
           GST_CAT_DEBUG (GST_CAT_CLOCK, "entry %p needs to be restarted",
               entry);
         } else {
@@ -732,7 +827,7 @@ gst_system_clock_id_wait_jitter_unlocked (GstClock * clock,
               entry);
         }
 
-        /* reschedule if gst_poll_wait returned early or we have to reschedule after
+        /* reschedule if the wait returned early or we have to reschedule after
          * an unlock*/
         now = gst_clock_get_time (clock);
         diff = GST_CLOCK_DIFF (now, entryt);
@@ -813,10 +908,10 @@ no_thread:
   return FALSE;
 }
 
-/* Add an entry to the list of pending async waits. The entry is inserted
- * in sorted order. If we inserted the entry at the head of the list, we
- * need to signal the thread as it might either be waiting on it or waiting
- * for a new entry.
+/* Add an entry to the heap of pending async waits. If the entry is before
+ * the entry that the async thread is waiting for, we need to wake up the
+ * thread so that it picks the new entry. If the heap was empty before, we
+ * need to signal the thread as it is waiting for a new entry.
  *
  * MT safe.
  */
@@ -825,7 +920,7 @@ gst_system_clock_id_wait_async (GstClock * clock, GstClockEntry * entry)
 {
   GstSystemClock *sysclock;
   GstSystemClockPrivate *priv;
-  GstClockEntry *head;
+  GstClockEntry *current;
 
   sysclock = GST_SYSTEM_CLOCK_CAST (clock);
   priv = sysclock->priv;
@@ -840,44 +935,24 @@ gst_system_clock_id_wait_async (GstClock * clock, GstClockEntry * entry)
   if (G_UNLIKELY (GET_ENTRY_STATUS (entry) == GST_CLOCK_UNSCHEDULED))
     goto was_unscheduled;
 
-  if (priv->entries)
-    head = priv->entries->data;
-  else
-    head = NULL;
-
   /* need to take a ref */
   gst_clock_id_ref ((GstClockID) entry);
-  /* insert the entry in sorted order */
-  priv->entries = g_list_insert_sorted (priv->entries, entry,
-      gst_clock_id_compare_func);
-
-  /* only need to send the signal if the entry was added to the
-   * front, else the thread is just waiting for another entry and
-   * will get to this entry automatically. */
-  if (priv->entries->data == entry) {
-    GST_CAT_DEBUG (GST_CAT_CLOCK, "async entry added to head %p", head);
-    if (head == NULL) {
-      /* the list was empty before, signal the cond so that the async thread can
-       * start taking a look at the queue */
+  gst_system_clock_push_entry (sysclock, entry);
+
+  current = priv->async_entry;
+  if (current == NULL) {
+    /* the async thread is not handling an entry and might be waiting for a
+     * new one, signal the cond so that it can take a look at the heap */
+    if (priv->entries->len == 1) {
       GST_CAT_DEBUG (GST_CAT_CLOCK, "first entry, sending signal");
       GST_SYSTEM_CLOCK_BROADCAST (clock);
-    } else {
-      GstClockReturn status;
-
-      status = GET_ENTRY_STATUS (head);
-      GST_CAT_DEBUG (GST_CAT_CLOCK, "head entry %p status %d", head, status);
-
-      if (status == GST_CLOCK_BUSY) {
-        GST_CAT_DEBUG (GST_CAT_CLOCK, "head entry is busy");
-        /* the async thread was waiting for an entry, unlock the wait so that it
-         * looks at the new head entry instead, we only need to do this once */
-        if (!priv->async_wakeup) {
-          GST_CAT_DEBUG (GST_CAT_CLOCK, "wakeup async thread");
-          priv->async_wakeup = TRUE;
-          gst_system_clock_add_wakeup (sysclock);
-        }
-      }
     }
+  } else if (GST_CLOCK_ENTRY_TIME (entry) < GST_CLOCK_ENTRY_TIME (current)) {
+    /* the async thread is waiting for a later entry, unlock the wait so that
+     * it looks at the new first entry instead */
+    GST_CAT_DEBUG (GST_CAT_CLOCK, "entry before %p, wakeup async thread",
+        current);
+    gst_clock_waiter_signal (priv->async_waiter, TRUE);
   }
   GST_OBJECT_UNLOCK (clock);
 
@@ -898,7 +973,7 @@ was_unscheduled:
 }
 
 /* unschedule an entry. This will set the state of the entry to GST_CLOCK_UNSCHEDULED
- * and will signal any thread waiting for entries to recheck their entry.
+ * and will signal the thread waiting for the entry to recheck its status.
  * We cannot really decide if the signal is needed or not because the entry
  * could be waited on in async or sync mode.
  *
@@ -907,11 +982,8 @@ was_unscheduled:
 static void
 gst_system_clock_id_unschedule (GstClock * clock, GstClockEntry * entry)
 {
-  GstSystemClock *sysclock;
   GstClockReturn status;
 
-  sysclock = GST_SYSTEM_CLOCK_CAST (clock);
-
   GST_CAT_DEBUG (GST_CAT_CLOCK, "unscheduling entry %p", entry);
 
   GST_OBJECT_LOCK (clock);
@@ -922,15 +994,12 @@ gst_system_clock_id_unschedule (GstClock * clock, GstClockEntry * entry)
               GST_CLOCK_UNSCHEDULED)));
 
   if (G_LIKELY (status == GST_CLOCK_BUSY)) {
-    /* the entry was being busy, wake up all entries so that they recheck their
-     * status. We cannot wake up just one entry because allocating such a
-     * datastructure for each entry would be too heavy and unlocking an entry
-     * is usually done when shutting down or some other exceptional case. */
+    /* the entry was being busy, wake up the thread that is waiting on it so
+     * that it rechecks the status. The waiter takes the object lock before
+     * returning so it stays valid while we hold the lock. */
     GST_CAT_DEBUG (GST_CAT_CLOCK, "entry was BUSY, doing wakeup");
-    if (!entry->unscheduled && !entry->woken_up) {
-      gst_system_clock_add_wakeup (sysclock);
-      entry->woken_up = TRUE;
-    }
+    if (!entry->unscheduled)
+      gst_clock_waiter_signal (GET_ENTRY_WAITER (entry), FALSE);
   }
   GST_OBJECT_UNLOCK (clock);
 }
@@ -42,6 +42,7 @@
 #include "gstbuffer.h"
 #include "gstquark.h"
 #include "gststructure.h"
+#include "gstbinaryformat.h"
 
 #include <gobject/gvaluecollector.h>
 #include <string.h>
@@ -878,6 +879,80 @@ gst_tag_list_new_from_string (const gchar * str)
   return tag_list;
 }
 
+/**
+ * gst_tag_list_to_bytes:
+ * @list: a #GstTagList
+ *
+ * Serializes a tag list and its scope into a compact binary representation.
+ * Tags of types that have no binary representation are stored with their
+ * string serialization.
+ *
+ * Returns: (transfer full): a new #GBytes, or NULL in case of an error.
+ *     Free with g_bytes_unref() after use.
+ *
+ * Since: 1.4
+ */
+GBytes *
+gst_tag_list_to_bytes (const GstTagList * list)
+{
+  GByteArray *array;
+
+  g_return_val_if_fail (GST_IS_TAG_LIST (list), NULL);
+
+  array = g_byte_array_sized_new (256);
+  _priv_gst_binary_write_header (array, GST_BINARY_KIND_TAG_LIST);
+  _priv_gst_binary_write_uint (array, GST_TAG_LIST_SCOPE (list));
+  if (!_priv_gst_binary_write_structure (array, GST_TAG_LIST_STRUCTURE (list))) {
+    g_byte_array_unref (array);
+    return NULL;
+  }
+  return g_byte_array_free_to_bytes (array);
+}
+
+/**
+ * gst_tag_list_new_from_bytes:
+ * @data: (array length=size): data created with gst_tag_list_to_bytes()
+ * @size: the size of @data
+ * @consumed: (out) (allow-none): the number of bytes that were parsed
+ *
+ * Deserializes a tag list from its binary representation. The data is
+ * parsed in place.
+ *
+ * Returns: a new #GstTagList, or NULL in case of an error.
+ *
+ * Since: 1.4
+ */
+GstTagList *
+gst_tag_list_new_from_bytes (const guint8 * data, gsize size,
+    gsize * consumed)
+{
+  GstBinaryReader reader = { data, size, 0 };
+  GstTagList *tag_list;
+  GstStructure *s;
+  guint64 scope;
+
+  g_return_val_if_fail (data != NULL || size == 0, NULL);
+
+  if (!_priv_gst_binary_read_header (&reader, GST_BINARY_KIND_TAG_LIST))
+    return NULL;
+
+  if (!_priv_gst_binary_read_uint (&reader, &scope)
+      || scope > GST_TAG_SCOPE_GLOBAL)
+    return NULL;
+
+  s = _priv_gst_binary_read_structure (&reader);
+  if (s == NULL)
+    return NULL;
+
+  tag_list = gst_tag_list_new_internal (s);
+  GST_TAG_LIST_SCOPE (tag_list) = scope;
+
+  if (consumed)
+    *consumed = reader.pos;
+
+  return tag_list;
+}
+
 /**
  * gst_tag_list_n_tags:
  * @list: A #GstTagList.
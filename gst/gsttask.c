@@ -72,6 +72,7 @@
 
 #include "gstinfo.h"
 #include "gsttask.h"
+#include "gstworkertaskpool.h"
 #include "glib-compat-private.h"
 
 #include <stdio.h>
@@ -106,6 +107,15 @@ struct _GstTaskPrivate
   /* remember the pool and id that is currently running. */
   gpointer id;
   GstTaskPool *pool_id;
+
+  /* set with gst_task_set_cooperative(), with the object lock */
+  gboolean cooperative;
+
+  /* when a cooperative task runs on a #GstWorkerTaskPool, each iteration is
+   * pushed to the pool as a separate item. scheduled is TRUE when an
+   * iteration is queued or running. */
+  gboolean iterated;
+  gboolean scheduled;
 };
 
 #ifdef _MSC_VER
@@ -141,6 +151,7 @@ SetThreadName (DWORD dwThreadID, LPCSTR szThreadName)
 static void gst_task_finalize (GObject * object);
 
 static void gst_task_func (GstTask * task);
+static void gst_task_func_cooperative (GstTask * task);
 
 static GMutex pool_lock;
 
@@ -355,6 +366,108 @@ no_lock:
   }
 }
 
+/* schedule the next iteration of a cooperative task.
+ * This function must be called with the task LOCK. */
+static gboolean
+schedule_cooperative (GstTask * task)
+{
+  GstTaskPrivate *priv = task->priv;
+  GError *error = NULL;
+
+  priv->scheduled = TRUE;
+  gst_task_pool_push (priv->pool_id,
+      (GstTaskPoolFunction) gst_task_func_cooperative, task, &error);
+
+  if (error != NULL) {
+    GST_WARNING_OBJECT (task, "failed to schedule task: %s", error->message);
+    g_error_free (error);
+    priv->scheduled = FALSE;
+    return FALSE;
+  }
+  return TRUE;
+}
+
+/* runs one iteration of a task on a #GstWorkerTaskPool and schedules the
+ * next one. A paused task is not scheduled until its state changes again.
+ * The iterations can run on different workers, so the enter and leave
+ * callbacks are called around every iteration on the worker that runs it. */
+static void
+gst_task_func_cooperative (GstTask * task)
+{
+  GRecMutex *lock;
+  GThread *tself;
+  GstTaskPrivate *priv;
+  GstTaskState state;
+
+  priv = task->priv;
+
+  tself = g_thread_self ();
+
+  GST_OBJECT_LOCK (task);
+  if (GET_TASK_STATE (task) == GST_TASK_STOPPED)
+    goto exit;
+  lock = GST_TASK_GET_LOCK (task);
+  if (G_UNLIKELY (lock == NULL))
+    goto no_lock;
+
+  if (G_LIKELY (GET_TASK_STATE (task) == GST_TASK_STARTED)) {
+    task->thread = tself;
+    GST_OBJECT_UNLOCK (task);
+
+    if (priv->enter_func)
+      priv->enter_func (task, tself, priv->enter_user_data);
+
+    /* locking order is TASK_LOCK, LOCK */
+    g_rec_mutex_lock (lock);
+    /* check again, we could have been paused while waiting for the lock */
+    if (G_LIKELY (GET_TASK_STATE (task) == GST_TASK_STARTED))
+      task->func (task->user_data);
+    g_rec_mutex_unlock (lock);
+
+    if (priv->leave_func)
+      priv->leave_func (task, tself, priv->leave_user_data);
+
+    GST_OBJECT_LOCK (task);
+    task->thread = NULL;
+  }
+
+  state = GET_TASK_STATE (task);
+  if (G_UNLIKELY (state == GST_TASK_STOPPED))
+    goto exit;
+
+  if (G_UNLIKELY (state == GST_TASK_PAUSED)) {
+    /* set_state() and join() schedule us again */
+    GST_INFO_OBJECT (task, "Task going to paused");
+    priv->scheduled = FALSE;
+    GST_TASK_SIGNAL (task);
+    GST_OBJECT_UNLOCK (task);
+    return;
+  }
+
+  if (G_UNLIKELY (!schedule_cooperative (task)))
+    goto exit;
+  GST_OBJECT_UNLOCK (task);
+
+  return;
+
+exit:
+  priv->scheduled = FALSE;
+  task->running = FALSE;
+  GST_TASK_SIGNAL (task);
+  GST_OBJECT_UNLOCK (task);
+
+  GST_DEBUG ("Exit task %p, thread %p", task, tself);
+
+  gst_object_unref (task);
+  return;
+
+no_lock:
+  {
+    g_warning ("starting task without a lock");
+    goto exit;
+  }
+}
+
 /**
  * gst_task_cleanup_all:
  *
@@ -507,6 +620,61 @@ gst_task_set_pool (GstTask * task, GstTaskPool * pool)
     gst_object_unref (old);
 }
 
+/**
+ * gst_task_set_cooperative:
+ * @task: a #GstTask
+ * @cooperative: %TRUE if the task function never blocks
+ *
+ * Declare that the task function of @task returns quickly and never blocks,
+ * for example on a queue, a clock or a downstream element. Only such tasks
+ * run cooperatively on a #GstWorkerTaskPool, with every iteration scheduled
+ * as a separate work item. Other tasks that have a #GstWorkerTaskPool set
+ * get their own thread from the default pool, so that they can't use up the
+ * workers of the pool by blocking.
+ *
+ * The new value is used the next time @task is started. The default is
+ * %FALSE.
+ *
+ * MT safe.
+ *
+ * Since: 1.4
+ */
+void
+gst_task_set_cooperative (GstTask * task, gboolean cooperative)
+{
+  g_return_if_fail (GST_IS_TASK (task));
+
+  GST_OBJECT_LOCK (task);
+  task->priv->cooperative = cooperative;
+  GST_OBJECT_UNLOCK (task);
+}
+
+/**
+ * gst_task_get_cooperative:
+ * @task: a #GstTask
+ *
+ * Check if @task was declared cooperative with gst_task_set_cooperative().
+ *
+ * MT safe.
+ *
+ * Returns: %TRUE if @task is cooperative.
+ *
+ * Since: 1.4
+ */
+gboolean
+gst_task_get_cooperative (GstTask * task)
+{
+  gboolean result;
+
+  g_return_val_if_fail (GST_IS_TASK (task), FALSE);
+
+  GST_OBJECT_LOCK (task);
+  result = task->priv->cooperative;
+  GST_OBJECT_UNLOCK (task);
+
+  return result;
+}
+
 /**
  * gst_task_set_enter_callback:
  * @task: The #GstTask to use
@@ -517,6 +685,9 @@ gst_task_set_pool (GstTask * task, GstTaskPool * pool)
  * Call @enter_func when the task function of @task is entered. @user_data will
  * be passed to @enter_func and @notify will be called when @user_data is no
  * longer referenced.
+ *
+ * A cooperative task on a #GstWorkerTaskPool enters before every iteration,
+ * on the thread that runs it.
  */
 void
 gst_task_set_enter_callback (GstTask * task, GstTaskThreadFunc enter_func,
@@ -555,6 +726,9 @@ gst_task_set_enter_callback (GstTask * task, GstTaskThreadFunc enter_func,
  * Call @leave_func when the task function of @task is left. @user_data will
  * be passed to @leave_func and @notify will be called when @user_data is no
  * longer referenced.
+ *
+ * A cooperative task on a #GstWorkerTaskPool leaves after every iteration,
+ * on the thread that ran it.
  */
 void
 gst_task_set_leave_callback (GstTask * task, GstTaskThreadFunc leave_func,
@@ -625,15 +799,33 @@ start_task (GstTask * task)
 
   /* push on the thread pool, we remember the original pool because the user
    * could change it later on and then we join to the wrong pool. */
-  priv->pool_id = gst_object_ref (priv->pool);
-  priv->id =
-      gst_task_pool_push (priv->pool_id, (GstTaskPoolFunction) gst_task_func,
-      task, &error);
+  if (GST_IS_WORKER_TASK_POOL (priv->pool) && !priv->cooperative) {
+    /* a task that can block would keep a worker busy for as long as it
+     * blocks, so it gets its own thread from the default pool */
+    GST_DEBUG_OBJECT (task, "task is not cooperative, using default pool");
+    g_mutex_lock (&pool_lock);
+    priv->pool_id = gst_object_ref (GST_TASK_GET_CLASS (task)->pool);
+    g_mutex_unlock (&pool_lock);
+  } else {
+    priv->pool_id = gst_object_ref (priv->pool);
+  }
 
-  if (error != NULL) {
-    g_warning ("failed to create thread: %s", error->message);
-    g_error_free (error);
-    res = FALSE;
+  /* on a worker pool we don't occupy a thread, we schedule each iteration
+   * as a separate work item */
+  priv->iterated = GST_IS_WORKER_TASK_POOL (priv->pool_id);
+  if (priv->iterated) {
+    priv->id = NULL;
+    res = schedule_cooperative (task);
+  } else {
+    priv->id =
+        gst_task_pool_push (priv->pool_id, (GstTaskPoolFunction) gst_task_func,
+        task, &error);
+
+    if (error != NULL) {
+      g_warning ("failed to create thread: %s", error->message);
+      g_error_free (error);
+      res = FALSE;
+    }
   }
   return res;
 }
@@ -681,7 +873,11 @@ gst_task_set_state (GstTask * task, GstTaskState state)
           res = start_task (task);
         break;
       case GST_TASK_PAUSED:
-        /* when we are paused, signal to go to the new state */
+        /* when we are paused, signal to go to the new state. A paused
+         * cooperative task is not scheduled, do that now. */
+        if (task->priv->iterated && task->running
+            && !task->priv->scheduled)
+          res = schedule_cooperative (task);
         GST_TASK_SIGNAL (task);
         break;
       case GST_TASK_STARTED:
@@ -799,6 +995,16 @@ gst_task_join (GstTask * task)
   SET_TASK_STATE (task, GST_TASK_STOPPED);
   /* signal the state change for when it was blocked in PAUSED. */
   GST_TASK_SIGNAL (task);
+  /* a paused cooperative task is not scheduled, schedule it so that it runs
+   * its exit path. If the pool doesn't accept it anymore, we do the cleanup
+   * of the task function ourselves. */
+  if (priv->iterated && task->running && !priv->scheduled) {
+    if (G_UNLIKELY (!schedule_cooperative (task))) {
+      task->running = FALSE;
+      /* the ref of start_task, the caller still has one */
+      gst_object_unref (task);
+    }
+  }
   /* we set the running flag when pushing the task on the thread pool.
    * This means that the task function might not be called when we try
    * to join it here. */
@@ -176,6 +176,9 @@ void            gst_task_set_lock       (GstTask *task, GRecMutex *mutex);
 GstTaskPool *   gst_task_get_pool       (GstTask *task);
 void            gst_task_set_pool       (GstTask *task, GstTaskPool *pool);
 
+void            gst_task_set_cooperative (GstTask *task, gboolean cooperative);
+gboolean        gst_task_get_cooperative (GstTask *task);
+
 void            gst_task_set_enter_callback  (GstTask *task,
                                               GstTaskThreadFunc enter_func,
                                               gpointer user_data,
@@ -94,29 +94,28 @@ static void gst_value_register_intersect_func (GType type1,
 static void gst_value_register_subtract_func (GType minuend_type,
     GType subtrahend_type, GstValueSubtractFunc func);
 
-typedef struct _GstValueUnionInfo GstValueUnionInfo;
-struct _GstValueUnionInfo
+/* the union, intersect and subtract functions are kept in open addressing hash
+ * tables keyed on the pair of types. The tables are only modified at startup,
+ * after that lookups don't need any locking. */
+typedef struct _GstValueDispatchInfo GstValueDispatchInfo;
+struct _GstValueDispatchInfo
 {
   GType type1;
   GType type2;
-  GstValueUnionFunc func;
+  gpointer func;
+  /* func expects the values in the reverse order */
+  gboolean swap;
 };
 
-typedef struct _GstValueIntersectInfo GstValueIntersectInfo;
-struct _GstValueIntersectInfo
+typedef struct _GstValueDispatchTable GstValueDispatchTable;
+struct _GstValueDispatchTable
 {
-  GType type1;
-  GType type2;
-  GstValueIntersectFunc func;
+  GstValueDispatchInfo *infos;
+  guint size;
+  guint n_infos;
 };
 
-typedef struct _GstValueSubtractInfo GstValueSubtractInfo;
-struct _GstValueSubtractInfo
-{
-  GType minuend;
-  GType subtrahend;
-  GstValueSubtractFunc func;
-};
+#define DISPATCH_TABLE_INITIAL_SIZE 64
 
 #define FUNDAMENTAL_TYPE_ID_MAX \
     (G_TYPE_FUNDAMENTAL_MAX >> G_TYPE_FUNDAMENTAL_SHIFT)
@@ -129,14 +128,16 @@ struct _GstValueSubtractInfo
 static GArray *gst_value_table;
 static GHashTable *gst_value_hash;
 static GstValueTable *gst_value_tables_fundamental[FUNDAMENTAL_TYPE_ID_MAX + 1];
-static GArray *gst_value_union_funcs;
-static GArray *gst_value_intersect_funcs;
-static GArray *gst_value_subtract_funcs;
+static GstValueDispatchTable gst_value_union_funcs;
+static GstValueDispatchTable gst_value_intersect_funcs;
+static GstValueDispatchTable gst_value_subtract_funcs;
 
 /* Forward declarations */
 static gchar *gst_value_serialize_fraction (const GValue * value);
 
 static GstValueCompareFunc gst_value_get_compare_func (const GValue * value1);
+static gint gst_value_compare_fraction (const GValue * value1,
+    const GValue * value2);
 static gint gst_value_compare_with_func (const GValue * value1,
     const GValue * value2, GstValueCompareFunc compare);
 
@@ -168,6 +169,92 @@ gst_value_hash_add_type (GType type, const GstValueTable * table)
   g_hash_table_insert (gst_value_hash, (gpointer) type, (gpointer) table);
 }
 
+static inline guint
+gst_value_dispatch_hash (GType type1, GType type2)
+{
+  guint h;
+
+  /* types are either fundamental type ids shifted by 2 or pointers, drop
+   * the bits that are always 0 */
+  h = (guint) (type1 >> 2) * 2654435761u;
+  h ^= (guint) (type2 >> 2) * 40503u;
+
+  return h ^ (h >> 15);
+}
+
+static inline const GstValueDispatchInfo *
+gst_value_dispatch_lookup (const GstValueDispatchTable * table,
+    GType type1, GType type2)
+{
+  const GstValueDispatchInfo *info;
+  guint i, mask;
+
+  if (G_UNLIKELY (table->infos == NULL))
+    return NULL;
+
+  mask = table->size - 1;
+  i = gst_value_dispatch_hash (type1, type2) & mask;
+
+  for (;;) {
+    info = &table->infos[i];
+    if (info->type1 == type1 && info->type2 == type2)
+      return info;
+    if (info->type1 == G_TYPE_INVALID)
+      return NULL;
+    i = (i + 1) & mask;
+  }
+}
+
+static void
+gst_value_dispatch_insert_info (GstValueDispatchTable * table,
+    const GstValueDispatchInfo * info)
+{
+  guint i, mask;
+
+  mask = table->size - 1;
+  i = gst_value_dispatch_hash (info->type1, info->type2) & mask;
+
+  while (table->infos[i].type1 != G_TYPE_INVALID)
+    i = (i + 1) & mask;
+
+  table->infos[i] = *info;
+  table->n_infos++;
+}
+
+/* the first function registered for a pair of types is used, like when the
+ * functions were scanned in registration order */
+static void
+gst_value_dispatch_add (GstValueDispatchTable * table, GType type1,
+    GType type2, gpointer func, gboolean swap)
+{
+  GstValueDispatchInfo info;
+
+  if (gst_value_dispatch_lookup (table, type1, type2))
+    return;
+
+  /* keep the load below 1/2 so that the probe sequences stay short */
+  if ((table->n_infos + 1) * 2 > table->size) {
+    GstValueDispatchInfo *old = table->infos;
+    guint i, old_size = table->size;
+
+    table->size = old_size ? old_size * 2 : DISPATCH_TABLE_INITIAL_SIZE;
+    table->infos = g_new0 (GstValueDispatchInfo, table->size);
+    table->n_infos = 0;
+
+    for (i = 0; i < old_size; i++) {
+      if (old[i].type1 != G_TYPE_INVALID)
+        gst_value_dispatch_insert_info (table, &old[i]);
+    }
+    g_free (old);
+  }
+
+  info.type1 = type1;
+  info.type2 = type2;
+  info.func = func;
+  info.swap = swap;
+  gst_value_dispatch_insert_info (table, &info);
+}
+
 /********
  * list *
  ********/
@@ -4345,7 +4432,18 @@ gst_value_get_compare_func (const GValue * value1)
   /* this is a fast check */
   best = gst_value_hash_lookup_type (type1);
 
-  /* slower checks */
+  /* most types derive from a registered type like enums and flags, find the
+   * closest registered parent type */
+  if (G_UNLIKELY (!best || !best->compare)) {
+    GType parent = type1;
+
+    do {
+      parent = g_type_parent (parent);
+      best = parent ? gst_value_hash_lookup_type (parent) : NULL;
+    } while (parent && (!best || !best->compare));
+  }
+
+  /* slower checks for the interfaces */
   if (G_UNLIKELY (!best || !best->compare)) {
     guint len = gst_value_table->len;
 
@@ -4457,15 +4555,33 @@ gint
 gst_value_compare (const GValue * value1, const GValue * value2)
 {
   GstValueCompareFunc compare;
-  GType ltype;
+  GType ltype, type1, type2;
 
   g_return_val_if_fail (G_IS_VALUE (value1), GST_VALUE_LESS_THAN);
   g_return_val_if_fail (G_IS_VALUE (value2), GST_VALUE_GREATER_THAN);
 
+  type1 = G_VALUE_TYPE (value1);
+  type2 = G_VALUE_TYPE (value2);
+
+  /* fast path for the common fundamental types */
+  if (type1 == type2) {
+    switch (type1) {
+      case G_TYPE_INT:
+        return gst_value_compare_int (value1, value2);
+      case G_TYPE_STRING:
+        return gst_value_compare_string (value1, value2);
+      default:
+        if (type1 == GST_TYPE_FRACTION)
+          return gst_value_compare_fraction (value1, value2);
+        break;
+    }
+  }
+
   /* Special cases: lists and scalar values ("{ 1 }" and "1" are equal),
-     as well as lists and ranges ("{ 1, 2 }" and "[ 1, 2 ]" are equal) */
+     as well as lists and ranges ("{ 1, 2 }" and "[ 1, 2 ]" are equal).
+     The list type is fundamental and can't be derived from. */
   ltype = gst_value_list_get_type ();
-  if (G_VALUE_HOLDS (value1, ltype) && !G_VALUE_HOLDS (value2, ltype)) {
+  if (type1 == ltype && type2 != ltype) {
     gint i, n, ret;
 
     if (gst_value_list_equals_range (value1, value2)) {
@@ -4488,7 +4604,7 @@ gst_value_compare (const GValue * value1, const GValue * value2)
     }
 
     return GST_VALUE_EQUAL;
-  } else if (G_VALUE_HOLDS (value2, ltype) && !G_VALUE_HOLDS (value1, ltype)) {
+  } else if (type2 == ltype && type1 != ltype) {
     gint i, n, ret;
 
     if (gst_value_list_equals_range (value2, value1)) {
@@ -4513,7 +4629,7 @@ gst_value_compare (const GValue * value1, const GValue * value2)
     return GST_VALUE_EQUAL;
   }
 
-  if (G_VALUE_TYPE (value1) != G_VALUE_TYPE (value2))
+  if (type1 != type2)
     return GST_VALUE_UNORDERED;
 
   compare = gst_value_get_compare_func (value1);
@@ -4571,25 +4687,11 @@ gst_value_compare_with_func (const GValue * value1, const GValue * value2,
 gboolean
 gst_value_can_union (const GValue * value1, const GValue * value2)
 {
-  GstValueUnionInfo *union_info;
-  guint i, len;
-
   g_return_val_if_fail (G_IS_VALUE (value1), FALSE);
   g_return_val_if_fail (G_IS_VALUE (value2), FALSE);
 
-  len = gst_value_union_funcs->len;
-
-  for (i = 0; i < len; i++) {
-    union_info = &g_array_index (gst_value_union_funcs, GstValueUnionInfo, i);
-    if (union_info->type1 == G_VALUE_TYPE (value1) &&
-        union_info->type2 == G_VALUE_TYPE (value2))
-      return TRUE;
-    if (union_info->type1 == G_VALUE_TYPE (value2) &&
-        union_info->type2 == G_VALUE_TYPE (value1))
-      return TRUE;
-  }
-
-  return FALSE;
+  return gst_value_dispatch_lookup (&gst_value_union_funcs,
+      G_VALUE_TYPE (value1), G_VALUE_TYPE (value2)) != NULL;
 }
 
 /**
@@ -4605,9 +4707,7 @@ gst_value_can_union (const GValue * value1, const GValue * value2)
 gboolean
 gst_value_union (GValue * dest, const GValue * value1, const GValue * value2)
 {
-  const GstValueUnionInfo *union_info;
-  guint i, len;
-  GType type1, type2;
+  const GstValueDispatchInfo *union_info;
 
   g_return_val_if_fail (dest != NULL, FALSE);
   g_return_val_if_fail (G_IS_VALUE (value1), FALSE);
@@ -4615,18 +4715,14 @@ gst_value_union (GValue * dest, const GValue * value1, const GValue * value2)
   g_return_val_if_fail (gst_value_list_or_array_are_compatible (value1, value2),
       FALSE);
 
-  len = gst_value_union_funcs->len;
-  type1 = G_VALUE_TYPE (value1);
-  type2 = G_VALUE_TYPE (value2);
+  union_info = gst_value_dispatch_lookup (&gst_value_union_funcs,
+      G_VALUE_TYPE (value1), G_VALUE_TYPE (value2));
+  if (union_info) {
+    GstValueUnionFunc func = (GstValueUnionFunc) union_info->func;
 
-  for (i = 0; i < len; i++) {
-    union_info = &g_array_index (gst_value_union_funcs, GstValueUnionInfo, i);
-    if (union_info->type1 == type1 && union_info->type2 == type2) {
-      return union_info->func (dest, value1, value2);
-    }
-    if (union_info->type1 == type2 && union_info->type2 == type1) {
-      return union_info->func (dest, value2, value1);
-    }
+    if (union_info->swap)
+      return func (dest, value2, value1);
+    return func (dest, value1, value2);
   }
 
   gst_value_list_concat (dest, value1, value2);
@@ -4648,13 +4744,10 @@ gst_value_union (GValue * dest, const GValue * value1, const GValue * value2)
 static void
 gst_value_register_union_func (GType type1, GType type2, GstValueUnionFunc func)
 {
-  GstValueUnionInfo union_info;
-
-  union_info.type1 = type1;
-  union_info.type2 = type2;
-  union_info.func = func;
-
-  g_array_append_val (gst_value_union_funcs, union_info);
+  gst_value_dispatch_add (&gst_value_union_funcs, type1, type2,
+      (gpointer) func, FALSE);
+  gst_value_dispatch_add (&gst_value_union_funcs, type2, type1,
+      (gpointer) func, TRUE);
 }
 
 /* intersection */
@@ -4673,36 +4766,27 @@ gst_value_register_union_func (GType type1, GType type2, GstValueUnionFunc func)
 gboolean
 gst_value_can_intersect (const GValue * value1, const GValue * value2)
 {
-  GstValueIntersectInfo *intersect_info;
-  guint i, len;
   GType ltype, type1, type2;
 
   g_return_val_if_fail (G_IS_VALUE (value1), FALSE);
   g_return_val_if_fail (G_IS_VALUE (value2), FALSE);
 
   ltype = gst_value_list_get_type ();
+  type1 = G_VALUE_TYPE (value1);
+  type2 = G_VALUE_TYPE (value2);
 
   /* special cases */
-  if (G_VALUE_HOLDS (value1, ltype) || G_VALUE_HOLDS (value2, ltype))
+  if (type1 == ltype || type2 == ltype)
     return TRUE;
 
-  type1 = G_VALUE_TYPE (value1);
-  type2 = G_VALUE_TYPE (value2);
-
   /* practically all GstValue types have a compare function (_can_compare=TRUE)
    * GstStructure and GstCaps have npot, but are intersectable */
   if (type1 == type2)
     return TRUE;
 
   /* check registered intersect functions */
-  len = gst_value_intersect_funcs->len;
-  for (i = 0; i < len; i++) {
-    intersect_info = &g_array_index (gst_value_intersect_funcs,
-        GstValueIntersectInfo, i);
-    if ((intersect_info->type1 == type1 && intersect_info->type2 == type2) ||
-        (intersect_info->type1 == type2 && intersect_info->type2 == type1))
-      return TRUE;
-  }
+  if (gst_value_dispatch_lookup (&gst_value_intersect_funcs, type1, type2))
+    return TRUE;
 
   return gst_value_can_compare (value1, value2);
 }
@@ -4725,19 +4809,20 @@ gboolean
 gst_value_intersect (GValue * dest, const GValue * value1,
     const GValue * value2)
 {
-  GstValueIntersectInfo *intersect_info;
-  guint i, len;
+  const GstValueDispatchInfo *intersect_info;
   GType ltype, type1, type2;
 
   g_return_val_if_fail (G_IS_VALUE (value1), FALSE);
   g_return_val_if_fail (G_IS_VALUE (value2), FALSE);
 
   ltype = gst_value_list_get_type ();
+  type1 = G_VALUE_TYPE (value1);
+  type2 = G_VALUE_TYPE (value2);
 
   /* special cases first */
-  if (G_VALUE_HOLDS (value1, ltype))
+  if (type1 == ltype)
     return gst_value_intersect_list (dest, value1, value2);
-  if (G_VALUE_HOLDS (value2, ltype))
+  if (type2 == ltype)
     return gst_value_intersect_list (dest, value2, value1);
 
   if (gst_value_compare (value1, value2) == GST_VALUE_EQUAL) {
@@ -4746,19 +4831,14 @@ gst_value_intersect (GValue * dest, const GValue * value1,
     return TRUE;
   }
 
-  type1 = G_VALUE_TYPE (value1);
-  type2 = G_VALUE_TYPE (value2);
+  intersect_info = gst_value_dispatch_lookup (&gst_value_intersect_funcs,
+      type1, type2);
+  if (intersect_info) {
+    GstValueIntersectFunc func = (GstValueIntersectFunc) intersect_info->func;
 
-  len = gst_value_intersect_funcs->len;
-  for (i = 0; i < len; i++) {
-    intersect_info = &g_array_index (gst_value_intersect_funcs,
-        GstValueIntersectInfo, i);
-    if (intersect_info->type1 == type1 && intersect_info->type2 == type2) {
-      return intersect_info->func (dest, value1, value2);
-    }
-    if (intersect_info->type1 == type2 && intersect_info->type2 == type1) {
-      return intersect_info->func (dest, value2, value1);
-    }
+    if (intersect_info->swap)
+      return func (dest, value2, value1);
+    return func (dest, value1, value2);
   }
   return FALSE;
 }
@@ -4782,13 +4862,10 @@ static void
 gst_value_register_intersect_func (GType type1, GType type2,
     GstValueIntersectFunc func)
 {
-  GstValueIntersectInfo intersect_info;
-
-  intersect_info.type1 = type1;
-  intersect_info.type2 = type2;
-  intersect_info.func = func;
-
-  g_array_append_val (gst_value_intersect_funcs, intersect_info);
+  gst_value_dispatch_add (&gst_value_intersect_funcs, type1, type2,
+      (gpointer) func, FALSE);
+  gst_value_dispatch_add (&gst_value_intersect_funcs, type2, type1,
+      (gpointer) func, TRUE);
 }
 
 
@@ -4811,31 +4888,25 @@ gboolean
 gst_value_subtract (GValue * dest, const GValue * minuend,
     const GValue * subtrahend)
 {
-  GstValueSubtractInfo *info;
-  guint i, len;
+  const GstValueDispatchInfo *info;
   GType ltype, mtype, stype;
 
   g_return_val_if_fail (G_IS_VALUE (minuend), FALSE);
   g_return_val_if_fail (G_IS_VALUE (subtrahend), FALSE);
 
   ltype = gst_value_list_get_type ();
+  mtype = G_VALUE_TYPE (minuend);
+  stype = G_VALUE_TYPE (subtrahend);
 
   /* special cases first */
-  if (G_VALUE_HOLDS (minuend, ltype))
+  if (mtype == ltype)
     return gst_value_subtract_from_list (dest, minuend, subtrahend);
-  if (G_VALUE_HOLDS (subtrahend, ltype))
+  if (stype == ltype)
     return gst_value_subtract_list (dest, minuend, subtrahend);
 
-  mtype = G_VALUE_TYPE (minuend);
-  stype = G_VALUE_TYPE (subtrahend);
-
-  len = gst_value_subtract_funcs->len;
-  for (i = 0; i < len; i++) {
-    info = &g_array_index (gst_value_subtract_funcs, GstValueSubtractInfo, i);
-    if (info->minuend == mtype && info->subtrahend == stype) {
-      return info->func (dest, minuend, subtrahend);
-    }
-  }
+  info = gst_value_dispatch_lookup (&gst_value_subtract_funcs, mtype, stype);
+  if (info)
+    return ((GstValueSubtractFunc) info->func) (dest, minuend, subtrahend);
 
   if (gst_value_compare (minuend, subtrahend) != GST_VALUE_EQUAL) {
     if (dest)
@@ -4872,28 +4943,21 @@ gst_value_subtract (GValue * dest, const GValue * minuend,
 gboolean
 gst_value_can_subtract (const GValue * minuend, const GValue * subtrahend)
 {
-  GstValueSubtractInfo *info;
-  guint i, len;
   GType ltype, mtype, stype;
 
   g_return_val_if_fail (G_IS_VALUE (minuend), FALSE);
   g_return_val_if_fail (G_IS_VALUE (subtrahend), FALSE);
 
   ltype = gst_value_list_get_type ();
+  mtype = G_VALUE_TYPE (minuend);
+  stype = G_VALUE_TYPE (subtrahend);
 
   /* special cases */
-  if (G_VALUE_HOLDS (minuend, ltype) || G_VALUE_HOLDS (subtrahend, ltype))
+  if (mtype == ltype || stype == ltype)
     return TRUE;
 
-  mtype = G_VALUE_TYPE (minuend);
-  stype = G_VALUE_TYPE (subtrahend);
-
-  len = gst_value_subtract_funcs->len;
-  for (i = 0; i < len; i++) {
-    info = &g_array_index (gst_value_subtract_funcs, GstValueSubtractInfo, i);
-    if (info->minuend == mtype && info->subtrahend == stype)
-      return TRUE;
-  }
+  if (gst_value_dispatch_lookup (&gst_value_subtract_funcs, mtype, stype))
+    return TRUE;
 
   return gst_value_can_compare (minuend, subtrahend);
 }
@@ -4914,16 +4978,11 @@ static void
 gst_value_register_subtract_func (GType minuend_type, GType subtrahend_type,
     GstValueSubtractFunc func)
 {
-  GstValueSubtractInfo info;
-
   g_return_if_fail (!gst_type_is_fixed (minuend_type)
       || !gst_type_is_fixed (subtrahend_type));
 
-  info.minuend = minuend_type;
-  info.subtrahend = subtrahend_type;
-  info.func = func;
-
-  g_array_append_val (gst_value_subtract_funcs, info);
+  gst_value_dispatch_add (&gst_value_subtract_funcs, minuend_type,
+      subtrahend_type, (gpointer) func, FALSE);
 }
 
 /**
@@ -6005,12 +6064,6 @@ _priv_gst_value_initialize (void)
 {
   gst_value_table = g_array_new (FALSE, FALSE, sizeof (GstValueTable));
   gst_value_hash = g_hash_table_new (NULL, NULL);
-  gst_value_union_funcs = g_array_new (FALSE, FALSE,
-      sizeof (GstValueUnionInfo));
-  gst_value_intersect_funcs = g_array_new (FALSE, FALSE,
-      sizeof (GstValueIntersectInfo));
-  gst_value_subtract_funcs = g_array_new (FALSE, FALSE,
-      sizeof (GstValueSubtractInfo));
 
   {
     static GstValueTable gst_value = {
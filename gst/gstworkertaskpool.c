@@ -0,0 +1,585 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * gstworkertaskpool.c: Task pool with a fixed set of worker threads
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/**
+ * SECTION:gstworkertaskpool
+ * @short_description: Task pool running tasks on a fixed set of workers
+ * @see_also: #GstTaskPool, #GstTask
+ *
+ * #GstWorkerTaskPool is a #GstTaskPool that runs all pushed functions on a
+ * fixed number of worker threads, by default one per CPU. Each worker has
+ * its own queue of work items; functions pushed from a worker are queued on
+ * that worker, other functions are distributed round-robin. A worker that
+ * runs out of work steals items from the other workers.
+ *
+ * When a #GstTask that was declared cooperative with
+ * gst_task_set_cooperative() is configured with a #GstWorkerTaskPool using
+ * gst_task_set_pool(), it does not occupy a thread for its whole lifetime.
+ * Instead, every iteration of the task function is scheduled as a separate
+ * work item that reschedules itself, so that many tasks can share a small,
+ * bounded number of threads. Paused tasks don't use a worker at all.
+ *
+ * Since a worker runs one work item at a time, a task function that blocks
+ * (for example waiting on a queue or on the clock) would keep its worker
+ * busy until it returns. Tasks that are not cooperative, like most pad
+ * tasks, therefore get their own thread from the default pool instead.
+ *
+ * With the #GstWorkerTaskPool:cpu-affinity property, each worker is pinned
+ * to one CPU on systems that support it, which keeps the work items
+ * executed by a worker in the same cache.
+ *
+ * Since: 1.4
+ */
+
+#include "gst_private.h"
+
+#include "gstinfo.h"
+#include "gstworkertaskpool.h"
+
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_SCHED_SETAFFINITY
+#include <sched.h>
+#include <errno.h>
+#endif
+
+GST_DEBUG_CATEGORY_STATIC (worker_task_pool_debug);
+#define GST_CAT_DEFAULT (worker_task_pool_debug)
+
+#define GST_WORKER_TASK_POOL_GET_PRIVATE(obj)  \
+   (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GST_TYPE_WORKER_TASK_POOL, GstWorkerTaskPoolPrivate))
+
+#define DEFAULT_N_WORKERS       0
+#define DEFAULT_CPU_AFFINITY    FALSE
+
+enum
+{
+  PROP_0,
+  PROP_N_WORKERS,
+  PROP_CPU_AFFINITY,
+  PROP_LAST
+};
+
+typedef struct
+{
+  GstTaskPoolFunction func;
+  gpointer user_data;
+} WorkItem;
+
+typedef struct
+{
+  GstWorkerTaskPool *pool;
+  GThread *thread;
+  guint index;
+
+  /* the items queued on this worker. The worker itself takes items from the
+   * head, other workers steal from the tail */
+  GMutex lock;
+  GQueue items;
+} Worker;
+
+struct _GstWorkerTaskPoolPrivate
+{
+  /* configuration, protected with the object lock */
+  guint n_workers;
+  gboolean cpu_affinity;
+
+  /* the running workers, set in prepare and cleared in cleanup */
+  Worker *workers;
+  guint n_active;
+  gint next_worker;
+
+  /* idle workers wait on cond with lock held. n_pending counts the queued
+   * items and n_idle the workers that are about to sleep, both are changed
+   * with atomic operations so that a push only needs to take the lock when
+   * there actually is an idle worker */
+  GMutex lock;
+  GCond cond;
+  gint n_pending;
+  gint n_idle;
+  gboolean stopping;
+};
+
+/* the worker of the current thread, if any */
+static GPrivate current_worker;
+
+static void gst_worker_task_pool_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec);
+static void gst_worker_task_pool_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec);
+static void gst_worker_task_pool_finalize (GObject * object);
+
+static void gst_worker_task_pool_prepare (GstTaskPool * pool, GError ** error);
+static void gst_worker_task_pool_cleanup (GstTaskPool * pool);
+static gpointer gst_worker_task_pool_push (GstTaskPool * pool,
+    GstTaskPoolFunction func, gpointer user_data, GError ** error);
+static void gst_worker_task_pool_join (GstTaskPool * pool, gpointer id);
+
+#define _do_init \
+{ \
+  GST_DEBUG_CATEGORY_INIT (worker_task_pool_debug, "workertaskpool", 0, \
+      "Worker thread pool"); \
+}
+
+G_DEFINE_TYPE_WITH_CODE (GstWorkerTaskPool, gst_worker_task_pool,
+    GST_TYPE_TASK_POOL, _do_init);
+
+static void
+gst_worker_task_pool_class_init (GstWorkerTaskPoolClass * klass)
+{
+  GObjectClass *gobject_class;
+  GstTaskPoolClass *gsttaskpool_class;
+
+  gobject_class = (GObjectClass *) klass;
+  gsttaskpool_class = (GstTaskPoolClass *) klass;
+
+  g_type_class_add_private (klass, sizeof (GstWorkerTaskPoolPrivate));
+
+  gobject_class->set_property = gst_worker_task_pool_set_property;
+  gobject_class->get_property = gst_worker_task_pool_get_property;
+  gobject_class->finalize = gst_worker_task_pool_finalize;
+
+  /**
+   * GstWorkerTaskPool:n-workers:
+   *
+   * The number of worker threads started by the pool, 0 starts one worker
+   * per CPU. Changing the value only has an effect the next time the pool
+   * is prepared.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_N_WORKERS,
+      g_param_spec_uint ("n-workers", "Number of workers",
+          "Number of worker threads (0 = one per CPU)", 0, G_MAXUINT16,
+          DEFAULT_N_WORKERS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstWorkerTaskPool:cpu-affinity:
+   *
+   * Pin each worker thread to a CPU. This is ignored on systems where the
+   * thread affinity can't be configured. Changing the value only has an
+   * effect the next time the pool is prepared.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_CPU_AFFINITY,
+      g_param_spec_boolean ("cpu-affinity", "CPU affinity",
+          "Pin each worker thread to a CPU", DEFAULT_CPU_AFFINITY,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+  gsttaskpool_class->prepare = gst_worker_task_pool_prepare;
+  gsttaskpool_class->cleanup = gst_worker_task_pool_cleanup;
+  gsttaskpool_class->push = gst_worker_task_pool_push;
+  gsttaskpool_class->join = gst_worker_task_pool_join;
+}
+
+static void
+gst_worker_task_pool_init (GstWorkerTaskPool * pool)
+{
+  GstWorkerTaskPoolPrivate *priv;
+
+  priv = pool->priv = GST_WORKER_TASK_POOL_GET_PRIVATE (pool);
+
+  priv->n_workers = DEFAULT_N_WORKERS;
+  priv->cpu_affinity = DEFAULT_CPU_AFFINITY;
+  g_mutex_init (&priv->lock);
+  g_cond_init (&priv->cond);
+}
+
+static void
+gst_worker_task_pool_finalize (GObject * object)
+{
+  GstWorkerTaskPool *pool = GST_WORKER_TASK_POOL (object);
+  GstWorkerTaskPoolPrivate *priv = pool->priv;
+
+  GST_DEBUG ("worker taskpool %p finalize", object);
+
+  /* make sure the workers are gone */
+  gst_worker_task_pool_cleanup (GST_TASK_POOL (pool));
+
+  g_mutex_clear (&priv->lock);
+  g_cond_clear (&priv->cond);
+
+  G_OBJECT_CLASS (gst_worker_task_pool_parent_class)->finalize (object);
+}
+
+static void
+gst_worker_task_pool_set_property (GObject * object, guint prop_id,
+    const GValue * value, GParamSpec * pspec)
+{
+  GstWorkerTaskPool *pool = GST_WORKER_TASK_POOL (object);
+
+  switch (prop_id) {
+    case PROP_N_WORKERS:
+      GST_OBJECT_LOCK (pool);
+      pool->priv->n_workers = g_value_get_uint (value);
+      GST_OBJECT_UNLOCK (pool);
+      break;
+    case PROP_CPU_AFFINITY:
+      GST_OBJECT_LOCK (pool);
+      pool->priv->cpu_affinity = g_value_get_boolean (value);
+      GST_OBJECT_UNLOCK (pool);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static void
+gst_worker_task_pool_get_property (GObject * object, guint prop_id,
+    GValue * value, GParamSpec * pspec)
+{
+  GstWorkerTaskPool *pool = GST_WORKER_TASK_POOL (object);
+
+  switch (prop_id) {
+    case PROP_N_WORKERS:
+      GST_OBJECT_LOCK (pool);
+      g_value_set_uint (value, pool->priv->n_workers);
+      GST_OBJECT_UNLOCK (pool);
+      break;
+    case PROP_CPU_AFFINITY:
+      GST_OBJECT_LOCK (pool);
+      g_value_set_boolean (value, pool->priv->cpu_affinity);
+      GST_OBJECT_UNLOCK (pool);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+  }
+}
+
+static guint
+get_num_processors (void)
+{
+#if GLIB_CHECK_VERSION(2,36,0)
+  return g_get_num_processors ();
+#elif defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+  long n = sysconf (_SC_NPROCESSORS_ONLN);
+
+  return n > 0 ? (guint) n : 1;
+#else
+  return 1;
+#endif
+}
+
+static void
+worker_set_affinity (Worker * worker, guint n_cpus)
+{
+#ifdef HAVE_SCHED_SETAFFINITY
+  cpu_set_t set;
+  guint cpu = worker->index % n_cpus;
+
+  CPU_ZERO (&set);
+  CPU_SET (cpu, &set);
+
+  if (sched_setaffinity (0, sizeof (set), &set) != 0)
+    GST_WARNING_OBJECT (worker->pool, "failed to pin worker %u to CPU %u: %s",
+        worker->index, cpu, g_strerror (errno));
+  else
+    GST_DEBUG_OBJECT (worker->pool, "pinned worker %u to CPU %u",
+        worker->index, cpu);
+#else
+  GST_DEBUG_OBJECT (worker->pool, "CPU affinity not supported");
+#endif
+}
+
+/* take the next item of our own queue */
+static WorkItem *
+worker_pop (Worker * worker)
+{
+  WorkItem *item;
+
+  g_mutex_lock (&worker->lock);
+  item = g_queue_pop_head (&worker->items);
+  g_mutex_unlock (&worker->lock);
+
+  return item;
+}
+
+/* take the last item of the queue of one of the other workers. The owner
+ * takes items from the head, so we leave it the items that it will execute
+ * next and that are most likely still in its cache. */
+static WorkItem *
+worker_steal (Worker * worker)
+{
+  GstWorkerTaskPoolPrivate *priv = worker->pool->priv;
+  WorkItem *item = NULL;
+  guint i;
+
+  for (i = 1; i < priv->n_active && item == NULL; i++) {
+    Worker *victim = &priv->workers[(worker->index + i) % priv->n_active];
+
+    g_mutex_lock (&victim->lock);
+    item = g_queue_pop_tail (&victim->items);
+    g_mutex_unlock (&victim->lock);
+
+    if (item)
+      GST_LOG_OBJECT (worker->pool, "worker %u stole item %p from worker %u",
+          worker->index, item, victim->index);
+  }
+  return item;
+}
+
+static gpointer
+worker_func (Worker * worker)
+{
+  GstWorkerTaskPool *pool = worker->pool;
+  GstWorkerTaskPoolPrivate *priv = pool->priv;
+  gboolean cpu_affinity;
+
+  g_private_set (&current_worker, worker);
+
+  GST_OBJECT_LOCK (pool);
+  cpu_affinity = priv->cpu_affinity;
+  GST_OBJECT_UNLOCK (pool);
+
+  if (cpu_affinity)
+    worker_set_affinity (worker, get_num_processors ());
+
+  GST_DEBUG_OBJECT (pool, "worker %u started", worker->index);
+
+  while (TRUE) {
+    WorkItem *item;
+
+    if ((item = worker_pop (worker)) || (item = worker_steal (worker))) {
+      GstTaskPoolFunction func = item->func;
+      gpointer user_data = item->user_data;
+
+      g_slice_free (WorkItem, item);
+      g_atomic_int_add (&priv->n_pending, -1);
+
+      func (user_data);
+      continue;
+    }
+
+    /* no work, go idle. We first announce that we are idle and then check
+     * for pending work, a push does it the other way around so that either
+     * we see the new item or the push sees us idle and wakes us up. */
+    g_mutex_lock (&priv->lock);
+    g_atomic_int_inc (&priv->n_idle);
+    while (g_atomic_int_get (&priv->n_pending) == 0 && !priv->stopping)
+      g_cond_wait (&priv->cond, &priv->lock);
+    g_atomic_int_add (&priv->n_idle, -1);
+    if (priv->stopping && g_atomic_int_get (&priv->n_pending) == 0) {
+      g_mutex_unlock (&priv->lock);
+      break;
+    }
+    g_mutex_unlock (&priv->lock);
+  }
+
+  GST_DEBUG_OBJECT (pool, "worker %u stopped", worker->index);
+
+  g_private_set (&current_worker, NULL);
+
+  return NULL;
+}
+
+static void
+gst_worker_task_pool_prepare (GstTaskPool * pool, GError ** error)
+{
+  GstWorkerTaskPool *wpool = GST_WORKER_TASK_POOL (pool);
+  GstWorkerTaskPoolPrivate *priv = wpool->priv;
+  guint i, n_workers;
+
+  GST_OBJECT_LOCK (pool);
+  if (priv->workers)
+    goto already_prepared;
+
+  n_workers = priv->n_workers;
+  if (n_workers == 0)
+    n_workers = get_num_processors ();
+
+  GST_DEBUG_OBJECT (pool, "starting %u workers", n_workers);
+
+  priv->stopping = FALSE;
+  priv->n_pending = 0;
+  priv->n_idle = 0;
+  priv->next_worker = 0;
+  priv->workers = g_new0 (Worker, n_workers);
+  for (i = 0; i < n_workers; i++) {
+    Worker *worker = &priv->workers[i];
+
+    worker->pool = wpool;
+    worker->index = i;
+    g_mutex_init (&worker->lock);
+    g_queue_init (&worker->items);
+  }
+  /* the workers steal from all the others, publish the count before
+   * starting any of them */
+  priv->n_active = n_workers;
+
+  for (i = 0; i < n_workers; i++) {
+    Worker *worker = &priv->workers[i];
+    gchar *name;
+
+    name = g_strdup_printf ("gstworker-%u", i);
+    worker->thread = g_thread_try_new (name, (GThreadFunc) worker_func, worker,
+        error);
+    g_free (name);
+
+    if (worker->thread == NULL)
+      goto no_thread;
+  }
+  GST_OBJECT_UNLOCK (pool);
+
+  return;
+
+  /* ERRORS */
+already_prepared:
+  {
+    GST_DEBUG_OBJECT (pool, "pool was already prepared");
+    GST_OBJECT_UNLOCK (pool);
+    return;
+  }
+no_thread:
+  {
+    GST_WARNING_OBJECT (pool, "failed to start worker %u", i);
+    GST_OBJECT_UNLOCK (pool);
+    /* stops and frees the workers that were started */
+    gst_worker_task_pool_cleanup (pool);
+    return;
+  }
+}
+
+static void
+gst_worker_task_pool_cleanup (GstTaskPool * pool)
+{
+  GstWorkerTaskPoolPrivate *priv = GST_WORKER_TASK_POOL (pool)->priv;
+  Worker *workers;
+  guint i, n_active;
+
+  GST_OBJECT_LOCK (pool);
+  workers = priv->workers;
+  n_active = priv->n_active;
+  GST_OBJECT_UNLOCK (pool);
+
+  if (workers == NULL)
+    return;
+
+  GST_DEBUG_OBJECT (pool, "stopping %u workers", n_active);
+
+  /* the workers exit when all queued items are processed, new items are
+   * refused from now on */
+  GST_OBJECT_LOCK (pool);
+  g_mutex_lock (&priv->lock);
+  priv->stopping = TRUE;
+  g_cond_broadcast (&priv->cond);
+  g_mutex_unlock (&priv->lock);
+  GST_OBJECT_UNLOCK (pool);
+
+  for (i = 0; i < n_active; i++) {
+    if (workers[i].thread)
+      g_thread_join (workers[i].thread);
+  }
+
+  GST_OBJECT_LOCK (pool);
+  for (i = 0; i < n_active; i++) {
+    g_warn_if_fail (g_queue_is_empty (&workers[i].items));
+    g_mutex_clear (&workers[i].lock);
+  }
+  g_free (workers);
+  priv->workers = NULL;
+  priv->n_active = 0;
+  GST_OBJECT_UNLOCK (pool);
+}
+
+static gpointer
+gst_worker_task_pool_push (GstTaskPool * pool, GstTaskPoolFunction func,
+    gpointer user_data, GError ** error)
+{
+  GstWorkerTaskPoolPrivate *priv = GST_WORKER_TASK_POOL (pool)->priv;
+  Worker *worker;
+  WorkItem *item;
+
+  worker = g_private_get (&current_worker);
+
+  GST_OBJECT_LOCK (pool);
+  if (G_UNLIKELY (priv->workers == NULL || priv->stopping))
+    goto not_prepared;
+
+  /* keep work pushed from a worker on that worker, spread the rest */
+  if (worker == NULL || worker->pool != GST_WORKER_TASK_POOL_CAST (pool)) {
+    guint idx = (guint) g_atomic_int_add (&priv->next_worker, 1);
+
+    worker = &priv->workers[idx % priv->n_active];
+  }
+
+  item = g_slice_new (WorkItem);
+  item->func = func;
+  item->user_data = user_data;
+
+  g_mutex_lock (&worker->lock);
+  g_queue_push_tail (&worker->items, item);
+  g_mutex_unlock (&worker->lock);
+  GST_OBJECT_UNLOCK (pool);
+
+  GST_LOG_OBJECT (pool, "queued item %p on worker %u", item, worker->index);
+
+  g_atomic_int_inc (&priv->n_pending);
+  if (g_atomic_int_get (&priv->n_idle) > 0) {
+    g_mutex_lock (&priv->lock);
+    g_cond_signal (&priv->cond);
+    g_mutex_unlock (&priv->lock);
+  }
+
+  /* there is nothing to join, items can't be cancelled */
+  return NULL;
+
+  /* ERRORS */
+not_prepared:
+  {
+    GST_OBJECT_UNLOCK (pool);
+    GST_WARNING_OBJECT (pool, "pool is not prepared");
+    g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_THREAD,
+        "worker task pool is not prepared");
+    return NULL;
+  }
+}
+
+static void
+gst_worker_task_pool_join (GstTaskPool * pool, gpointer id)
+{
+  /* we do nothing here, the workers are shared */
+}
+
+/**
+ * gst_worker_task_pool_new:
+ * @n_workers: the number of worker threads, 0 for one per CPU
+ *
+ * Create a new #GstWorkerTaskPool with @n_workers worker threads. The pool
+ * needs to be prepared with gst_task_pool_prepare() before it can be used.
+ *
+ * Returns: (transfer full): a new #GstTaskPool. gst_object_unref() after usage.
+ *
+ * Since: 1.4
+ */
+GstTaskPool *
+gst_worker_task_pool_new (guint n_workers)
+{
+  GstTaskPool *pool;
+
+  pool = g_object_new (GST_TYPE_WORKER_TASK_POOL, "n-workers", n_workers, NULL);
+
+  return pool;
+}
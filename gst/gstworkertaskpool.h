@@ -0,0 +1,75 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * gstworkertaskpool.h: Task pool with a fixed set of worker threads
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_WORKER_TASK_POOL_H__
+#define __GST_WORKER_TASK_POOL_H__
+
+#include <gst/gsttaskpool.h>
+
+G_BEGIN_DECLS
+
+/* --- standard type macros --- */
+#define GST_TYPE_WORKER_TASK_POOL             (gst_worker_task_pool_get_type ())
+#define GST_WORKER_TASK_POOL(pool)            (G_TYPE_CHECK_INSTANCE_CAST ((pool), GST_TYPE_WORKER_TASK_POOL, GstWorkerTaskPool))
+#define GST_IS_WORKER_TASK_POOL(pool)         (G_TYPE_CHECK_INSTANCE_TYPE ((pool), GST_TYPE_WORKER_TASK_POOL))
+#define GST_WORKER_TASK_POOL_CLASS(pclass)    (G_TYPE_CHECK_CLASS_CAST ((pclass), GST_TYPE_WORKER_TASK_POOL, GstWorkerTaskPoolClass))
+#define GST_IS_WORKER_TASK_POOL_CLASS(pclass) (G_TYPE_CHECK_CLASS_TYPE ((pclass), GST_TYPE_WORKER_TASK_POOL))
+#define GST_WORKER_TASK_POOL_GET_CLASS(pool)  (G_TYPE_INSTANCE_GET_CLASS ((pool), GST_TYPE_WORKER_TASK_POOL, GstWorkerTaskPoolClass))
+#define GST_WORKER_TASK_POOL_CAST(pool)       ((GstWorkerTaskPool*)(pool))
+
+typedef struct _GstWorkerTaskPool GstWorkerTaskPool;
+typedef struct _GstWorkerTaskPoolClass GstWorkerTaskPoolClass;
+typedef struct _GstWorkerTaskPoolPrivate GstWorkerTaskPoolPrivate;
+
+/**
+ * GstWorkerTaskPool:
+ *
+ * The opaque #GstWorkerTaskPool object.
+ */
+struct _GstWorkerTaskPool {
+  GstTaskPool    pool;
+
+  /*< private >*/
+  GstWorkerTaskPoolPrivate *priv;
+
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+/**
+ * GstWorkerTaskPoolClass:
+ * @parent_class: the parent class structure
+ *
+ * The #GstWorkerTaskPoolClass object.
+ */
+struct _GstWorkerTaskPoolClass {
+  GstTaskPoolClass parent_class;
+
+  /*< private >*/
+  gpointer _gst_reserved[GST_PADDING];
+};
+
+GType           gst_worker_task_pool_get_type     (void);
+
+GstTaskPool *   gst_worker_task_pool_new          (guint n_workers);
+
+G_END_DECLS
+
+#endif /* __GST_WORKER_TASK_POOL_H__ */
@@ -195,6 +195,20 @@
  * </itemizedlist>
  * </para>
  * </refsect2>
+ * <refsect2>
+ * <title>Parallel transforms</title>
+ * <para>
+ * Sub-classes whose transform of a buffer does not depend on previous
+ * buffers can set the class variable frame_independent. In push mode the
+ * transform and transform_ip methods are then called from a pool of threads
+ * for several buffers at the same time, see
+ * gst_base_transform_set_max_threads(). Negotiation, QoS, allocating the
+ * output buffers and the before_transform method are still handled in order
+ * in the streaming thread, and the results are pushed downstream in the order
+ * of the input buffers. Serialized events and queries wait until all
+ * buffers before them have been pushed.
+ * </para>
+ * </refsect2>
  */
 
 #ifdef HAVE_CONFIG_H
@@ -267,8 +281,44 @@ struct _GstBaseTransformPrivate
   GstAllocator *allocator;
   GstAllocationParams params;
   GstQuery *query;
+
+  /* parallel transforms, with OBJECT_LOCK */
+  guint max_threads;
+  /* only used from the streaming thread, thread_pool is NULL when not
+   * transforming in parallel */
+  GThreadPool *thread_pool;
+  guint window;
+  /* pending jobs in input order, with parallel_lock */
+  GMutex parallel_lock;
+  GCond parallel_cond;
+  GQueue parallel_jobs;
+  GstFlowReturn parallel_ret;
+  /* set while a thread pushes finished jobs */
+  gboolean parallel_pushing;
+  /* only used by the thread that pushes */
+  gboolean parallel_discont;
 };
 
+/* how a buffer is transformed */
+typedef enum
+{
+  TRANSFORM_NONE,
+  TRANSFORM_IP,
+  TRANSFORM_COPY
+} TransformMethod;
+
+/* a buffer that is transformed in the thread pool */
+typedef struct
+{
+  GstBuffer *inbuf;
+  GstBuffer *outbuf;
+  TransformMethod method;
+  GstClockTime position;
+  gboolean discont;
+  GstFlowReturn ret;
+  gboolean done;
+} TransformJob;
+
 
 static GstElementClass *parent_class = NULL;
 
@@ -330,6 +380,11 @@ static GstFlowReturn gst_base_transform_getrange (GstPad * pad,
     GstObject * parent, guint64 offset, guint length, GstBuffer ** buffer);
 static GstFlowReturn gst_base_transform_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static GstFlowReturn gst_base_transform_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
+static GstFlowReturn gst_base_transform_parallel_push (GstBaseTransform *
+    trans, guint max_pending);
+static void gst_base_transform_parallel_discard (GstBaseTransform * trans);
 static GstCaps *gst_base_transform_default_transform_caps (GstBaseTransform *
     trans, GstPadDirection direction, GstCaps * caps, GstCaps * filter);
 static GstCaps *gst_base_transform_default_fixate_caps (GstBaseTransform *
@@ -366,6 +421,11 @@ gst_base_transform_default_transform_meta (GstBaseTransform * trans,
 static void
 gst_base_transform_finalize (GObject * object)
 {
+  GstBaseTransform *trans = GST_BASE_TRANSFORM (object);
+
+  g_mutex_clear (&trans->priv->parallel_lock);
+  g_cond_clear (&trans->priv->parallel_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -439,6 +499,8 @@ gst_base_transform_init (GstBaseTransform * trans,
       GST_DEBUG_FUNCPTR (gst_base_transform_sink_event));
   gst_pad_set_chain_function (trans->sinkpad,
       GST_DEBUG_FUNCPTR (gst_base_transform_chain));
+  gst_pad_set_chain_list_function (trans->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_base_transform_chain_list));
   gst_pad_set_activatemode_function (trans->sinkpad,
       GST_DEBUG_FUNCPTR (gst_base_transform_sink_activate_mode));
   gst_pad_set_query_function (trans->sinkpad,
@@ -480,6 +542,13 @@ gst_base_transform_init (GstBaseTransform * trans,
 
   priv->processed = 0;
   priv->dropped = 0;
+
+  priv->max_threads = 0;
+  priv->thread_pool = NULL;
+  priv->parallel_ret = GST_FLOW_OK;
+  g_mutex_init (&priv->parallel_lock);
+  g_cond_init (&priv->parallel_cond);
+  g_queue_init (&priv->parallel_jobs);
 }
 
 static GstCaps *
@@ -956,6 +1025,23 @@ gst_base_transform_do_bufferpool (GstBaseTransform * trans, GstCaps * outcaps)
     GST_DEBUG_OBJECT (trans, "peer ALLOCATION query failed");
   }
 
+  /* buffers that are being transformed in parallel or wait to be pushed are
+   * not back in the pool yet */
+  if (priv->thread_pool) {
+    guint i, size, min, max;
+
+    for (i = 0; i < gst_query_get_n_allocation_pools (query); i++) {
+      gst_query_parse_nth_allocation_pool (query, i, &pool, &size, &min, &max);
+      min += priv->window;
+      if (max != 0)
+        max = MAX (max + priv->window, min);
+      gst_query_set_nth_allocation_pool (query, i, pool, size, min, max);
+      if (pool)
+        gst_object_unref (pool);
+    }
+    pool = NULL;
+  }
+
   klass = GST_BASE_TRANSFORM_GET_CLASS (trans);
 
   GST_DEBUG_OBJECT (trans, "calling decide_allocation");
@@ -1534,6 +1620,11 @@ gst_base_transform_query (GstPad * pad, GstObject * parent, GstQuery * query)
   trans = GST_BASE_TRANSFORM (parent);
   bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
 
+  /* like serialized events, serialized queries come after the buffers */
+  if (trans->priv->thread_pool && pad == trans->sinkpad &&
+      GST_QUERY_IS_SERIALIZED (query))
+    gst_base_transform_parallel_push (trans, 0);
+
   if (bclass->query)
     ret = bclass->query (trans, GST_PAD_DIRECTION (pad), query);
 
@@ -1815,6 +1906,26 @@ gst_base_transform_sink_event (GstPad * pad, GstObject * parent,
   trans = GST_BASE_TRANSFORM (parent);
   bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
 
+  /* serialized events go after all buffers that came before them */
+  if (trans->priv->thread_pool && GST_EVENT_IS_SERIALIZED (event)) {
+    GstFlowReturn fret;
+
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP) {
+      gst_base_transform_parallel_discard (trans);
+    } else {
+      fret = gst_base_transform_parallel_push (trans, 0);
+      /* no buffer comes after EOS to return the error of the last buffers
+       * upstream, post it instead */
+      if (GST_EVENT_TYPE (event) == GST_EVENT_EOS &&
+          (fret == GST_FLOW_NOT_LINKED || fret < GST_FLOW_EOS)) {
+        GST_ELEMENT_ERROR (trans, STREAM, FAILED,
+            (_("Internal data flow error.")),
+            ("transform stopped, reason %s (%d)", gst_flow_get_name (fret),
+                fret));
+      }
+    }
+  }
+
   if (bclass->sink_event)
     ret = bclass->sink_event (trans, event);
   else
@@ -1933,21 +2044,12 @@ gst_base_transform_src_eventfunc (GstBaseTransform * trans, GstEvent * event)
   return ret;
 }
 
-/* perform a transform on @inbuf and put the result in @outbuf.
- *
- * This function is common to the push and pull-based operations.
- *
- * This function takes ownership of @inbuf */
-static GstFlowReturn
-gst_base_transform_handle_buffer (GstBaseTransform * trans, GstBuffer * inbuf,
-    GstBuffer ** outbuf)
+/* handles a pending reconfigure and checks if buffers can be handled */
+static gboolean
+gst_base_transform_check_negotiated (GstBaseTransform * trans)
 {
   GstBaseTransformClass *bclass;
   GstBaseTransformPrivate *priv = trans->priv;
-  GstFlowReturn ret = GST_FLOW_OK;
-  gboolean want_in_place;
-  GstClockTime running_time;
-  GstClockTime timestamp;
   gboolean reconfigure;
 
   bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
@@ -1973,6 +2075,44 @@ gst_base_transform_handle_buffer (GstBaseTransform * trans, GstBuffer * inbuf,
   }
 
 no_reconfigure:
+  /* Don't allow buffer handling before negotiation, except in passthrough mode
+   * or if the class doesn't implement a set_caps function (in which case it doesn't
+   * care about caps)
+   */
+  if (!priv->negotiated && !priv->passthrough && (bclass->set_caps != NULL))
+    goto not_negotiated;
+
+  return TRUE;
+
+  /* ERRORS */
+not_negotiated:
+  {
+    GST_ELEMENT_WARNING (trans, STREAM, FORMAT,
+        ("not negotiated"), ("not negotiated"));
+    return FALSE;
+  }
+}
+
+/* does everything that needs to happen in order before the transform of
+ * @inbuf: negotiation, QoS and allocating the output buffer.
+ *
+ * On success @outbuf contains the buffer to transform into, otherwise @inbuf
+ * is consumed and @outbuf is NULL. */
+static GstFlowReturn
+gst_base_transform_prepare_buffer (GstBaseTransform * trans, GstBuffer * inbuf,
+    GstBuffer ** outbuf)
+{
+  GstBaseTransformClass *bclass;
+  GstBaseTransformPrivate *priv = trans->priv;
+  GstFlowReturn ret = GST_FLOW_OK;
+  GstClockTime running_time;
+  GstClockTime timestamp;
+
+  bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+
+  if (G_UNLIKELY (!gst_base_transform_check_negotiated (trans)))
+    goto not_negotiated;
+
   if (GST_BUFFER_OFFSET_IS_VALID (inbuf))
     GST_DEBUG_OBJECT (trans,
         "handling buffer %p of size %" G_GSIZE_FORMAT " and offset %"
@@ -1983,13 +2123,6 @@ no_reconfigure:
         "handling buffer %p of size %" G_GSIZE_FORMAT " and offset NONE", inbuf,
         gst_buffer_get_size (inbuf));
 
-  /* Don't allow buffer handling before negotiation, except in passthrough mode
-   * or if the class doesn't implement a set_caps function (in which case it doesn't
-   * care about caps)
-   */
-  if (!priv->negotiated && !priv->passthrough && (bclass->set_caps != NULL))
-    goto not_negotiated;
-
   /* Set discont flag so we can mark the outgoing buffer */
   if (GST_BUFFER_IS_DISCONT (inbuf)) {
     GST_DEBUG_OBJECT (trans, "got DISCONT buffer %p", inbuf);
@@ -2070,54 +2203,24 @@ no_qos:
   GST_DEBUG_OBJECT (trans, "using allocated buffer in %p, out %p", inbuf,
       *outbuf);
 
-  /* now perform the needed transform */
-  if (priv->passthrough) {
-    /* In passthrough mode, give transform_ip a look at the
-     * buffer, without making it writable, or just push the
-     * data through */
-    if (bclass->transform_ip_on_passthrough && bclass->transform_ip) {
-      GST_DEBUG_OBJECT (trans, "doing passthrough transform_ip");
-      ret = bclass->transform_ip (trans, *outbuf);
-    } else {
-      GST_DEBUG_OBJECT (trans, "element is in passthrough");
-    }
-  } else {
-    want_in_place = (bclass->transform_ip != NULL) && priv->always_in_place;
-
-    if (want_in_place) {
-      GST_DEBUG_OBJECT (trans, "doing inplace transform");
-      ret = bclass->transform_ip (trans, *outbuf);
-    } else {
-      GST_DEBUG_OBJECT (trans, "doing non-inplace transform");
-
-      if (bclass->transform)
-        ret = bclass->transform (trans, inbuf, *outbuf);
-      else
-        ret = GST_FLOW_NOT_SUPPORTED;
-    }
-  }
+  return GST_FLOW_OK;
 
 skip:
-  /* only unref input buffer if we allocated a new outbuf buffer. If we reused
-   * the input buffer, no refcount is changed to keep the input buffer writable
-   * when needed. */
-  if (*outbuf != inbuf)
-    gst_buffer_unref (inbuf);
-
-  return ret;
+  gst_buffer_unref (inbuf);
+  *outbuf = NULL;
+  return GST_FLOW_OK;
 
   /* ERRORS */
 not_negotiated:
   {
     gst_buffer_unref (inbuf);
     *outbuf = NULL;
-    GST_ELEMENT_WARNING (trans, STREAM, FORMAT,
-        ("not negotiated"), ("not negotiated"));
     return GST_FLOW_NOT_NEGOTIATED;
   }
 no_prepare:
   {
     gst_buffer_unref (inbuf);
+    *outbuf = NULL;
     GST_ELEMENT_ERROR (trans, STREAM, NOT_IMPLEMENTED,
         ("Sub-class has no prepare_output_buffer implementation"), (NULL));
     return GST_FLOW_NOT_SUPPORTED;
@@ -2132,6 +2235,89 @@ no_buffer:
   }
 }
 
+/* decides how the buffers are transformed in the current configuration */
+static TransformMethod
+gst_base_transform_get_method (GstBaseTransform * trans)
+{
+  GstBaseTransformClass *bclass;
+  GstBaseTransformPrivate *priv = trans->priv;
+
+  bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+
+  if (priv->passthrough) {
+    /* In passthrough mode, give transform_ip a look at the
+     * buffer, without making it writable, or just push the
+     * data through */
+    if (bclass->transform_ip_on_passthrough && bclass->transform_ip)
+      return TRANSFORM_IP;
+    return TRANSFORM_NONE;
+  }
+  if (bclass->transform_ip != NULL && priv->always_in_place)
+    return TRANSFORM_IP;
+
+  return TRANSFORM_COPY;
+}
+
+/* performs the transform of @inbuf into @outbuf, this is the only part that
+ * can run in parallel for different buffers */
+static GstFlowReturn
+gst_base_transform_transform_buffer (GstBaseTransform * trans,
+    TransformMethod method, GstBuffer * inbuf, GstBuffer * outbuf)
+{
+  GstBaseTransformClass *bclass;
+  GstFlowReturn ret;
+
+  bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+
+  switch (method) {
+    case TRANSFORM_IP:
+      GST_DEBUG_OBJECT (trans, "doing inplace transform");
+      ret = bclass->transform_ip (trans, outbuf);
+      break;
+    case TRANSFORM_COPY:
+      GST_DEBUG_OBJECT (trans, "doing non-inplace transform");
+      if (bclass->transform)
+        ret = bclass->transform (trans, inbuf, outbuf);
+      else
+        ret = GST_FLOW_NOT_SUPPORTED;
+      break;
+    case TRANSFORM_NONE:
+    default:
+      GST_DEBUG_OBJECT (trans, "element is in passthrough");
+      ret = GST_FLOW_OK;
+      break;
+  }
+
+  return ret;
+}
+
+/* perform a transform on @inbuf and put the result in @outbuf.
+ *
+ * This function is common to the push and pull-based operations.
+ *
+ * This function takes ownership of @inbuf */
+static GstFlowReturn
+gst_base_transform_handle_buffer (GstBaseTransform * trans, GstBuffer * inbuf,
+    GstBuffer ** outbuf)
+{
+  GstFlowReturn ret;
+
+  ret = gst_base_transform_prepare_buffer (trans, inbuf, outbuf);
+  if (ret != GST_FLOW_OK || *outbuf == NULL)
+    return ret;
+
+  ret = gst_base_transform_transform_buffer (trans,
+      gst_base_transform_get_method (trans), inbuf, *outbuf);
+
+  /* only unref input buffer if we allocated a new outbuf buffer. If we reused
+   * the input buffer, no refcount is changed to keep the input buffer writable
+   * when needed. */
+  if (*outbuf != inbuf)
+    gst_buffer_unref (inbuf);
+
+  return ret;
+}
+
 /* FIXME, getrange is broken, need to pull range from the other
  * end based on the transform_size result.
  */
@@ -2168,76 +2354,76 @@ pull_error:
   }
 }
 
-static GstFlowReturn
-gst_base_transform_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+/* remember the end position of the input and the output */
+static void
+gst_base_transform_update_position (GstBaseTransform * trans,
+    GstClockTime position, GstBuffer * outbuf)
 {
-  GstBaseTransform *trans;
-  GstBaseTransformClass *klass;
-  GstBaseTransformPrivate *priv;
-  GstFlowReturn ret;
-  GstClockTime position = GST_CLOCK_TIME_NONE;
-  GstClockTime timestamp, duration;
-  GstBuffer *outbuf = NULL;
+  GstClockTime position_out = GST_CLOCK_TIME_NONE;
 
-  trans = GST_BASE_TRANSFORM (parent);
-  priv = trans->priv;
+  if (trans->segment.format != GST_FORMAT_TIME)
+    return;
+
+  /* Remember last stop position */
+  if (position != GST_CLOCK_TIME_NONE)
+    trans->segment.position = position;
+
+  if (GST_BUFFER_TIMESTAMP_IS_VALID (outbuf)) {
+    position_out = GST_BUFFER_TIMESTAMP (outbuf);
+    if (GST_BUFFER_DURATION_IS_VALID (outbuf))
+      position_out += GST_BUFFER_DURATION (outbuf);
+  } else if (position != GST_CLOCK_TIME_NONE) {
+    position_out = position;
+  }
+  if (position_out != GST_CLOCK_TIME_NONE)
+    trans->priv->position_out = position_out;
+}
+
+/* calculate end position of a buffer */
+static GstClockTime
+gst_base_transform_buffer_end (GstBuffer * buffer)
+{
+  GstClockTime timestamp, duration;
 
   timestamp = GST_BUFFER_TIMESTAMP (buffer);
   duration = GST_BUFFER_DURATION (buffer);
 
-  /* calculate end position of the incoming buffer */
-  if (timestamp != GST_CLOCK_TIME_NONE) {
-    if (duration != GST_CLOCK_TIME_NONE)
-      position = timestamp + duration;
-    else
-      position = timestamp;
-  }
+  if (timestamp != GST_CLOCK_TIME_NONE && duration != GST_CLOCK_TIME_NONE)
+    return timestamp + duration;
 
-  klass = GST_BASE_TRANSFORM_GET_CLASS (trans);
-  if (klass->before_transform)
-    klass->before_transform (trans, buffer);
+  return timestamp;
+}
 
-  /* protect transform method and concurrent buffer alloc */
-  ret = gst_base_transform_handle_buffer (trans, buffer, &outbuf);
+/* handles the result @ret of transforming a buffer that ends at @position
+ * into @outbuf, in input order. @outbuf is set to NULL when nothing needs to
+ * be pushed */
+static GstFlowReturn
+gst_base_transform_finish_buffer (GstBaseTransform * trans,
+    GstClockTime position, GstFlowReturn ret, GstBuffer ** outbuf)
+{
+  GstBaseTransformPrivate *priv = trans->priv;
 
   /* outbuf can be NULL, this means a dropped buffer, if we have a buffer but
    * GST_BASE_TRANSFORM_FLOW_DROPPED we will not push either. */
-  if (outbuf != NULL) {
+  if (*outbuf != NULL) {
     if (ret == GST_FLOW_OK) {
-      GstClockTime position_out = GST_CLOCK_TIME_NONE;
-
-      /* Remember last stop position */
-      if (position != GST_CLOCK_TIME_NONE &&
-          trans->segment.format == GST_FORMAT_TIME)
-        trans->segment.position = position;
-
-      if (GST_BUFFER_TIMESTAMP_IS_VALID (outbuf)) {
-        position_out = GST_BUFFER_TIMESTAMP (outbuf);
-        if (GST_BUFFER_DURATION_IS_VALID (outbuf))
-          position_out += GST_BUFFER_DURATION (outbuf);
-      } else if (position != GST_CLOCK_TIME_NONE) {
-        position_out = position;
-      }
-      if (position_out != GST_CLOCK_TIME_NONE
-          && trans->segment.format == GST_FORMAT_TIME)
-        priv->position_out = position_out;
+      gst_base_transform_update_position (trans, position, *outbuf);
 
       /* apply DISCONT flag if the buffer is not yet marked as such */
-      if (trans->priv->discont) {
+      if (priv->discont) {
         GST_DEBUG_OBJECT (trans, "we have a pending DISCONT");
-        if (!GST_BUFFER_IS_DISCONT (outbuf)) {
+        if (!GST_BUFFER_IS_DISCONT (*outbuf)) {
           GST_DEBUG_OBJECT (trans, "marking DISCONT on output buffer");
-          outbuf = gst_buffer_make_writable (outbuf);
-          GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
+          *outbuf = gst_buffer_make_writable (*outbuf);
+          GST_BUFFER_FLAG_SET (*outbuf, GST_BUFFER_FLAG_DISCONT);
         }
         priv->discont = FALSE;
       }
       priv->processed++;
-
-      ret = gst_pad_push (trans->srcpad, outbuf);
     } else {
       GST_DEBUG_OBJECT (trans, "we got return %s", gst_flow_get_name (ret));
-      gst_buffer_unref (outbuf);
+      gst_buffer_unref (*outbuf);
+      *outbuf = NULL;
     }
   }
 
@@ -2251,6 +2437,407 @@ gst_base_transform_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   return ret;
 }
 
+/* transforms @buffer and places the buffer to push in @outbuf, which is NULL
+ * when nothing needs to be pushed */
+static GstFlowReturn
+gst_base_transform_process (GstBaseTransform * trans, GstBuffer * buffer,
+    GstBuffer ** outbuf)
+{
+  GstBaseTransformClass *klass;
+  GstFlowReturn ret;
+  GstClockTime position;
+
+  position = gst_base_transform_buffer_end (buffer);
+
+  klass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+  if (klass->before_transform)
+    klass->before_transform (trans, buffer);
+
+  /* protect transform method and concurrent buffer alloc */
+  *outbuf = NULL;
+  ret = gst_base_transform_handle_buffer (trans, buffer, outbuf);
+
+  return gst_base_transform_finish_buffer (trans, position, ret, outbuf);
+}
+
+/* finishes the oldest job and pushes its result. Called without
+ * parallel_lock by the thread that set parallel_pushing. */
+static GstFlowReturn
+gst_base_transform_parallel_finish (GstBaseTransform * trans,
+    TransformJob * job)
+{
+  GstBaseTransformPrivate *priv = trans->priv;
+  GstBuffer *outbuf = job->outbuf;
+  GstFlowReturn ret = job->ret;
+  gboolean discont;
+
+  /* the streaming thread owns priv->discont, see
+   * gst_base_transform_finish_buffer() for the single buffer version */
+  discont = job->discont || priv->parallel_discont;
+  priv->parallel_discont = FALSE;
+
+  if (ret == GST_FLOW_OK) {
+    gst_base_transform_update_position (trans, job->position, outbuf);
+    if (discont && !GST_BUFFER_IS_DISCONT (outbuf)) {
+      GST_DEBUG_OBJECT (trans, "marking DISCONT on output buffer");
+      outbuf = gst_buffer_make_writable (outbuf);
+      GST_BUFFER_FLAG_SET (outbuf, GST_BUFFER_FLAG_DISCONT);
+    }
+    priv->processed++;
+    return gst_pad_push (trans->srcpad, outbuf);
+  }
+
+  gst_buffer_unref (outbuf);
+  if (ret == GST_BASE_TRANSFORM_FLOW_DROPPED) {
+    GST_DEBUG_OBJECT (trans, "dropped a buffer, marking DISCONT");
+    discont = TRUE;
+    ret = GST_FLOW_OK;
+  }
+  priv->parallel_discont = discont;
+
+  return ret;
+}
+
+/* pushes the results of the finished jobs at the head of the queue in input
+ * order, unless another thread is already doing that. Called with
+ * parallel_lock, which is released while pushing. */
+static void
+gst_base_transform_parallel_push_done (GstBaseTransform * trans)
+{
+  GstBaseTransformPrivate *priv = trans->priv;
+  TransformJob *job;
+  GstFlowReturn ret;
+
+  if (priv->parallel_pushing)
+    return;
+  priv->parallel_pushing = TRUE;
+
+  while ((job = g_queue_peek_head (&priv->parallel_jobs)) && job->done) {
+    g_queue_pop_head (&priv->parallel_jobs);
+    /* after an error, drop the results until upstream saw the error */
+    if (priv->parallel_ret == GST_FLOW_OK) {
+      g_mutex_unlock (&priv->parallel_lock);
+      ret = gst_base_transform_parallel_finish (trans, job);
+      g_mutex_lock (&priv->parallel_lock);
+
+      if (ret != GST_FLOW_OK && priv->parallel_ret == GST_FLOW_OK) {
+        GST_DEBUG_OBJECT (trans, "got %s for transformed buffer",
+            gst_flow_get_name (ret));
+        priv->parallel_ret = ret;
+      }
+    } else {
+      gst_buffer_unref (job->outbuf);
+    }
+    g_slice_free (TransformJob, job);
+  }
+
+  priv->parallel_pushing = FALSE;
+  g_cond_broadcast (&priv->parallel_cond);
+}
+
+/* called from the thread pool. The result is pushed right away when it is the
+ * oldest one, so that no buffer waits for the next input. */
+static void
+gst_base_transform_parallel_func (gpointer data, gpointer user_data)
+{
+  GstBaseTransform *trans = user_data;
+  GstBaseTransformPrivate *priv = trans->priv;
+  TransformJob *job = data;
+
+  job->ret = gst_base_transform_transform_buffer (trans, job->method,
+      job->inbuf, job->outbuf);
+
+  /* see gst_base_transform_handle_buffer() */
+  if (job->outbuf != job->inbuf)
+    gst_buffer_unref (job->inbuf);
+  job->inbuf = NULL;
+
+  g_mutex_lock (&priv->parallel_lock);
+  job->done = TRUE;
+  g_cond_broadcast (&priv->parallel_cond);
+  gst_base_transform_parallel_push_done (trans);
+  g_mutex_unlock (&priv->parallel_lock);
+}
+
+/* waits until no more than @max_pending jobs are pending, use 0 to wait until
+ * the results of all jobs were pushed. Returns the flow return of the pushed
+ * results. Called from the streaming thread. */
+static GstFlowReturn
+gst_base_transform_parallel_push (GstBaseTransform * trans, guint max_pending)
+{
+  GstBaseTransformPrivate *priv = trans->priv;
+  GstFlowReturn ret;
+
+  g_mutex_lock (&priv->parallel_lock);
+  while (TRUE) {
+    gst_base_transform_parallel_push_done (trans);
+    if (g_queue_get_length (&priv->parallel_jobs) <= max_pending &&
+        (max_pending > 0 || !priv->parallel_pushing))
+      break;
+    g_cond_wait (&priv->parallel_cond, &priv->parallel_lock);
+  }
+  ret = priv->parallel_ret;
+  g_mutex_unlock (&priv->parallel_lock);
+
+  return ret;
+}
+
+/* waits for all pending jobs and drops their results */
+static void
+gst_base_transform_parallel_discard (GstBaseTransform * trans)
+{
+  GstBaseTransformPrivate *priv = trans->priv;
+  TransformJob *job;
+
+  g_mutex_lock (&priv->parallel_lock);
+  /* keep the pool threads from pushing while we drop the jobs */
+  while (priv->parallel_pushing)
+    g_cond_wait (&priv->parallel_cond, &priv->parallel_lock);
+  priv->parallel_pushing = TRUE;
+
+  while ((job = g_queue_peek_head (&priv->parallel_jobs))) {
+    if (!job->done) {
+      g_cond_wait (&priv->parallel_cond, &priv->parallel_lock);
+      continue;
+    }
+    g_queue_pop_head (&priv->parallel_jobs);
+    if (job->outbuf)
+      gst_buffer_unref (job->outbuf);
+    g_slice_free (TransformJob, job);
+  }
+  priv->parallel_ret = GST_FLOW_OK;
+  priv->parallel_discont = FALSE;
+  priv->parallel_pushing = FALSE;
+  g_cond_broadcast (&priv->parallel_cond);
+  g_mutex_unlock (&priv->parallel_lock);
+}
+
+/* chain function when transforming in parallel. Everything but the transform
+ * itself happens here in order, the transform is done in the thread pool and
+ * the results are pushed in input order as soon as they are done. Errors
+ * from downstream are returned on the next buffer. */
+static GstFlowReturn
+gst_base_transform_chain_parallel (GstBaseTransform * trans,
+    GstBuffer * buffer)
+{
+  GstBaseTransformClass *klass;
+  GstBaseTransformPrivate *priv = trans->priv;
+  GstFlowReturn ret;
+  GstClockTime position;
+  GstBuffer *outbuf = NULL;
+  TransformJob *job;
+
+  /* a new configuration can't be applied while buffers are being
+   * transformed with the old one */
+  if (G_UNLIKELY (GST_PAD_NEEDS_RECONFIGURE (trans->srcpad)))
+    gst_base_transform_parallel_push (trans, 0);
+
+  position = gst_base_transform_buffer_end (buffer);
+
+  klass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+  if (klass->before_transform)
+    klass->before_transform (trans, buffer);
+
+  ret = gst_base_transform_prepare_buffer (trans, buffer, &outbuf);
+  if (ret != GST_FLOW_OK || outbuf == NULL)
+    goto done;
+
+  job = g_slice_new (TransformJob);
+  job->inbuf = buffer;
+  job->outbuf = outbuf;
+  job->method = gst_base_transform_get_method (trans);
+  job->position = position;
+  /* the DISCONT flag goes on the output of this buffer */
+  job->discont = priv->discont;
+  priv->discont = FALSE;
+  job->ret = GST_FLOW_OK;
+  job->done = FALSE;
+
+  g_mutex_lock (&priv->parallel_lock);
+  g_queue_push_tail (&priv->parallel_jobs, job);
+  g_mutex_unlock (&priv->parallel_lock);
+
+  if (job->method == TRANSFORM_NONE)
+    gst_base_transform_parallel_func (job, trans);
+  else
+    g_thread_pool_push (priv->thread_pool, job, NULL);
+
+  /* wait when the window is full */
+  gst_base_transform_parallel_push (trans, priv->window);
+
+done:
+  g_mutex_lock (&priv->parallel_lock);
+  if (ret == GST_FLOW_OK)
+    ret = priv->parallel_ret;
+  priv->parallel_ret = GST_FLOW_OK;
+  g_mutex_unlock (&priv->parallel_lock);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_base_transform_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  GstBaseTransform *trans;
+  GstFlowReturn ret;
+  GstBuffer *outbuf;
+
+  trans = GST_BASE_TRANSFORM (parent);
+
+  if (trans->priv->thread_pool)
+    return gst_base_transform_chain_parallel (trans, buffer);
+
+  ret = gst_base_transform_process (trans, buffer, &outbuf);
+
+  if (outbuf != NULL)
+    ret = gst_pad_push (trans->srcpad, outbuf);
+
+  return ret;
+}
+
+/* transforms the list with the transform_list vmethod */
+static GstFlowReturn
+gst_base_transform_transform_list (GstBaseTransform * trans,
+    GstBufferList * list)
+{
+  GstBaseTransformClass *klass;
+  GstBaseTransformPrivate *priv = trans->priv;
+  GstFlowReturn ret;
+  GstClockTime position = GST_CLOCK_TIME_NONE;
+  GstBuffer *buffer;
+  guint len;
+
+  klass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+
+  if (G_UNLIKELY (!gst_base_transform_check_negotiated (trans)))
+    return GST_FLOW_NOT_NEGOTIATED;
+
+  len = gst_buffer_list_length (list);
+  if (len > 0) {
+    buffer = gst_buffer_list_get (list, 0);
+    if (GST_BUFFER_IS_DISCONT (buffer)) {
+      GST_DEBUG_OBJECT (trans, "got DISCONT buffer %p", buffer);
+      priv->discont = TRUE;
+    }
+    position = gst_base_transform_buffer_end (gst_buffer_list_get (list,
+            len - 1));
+  }
+
+  ret = klass->transform_list (trans, list);
+
+  if (ret == GST_FLOW_OK && (len = gst_buffer_list_length (list)) > 0) {
+    gst_base_transform_update_position (trans, position,
+        gst_buffer_list_get (list, len - 1));
+
+    buffer = gst_buffer_list_get (list, 0);
+    if (priv->discont && !GST_BUFFER_IS_DISCONT (buffer)) {
+      GST_DEBUG_OBJECT (trans, "marking DISCONT on output buffer");
+      buffer = gst_buffer_make_writable (gst_buffer_ref (buffer));
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+      gst_buffer_list_remove (list, 0, 1);
+      gst_buffer_list_insert (list, 0, buffer);
+    }
+    priv->discont = FALSE;
+    priv->processed += len;
+  }
+
+  return ret;
+}
+
+/* pushes the output buffers collected in @pending and frees it */
+static GstFlowReturn
+gst_base_transform_push_pending (GstBaseTransform * trans,
+    GstBufferList ** pending)
+{
+  GstBufferList *list = *pending;
+
+  *pending = NULL;
+  if (list == NULL)
+    return GST_FLOW_OK;
+
+  return gst_pad_push_list (trans->srcpad, list);
+}
+
+static GstFlowReturn
+gst_base_transform_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstBaseTransform *trans;
+  GstBaseTransformClass *klass;
+  GstFlowReturn ret = GST_FLOW_OK, push_ret;
+  GstBufferList *pending = NULL;
+  GstBuffer *buffer, *outbuf;
+  guint i, len;
+
+  trans = GST_BASE_TRANSFORM (parent);
+  klass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+
+  len = gst_buffer_list_length (list);
+
+  if (klass->transform_list) {
+    /* the buffers are replaced by the output buffers */
+    list = gst_buffer_list_make_writable (list);
+
+    /* keep the order with buffers that are still being transformed */
+    if (trans->priv->thread_pool)
+      gst_base_transform_parallel_push (trans, 0);
+
+    ret = gst_base_transform_transform_list (trans, list);
+
+    if (ret == GST_BASE_TRANSFORM_FLOW_DROPPED) {
+      GST_DEBUG_OBJECT (trans, "dropped a list, marking DISCONT");
+      trans->priv->discont = TRUE;
+      gst_buffer_list_unref (list);
+      return GST_FLOW_OK;
+    } else if (ret != GST_FLOW_OK) {
+      GST_DEBUG_OBJECT (trans, "we got return %s", gst_flow_get_name (ret));
+      gst_buffer_list_unref (list);
+      return ret;
+    }
+
+    if (gst_buffer_list_length (list) == 0) {
+      gst_buffer_list_unref (list);
+      return GST_FLOW_OK;
+    }
+    return gst_pad_push_list (trans->srcpad, list);
+  }
+
+  /* Only the output of in-place and passthrough transforms is collected and
+   * pushed as one list. Transforms into new buffers are pushed one by one, so
+   * that a bounded pool downstream can't run dry in the middle of a list and
+   * so that buffers the subclass pushes itself stay in order. */
+  for (i = 0; i < len && ret == GST_FLOW_OK; i++) {
+    buffer = gst_buffer_ref (gst_buffer_list_get (list, i));
+
+    if (trans->priv->thread_pool
+        || GST_PAD_NEEDS_RECONFIGURE (trans->srcpad)
+        || gst_base_transform_get_method (trans) == TRANSFORM_COPY) {
+      /* a reconfigure pushes new caps, push what we have before it */
+      ret = gst_base_transform_push_pending (trans, &pending);
+      if (ret == GST_FLOW_OK)
+        ret = gst_base_transform_chain (pad, parent, buffer);
+      else
+        gst_buffer_unref (buffer);
+      continue;
+    }
+
+    ret = gst_base_transform_process (trans, buffer, &outbuf);
+    if (outbuf != NULL) {
+      if (pending == NULL)
+        pending = gst_buffer_list_new_sized (len - i);
+      gst_buffer_list_add (pending, outbuf);
+    }
+  }
+  gst_buffer_list_unref (list);
+
+  /* push what was transformed before an error, like for single buffers */
+  push_ret = gst_base_transform_push_pending (trans, &pending);
+  if (ret == GST_FLOW_OK)
+    ret = push_ret;
+
+  return ret;
+}
+
 static void
 gst_base_transform_set_property (GObject * object, guint prop_id,
     const GValue * value, GParamSpec * pspec)
@@ -2287,6 +2874,70 @@ gst_base_transform_get_property (GObject * object, guint prop_id,
   }
 }
 
+/* creates the thread pool when the subclass can transform buffers in
+ * parallel */
+static void
+gst_base_transform_start_parallel (GstBaseTransform * trans)
+{
+  GstBaseTransformClass *bclass;
+  GstBaseTransformPrivate *priv = trans->priv;
+  GError *err = NULL;
+  guint n_threads;
+
+  bclass = GST_BASE_TRANSFORM_GET_CLASS (trans);
+  if (!bclass->frame_independent)
+    return;
+
+  GST_OBJECT_LOCK (trans);
+  n_threads = priv->max_threads;
+  GST_OBJECT_UNLOCK (trans);
+
+  if (n_threads == 0) {
+#if GLIB_CHECK_VERSION(2,36,0)
+    n_threads = g_get_num_processors ();
+#else
+    n_threads = 1;
+#endif
+  }
+  if (n_threads < 2)
+    return;
+
+  priv->thread_pool = g_thread_pool_new (gst_base_transform_parallel_func,
+      trans, n_threads, FALSE, &err);
+  if (priv->thread_pool == NULL)
+    goto no_pool;
+
+  /* enough jobs to keep all threads busy while the oldest one finishes */
+  priv->window = 2 * n_threads;
+  priv->parallel_ret = GST_FLOW_OK;
+  priv->parallel_pushing = FALSE;
+  priv->parallel_discont = FALSE;
+  GST_DEBUG_OBJECT (trans, "transforming with %u threads", n_threads);
+  return;
+
+  /* ERRORS */
+no_pool:
+  {
+    GST_WARNING_OBJECT (trans, "could not create thread pool: %s",
+        err->message);
+    g_clear_error (&err);
+    return;
+  }
+}
+
+static void
+gst_base_transform_stop_parallel (GstBaseTransform * trans)
+{
+  GstBaseTransformPrivate *priv = trans->priv;
+
+  if (priv->thread_pool == NULL)
+    return;
+
+  gst_base_transform_parallel_discard (trans);
+  g_thread_pool_free (priv->thread_pool, FALSE, TRUE);
+  priv->thread_pool = NULL;
+}
+
 /* not a vmethod of anything, just an internal method */
 static gboolean
 gst_base_transform_activate (GstBaseTransform * trans, gboolean active)
@@ -2303,6 +2954,9 @@ gst_base_transform_activate (GstBaseTransform * trans, gboolean active)
     if (priv->pad_mode == GST_PAD_MODE_NONE && bclass->start)
       result &= bclass->start (trans);
 
+    if (priv->pad_mode == GST_PAD_MODE_NONE)
+      gst_base_transform_start_parallel (trans);
+
     incaps = gst_pad_get_current_caps (trans->sinkpad);
     outcaps = gst_pad_get_current_caps (trans->srcpad);
 
@@ -2334,6 +2988,9 @@ gst_base_transform_activate (GstBaseTransform * trans, gboolean active)
     GST_PAD_STREAM_LOCK (trans->sinkpad);
     GST_PAD_STREAM_UNLOCK (trans->sinkpad);
 
+    /* the subclass can't be called anymore after stop */
+    gst_base_transform_stop_parallel (trans);
+
     priv->have_same_caps = FALSE;
     /* We can only reset the passthrough mode if the instance told us to 
        handle it in configure_caps */
@@ -2663,6 +3320,65 @@ gst_base_transform_set_prefer_passthrough (GstBaseTransform * trans,
   GST_OBJECT_UNLOCK (trans);
 }
 
+/**
+ * gst_base_transform_set_max_threads:
+ * @trans: a #GstBaseTransform
+ * @max_threads: the maximum number of threads, 0 to use one thread per
+ *     processor
+ *
+ * Set the maximum number of threads that transform buffers at the same time
+ * when the subclass set frame_independent in its class. A value of 1
+ * disables parallel transforms. The default is 0.
+ *
+ * The transformed buffers are pushed downstream in input order from the
+ * threads that transform them, as soon as all buffers before them were
+ * pushed.
+ *
+ * The new value is used the next time @trans is activated.
+ *
+ * MT safe.
+ *
+ * Since: 1.4
+ */
+void
+gst_base_transform_set_max_threads (GstBaseTransform * trans,
+    guint max_threads)
+{
+  g_return_if_fail (GST_IS_BASE_TRANSFORM (trans));
+
+  GST_OBJECT_LOCK (trans);
+  trans->priv->max_threads = max_threads;
+  GST_DEBUG_OBJECT (trans, "max threads %u", max_threads);
+  GST_OBJECT_UNLOCK (trans);
+}
+
+/**
+ * gst_base_transform_get_max_threads:
+ * @trans: a #GstBaseTransform
+ *
+ * Get the maximum number of threads that transform buffers at the same time,
+ * see gst_base_transform_set_max_threads().
+ *
+ * Returns: the maximum number of threads, 0 for one thread per processor.
+ *
+ * MT safe.
+ *
+ * Since: 1.4
+ */
+guint
+gst_base_transform_get_max_threads (GstBaseTransform * trans)
+{
+  guint result;
+
+  g_return_val_if_fail (GST_IS_BASE_TRANSFORM (trans), 0);
+
+  GST_OBJECT_LOCK (trans);
+  result = trans->priv->max_threads;
+  GST_OBJECT_UNLOCK (trans);
+
+  return result;
+}
+
 /**
  * gst_base_transform_reconfigure_sink:
  * @trans: a #GstBaseTransform
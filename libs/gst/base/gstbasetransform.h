@@ -189,6 +189,21 @@ struct _GstBaseTransform {
  *                  of the outgoing buffer.
  * @transform_ip:   Required if the element operates in-place.
  *                  Transform the incoming buffer in-place.
+ * @transform_list: Optional. Since: 1.4
+ *                  Transform all buffers of the incoming writable buffer list
+ *                  at once. Buffers can be modified, replaced, removed or
+ *                  added. The resulting list is pushed downstream. When not
+ *                  set, the buffers of a list are transformed one by one with
+ *                  the other methods. The results of in-place and passthrough
+ *                  transforms are pushed downstream as one list, so
+ *                  @transform_ip must not push buffers itself; the results
+ *                  of @transform are pushed one by one.
+ * @frame_independent: Since: 1.4. If set to %TRUE, the transform of a buffer
+ *                     does not depend on other buffers and @transform and
+ *                     @transform_ip can be called for several buffers from
+ *                     different threads at the same time, see
+ *                     gst_base_transform_set_max_threads().
+ *                     Set to %FALSE by default.
  *
  * Subclasses can override any of the available virtual methods or not, as
  * needed. At minimum either @transform or @transform_ip need to be overridden.
@@ -258,8 +273,12 @@ struct _GstBaseTransformClass {
                                  GstBuffer *outbuf);
   GstFlowReturn (*transform_ip) (GstBaseTransform *trans, GstBuffer *buf);
 
+  GstFlowReturn (*transform_list) (GstBaseTransform *trans, GstBufferList *list);
+
+  gboolean       frame_independent;
+
   /*< private >*/
-  gpointer       _gst_reserved[GST_PADDING_LARGE];
+  gpointer       _gst_reserved[GST_PADDING_LARGE - 2];
 };
 
 GType           gst_base_transform_get_type         (void);
@@ -286,6 +305,10 @@ void            gst_base_transform_set_gap_aware    (GstBaseTransform *trans,
 void            gst_base_transform_set_prefer_passthrough (GstBaseTransform *trans,
                                                            gboolean prefer_passthrough);
 
+void            gst_base_transform_set_max_threads  (GstBaseTransform *trans,
+                                                     guint max_threads);
+guint           gst_base_transform_get_max_threads  (GstBaseTransform *trans);
+
 GstBufferPool * gst_base_transform_get_buffer_pool  (GstBaseTransform *trans);
 void            gst_base_transform_get_allocator    (GstBaseTransform *trans,
                                                      GstAllocator **allocator,
@@ -70,6 +70,14 @@
  *     Thus these pads may but need not have data when the callback is called.
  *     All pads are in waiting mode by default.
  *   </para></listitem>
+ *   <listitem><para>
+ *     Live elements such as mixers can use gst_collect_pads_set_live(). The
+ *     callback is then not called when all pads have data but from a
+ *     separate thread at regular intervals, synchronized to the clock, with
+ *     whatever data is available at that moment. A pad that is late does
+ *     not stall the output, gst_collect_pads_get_lateness() tells how late
+ *     it was.
+ *   </para></listitem>
  * </itemizedlist>
  *
  * Last reviewed on 2011-10-28 (0.10.36)
@@ -96,6 +104,17 @@ struct _GstCollectDataPrivate
   /* refcounting for struct, and destroy callback */
   GstCollectDataDestroyNotify destroy_notify;
   gint refcount;
+
+  /* live mode: buffer handed over by the chain function, only taken out with
+   * STREAM_LOCK */
+  GstBuffer *pending;
+  /* with STREAM_LOCK */
+  GstClockTime end_position;
+  GstClockTimeDiff lateness;
+
+  /* live mode: taken when collectpads updates the segment and around the
+   * clip function, which runs without STREAM_LOCK */
+  GMutex segment_lock;
 };
 
 struct _GstCollectPadsPrivate
@@ -138,6 +157,19 @@ struct _GstCollectPadsPrivate
   gboolean seeking;
   gboolean pending_flush_start;
   gboolean pending_flush_stop;
+
+  /* live mode, with LOCK */
+  gboolean live;
+  GstElement *live_element;
+  GstClockTime interval;
+  GstClockTime latency;
+  GstClockID clock_id;
+
+  /* live mode, with STREAM_LOCK */
+  GstTask *task;
+  GRecMutex task_lock;
+  GstClockTime live_time;       /* running time of the next output */
+  gint live_ret;                /* atomic, returned from the chain functions */
 };
 
 static void gst_collect_pads_clear (GstCollectPads * pads,
@@ -162,6 +194,10 @@ static gboolean gst_collect_pads_event_default_internal (GstCollectPads *
     pads, GstCollectData * data, GstEvent * event, gpointer user_data);
 static gboolean gst_collect_pads_query_default_internal (GstCollectPads *
     pads, GstCollectData * data, GstQuery * query, gpointer user_data);
+static void gst_collect_pads_live_loop (GstCollectPads * pads);
+static void gst_collect_pads_live_wakeup (GstCollectPads * pads);
+static void gst_collect_pads_live_wait_consumed (GstCollectPads * pads,
+    GstCollectData * data);
 
 
 /* Some properties are protected by LOCK, others by STREAM_LOCK
@@ -266,6 +302,14 @@ gst_collect_pads_init (GstCollectPads * pads)
   pads->priv->pending_flush_start = FALSE;
   pads->priv->pending_flush_stop = FALSE;
 
+  /* members for live mode */
+  pads->priv->live = FALSE;
+  pads->priv->interval = GST_CLOCK_TIME_NONE;
+  pads->priv->latency = 0;
+  pads->priv->live_time = GST_CLOCK_TIME_NONE;
+  pads->priv->live_ret = GST_FLOW_OK;
+  g_rec_mutex_init (&pads->priv->task_lock);
+
   /* clear floating flag */
   gst_object_ref_sink (pads);
 }
@@ -277,6 +321,12 @@ gst_collect_pads_finalize (GObject * object)
 
   GST_DEBUG_OBJECT (object, "finalize");
 
+  if (pads->priv->task) {
+    gst_task_join (pads->priv->task);
+    gst_object_unref (pads->priv->task);
+  }
+  g_rec_mutex_clear (&pads->priv->task_lock);
+
   g_rec_mutex_clear (&pads->stream_lock);
 
   g_cond_clear (&pads->priv->evt_cond);
@@ -411,6 +461,18 @@ ref_data (GstCollectData * data)
   g_atomic_int_inc (&(data->priv->refcount));
 }
 
+/* drops the buffer handed over in live mode */
+static void
+clear_pending (GstCollectData * data)
+{
+  GstBuffer *buffer;
+
+  buffer = g_atomic_pointer_get (&data->priv->pending);
+  if (buffer && g_atomic_pointer_compare_and_exchange (&data->priv->pending,
+          buffer, NULL))
+    gst_buffer_unref (buffer);
+}
+
 static void
 unref_data (GstCollectData * data)
 {
@@ -427,6 +489,8 @@ unref_data (GstCollectData * data)
   if (data->buffer) {
     gst_buffer_unref (data->buffer);
   }
+  clear_pending (data);
+  g_mutex_clear (&data->priv->segment_lock);
   g_free (data->priv);
   g_free (data);
 }
@@ -627,6 +691,7 @@ gst_collect_pads_add_pad (GstCollectPads * pads, GstPad * pad, guint size,
 
   data = g_malloc0 (size);
   data->priv = g_new0 (GstCollectDataPrivate, 1);
+  g_mutex_init (&data->priv->segment_lock);
   data->collect = pads;
   data->pad = gst_object_ref (pad);
   data->buffer = NULL;
@@ -636,6 +701,7 @@ gst_collect_pads_add_pad (GstCollectPads * pads, GstPad * pad, guint size,
   data->state |= lock ? GST_COLLECT_PADS_STATE_LOCKED : 0;
   data->priv->refcount = 1;
   data->priv->destroy_notify = destroy_notify;
+  data->priv->end_position = 0;
 
   GST_OBJECT_LOCK (pads);
   GST_OBJECT_LOCK (pad);
@@ -846,13 +912,28 @@ gst_collect_pads_start (GstCollectPads * pads)
     GstCollectData *data;
 
     data = collected->data;
+    g_mutex_lock (&data->priv->segment_lock);
     gst_segment_init (&data->segment, GST_FORMAT_UNDEFINED);
+    g_mutex_unlock (&data->priv->segment_lock);
+    data->priv->end_position = 0;
+    data->priv->lateness = 0;
   }
 
   gst_collect_pads_set_flushing_unlocked (pads, FALSE);
 
   /* Start collect pads */
   pads->priv->started = TRUE;
+
+  if (pads->priv->live) {
+    if (pads->priv->task == NULL) {
+      pads->priv->task = gst_task_new ((GstTaskFunction)
+          gst_collect_pads_live_loop, pads, NULL);
+      gst_task_set_lock (pads->priv->task, &pads->priv->task_lock);
+    }
+    pads->priv->live_time = GST_CLOCK_TIME_NONE;
+    g_atomic_int_set (&pads->priv->live_ret, GST_FLOW_OK);
+    gst_task_start (pads->priv->task);
+  }
   GST_OBJECT_UNLOCK (pads);
   GST_COLLECT_PADS_STREAM_UNLOCK (pads);
 }
@@ -900,6 +981,7 @@ gst_collect_pads_stop (GstCollectPads * pads)
       gst_buffer_replace (buffer_p, NULL);
       data->pos = 0;
     }
+    clear_pending (data);
     GST_COLLECT_PADS_STATE_UNSET (data, GST_COLLECT_PADS_STATE_EOS);
   }
 
@@ -908,6 +990,14 @@ gst_collect_pads_stop (GstCollectPads * pads)
   pads->priv->earliest_data = NULL;
   pads->priv->earliest_time = GST_CLOCK_TIME_NONE;
 
+  /* the live task ends when it sees that we are stopped, don't join it here
+   * as it could be pushing downstream */
+  if (pads->priv->task) {
+    gst_task_stop (pads->priv->task);
+    if (pads->priv->clock_id)
+      gst_clock_id_unschedule (pads->priv->clock_id);
+  }
+
   GST_OBJECT_UNLOCK (pads);
   /* Wake them up so they can end the chain functions. */
   GST_COLLECT_PADS_EVT_BROADCAST (pads);
@@ -993,6 +1083,7 @@ gst_collect_pads_clear (GstCollectPads * pads, GstCollectData * data)
 {
   GstBuffer *buf;
 
+  clear_pending (data);
   if ((buf = gst_collect_pads_pop (pads, data)))
     gst_buffer_unref (buf);
 }
@@ -1231,6 +1322,149 @@ gst_collect_pads_set_waiting (GstCollectPads * pads, GstCollectData * data,
   }
 }
 
+/**
+ * gst_collect_pads_set_live:
+ * @pads: the collectpads to use
+ * @element: the element that owns @pads
+ * @interval: the duration of one output, or #GST_CLOCK_TIME_NONE to
+ *     disable live mode
+ * @latency: the latency to add to the deadline of an output
+ *
+ * Put @pads in live mode. The callback set with
+ * gst_collect_pads_set_function() is then no longer called when all pads
+ * have data, but from a separate thread, once every @interval of running
+ * time. It is called when the clock of @element reaches the end of the
+ * output plus @latency, with whatever data is available on the pads at that
+ * moment. gst_collect_pads_get_live_window() gives the running times of the
+ * output to produce and gst_collect_pads_get_lateness() tells which pads did
+ * not have their data in time. When all pads are EOS the callback is called
+ * without waiting until it returns something else than #GST_FLOW_OK.
+ *
+ * The chain functions don't take the STREAM_LOCK in live mode. The clip
+ * function is called from the streaming thread of the pad while the callback
+ * may be running, with a lock of the pad that collectpads also takes when it
+ * updates the segment of the pad. The clip function should only read the
+ * segment, and the callback should not modify it.
+ * Every pad has room for one more buffer that is moved to the pad around the
+ * callback, upstream only blocks when that is full. Serialized events wait
+ * until the buffers before them were popped. Flow errors of the callback are
+ * returned upstream and stop the output until the next FLUSH_STOP.
+ *
+ * The positions of the pads are expected in running time, as produced by
+ * gst_collect_pads_clip_running_time().
+ *
+ * Live mode can only be switched on or off when @pads is not started,
+ * @interval and @latency can be updated at any time.
+ *
+ * MT safe.
+ *
+ * Since: 1.4
+ */
+void
+gst_collect_pads_set_live (GstCollectPads * pads, GstElement * element,
+    GstClockTime interval, GstClockTime latency)
+{
+  gboolean live;
+
+  g_return_if_fail (pads != NULL);
+  g_return_if_fail (GST_IS_COLLECT_PADS (pads));
+
+  live = GST_CLOCK_TIME_IS_VALID (interval) && interval > 0;
+
+  g_return_if_fail (!live || GST_IS_ELEMENT (element));
+  g_return_if_fail (!live || GST_CLOCK_TIME_IS_VALID (latency));
+
+  GST_OBJECT_LOCK (pads);
+  if (G_UNLIKELY (pads->priv->started && live != pads->priv->live))
+    goto started;
+
+  GST_DEBUG_OBJECT (pads, "live %d, interval %" GST_TIME_FORMAT ", latency %"
+      GST_TIME_FORMAT, live, GST_TIME_ARGS (interval), GST_TIME_ARGS (latency));
+
+  pads->priv->live = live;
+  pads->priv->live_element = element;
+  pads->priv->interval = interval;
+  pads->priv->latency = latency;
+  GST_OBJECT_UNLOCK (pads);
+
+  return;
+
+  /* ERRORS */
+started:
+  {
+    GST_OBJECT_UNLOCK (pads);
+    GST_WARNING_OBJECT (pads, "cannot change the live mode when started");
+    return;
+  }
+}
+
+/**
+ * gst_collect_pads_get_live_window:
+ * @pads: the collectpads to use
+ * @start: (out) (allow-none): the running time of the start of the output
+ * @end: (out) (allow-none): the running time of the end of the output
+ *
+ * Get the running times of the output to produce from the callback in live
+ * mode. This function should be called with @pads STREAM_LOCK held, such as
+ * in the callback.
+ *
+ * Returns: %TRUE if @pads is in live mode and the output is known.
+ *
+ * Since: 1.4
+ */
+gboolean
+gst_collect_pads_get_live_window (GstCollectPads * pads, GstClockTime * start,
+    GstClockTime * end)
+{
+  GstClockTime interval;
+
+  g_return_val_if_fail (pads != NULL, FALSE);
+  g_return_val_if_fail (GST_IS_COLLECT_PADS (pads), FALSE);
+
+  if (!pads->priv->live || !GST_CLOCK_TIME_IS_VALID (pads->priv->live_time))
+    return FALSE;
+
+  GST_OBJECT_LOCK (pads);
+  interval = pads->priv->interval;
+  GST_OBJECT_UNLOCK (pads);
+
+  if (start)
+    *start = pads->priv->live_time;
+  if (end)
+    *end = pads->priv->live_time + interval;
+
+  return TRUE;
+}
+
+/**
+ * gst_collect_pads_get_lateness:
+ * @pads: the collectpads to use
+ * @data: the data to use
+ *
+ * Get how late the pad of @data was when the callback was last called in
+ * live mode. This is the difference between the end of the output and the
+ * end of the last data received on the pad, a positive value means that the
+ * pad did not have all the data for the output. This function should be
+ * called with @pads STREAM_LOCK held, such as in the callback.
+ *
+ * Returns: the lateness of @data, 0 when it was in time or @pads is not in
+ * live mode.
+ *
+ * Since: 1.4
+ */
+GstClockTimeDiff
+gst_collect_pads_get_lateness (GstCollectPads * pads, GstCollectData * data)
+{
+  g_return_val_if_fail (pads != NULL, 0);
+  g_return_val_if_fail (GST_IS_COLLECT_PADS (pads), 0);
+  g_return_val_if_fail (data != NULL, 0);
+
+  if (!pads->priv->live)
+    return 0;
+
+  return MAX (data->priv->lateness, 0);
+}
+
 /* see if pads were added or removed and update our stats. Any pad
  * added after releasing the LOCK will get collected in the next
  * round.
@@ -1355,6 +1589,235 @@ gst_collect_pads_check_collected (GstCollectPads * pads)
   return flow_ret;
 }
 
+/* moves the buffers handed over by the chain functions to the pads that have
+ * room for them.
+ *
+ * Must be called with STREAM_LOCK. */
+static void
+gst_collect_pads_live_take_pending (GstCollectPads * pads)
+{
+  GSList *collected;
+  gboolean taken = FALSE;
+
+  for (collected = pads->data; collected; collected = g_slist_next (collected)) {
+    GstCollectData *data = (GstCollectData *) collected->data;
+    GstBuffer *buffer;
+    GstClockTime timestamp;
+
+    if (data->buffer != NULL)
+      continue;
+
+    /* the chain function only fills an empty slot and we are the only one
+     * emptying it */
+    buffer = g_atomic_pointer_get (&data->priv->pending);
+    if (buffer == NULL)
+      continue;
+    g_atomic_pointer_set (&data->priv->pending, NULL);
+
+    if (GST_COLLECT_PADS_STATE_IS_SET (data, GST_COLLECT_PADS_STATE_WAITING))
+      pads->priv->queuedpads++;
+    data->buffer = buffer;
+    taken = TRUE;
+
+    timestamp = GST_BUFFER_DTS (buffer);
+    if (!GST_CLOCK_TIME_IS_VALID (timestamp))
+      timestamp = GST_BUFFER_PTS (buffer);
+    if (GST_CLOCK_TIME_IS_VALID (timestamp)) {
+      g_mutex_lock (&data->priv->segment_lock);
+      if (data->segment.format == GST_FORMAT_TIME)
+        data->segment.position = timestamp;
+      g_mutex_unlock (&data->priv->segment_lock);
+      data->priv->end_position = timestamp;
+      if (GST_BUFFER_PTS_IS_VALID (buffer)
+          && GST_BUFFER_DURATION_IS_VALID (buffer))
+        data->priv->end_position =
+            GST_BUFFER_PTS (buffer) + GST_BUFFER_DURATION (buffer);
+    }
+  }
+
+  /* wake up the chain functions waiting for an empty slot */
+  if (taken)
+    GST_COLLECT_PADS_EVT_BROADCAST (pads);
+}
+
+/* updates the lateness of all pads for an output ending at @end.
+ *
+ * Must be called with STREAM_LOCK. */
+static void
+gst_collect_pads_live_update_lateness (GstCollectPads * pads, GstClockTime end)
+{
+  GSList *collected;
+
+  for (collected = pads->data; collected; collected = g_slist_next (collected)) {
+    GstCollectData *data = (GstCollectData *) collected->data;
+
+    if (GST_COLLECT_PADS_STATE_IS_SET (data, GST_COLLECT_PADS_STATE_EOS))
+      data->priv->lateness = 0;
+    else
+      data->priv->lateness = GST_CLOCK_DIFF (data->priv->end_position, end);
+
+    if (data->priv->lateness > 0)
+      GST_LOG_OBJECT (pads, "pad %s:%s is late by %" GST_TIME_FORMAT,
+          GST_DEBUG_PAD_NAME (data->pad),
+          GST_TIME_ARGS (data->priv->lateness));
+  }
+}
+
+/* makes the live task check its state again */
+static void
+gst_collect_pads_live_wakeup (GstCollectPads * pads)
+{
+  GST_OBJECT_LOCK (pads);
+  if (pads->priv->clock_id)
+    gst_clock_id_unschedule (pads->priv->clock_id);
+  GST_OBJECT_UNLOCK (pads);
+}
+
+/* the task of the live mode. Calls the collect function once every interval
+ * when the clock reaches the end of the output plus the latency, and drains
+ * without waiting when all pads are EOS. */
+static void
+gst_collect_pads_live_loop (GstCollectPads * pads)
+{
+  GstCollectPadsFunction func;
+  gpointer user_data;
+  GstElement *element;
+  GstClock *clock = NULL;
+  GstClockTime interval, latency, base_time = 0, now, end;
+  GstClockID id;
+  GstClockReturn cret;
+  GstFlowReturn ret;
+  gint64 end_time;
+  guint32 cookie;
+
+  GST_OBJECT_LOCK (pads);
+  func = pads->priv->func;
+  user_data = pads->priv->user_data;
+  element = pads->priv->live_element;
+  interval = pads->priv->interval;
+  latency = pads->priv->latency;
+  GST_OBJECT_UNLOCK (pads);
+
+  GST_COLLECT_PADS_STREAM_LOCK (pads);
+  if (G_UNLIKELY (!pads->priv->started))
+    goto stopped;
+
+  gst_collect_pads_check_pads (pads);
+
+  if (G_UNLIKELY (pads->priv->numpads > 0 &&
+          pads->priv->eospads == pads->priv->numpads)) {
+    GST_DEBUG_OBJECT (pads, "All active pads (%d) are EOS, draining",
+        pads->priv->numpads);
+    gst_collect_pads_live_take_pending (pads);
+    do {
+      ret = func (pads, user_data);
+      gst_collect_pads_live_take_pending (pads);
+    } while (ret == GST_FLOW_OK);
+    goto done;
+  }
+
+  /* the clock and base time are only meaningful when PLAYING */
+  GST_OBJECT_LOCK (element);
+  if (GST_STATE (element) == GST_STATE_PLAYING
+      && (clock = GST_ELEMENT_CLOCK (element))) {
+    gst_object_ref (clock);
+    base_time = GST_ELEMENT_CAST (element)->base_time;
+  }
+  GST_OBJECT_UNLOCK (element);
+
+  if (clock == NULL)
+    goto not_playing;
+
+  if (!GST_CLOCK_TIME_IS_VALID (pads->priv->live_time)) {
+    now = gst_clock_get_time (clock);
+    pads->priv->live_time = now > base_time ? now - base_time : 0;
+    GST_DEBUG_OBJECT (pads, "starting output at %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (pads->priv->live_time));
+  }
+  end = pads->priv->live_time + interval;
+  GST_COLLECT_PADS_STREAM_UNLOCK (pads);
+
+  /* wait for the deadline of this output */
+  id = gst_clock_new_single_shot_id (clock, base_time + end + latency);
+  gst_object_unref (clock);
+
+  GST_OBJECT_LOCK (pads);
+  if (G_UNLIKELY (!pads->priv->started)) {
+    GST_OBJECT_UNLOCK (pads);
+    gst_clock_id_unref (id);
+    return;
+  }
+  pads->priv->clock_id = id;
+  GST_OBJECT_UNLOCK (pads);
+
+  GST_LOG_OBJECT (pads, "waiting for the deadline of the output ending at %"
+      GST_TIME_FORMAT, GST_TIME_ARGS (end));
+  cret = gst_clock_id_wait (id, NULL);
+
+  GST_OBJECT_LOCK (pads);
+  pads->priv->clock_id = NULL;
+  GST_OBJECT_UNLOCK (pads);
+  gst_clock_id_unref (id);
+
+  /* woken up to check the state again */
+  if (cret == GST_CLOCK_UNSCHEDULED)
+    return;
+
+  GST_COLLECT_PADS_STREAM_LOCK (pads);
+  if (G_UNLIKELY (!pads->priv->started))
+    goto stopped;
+
+  gst_collect_pads_check_pads (pads);
+  gst_collect_pads_live_take_pending (pads);
+  gst_collect_pads_live_update_lateness (pads, end);
+
+  GST_DEBUG_OBJECT (pads, "deadline reached, calling %s",
+      GST_DEBUG_FUNCPTR_NAME (func));
+  ret = func (pads, user_data);
+
+  /* refill the pads that were consumed */
+  gst_collect_pads_live_take_pending (pads);
+  pads->priv->live_time = end;
+
+done:
+  if (G_UNLIKELY (ret != GST_FLOW_OK)) {
+    GST_DEBUG_OBJECT (pads, "pausing task, reason %s",
+        gst_flow_get_name (ret));
+    /* the chain functions return this upstream, a FLUSH_STOP starts us
+     * again */
+    g_atomic_int_set (&pads->priv->live_ret, ret);
+    gst_task_pause (pads->priv->task);
+    GST_COLLECT_PADS_EVT_BROADCAST (pads);
+  }
+  GST_COLLECT_PADS_STREAM_UNLOCK (pads);
+
+  return;
+
+  /* ERRORS */
+stopped:
+  {
+    GST_DEBUG_OBJECT (pads, "stopped");
+    GST_COLLECT_PADS_STREAM_UNLOCK (pads);
+    return;
+  }
+not_playing:
+  {
+    GST_COLLECT_PADS_STREAM_UNLOCK (pads);
+
+    /* no clock to wait on yet, check again after an interval or when
+     * something changed */
+    GST_COLLECT_PADS_EVT_INIT (cookie);
+    end_time = g_get_monotonic_time () + GST_TIME_AS_USECONDS (interval) + 1;
+    g_mutex_lock (GST_COLLECT_PADS_GET_EVT_LOCK (pads));
+    while (cookie == pads->priv->evt_cookie) {
+      if (!g_cond_wait_until (GST_COLLECT_PADS_GET_EVT_COND (pads),
+              GST_COLLECT_PADS_GET_EVT_LOCK (pads), end_time))
+        break;
+    }
+    g_mutex_unlock (GST_COLLECT_PADS_GET_EVT_LOCK (pads));
+    return;
+  }
+}
 
 /* General overview:
  * - only pad with a buffer can determine earliest_data (and earliest_time)
@@ -1725,7 +2188,9 @@ gst_collect_pads_event_default (GstCollectPads * pads, GstCollectData * data,
       GST_COLLECT_PADS_STATE_UNSET (data, GST_COLLECT_PADS_STATE_FLUSHING);
       gst_collect_pads_clear (pads, data);
       /* we need new segment info after the flush */
+      g_mutex_lock (&data->priv->segment_lock);
       gst_segment_init (&data->segment, GST_FORMAT_UNDEFINED);
+      g_mutex_unlock (&data->priv->segment_lock);
       GST_COLLECT_PADS_STATE_UNSET (data, GST_COLLECT_PADS_STATE_NEW_SEGMENT);
       /* if the pad was EOS, remove the EOS flag and
        * decrement the number of eospads */
@@ -1737,6 +2202,13 @@ gst_collect_pads_event_default (GstCollectPads * pads, GstCollectData * data,
         pads->priv->eospads--;
         GST_COLLECT_PADS_STATE_UNSET (data, GST_COLLECT_PADS_STATE_EOS);
       }
+      data->priv->end_position = 0;
+      /* restart the live task after a flow error or a drain */
+      if (pads->priv->live && pads->priv->started) {
+        pads->priv->live_time = GST_CLOCK_TIME_NONE;
+        g_atomic_int_set (&pads->priv->live_ret, GST_FLOW_OK);
+        gst_task_start (pads->priv->task);
+      }
       GST_COLLECT_PADS_STREAM_UNLOCK (pads);
 
       if (g_atomic_int_get (&pads->priv->seeking)) {
@@ -1763,7 +2235,10 @@ gst_collect_pads_event_default (GstCollectPads * pads, GstCollectData * data,
         pads->priv->eospads++;
       }
       /* check if we need collecting anything, we ignore the result. */
-      gst_collect_pads_check_collected (pads);
+      if (pads->priv->live)
+        gst_collect_pads_live_wakeup (pads);
+      else
+        gst_collect_pads_check_collected (pads);
       GST_COLLECT_PADS_STREAM_UNLOCK (pads);
 
       goto eat;
@@ -1786,14 +2261,18 @@ gst_collect_pads_event_default (GstCollectPads * pads, GstCollectData * data,
       }
 
       /* need to update segment first */
+      g_mutex_lock (&data->priv->segment_lock);
       data->segment = seg;
+      g_mutex_unlock (&data->priv->segment_lock);
       GST_COLLECT_PADS_STATE_SET (data, GST_COLLECT_PADS_STATE_NEW_SEGMENT);
 
       /* now we can use for e.g. running time */
       seg.position =
           gst_collect_pads_clip_time (pads, data, seg.start + seg.offset);
       /* update again */
+      g_mutex_lock (&data->priv->segment_lock);
       data->segment = seg;
+      g_mutex_unlock (&data->priv->segment_lock);
 
       /* default muxing functionality */
       if (!buffer_func)
@@ -1809,7 +2288,7 @@ gst_collect_pads_event_default (GstCollectPads * pads, GstCollectData * data,
     }
     case GST_EVENT_GAP:
     {
-      GstClockTime start, duration;
+      GstClockTime start, duration, position;
 
       GST_COLLECT_PADS_STREAM_LOCK (pads);
 
@@ -1819,10 +2298,12 @@ gst_collect_pads_event_default (GstCollectPads * pads, GstCollectData * data,
         start += duration;
       /* we do not expect another buffer until after gap,
        * so that is our position now */
-      data->segment.position = gst_collect_pads_clip_time (pads, data, start);
+      position = gst_collect_pads_clip_time (pads, data, start);
+      g_mutex_lock (&data->priv->segment_lock);
+      data->segment.position = position;
+      g_mutex_unlock (&data->priv->segment_lock);
 
-      gst_collect_pads_handle_position_update (pads, data,
-          data->segment.position);
+      gst_collect_pads_handle_position_update (pads, data, position);
 
       GST_COLLECT_PADS_STREAM_UNLOCK (pads);
       goto eat;
@@ -1971,7 +2452,10 @@ gst_collect_pads_event (GstPad * pad, GstObject * parent, GstEvent * event)
   GST_OBJECT_UNLOCK (pads);
 
   if (GST_EVENT_IS_SERIALIZED (event)) {
-    GST_COLLECT_PADS_STREAM_LOCK (pads);
+    if (pads->priv->live)
+      gst_collect_pads_live_wait_consumed (pads, data);
+    else
+      GST_COLLECT_PADS_STREAM_LOCK (pads);
     need_unlock = TRUE;
   }
 
@@ -2098,6 +2582,151 @@ pad_removed:
 }
 
 
+/* In live mode the chain function returns once the buffer is in the slot of
+ * the pad. Serialized events must not overtake it, so they wait until the
+ * live task took the buffer out of the slot and the collect function popped
+ * it, like the chain function does when not live. Returns with the
+ * STREAM_LOCK taken. */
+static void
+gst_collect_pads_live_wait_consumed (GstCollectPads * pads,
+    GstCollectData * data)
+{
+  gboolean removed;
+  guint32 cookie;
+
+  while (TRUE) {
+    /* any change after this wakes us up below */
+    GST_COLLECT_PADS_EVT_INIT (cookie);
+
+    GST_COLLECT_PADS_STREAM_LOCK (pads);
+    /* nothing will take the buffer when flushing, stopped or after an
+     * error of the live task */
+    if (!pads->priv->started
+        || GST_COLLECT_PADS_STATE_IS_SET (data, GST_COLLECT_PADS_STATE_FLUSHING)
+        || g_atomic_int_get (&pads->priv->live_ret) != GST_FLOW_OK)
+      break;
+    GST_OBJECT_LOCK (data->pad);
+    removed = gst_pad_get_element_private (data->pad) != data;
+    GST_OBJECT_UNLOCK (data->pad);
+    if (removed)
+      break;
+    if (g_atomic_pointer_get (&data->priv->pending) == NULL
+        && data->buffer == NULL)
+      break;
+    GST_COLLECT_PADS_STREAM_UNLOCK (pads);
+
+    GST_DEBUG_OBJECT (pads, "Pad %s:%s has data queued, waiting before event",
+        GST_DEBUG_PAD_NAME (data->pad));
+    GST_COLLECT_PADS_EVT_WAIT (pads, cookie);
+  }
+}
+
+/* In live mode the buffer is only handed over to the live task through the
+ * slot of the pad, the STREAM_LOCK is not taken so that the chain functions
+ * don't wait for the callback. We wait when the slot is still full. */
+static GstFlowReturn
+gst_collect_pads_chain_live (GstCollectPads * pads, GstCollectData * data,
+    GstPad * pad, GstBuffer * buffer)
+{
+  GstFlowReturn ret;
+  gboolean removed;
+  guint32 cookie;
+
+  /* see if we need to clip, the live task updates the position of the
+   * segment with the segment lock of the pad */
+  if (pads->priv->clip_func) {
+    GstBuffer *outbuf = NULL;
+
+    g_mutex_lock (&data->priv->segment_lock);
+    ret =
+        pads->priv->clip_func (pads, data, buffer, &outbuf,
+        pads->priv->clip_user_data);
+    g_mutex_unlock (&data->priv->segment_lock);
+    buffer = outbuf;
+
+    if (G_UNLIKELY (outbuf == NULL))
+      goto clipped;
+
+    if (G_UNLIKELY (ret != GST_FLOW_OK))
+      goto error;
+  }
+
+  while (TRUE) {
+    /* any change after this wakes us up below */
+    GST_COLLECT_PADS_EVT_INIT (cookie);
+
+    if (G_UNLIKELY (!pads->priv->started))
+      goto not_started;
+    if (G_UNLIKELY (GST_COLLECT_PADS_STATE_IS_SET (data,
+                GST_COLLECT_PADS_STATE_FLUSHING)))
+      goto flushing;
+    if (G_UNLIKELY (GST_COLLECT_PADS_STATE_IS_SET (data,
+                GST_COLLECT_PADS_STATE_EOS)))
+      goto eos;
+    /* pad could be removed */
+    GST_OBJECT_LOCK (pad);
+    removed = gst_pad_get_element_private (pad) != data;
+    GST_OBJECT_UNLOCK (pad);
+    if (G_UNLIKELY (removed))
+      goto pad_removed;
+
+    /* report errors of the live task */
+    ret = g_atomic_int_get (&pads->priv->live_ret);
+    if (G_UNLIKELY (ret != GST_FLOW_OK))
+      goto error;
+
+    if (g_atomic_pointer_compare_and_exchange (&data->priv->pending, NULL,
+            buffer))
+      break;
+
+    GST_DEBUG_OBJECT (pads, "Pad %s:%s has a buffer pending, waiting",
+        GST_DEBUG_PAD_NAME (pad));
+    GST_COLLECT_PADS_EVT_WAIT (pads, cookie);
+  }
+
+  GST_DEBUG_OBJECT (pads, "Handed over buffer %p for pad %s:%s", buffer,
+      GST_DEBUG_PAD_NAME (pad));
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+clipped:
+  {
+    GST_DEBUG ("clipped buffer on pad %s:%s", GST_DEBUG_PAD_NAME (pad));
+    return GST_FLOW_OK;
+  }
+not_started:
+  {
+    GST_DEBUG ("not started");
+    ret = GST_FLOW_FLUSHING;
+    goto error;
+  }
+flushing:
+  {
+    GST_DEBUG ("pad %s:%s is flushing", GST_DEBUG_PAD_NAME (pad));
+    ret = GST_FLOW_FLUSHING;
+    goto error;
+  }
+eos:
+  {
+    GST_DEBUG ("pad %s:%s is eos", GST_DEBUG_PAD_NAME (pad));
+    ret = GST_FLOW_EOS;
+    goto error;
+  }
+pad_removed:
+  {
+    GST_WARNING ("%s got removed from collectpads", GST_OBJECT_NAME (pad));
+    ret = GST_FLOW_NOT_LINKED;
+    goto error;
+  }
+error:
+  {
+    GST_DEBUG ("collect failed, reason %d (%s)", ret, gst_flow_get_name (ret));
+    gst_buffer_unref (buffer);
+    return ret;
+  }
+}
+
 /* For each buffer we receive we check if our collected condition is reached
  * and if so we call the collected function. When this is done we check if
  * data has been unqueued. If data is still queued we wait holding the stream
@@ -2125,6 +2754,12 @@ gst_collect_pads_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
 
   pads = data->collect;
 
+  if (pads->priv->live) {
+    ret = gst_collect_pads_chain_live (pads, data, pad, buffer);
+    unref_data (data);
+    return ret;
+  }
+
   GST_COLLECT_PADS_STREAM_LOCK (pads);
   /* if not started, bail out */
   if (G_UNLIKELY (!pads->priv->started))
@@ -360,6 +360,13 @@ GstBuffer*      gst_collect_pads_take_buffer   (GstCollectPads * pads, GstCollec
 void            gst_collect_pads_set_waiting   (GstCollectPads *pads, GstCollectData *data,
                                                 gboolean waiting);
 
+/* live mode */
+void            gst_collect_pads_set_live        (GstCollectPads *pads, GstElement *element,
+                                                  GstClockTime interval, GstClockTime latency);
+gboolean        gst_collect_pads_get_live_window (GstCollectPads *pads, GstClockTime *start,
+                                                  GstClockTime *end);
+GstClockTimeDiff gst_collect_pads_get_lateness   (GstCollectPads *pads, GstCollectData *data);
+
 /* convenience helper */
 GstFlowReturn	gst_collect_pads_clip_running_time (GstCollectPads * pads,
 					            GstCollectData * cdata,
@@ -0,0 +1,272 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * gstelements_private.c: shared helpers of the core elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/types.h>
+#ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+#endif
+#ifdef HAVE_SYS_UIO_H
+#  include <sys/uio.h>
+#endif
+#ifdef G_OS_WIN32
+#  include <io.h>
+#endif
+
+#include "gstelements_private.h"
+
+#ifdef HAVE_SYS_UIO_H
+#define gst_writev writev
+#else
+struct iovec
+{
+  void *iov_base;
+  size_t iov_len;
+};
+
+/* write the first vector that is not empty, the caller deals with short
+ * writes */
+static gssize
+gst_writev (gint fd, const struct iovec *vecs, gint n_vecs)
+{
+  gint i;
+
+  for (i = 0; i < n_vecs; i++) {
+    if (vecs[i].iov_len > 0)
+      return write (fd, vecs[i].iov_base, vecs[i].iov_len);
+  }
+  return 0;
+}
+#endif
+
+/* write out @left bytes in @vecs, waiting on @fdset for the fd to become
+ * writable when given. @vecs is modified. */
+static GstFlowReturn
+gst_writev_vecs (GstObject * sink, gint fd, GstPoll * fdset,
+    struct iovec *vecs, guint n_vecs, gsize left, guint64 * bytes_written)
+{
+  gssize written;
+  gint err;
+
+  while (left > 0) {
+    if (fdset != NULL) {
+      gint retval;
+
+      do {
+        retval = gst_poll_wait (fdset, GST_CLOCK_TIME_NONE);
+        err = errno;
+      } while (retval == -1 && (err == EINTR || err == EAGAIN));
+
+      if (retval == -1) {
+        if (err == EBUSY)
+          goto stopped;
+        else
+          goto poll_error;
+      }
+    }
+
+    GST_LOG_OBJECT (sink, "writing %" G_GSIZE_FORMAT " bytes in %u vectors "
+        "to fd %d", left, n_vecs, fd);
+
+    written = gst_writev (fd, vecs, n_vecs);
+
+    if (G_UNLIKELY (written < 0)) {
+      /* keep the error of the write, logging might change errno */
+      err = errno;
+
+      /* try to write again on non-fatal errors */
+      if (err == EAGAIN || err == EINTR)
+        continue;
+
+      goto write_error;
+    }
+
+    left -= written;
+    *bytes_written += written;
+
+    /* skip what was written and retry with the rest */
+    while (n_vecs > 0 && (gsize) written >= vecs->iov_len) {
+      written -= vecs->iov_len;
+      vecs++;
+      n_vecs--;
+    }
+    if (written > 0) {
+      vecs->iov_base = (guint8 *) vecs->iov_base + written;
+      vecs->iov_len -= written;
+    }
+  }
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+stopped:
+  {
+    GST_DEBUG_OBJECT (sink, "poll stopped");
+    return GST_FLOW_FLUSHING;
+  }
+poll_error:
+  {
+    GST_DEBUG_OBJECT (sink, "poll failed: %s", g_strerror (err));
+    errno = err;
+    return GST_FLOW_ERROR;
+  }
+write_error:
+  {
+    GST_DEBUG_OBJECT (sink, "write failed: %s", g_strerror (err));
+    errno = err;
+    return GST_FLOW_ERROR;
+  }
+}
+
+static void
+gst_unmap_vecs (GstMapInfo * maps, guint n_maps)
+{
+  gint err = errno;
+  guint i;
+
+  for (i = 0; i < n_maps; i++)
+    gst_memory_unmap (maps[i].memory, &maps[i]);
+
+  errno = err;
+}
+
+/**
+ * gst_writev_buffers:
+ * @sink: the object writing, for debugging
+ * @fd: the file descriptor to write to
+ * @fdset: (allow-none): a #GstPoll to wait on before writing
+ * @buffers: the buffers to write
+ * @num_buffers: the number of buffers in @buffers
+ * @bytes_written: (inout): incremented with the amount of bytes written
+ *
+ * Write the memory of all @buffers to @fd, using one writev() call for up
+ * to GST_IOV_MAX memory blocks.
+ *
+ * Returns: #GST_FLOW_OK, #GST_FLOW_FLUSHING when @fdset was set flushing or
+ * #GST_FLOW_ERROR with errno set.
+ */
+GstFlowReturn
+gst_writev_buffers (GstObject * sink, gint fd, GstPoll * fdset,
+    GstBuffer ** buffers, guint num_buffers, guint64 * bytes_written)
+{
+  struct iovec vecs[GST_IOV_MAX];
+  GstMapInfo maps[GST_IOV_MAX];
+  guint i, j, n_mem, n_vecs = 0;
+  gsize left = 0;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  for (i = 0; i < num_buffers; i++) {
+    n_mem = gst_buffer_n_memory (buffers[i]);
+
+    for (j = 0; j < n_mem; j++) {
+      GstMemory *mem = gst_buffer_peek_memory (buffers[i], j);
+
+      if (!gst_memory_map (mem, &maps[n_vecs], GST_MAP_READ))
+        goto map_failed;
+
+      vecs[n_vecs].iov_base = maps[n_vecs].data;
+      vecs[n_vecs].iov_len = maps[n_vecs].size;
+      left += maps[n_vecs].size;
+      n_vecs++;
+
+      if (n_vecs == GST_IOV_MAX) {
+        ret = gst_writev_vecs (sink, fd, fdset, vecs, n_vecs, left,
+            bytes_written);
+        gst_unmap_vecs (maps, n_vecs);
+        n_vecs = 0;
+        left = 0;
+
+        if (ret != GST_FLOW_OK)
+          return ret;
+      }
+    }
+  }
+
+  if (n_vecs > 0) {
+    ret = gst_writev_vecs (sink, fd, fdset, vecs, n_vecs, left, bytes_written);
+    gst_unmap_vecs (maps, n_vecs);
+  }
+
+  return ret;
+
+  /* ERRORS */
+map_failed:
+  {
+    GST_WARNING_OBJECT (sink, "could not map memory of buffer %u", i);
+    gst_unmap_vecs (maps, n_vecs);
+    errno = EINVAL;
+    return GST_FLOW_ERROR;
+  }
+}
+
+/**
+ * gst_writev_buffer:
+ * @sink: the object writing, for debugging
+ * @fd: the file descriptor to write to
+ * @fdset: (allow-none): a #GstPoll to wait on before writing
+ * @buffer: the buffer to write
+ * @bytes_written: (inout): incremented with the amount of bytes written
+ *
+ * Write all memory blocks of @buffer with gst_writev_buffers().
+ */
+GstFlowReturn
+gst_writev_buffer (GstObject * sink, gint fd, GstPoll * fdset,
+    GstBuffer * buffer, guint64 * bytes_written)
+{
+  return gst_writev_buffers (sink, fd, fdset, &buffer, 1, bytes_written);
+}
+
+/**
+ * gst_writev_buffer_list:
+ * @sink: the object writing, for debugging
+ * @fd: the file descriptor to write to
+ * @fdset: (allow-none): a #GstPoll to wait on before writing
+ * @list: the buffer list to write
+ * @bytes_written: (inout): incremented with the amount of bytes written
+ *
+ * Write all buffers in @list with gst_writev_buffers(), GST_IOV_MAX buffers
+ * at a time.
+ */
+GstFlowReturn
+gst_writev_buffer_list (GstObject * sink, gint fd, GstPoll * fdset,
+    GstBufferList * list, guint64 * bytes_written)
+{
+  GstBuffer *buffers[GST_IOV_MAX];
+  guint i, j, n, num_buffers;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  num_buffers = gst_buffer_list_length (list);
+
+  for (i = 0; i < num_buffers && ret == GST_FLOW_OK; i += n) {
+    n = MIN (num_buffers - i, GST_IOV_MAX);
+    for (j = 0; j < n; j++)
+      buffers[j] = gst_buffer_list_get (list, i + j);
+
+    ret = gst_writev_buffers (sink, fd, fdset, buffers, n, bytes_written);
+  }
+  return ret;
+}
@@ -0,0 +1,59 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * gstelements_private.h: shared helpers of the core elements
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_ELEMENTS_PRIVATE_H__
+#define __GST_ELEMENTS_PRIVATE_H__
+
+#include <gst/gst.h>
+#include <limits.h>
+
+G_BEGIN_DECLS
+
+/* POSIX only guarantees 16, use that when the platform doesn't tell us.
+ * The vectors and memory maps are kept on the stack, so limit their
+ * amount. */
+#ifndef IOV_MAX
+#define IOV_MAX 16
+#endif
+#define GST_IOV_MAX MIN (IOV_MAX, 64)
+
+G_GNUC_INTERNAL
+GstFlowReturn   gst_writev_buffers      (GstObject * sink, gint fd,
+                                         GstPoll * fdset,
+                                         GstBuffer ** buffers,
+                                         guint num_buffers,
+                                         guint64 * bytes_written);
+
+G_GNUC_INTERNAL
+GstFlowReturn   gst_writev_buffer       (GstObject * sink, gint fd,
+                                         GstPoll * fdset,
+                                         GstBuffer * buffer,
+                                         guint64 * bytes_written);
+
+G_GNUC_INTERNAL
+GstFlowReturn   gst_writev_buffer_list  (GstObject * sink, gint fd,
+                                         GstPoll * fdset,
+                                         GstBufferList * list,
+                                         guint64 * bytes_written);
+
+G_END_DECLS
+
+#endif /* __GST_ELEMENTS_PRIVATE_H__ */
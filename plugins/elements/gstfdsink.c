@@ -60,6 +60,7 @@
 #include <string.h>
 
 #include "gstfdsink.h"
+#include "gstelements_private.h"
 
 #ifdef G_OS_WIN32
 #include <io.h>                 /* lseek, open, close, read */
@@ -109,6 +110,8 @@ static void gst_fd_sink_dispose (GObject * obj);
 static gboolean gst_fd_sink_query (GstBaseSink * bsink, GstQuery * query);
 static GstFlowReturn gst_fd_sink_render (GstBaseSink * sink,
     GstBuffer * buffer);
+static GstFlowReturn gst_fd_sink_render_list (GstBaseSink * sink,
+    GstBufferList * list);
 static gboolean gst_fd_sink_start (GstBaseSink * basesink);
 static gboolean gst_fd_sink_stop (GstBaseSink * basesink);
 static gboolean gst_fd_sink_unlock (GstBaseSink * basesink);
@@ -140,6 +143,7 @@ gst_fd_sink_class_init (GstFdSinkClass * klass)
       gst_static_pad_template_get (&sinktemplate));
 
   gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_fd_sink_render);
+  gstbasesink_class->render_list = GST_DEBUG_FUNCPTR (gst_fd_sink_render_list);
   gstbasesink_class->start = GST_DEBUG_FUNCPTR (gst_fd_sink_start);
   gstbasesink_class->stop = GST_DEBUG_FUNCPTR (gst_fd_sink_stop);
   gstbasesink_class->unlock = GST_DEBUG_FUNCPTR (gst_fd_sink_unlock);
@@ -230,107 +234,82 @@ gst_fd_sink_query (GstBaseSink * bsink, GstQuery * query)
 }
 
 static GstFlowReturn
-gst_fd_sink_render (GstBaseSink * sink, GstBuffer * buffer)
+gst_fd_sink_handle_result (GstFdSink * fdsink, GstFlowReturn ret,
+    guint64 written)
 {
-  GstFdSink *fdsink;
-  GstMapInfo info;
-  guint8 *ptr;
-  gsize left;
-  gint written;
-
-#ifndef HAVE_WIN32
-  gint retval;
-#endif
-
-  fdsink = GST_FD_SINK (sink);
+  /* the error of the failed write, before logging can change it */
+  gint err = errno;
 
-  g_return_val_if_fail (fdsink->fd >= 0, GST_FLOW_ERROR);
+  fdsink->bytes_written += written;
+  fdsink->current_pos += written;
 
-  gst_buffer_map (buffer, &info, GST_MAP_READ);
+  GST_DEBUG_OBJECT (fdsink, "wrote %" G_GUINT64_FORMAT " bytes", written);
 
-  ptr = info.data;
-  left = info.size;
+  if (G_UNLIKELY (ret == GST_FLOW_FLUSHING)) {
+    GST_DEBUG_OBJECT (fdsink, "Select stopped");
+  } else if (G_UNLIKELY (ret == GST_FLOW_ERROR)) {
+    switch (err) {
+      case ENOSPC:
+        GST_ELEMENT_ERROR (fdsink, RESOURCE, NO_SPACE_LEFT, (NULL), (NULL));
+        break;
+      default:{
+        GST_ELEMENT_ERROR (fdsink, RESOURCE, WRITE, (NULL),
+            ("Error while writing to file descriptor %d: %s",
+                fdsink->fd, g_strerror (err)));
+      }
+    }
+  }
+  return ret;
+}
 
-again:
+static GstPoll *
+gst_fd_sink_get_poll (GstFdSink * fdsink)
+{
 #ifndef HAVE_WIN32
-  do {
-    GST_DEBUG_OBJECT (fdsink, "going into select, have %" G_GSIZE_FORMAT
-        " bytes to write", info.size);
-    retval = gst_poll_wait (fdsink->fdset, GST_CLOCK_TIME_NONE);
-  } while (retval == -1 && (errno == EINTR || errno == EAGAIN));
-
-  if (retval == -1) {
-    if (errno == EBUSY)
-      goto stopped;
-    else
-      goto select_error;
-  }
+  return fdsink->fdset;
+#else
+  return NULL;
 #endif
+}
 
-  GST_DEBUG_OBJECT (fdsink, "writing %" G_GSIZE_FORMAT " bytes to"
-      " file descriptor %d", info.size, fdsink->fd);
+static GstFlowReturn
+gst_fd_sink_render (GstBaseSink * sink, GstBuffer * buffer)
+{
+  GstFdSink *fdsink;
+  GstFlowReturn ret;
+  guint64 written = 0;
+
+  fdsink = GST_FD_SINK (sink);
 
-  written = write (fdsink->fd, ptr, left);
+  g_return_val_if_fail (fdsink->fd >= 0, GST_FLOW_ERROR);
 
-  /* check for errors */
-  if (G_UNLIKELY (written < 0)) {
-    /* try to write again on non-fatal errors */
-    if (errno == EAGAIN || errno == EINTR)
-      goto again;
+  GST_DEBUG_OBJECT (fdsink, "writing %" G_GSIZE_FORMAT " bytes to"
+      " file descriptor %d", gst_buffer_get_size (buffer), fdsink->fd);
 
-    /* else go to our error handler */
-    goto write_error;
-  }
+  ret = gst_writev_buffer (GST_OBJECT_CAST (fdsink), fdsink->fd,
+      gst_fd_sink_get_poll (fdsink), buffer, &written);
 
-  /* all is fine when we get here */
-  left -= written;
-  ptr += written;
-  fdsink->bytes_written += written;
-  fdsink->current_pos += written;
+  return gst_fd_sink_handle_result (fdsink, ret, written);
+}
 
-  GST_DEBUG_OBJECT (fdsink, "wrote %d bytes, %" G_GSIZE_FORMAT " left", written,
-      left);
+static GstFlowReturn
+gst_fd_sink_render_list (GstBaseSink * sink, GstBufferList * list)
+{
+  GstFdSink *fdsink;
+  GstFlowReturn ret;
+  guint64 written = 0;
 
-  /* short write, select and try to write the remainder */
-  if (G_UNLIKELY (left > 0))
-    goto again;
+  fdsink = GST_FD_SINK (sink);
 
-  gst_buffer_unmap (buffer, &info);
+  g_return_val_if_fail (fdsink->fd >= 0, GST_FLOW_ERROR);
 
-  return GST_FLOW_OK;
+  GST_DEBUG_OBJECT (fdsink, "writing list of %u buffers to file descriptor %d",
+      gst_buffer_list_length (list), fdsink->fd);
 
-#ifndef HAVE_WIN32
-select_error:
-  {
-    GST_ELEMENT_ERROR (fdsink, RESOURCE, READ, (NULL),
-        ("select on file descriptor: %s.", g_strerror (errno)));
-    GST_DEBUG_OBJECT (fdsink, "Error during select");
-    gst_buffer_unmap (buffer, &info);
-    return GST_FLOW_ERROR;
-  }
-stopped:
-  {
-    GST_DEBUG_OBJECT (fdsink, "Select stopped");
-    gst_buffer_unmap (buffer, &info);
-    return GST_FLOW_FLUSHING;
-  }
-#endif
+  ret = gst_writev_buffer_list (GST_OBJECT_CAST (fdsink), fdsink->fd,
+      gst_fd_sink_get_poll (fdsink), list, &written);
 
-write_error:
-  {
-    switch (errno) {
-      case ENOSPC:
-        GST_ELEMENT_ERROR (fdsink, RESOURCE, NO_SPACE_LEFT, (NULL), (NULL));
-        break;
-      default:{
-        GST_ELEMENT_ERROR (fdsink, RESOURCE, WRITE, (NULL),
-            ("Error while writing to file descriptor %d: %s",
-                fdsink->fd, g_strerror (errno)));
-      }
-    }
-    gst_buffer_unmap (buffer, &info);
-    return GST_FLOW_ERROR;
-  }
+  return gst_fd_sink_handle_result (fdsink, ret, written);
 }
 
 static gboolean
@@ -44,6 +44,11 @@
  * </listitem>
  * </itemizedlist>
  *
+ * When the file descriptor refers to a regular file and
+ * #GstFdSrc:read-ahead is set, the file is read ahead from a background
+ * thread, see #GstFileSrc:read-ahead. The file position of the file
+ * descriptor is not updated by these reads.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -100,6 +105,7 @@ GST_DEBUG_CATEGORY_STATIC (gst_fd_src_debug);
 
 #define DEFAULT_FD              0
 #define DEFAULT_TIMEOUT         0
+#define DEFAULT_READ_AHEAD      0
 
 enum
 {
@@ -107,6 +113,9 @@ enum
 
   PROP_FD,
   PROP_TIMEOUT,
+  PROP_READ_AHEAD,
+  PROP_READ_AHEAD_HITS,
+  PROP_READ_AHEAD_MISSES,
 
   PROP_LAST
 };
@@ -166,6 +175,20 @@ gst_fd_src_class_init (GstFdSrcClass * klass)
           "Post a message after timeout microseconds (0 = disabled)", 0,
           G_MAXUINT64, DEFAULT_TIMEOUT,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_READ_AHEAD,
+      g_param_spec_uint64 ("read-ahead", "Read-ahead",
+          "Amount of bytes to read ahead from a background thread when the fd "
+          "is a regular file (0 = disabled)", 0, G_MAXUINT64,
+          DEFAULT_READ_AHEAD, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_READ_AHEAD_HITS,
+      g_param_spec_uint64 ("read-ahead-hits", "Read-ahead hits",
+          "Amount of blocks that were available from the read-ahead window",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_READ_AHEAD_MISSES,
+      g_param_spec_uint64 ("read-ahead-misses", "Read-ahead misses",
+          "Amount of blocks that had to be read from the streaming thread",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
   gst_element_class_set_static_metadata (gstelement_class,
       "Filedescriptor Source",
@@ -196,6 +219,10 @@ gst_fd_src_init (GstFdSrc * fdsrc)
   fdsrc->timeout = DEFAULT_TIMEOUT;
   fdsrc->uri = g_strdup_printf ("fd://0");
   fdsrc->curoffset = 0;
+  fdsrc->read_ahead = DEFAULT_READ_AHEAD;
+  fdsrc->ra = NULL;
+  fdsrc->ra_hits = 0;
+  fdsrc->ra_misses = 0;
 }
 
 static void
@@ -282,6 +309,17 @@ gst_fd_src_start (GstBaseSrc * bsrc)
 
   gst_fd_src_update_fd (src, -1);
 
+  if (src->read_ahead > 0 && src->seekable_fd) {
+    GstReadAhead *ra;
+
+    ra = gst_read_ahead_new (GST_OBJECT_CAST (src), src->fd, src->read_ahead);
+
+    GST_OBJECT_LOCK (src);
+    src->ra = ra;
+    src->ra_hits = src->ra_misses = 0;
+    GST_OBJECT_UNLOCK (src);
+  }
+
   return TRUE;
 
   /* ERRORS */
@@ -303,6 +341,17 @@ gst_fd_src_stop (GstBaseSrc * bsrc)
     src->fdset = NULL;
   }
 
+  if (src->ra) {
+    GstReadAhead *ra = src->ra;
+
+    GST_OBJECT_LOCK (src);
+    gst_read_ahead_get_stats (ra, &src->ra_hits, &src->ra_misses);
+    src->ra = NULL;
+    GST_OBJECT_UNLOCK (src);
+
+    gst_read_ahead_free (ra);
+  }
+
   return TRUE;
 }
 
@@ -358,6 +407,9 @@ gst_fd_src_set_property (GObject * object, guint prop_id, const GValue * value,
       GST_DEBUG_OBJECT (src, "poll timeout set to %" GST_TIME_FORMAT,
           GST_TIME_ARGS (src->timeout));
       break;
+    case PROP_READ_AHEAD:
+      src->read_ahead = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -377,12 +429,68 @@ gst_fd_src_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_TIMEOUT:
       g_value_set_uint64 (value, src->timeout);
       break;
+    case PROP_READ_AHEAD:
+      g_value_set_uint64 (value, src->read_ahead);
+      break;
+    case PROP_READ_AHEAD_HITS:
+    case PROP_READ_AHEAD_MISSES:
+    {
+      guint64 hits, misses;
+
+      GST_OBJECT_LOCK (src);
+      if (src->ra) {
+        gst_read_ahead_get_stats (src->ra, &hits, &misses);
+      } else {
+        hits = src->ra_hits;
+        misses = src->ra_misses;
+      }
+      GST_OBJECT_UNLOCK (src);
+
+      g_value_set_uint64 (value,
+          prop_id == PROP_READ_AHEAD_HITS ? hits : misses);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+static GstFlowReturn
+gst_fd_src_create_read_ahead (GstFdSrc * src, guint blocksize,
+    GstBuffer ** outbuf)
+{
+  GstFlowReturn ret;
+  GstBuffer *buf;
+
+  ret = gst_read_ahead_read (src->ra, src->curoffset, blocksize, &buf);
+  if (G_UNLIKELY (ret != GST_FLOW_OK))
+    goto read_failed;
+
+  GST_BUFFER_OFFSET (buf) = src->curoffset;
+  GST_BUFFER_TIMESTAMP (buf) = GST_CLOCK_TIME_NONE;
+  src->curoffset += gst_buffer_get_size (buf);
+
+  GST_LOG_OBJECT (src, "Read buffer of size %" G_GSIZE_FORMAT,
+      gst_buffer_get_size (buf));
+
+  *outbuf = buf;
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+read_failed:
+  {
+    if (ret == GST_FLOW_EOS) {
+      GST_DEBUG_OBJECT (src, "Read 0 bytes. EOS.");
+    } else {
+      GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL),
+          ("read on file descriptor: %s.", g_strerror (errno)));
+    }
+    return ret;
+  }
+}
+
 static GstFlowReturn
 gst_fd_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 {
@@ -438,6 +546,9 @@ gst_fd_src_create (GstPushSrc * psrc, GstBuffer ** outbuf)
 
   blocksize = GST_BASE_SRC (src)->blocksize;
 
+  if (src->ra)
+    return gst_fd_src_create_read_ahead (src, blocksize, outbuf);
+
   /* create the buffer */
   buf = gst_buffer_new_allocate (NULL, blocksize, NULL);
   if (G_UNLIKELY (buf == NULL))
@@ -587,6 +698,7 @@ gst_fd_src_do_seek (GstBaseSrc * bsrc, GstSegment * segment)
 
   segment->position = segment->start;
   segment->time = segment->start;
+  src->curoffset = offset;
 
   return TRUE;
 
@@ -28,6 +28,8 @@
 #include <gst/gst.h>
 #include <gst/base/gstpushsrc.h>
 
+#include "gstreadahead.h"
+
 G_BEGIN_DECLS
 
 
@@ -71,6 +73,11 @@ struct _GstFdSrc {
   GstPoll *fdset;
 
   gulong curoffset; /* current offset in file */
+
+  guint64 read_ahead;   /* read-ahead window in bytes */
+  GstReadAhead *ra;     /* read-ahead engine when active */
+  guint64 ra_hits;      /* read-ahead stats of the last run */
+  guint64 ra_misses;
 };
 
 struct _GstFdSrcClass {
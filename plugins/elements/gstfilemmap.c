@@ -0,0 +1,226 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * gstfilemmap.c: read-only memory pointing into mapped files
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstFileMapping is a refcounted window of a file mapped with mmap(). The
+ * allocator wraps parts of such a window in read-only memory that keeps the
+ * mapping alive until it is freed, so that elements can hand out data from
+ * files without copying it. Used by filesrc and the temp file of queue2.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstfilemmap.h"
+
+#ifdef HAVE_MMAP
+#include <sys/types.h>
+#include <sys/mman.h>
+
+GST_DEBUG_CATEGORY_STATIC (file_mmap_debug);
+#define GST_CAT_DEFAULT file_mmap_debug
+
+typedef struct
+{
+  GstMemory mem;
+
+  GstFileMapping *mapping;
+} GstFileMmapMemory;
+
+typedef struct
+{
+  GstAllocator parent;
+} GstFileMmapAllocator;
+
+typedef struct
+{
+  GstAllocatorClass parent_class;
+} GstFileMmapAllocatorClass;
+
+static GType gst_file_mmap_allocator_get_type (void);
+G_DEFINE_TYPE (GstFileMmapAllocator, gst_file_mmap_allocator,
+    GST_TYPE_ALLOCATOR);
+
+/* map @size bytes of @fd starting at @offset, which must be a multiple of
+ * the page size. Returns NULL with errno set when the mmap() fails. */
+GstFileMapping *
+gst_file_mapping_new (gint fd, guint64 offset, gsize size)
+{
+  GstFileMapping *mapping;
+  gpointer data;
+
+  data = mmap (NULL, size, PROT_READ, MAP_SHARED, fd, (off_t) offset);
+  if (data == MAP_FAILED)
+    return NULL;
+
+  mapping = g_slice_new (GstFileMapping);
+  mapping->refcount = 1;
+  mapping->data = data;
+  mapping->size = size;
+  mapping->offset = offset;
+
+  return mapping;
+}
+
+GstFileMapping *
+gst_file_mapping_ref (GstFileMapping * mapping)
+{
+  g_atomic_int_inc (&mapping->refcount);
+
+  return mapping;
+}
+
+void
+gst_file_mapping_unref (GstFileMapping * mapping)
+{
+  if (g_atomic_int_dec_and_test (&mapping->refcount)) {
+    GST_LOG ("unmapping %p, offset %" G_GUINT64_FORMAT ", size %"
+        G_GSIZE_FORMAT, mapping->data, mapping->offset, mapping->size);
+    munmap ((void *) mapping->data, mapping->size);
+    g_slice_free (GstFileMapping, mapping);
+  }
+}
+
+static GstFileMmapMemory *
+gst_file_mmap_memory_new_internal (GstAllocator * allocator,
+    GstMemory * parent, GstFileMapping * mapping, gsize offset, gsize size)
+{
+  GstFileMmapMemory *mem;
+
+  mem = g_slice_new (GstFileMmapMemory);
+  gst_memory_init (GST_MEMORY_CAST (mem),
+      GST_MEMORY_FLAG_READONLY, allocator, parent,
+      mapping->size, 0, offset, size);
+  mem->mapping = gst_file_mapping_ref (mapping);
+
+  return mem;
+}
+
+/* wrap @size bytes at @offset in @mapping in read-only memory */
+GstMemory *
+gst_file_mmap_memory_new (GstAllocator * allocator, GstFileMapping * mapping,
+    gsize offset, gsize size)
+{
+  g_return_val_if_fail (offset + size <= mapping->size, NULL);
+
+  return GST_MEMORY_CAST (gst_file_mmap_memory_new_internal (allocator, NULL,
+          mapping, offset, size));
+}
+
+static gpointer
+gst_file_mmap_memory_map (GstFileMmapMemory * mem, gsize maxsize,
+    GstMapFlags flags)
+{
+  /* memory is flagged readonly, locking for write already failed */
+  return mem->mapping->data;
+}
+
+static gboolean
+gst_file_mmap_memory_unmap (GstFileMmapMemory * mem)
+{
+  return TRUE;
+}
+
+static GstFileMmapMemory *
+gst_file_mmap_memory_share (GstFileMmapMemory * mem, gssize offset,
+    gsize size)
+{
+  GstMemory *parent;
+
+  /* find the real parent */
+  if ((parent = mem->mem.parent) == NULL)
+    parent = (GstMemory *) mem;
+
+  if (size == -1)
+    size = mem->mem.size - offset;
+
+  return gst_file_mmap_memory_new_internal (mem->mem.allocator, parent,
+      mem->mapping, mem->mem.offset + offset, size);
+}
+
+static gboolean
+gst_file_mmap_memory_is_span (GstFileMmapMemory * mem1,
+    GstFileMmapMemory * mem2, gsize * offset)
+{
+  if (mem1->mapping != mem2->mapping)
+    return FALSE;
+
+  if (offset) {
+    GstMemory *parent;
+
+    parent = mem1->mem.parent;
+
+    *offset = mem1->mem.offset - parent->offset;
+  }
+
+  return mem1->mem.offset + mem1->mem.size == mem2->mem.offset;
+}
+
+static GstMemory *
+gst_file_mmap_allocator_alloc (GstAllocator * allocator, gsize size,
+    GstAllocationParams * params)
+{
+  /* memory is only created by wrapping a mapping */
+  return NULL;
+}
+
+static void
+gst_file_mmap_allocator_free (GstAllocator * allocator, GstMemory * mem)
+{
+  GstFileMmapMemory *fmem = (GstFileMmapMemory *) mem;
+
+  gst_file_mapping_unref (fmem->mapping);
+  g_slice_free (GstFileMmapMemory, fmem);
+}
+
+static void
+gst_file_mmap_allocator_class_init (GstFileMmapAllocatorClass * klass)
+{
+  GstAllocatorClass *allocator_class = (GstAllocatorClass *) klass;
+
+  allocator_class->alloc = gst_file_mmap_allocator_alloc;
+  allocator_class->free = gst_file_mmap_allocator_free;
+
+  GST_DEBUG_CATEGORY_INIT (file_mmap_debug, "filemmap", 0,
+      "Memory pointing into mapped files");
+}
+
+static void
+gst_file_mmap_allocator_init (GstFileMmapAllocator * allocator)
+{
+  GstAllocator *alloc = GST_ALLOCATOR_CAST (allocator);
+
+  alloc->mem_type = GST_FILE_MMAP_MEMORY_TYPE;
+  alloc->mem_map = (GstMemoryMapFunction) gst_file_mmap_memory_map;
+  alloc->mem_unmap = (GstMemoryUnmapFunction) gst_file_mmap_memory_unmap;
+  alloc->mem_share = (GstMemoryShareFunction) gst_file_mmap_memory_share;
+  alloc->mem_is_span = (GstMemoryIsSpanFunction) gst_file_mmap_memory_is_span;
+
+  /* copies are made in system memory */
+  GST_OBJECT_FLAG_SET (allocator, GST_ALLOCATOR_FLAG_CUSTOM_ALLOC);
+}
+
+GstAllocator *
+gst_file_mmap_allocator_new (void)
+{
+  return g_object_new (gst_file_mmap_allocator_get_type (), NULL);
+}
+#endif
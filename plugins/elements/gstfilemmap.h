@@ -0,0 +1,62 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * gstfilemmap.h: read-only memory pointing into mapped files
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_FILE_MMAP_H__
+#define __GST_FILE_MMAP_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+#define GST_FILE_MMAP_MEMORY_TYPE "FileMmap"
+
+typedef struct _GstFileMapping GstFileMapping;
+
+/* a window of a file that is mapped into memory. It is shared by all the
+ * memory blocks pointing into it and unmapped when the last one is freed */
+struct _GstFileMapping
+{
+  volatile gint refcount;
+
+  guint8 *data;
+  gsize size;
+  guint64 offset;               /* offset of data in the file */
+};
+
+G_GNUC_INTERNAL
+GstFileMapping * gst_file_mapping_new       (gint fd, guint64 offset,
+                                             gsize size);
+G_GNUC_INTERNAL
+GstFileMapping * gst_file_mapping_ref       (GstFileMapping * mapping);
+G_GNUC_INTERNAL
+void             gst_file_mapping_unref     (GstFileMapping * mapping);
+
+G_GNUC_INTERNAL
+GstAllocator *   gst_file_mmap_allocator_new (void);
+
+G_GNUC_INTERNAL
+GstMemory *      gst_file_mmap_memory_new   (GstAllocator * allocator,
+                                             GstFileMapping * mapping,
+                                             gsize offset, gsize size);
+
+G_END_DECLS
+
+#endif /* __GST_FILE_MMAP_H__ */
@@ -32,6 +32,19 @@
  * gst-launch v4l2src num-buffers=1 ! jpegenc ! filesink location=capture1.jpeg
  * ]| Capture one frame from a v4l2 camera and save as jpeg image.
  * </refsect2>
+ *
+ * Data is written with writev(), so buffers consisting of multiple memory
+ * blocks and buffer lists are written with a single system call. In the
+ * default and full #GstFileSink:buffer-mode, small buffers are copied into
+ * a buffer of #GstFileSink:buffer-size bytes that is written out when full;
+ * larger buffers and buffers in line and unbuffered mode are written
+ * immediately.
+ *
+ * When #GstFileSink:o-direct is set, the file is written with O_DIRECT in
+ * blocks of #GstFileSink:buffer-size bytes, bypassing the page cache. This
+ * is useful for long recordings that are not read back soon. The last
+ * partial block is written without O_DIRECT when the stream ends or when the
+ * sink seeks, after which the normal mode is used.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -42,13 +55,13 @@
 
 #include <gst/gst.h>
 #include <stdio.h>              /* for fseeko() */
-#ifdef HAVE_STDIO_EXT_H
-#include <stdio_ext.h>          /* for __fbufsize, for debugging */
-#endif
+#include <stdlib.h>
 #include <errno.h>
 #include "gstfilesink.h"
+#include "gstelements_private.h"
 #include <string.h>
 #include <sys/types.h>
+#include <fcntl.h>
 
 #ifdef G_OS_WIN32
 #include <io.h>                 /* lseek, open, close, read */
@@ -100,6 +113,10 @@ GST_DEBUG_CATEGORY_STATIC (gst_file_sink_debug);
 #define DEFAULT_BUFFER_MODE 	-1
 #define DEFAULT_BUFFER_SIZE 	64 * 1024
 #define DEFAULT_APPEND		FALSE
+#define DEFAULT_O_DIRECT	FALSE
+
+/* alignment of offsets and sizes of O_DIRECT writes */
+#define DIRECT_ALIGN		4096
 
 enum
 {
@@ -108,6 +125,7 @@ enum
   PROP_BUFFER_MODE,
   PROP_BUFFER_SIZE,
   PROP_APPEND,
+  PROP_O_DIRECT,
   PROP_LAST
 };
 
@@ -164,6 +182,11 @@ static gboolean gst_file_sink_stop (GstBaseSink * sink);
 static gboolean gst_file_sink_event (GstBaseSink * sink, GstEvent * event);
 static GstFlowReturn gst_file_sink_render (GstBaseSink * sink,
     GstBuffer * buffer);
+static GstFlowReturn gst_file_sink_render_list (GstBaseSink * sink,
+    GstBufferList * list);
+static GstFlowReturn gst_file_sink_flush_buffer (GstFileSink * filesink);
+static GstFlowReturn gst_file_sink_flush_direct (GstFileSink * filesink);
+static void gst_file_sink_enable_direct (GstFileSink * filesink);
 
 static gboolean gst_file_sink_do_seek (GstFileSink * filesink,
     guint64 new_offset);
@@ -206,7 +229,8 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
 
   g_object_class_install_property (gobject_class, PROP_BUFFER_SIZE,
       g_param_spec_uint ("buffer-size", "Buffering size",
-          "Size of buffer in number of bytes for line or full buffer-mode", 0,
+          "Size of buffer in number of bytes for default or full buffer-mode",
+          0,
           G_MAXUINT, DEFAULT_BUFFER_SIZE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
@@ -220,6 +244,17 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
           "Append to an already existing file", DEFAULT_APPEND,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstFileSink:o-direct
+   *
+   * Write the file with O_DIRECT in aligned blocks of buffer-size bytes.
+   * Ignored on platforms or file systems that don't support it.
+   */
+  g_object_class_install_property (gobject_class, PROP_O_DIRECT,
+      g_param_spec_boolean ("o-direct", "O_DIRECT",
+          "Bypass the page cache by writing aligned blocks with O_DIRECT",
+          DEFAULT_O_DIRECT, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "File Sink",
       "Sink/File", "Write stream to a file",
@@ -231,6 +266,8 @@ gst_file_sink_class_init (GstFileSinkClass * klass)
   gstbasesink_class->stop = GST_DEBUG_FUNCPTR (gst_file_sink_stop);
   gstbasesink_class->query = GST_DEBUG_FUNCPTR (gst_file_sink_query);
   gstbasesink_class->render = GST_DEBUG_FUNCPTR (gst_file_sink_render);
+  gstbasesink_class->render_list =
+      GST_DEBUG_FUNCPTR (gst_file_sink_render_list);
   gstbasesink_class->event = GST_DEBUG_FUNCPTR (gst_file_sink_event);
 
   if (sizeof (off_t) < 8) {
@@ -247,8 +284,15 @@ gst_file_sink_init (GstFileSink * filesink)
   filesink->current_pos = 0;
   filesink->buffer_mode = DEFAULT_BUFFER_MODE;
   filesink->buffer_size = DEFAULT_BUFFER_SIZE;
-  filesink->buffer = NULL;
+  filesink->pending = NULL;
+  filesink->pending_size = 0;
+  filesink->current_buffer_size = 0;
   filesink->append = FALSE;
+  filesink->o_direct = DEFAULT_O_DIRECT;
+  filesink->using_direct = FALSE;
+  filesink->direct_buffer = NULL;
+  filesink->direct_size = 0;
+  filesink->direct_fill = 0;
 
   gst_base_sink_set_sync (GST_BASE_SINK (filesink), FALSE);
 }
@@ -264,9 +308,6 @@ gst_file_sink_dispose (GObject * object)
   sink->uri = NULL;
   g_free (sink->filename);
   sink->filename = NULL;
-  g_free (sink->buffer);
-  sink->buffer = NULL;
-  sink->buffer_size = 0;
 }
 
 static gboolean
@@ -323,6 +364,9 @@ gst_file_sink_set_property (GObject * object, guint prop_id,
     case PROP_APPEND:
       sink->append = g_value_get_boolean (value);
       break;
+    case PROP_O_DIRECT:
+      sink->o_direct = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -348,6 +392,9 @@ gst_file_sink_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_APPEND:
       g_value_set_boolean (value, sink->append);
       break;
+    case PROP_O_DIRECT:
+      g_value_set_boolean (value, sink->o_direct);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -357,8 +404,6 @@ gst_file_sink_get_property (GObject * object, guint prop_id, GValue * value,
 static gboolean
 gst_file_sink_open_file (GstFileSink * sink)
 {
-  gint mode;
-
   /* open the file */
   if (sink->filename == NULL || sink->filename[0] == '\0')
     goto no_filename;
@@ -370,35 +415,17 @@ gst_file_sink_open_file (GstFileSink * sink)
   if (sink->file == NULL)
     goto open_failed;
 
-  /* see if we are asked to perform a specific kind of buffering */
-  if ((mode = sink->buffer_mode) != -1) {
-    guint buffer_size;
-
-    /* free previous buffer if any */
-    g_free (sink->buffer);
+  /* we do our own buffering and write with writev() on the fd, make sure
+   * stdio doesn't buffer anything */
+  setvbuf (sink->file, NULL, _IONBF, 0);
 
-    if (mode == _IONBF) {
-      /* no buffering */
-      sink->buffer = NULL;
-      buffer_size = 0;
-    } else {
-      /* allocate buffer */
-      sink->buffer = g_malloc (sink->buffer_size);
-      buffer_size = sink->buffer_size;
-    }
-    /* Cygwin does not have __fbufsize */
-#if defined(HAVE_STDIO_EXT_H) && !defined(__CYGWIN__)
-    GST_DEBUG_OBJECT (sink, "change buffer size %u to %u, mode %d",
-        (guint) __fbufsize (sink->file), buffer_size, mode);
-#else
-    GST_DEBUG_OBJECT (sink, "change  buffer size to %u, mode %d",
-        sink->buffer_size, mode);
-#endif
-    if (setvbuf (sink->file, sink->buffer, mode, buffer_size) != 0) {
-      GST_WARNING_OBJECT (sink, "warning: setvbuf failed: %s",
-          g_strerror (errno));
-    }
+  /* unbuffered and line buffered modes write every buffer right away */
+  if (sink->buffer_mode != _IONBF && sink->buffer_mode != _IOLBF
+      && sink->buffer_size > 0) {
+    sink->pending_size = sink->buffer_size;
+    sink->pending = g_malloc (sink->pending_size);
   }
+  sink->current_buffer_size = 0;
 
   sink->current_pos = 0;
   /* try to seek in the file to figure out if it is seekable */
@@ -407,6 +434,9 @@ gst_file_sink_open_file (GstFileSink * sink)
   GST_DEBUG_OBJECT (sink, "opened file %s, seekable %d",
       sink->filename, sink->seekable);
 
+  if (sink->o_direct)
+    gst_file_sink_enable_direct (sink);
+
   return TRUE;
 
   /* ERRORS */
@@ -429,14 +459,28 @@ static void
 gst_file_sink_close_file (GstFileSink * sink)
 {
   if (sink->file) {
+    if (gst_file_sink_flush_buffer (sink) != GST_FLOW_OK) {
+      gint err = errno;
+
+      GST_ELEMENT_WARNING (sink, RESOURCE, WRITE,
+          (_("Error while writing to file \"%s\"."), sink->filename),
+          ("%s", g_strerror (err)));
+    }
+
+    g_free (sink->pending);
+    sink->pending = NULL;
+    sink->pending_size = 0;
+
+    if (sink->direct_buffer) {
+      free (sink->direct_buffer);
+      sink->direct_buffer = NULL;
+    }
+
     if (fclose (sink->file) != 0)
       goto close_failed;
 
     GST_DEBUG_OBJECT (sink, "closed file");
     sink->file = NULL;
-
-    g_free (sink->buffer);
-    sink->buffer = NULL;
   }
   return;
 
@@ -465,7 +509,10 @@ gst_file_sink_query (GstBaseSink * bsink, GstQuery * query)
       switch (format) {
         case GST_FORMAT_DEFAULT:
         case GST_FORMAT_BYTES:
-          gst_query_set_position (query, GST_FORMAT_BYTES, self->current_pos);
+          /* include the data we didn't write yet */
+          gst_query_set_position (query, GST_FORMAT_BYTES,
+              self->current_pos + self->current_buffer_size +
+              self->direct_fill);
           res = TRUE;
           break;
         default:
@@ -515,6 +562,9 @@ gst_file_sink_do_seek (GstFileSink * filesink, guint64 new_offset)
   GST_DEBUG_OBJECT (filesink, "Seeking to offset %" G_GUINT64_FORMAT
       " using " __GST_STDIO_SEEK_FUNCTION, new_offset);
 
+  if (gst_file_sink_flush_buffer (filesink) != GST_FLOW_OK)
+    goto flush_failed;
+
   if (fflush (filesink->file))
     goto flush_failed;
 
@@ -539,12 +589,18 @@ gst_file_sink_do_seek (GstFileSink * filesink, guint64 new_offset)
   /* ERRORS */
 flush_failed:
   {
-    GST_DEBUG_OBJECT (filesink, "Flush failed: %s", g_strerror (errno));
+    gint err = errno;
+
+    GST_DEBUG_OBJECT (filesink, "Flush failed: %s", g_strerror (err));
+    errno = err;
     return FALSE;
   }
 seek_failed:
   {
-    GST_DEBUG_OBJECT (filesink, "Seeking failed: %s", g_strerror (errno));
+    gint err = errno;
+
+    GST_DEBUG_OBJECT (filesink, "Seeking failed: %s", g_strerror (err));
+    errno = err;
     return FALSE;
   }
 }
@@ -588,13 +644,24 @@ gst_file_sink_event (GstBaseSink * sink, GstEvent * event)
       break;
     }
     case GST_EVENT_FLUSH_STOP:
-      if (filesink->current_pos != 0 && filesink->seekable) {
-        gst_file_sink_do_seek (filesink, 0);
-        if (ftruncate (fileno (filesink->file), 0))
-          goto flush_failed;
+      if (filesink->seekable) {
+        /* the file is truncated, so what we did not write yet is dropped */
+        filesink->current_buffer_size = 0;
+        filesink->direct_fill = 0;
+        if (filesink->current_pos != 0) {
+          gst_file_sink_do_seek (filesink, 0);
+          if (ftruncate (fileno (filesink->file), 0))
+            goto flush_failed;
+        }
+      } else if (gst_file_sink_flush_buffer (filesink) != GST_FLOW_OK) {
+        /* what was written before can't be taken back either, write the
+         * pending data too like stdio would have done */
+        goto flush_failed;
       }
       break;
     case GST_EVENT_EOS:
+      if (gst_file_sink_flush_buffer (filesink) != GST_FLOW_OK)
+        goto flush_failed;
       if (fflush (filesink->file))
         goto flush_failed;
       break;
@@ -607,17 +674,21 @@ gst_file_sink_event (GstBaseSink * sink, GstEvent * event)
   /* ERRORS */
 seek_failed:
   {
+    gint err = errno;
+
     GST_ELEMENT_ERROR (filesink, RESOURCE, SEEK,
         (_("Error while seeking in file \"%s\"."), filesink->filename),
-        GST_ERROR_SYSTEM);
+        ("%s", g_strerror (err)));
     gst_event_unref (event);
     return FALSE;
   }
 flush_failed:
   {
+    gint err = errno;
+
     GST_ELEMENT_ERROR (filesink, RESOURCE, WRITE,
         (_("Error while writing to file \"%s\"."), filesink->filename),
-        GST_ERROR_SYSTEM);
+        ("%s", g_strerror (err)));
     gst_event_unref (event);
     return FALSE;
   }
@@ -646,46 +717,293 @@ gst_file_sink_get_current_offset (GstFileSink * filesink, guint64 * p_pos)
   return (ret != (off_t) - 1);
 }
 
+/* @err is the errno of the failed write */
+static void
+gst_file_sink_post_write_error (GstFileSink * filesink, gint err)
+{
+  switch (err) {
+    case ENOSPC:{
+      GST_ELEMENT_ERROR (filesink, RESOURCE, NO_SPACE_LEFT, (NULL), (NULL));
+      break;
+    }
+    default:{
+      GST_ELEMENT_ERROR (filesink, RESOURCE, WRITE,
+          (_("Error while writing to file \"%s\"."), filesink->filename),
+          ("%s", g_strerror (err)));
+    }
+  }
+}
+
+/* write the data that was collected so far. On error, errno is the one of
+ * the failed write */
 static GstFlowReturn
-gst_file_sink_render (GstBaseSink * sink, GstBuffer * buffer)
+gst_file_sink_flush_buffer (GstFileSink * filesink)
 {
-  GstFileSink *filesink;
-  GstMapInfo info;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if (filesink->using_direct || filesink->direct_fill > 0)
+    ret = gst_file_sink_flush_direct (filesink);
+
+  if (filesink->current_buffer_size > 0) {
+    GstBuffer *buf;
+    gint err;
+
+    GST_DEBUG_OBJECT (filesink, "writing %" G_GUINT64_FORMAT
+        " bytes at %" G_GUINT64_FORMAT, filesink->current_buffer_size,
+        filesink->current_pos);
+
+    if (ret == GST_FLOW_OK) {
+      buf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+          filesink->pending, filesink->pending_size, 0,
+          filesink->current_buffer_size, NULL, NULL);
+      ret = gst_writev_buffer (GST_OBJECT_CAST (filesink),
+          fileno (filesink->file), NULL, buf, &filesink->current_pos);
+      err = errno;
+      gst_buffer_unref (buf);
+      errno = err;
+    }
+    filesink->current_buffer_size = 0;
+  }
 
-  filesink = GST_FILE_SINK (sink);
+  return ret;
+}
 
-  gst_buffer_map (buffer, &info, GST_MAP_READ);
+static void
+gst_file_sink_enable_direct (GstFileSink * filesink)
+{
+#if defined(O_DIRECT) && defined(HAVE_POSIX_MEMALIGN)
+  gint fd, flags;
+  gpointer mem;
+
+  /* the file offset must be aligned */
+  if (filesink->current_pos % DIRECT_ALIGN != 0)
+    goto unaligned;
+
+  filesink->direct_size =
+      MAX (DIRECT_ALIGN, (filesink->buffer_size + DIRECT_ALIGN - 1) &
+      ~(DIRECT_ALIGN - 1));
+  if (posix_memalign (&mem, DIRECT_ALIGN, filesink->direct_size) != 0)
+    goto no_memory;
+
+  fd = fileno (filesink->file);
+  flags = fcntl (fd, F_GETFL);
+  if (flags == -1 || fcntl (fd, F_SETFL, flags | O_DIRECT) == -1)
+    goto not_supported;
+
+  GST_DEBUG_OBJECT (filesink, "writing with O_DIRECT in blocks of %"
+      G_GSIZE_FORMAT " bytes", filesink->direct_size);
+
+  filesink->direct_buffer = mem;
+  filesink->direct_fill = 0;
+  filesink->using_direct = TRUE;
+  return;
 
-  GST_DEBUG_OBJECT (filesink,
-      "writing %" G_GSIZE_FORMAT " bytes at %" G_GUINT64_FORMAT,
-      info.size, filesink->current_pos);
+  /* ERRORS */
+unaligned:
+  {
+    GST_WARNING_OBJECT (filesink, "file position %" G_GUINT64_FORMAT
+        " is not aligned, not using O_DIRECT", filesink->current_pos);
+    return;
+  }
+no_memory:
+  {
+    GST_WARNING_OBJECT (filesink, "could not allocate aligned memory");
+    return;
+  }
+not_supported:
+  {
+    GST_WARNING_OBJECT (filesink, "could not enable O_DIRECT: %s",
+        g_strerror (errno));
+    free (mem);
+    return;
+  }
+#else
+  GST_WARNING_OBJECT (filesink, "O_DIRECT is not supported");
+#endif
+}
 
-  if (info.size > 0 && info.data != NULL) {
-    if (fwrite (info.data, info.size, 1, filesink->file) != 1)
-      goto handle_error;
+static void
+gst_file_sink_disable_direct (GstFileSink * filesink)
+{
+#ifdef O_DIRECT
+  gint fd, flags;
 
-    filesink->current_pos += info.size;
+  fd = fileno (filesink->file);
+  flags = fcntl (fd, F_GETFL);
+  if (flags != -1)
+    fcntl (fd, F_SETFL, flags & ~O_DIRECT);
+#endif
+  filesink->using_direct = FALSE;
+}
+
+static GstFlowReturn
+gst_file_sink_write_direct (GstFileSink * filesink, gsize size)
+{
+  GstFlowReturn ret;
+  GstBuffer *buf;
+  gint err;
+
+  buf = gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
+      filesink->direct_buffer, filesink->direct_size, 0, size, NULL, NULL);
+  ret = gst_writev_buffer (GST_OBJECT_CAST (filesink),
+      fileno (filesink->file), NULL, buf, &filesink->current_pos);
+  err = errno;
+  gst_buffer_unref (buf);
+
+  if (ret != GST_FLOW_OK && err == EINVAL && filesink->using_direct) {
+    /* the file system doesn't support O_DIRECT */
+    GST_WARNING_OBJECT (filesink, "O_DIRECT write failed, disabling");
+    gst_file_sink_disable_direct (filesink);
+    return gst_file_sink_write_direct (filesink, size);
   }
-  gst_buffer_unmap (buffer, &info);
+  errno = err;
+  return ret;
+}
 
-  return GST_FLOW_OK;
+/* write out the aligned part of the staging buffer with O_DIRECT and the
+ * rest without. The file position is not aligned anymore afterwards so
+ * O_DIRECT is not used from now on. */
+static GstFlowReturn
+gst_file_sink_flush_direct (GstFileSink * filesink)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  gsize aligned, rest;
+  gint err;
 
-handle_error:
-  {
-    switch (errno) {
-      case ENOSPC:{
-        GST_ELEMENT_ERROR (filesink, RESOURCE, NO_SPACE_LEFT, (NULL), (NULL));
-        break;
+  aligned = filesink->direct_fill & ~(DIRECT_ALIGN - 1);
+  rest = filesink->direct_fill - aligned;
+
+  if (aligned > 0 && filesink->using_direct)
+    ret = gst_file_sink_write_direct (filesink, aligned);
+
+  err = errno;
+  if (filesink->using_direct)
+    gst_file_sink_disable_direct (filesink);
+  errno = err;
+
+  if (ret == GST_FLOW_OK && rest > 0) {
+    memmove (filesink->direct_buffer, filesink->direct_buffer + aligned, rest);
+    ret = gst_file_sink_write_direct (filesink, rest);
+  }
+  filesink->direct_fill = 0;
+
+  return ret;
+}
+
+/* copy the buffers into the aligned staging buffer and write it out
+ * whenever it is full */
+static GstFlowReturn
+gst_file_sink_render_direct (GstFileSink * filesink, GstBuffer ** buffers,
+    guint num_buffers)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i;
+
+  for (i = 0; i < num_buffers && ret == GST_FLOW_OK; i++) {
+    gsize offset = 0, size, n;
+
+    size = gst_buffer_get_size (buffers[i]);
+
+    while (offset < size && ret == GST_FLOW_OK) {
+      n = MIN (size - offset, filesink->direct_size - filesink->direct_fill);
+      gst_buffer_extract (buffers[i], offset,
+          filesink->direct_buffer + filesink->direct_fill, n);
+      filesink->direct_fill += n;
+      offset += n;
+
+      if (filesink->direct_fill == filesink->direct_size) {
+        ret = gst_file_sink_write_direct (filesink, filesink->direct_size);
+        filesink->direct_fill = 0;
       }
-      default:{
-        GST_ELEMENT_ERROR (filesink, RESOURCE, WRITE,
-            (_("Error while writing to file \"%s\"."), filesink->filename),
-            ("%s", g_strerror (errno)));
+    }
+  }
+
+  /* O_DIRECT got disabled, write the remaining data now as the next buffers
+   * will not go through the staging buffer anymore */
+  if (ret == GST_FLOW_OK && !filesink->using_direct)
+    ret = gst_file_sink_flush_direct (filesink);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_file_sink_render_buffers (GstFileSink * filesink, GstBuffer ** buffers,
+    guint num_buffers, guint64 size)
+{
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i;
+
+  GST_DEBUG_OBJECT (filesink,
+      "rendering %u buffers, %" G_GUINT64_FORMAT " bytes at %" G_GUINT64_FORMAT,
+      num_buffers, size, filesink->current_pos + filesink->current_buffer_size);
+
+  if (filesink->using_direct) {
+    ret = gst_file_sink_render_direct (filesink, buffers, num_buffers);
+  } else {
+    /* write what we collected so far when these buffers don't fit anymore */
+    if (filesink->current_buffer_size + size > filesink->pending_size)
+      ret = gst_file_sink_flush_buffer (filesink);
+
+    if (ret != GST_FLOW_OK) {
+      /* error, nothing to do */
+    } else if (size >= filesink->pending_size) {
+      /* too big to collect, write them out right away */
+      ret = gst_writev_buffers (GST_OBJECT_CAST (filesink),
+          fileno (filesink->file), NULL, buffers, num_buffers,
+          &filesink->current_pos);
+    } else {
+      /* copy the data, upstream gets its buffers back when we return */
+      for (i = 0; i < num_buffers; i++) {
+        filesink->current_buffer_size +=
+            gst_buffer_extract (buffers[i], 0,
+            filesink->pending + filesink->current_buffer_size, G_MAXSIZE);
       }
     }
-    gst_buffer_unmap (buffer, &info);
-    return GST_FLOW_ERROR;
   }
+
+  if (ret == GST_FLOW_ERROR)
+    gst_file_sink_post_write_error (filesink, errno);
+
+  return ret;
+}
+
+static GstFlowReturn
+gst_file_sink_render (GstBaseSink * sink, GstBuffer * buffer)
+{
+  GstFileSink *filesink;
+
+  filesink = GST_FILE_SINK (sink);
+
+  return gst_file_sink_render_buffers (filesink, &buffer, 1,
+      gst_buffer_get_size (buffer));
+}
+
+static GstFlowReturn
+gst_file_sink_render_list (GstBaseSink * sink, GstBufferList * list)
+{
+  GstFileSink *filesink;
+  GstBuffer *buffers[GST_IOV_MAX];
+  guint i, j, n, num_buffers;
+  guint64 size;
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  filesink = GST_FILE_SINK (sink);
+
+  num_buffers = gst_buffer_list_length (list);
+
+  /* in chunks, so that the buffer pointers fit on the stack */
+  for (i = 0; i < num_buffers && ret == GST_FLOW_OK; i += n) {
+    n = MIN (num_buffers - i, GST_IOV_MAX);
+    size = 0;
+    for (j = 0; j < n; j++) {
+      buffers[j] = gst_buffer_list_get (list, i + j);
+      size += gst_buffer_get_size (buffers[j]);
+    }
+
+    ret = gst_file_sink_render_buffers (filesink, buffers, n, size);
+  }
+
+  return ret;
 }
 
 static gboolean
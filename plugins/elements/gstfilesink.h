@@ -63,9 +63,21 @@ struct _GstFileSink {
 
   gint    buffer_mode;
   guint   buffer_size;
-  gchar  *buffer;
-  
+
+  /* data waiting to be written in one go. It is copied out of the incoming
+   * buffers so that upstream gets them back right away */
+  guint8 *pending;
+  gsize pending_size;
+  guint64 current_buffer_size;
+
   gboolean append;
+
+  /* O_DIRECT writing */
+  gboolean o_direct;
+  gboolean using_direct;
+  guint8 *direct_buffer;
+  gsize direct_size;
+  gsize direct_fill;
 };
 
 struct _GstFileSinkClass {
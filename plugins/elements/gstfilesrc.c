@@ -31,6 +31,21 @@
  * gst-launch filesrc location=song.ogg ! decodebin2 ! autoaudiosink
  * ]| Play a song.ogg from local dir.
  * </refsect2>
+ *
+ * When #GstFileSrc:use-mmap is set, regular files are mapped into memory in
+ * windows of #GstFileSrc:mmapsize bytes and the buffers pushed downstream
+ * point directly into the mapping instead of containing a copy of the data.
+ * Such buffers contain read-only memory that keeps the mapping alive until
+ * the last buffer referencing it is freed. Note that the file must not be
+ * truncated while it is mapped.
+ *
+ * Setting #GstFileSrc:read-ahead to a non-zero window size reads regular
+ * files from a background thread instead. As long as the file is read
+ * sequentially, the window after the current position is read ahead so that
+ * the streaming thread doesn't block on the disk. Random access reads, such
+ * as those done by demuxers in pull mode, are served from a small cache of
+ * recently read blocks. #GstFileSrc:read-ahead-hits and
+ * #GstFileSrc:read-ahead-misses can be used to tune the window size.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -128,11 +143,19 @@ enum
 };
 
 #define DEFAULT_BLOCKSIZE       4*1024
+#define DEFAULT_USE_MMAP        FALSE
+#define DEFAULT_MMAPSIZE        4*1024*1024
+#define DEFAULT_READ_AHEAD      0
 
 enum
 {
   PROP_0,
-  PROP_LOCATION
+  PROP_LOCATION,
+  PROP_USE_MMAP,
+  PROP_MMAPSIZE,
+  PROP_READ_AHEAD,
+  PROP_READ_AHEAD_HITS,
+  PROP_READ_AHEAD_MISSES
 };
 
 static void gst_file_src_finalize (GObject * object);
@@ -147,6 +170,8 @@ static gboolean gst_file_src_stop (GstBaseSrc * basesrc);
 
 static gboolean gst_file_src_is_seekable (GstBaseSrc * src);
 static gboolean gst_file_src_get_size (GstBaseSrc * src, guint64 * size);
+static GstFlowReturn gst_file_src_create (GstBaseSrc * src, guint64 offset,
+    guint length, GstBuffer ** buffer);
 static GstFlowReturn gst_file_src_fill (GstBaseSrc * src, guint64 offset,
     guint length, GstBuffer * buf);
 
@@ -178,6 +203,32 @@ gst_file_src_class_init (GstFileSrcClass * klass)
           "Location of the file to read", NULL,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
           GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_USE_MMAP,
+      g_param_spec_boolean ("use-mmap", "Use mmap",
+          "Map regular files into memory and push buffers that point into "
+          "the mapping instead of reading the data", DEFAULT_USE_MMAP,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_MMAPSIZE,
+      g_param_spec_uint64 ("mmapsize", "mmap() Block Size",
+          "Size in bytes of the windows of the file that are mapped at once",
+          0, G_MAXUINT64, DEFAULT_MMAPSIZE,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_READ_AHEAD,
+      g_param_spec_uint64 ("read-ahead", "Read-ahead",
+          "Amount of bytes to read ahead from a background thread "
+          "(0 = disabled)", 0, G_MAXUINT64, DEFAULT_READ_AHEAD,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS |
+          GST_PARAM_MUTABLE_READY));
+  g_object_class_install_property (gobject_class, PROP_READ_AHEAD_HITS,
+      g_param_spec_uint64 ("read-ahead-hits", "Read-ahead hits",
+          "Amount of blocks that were available from the read-ahead window",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (gobject_class, PROP_READ_AHEAD_MISSES,
+      g_param_spec_uint64 ("read-ahead-misses", "Read-ahead misses",
+          "Amount of blocks that had to be read from the streaming thread",
+          0, G_MAXUINT64, 0, G_PARAM_READABLE | G_PARAM_STATIC_STRINGS));
 
   gobject_class->finalize = gst_file_src_finalize;
 
@@ -193,6 +244,7 @@ gst_file_src_class_init (GstFileSrcClass * klass)
   gstbasesrc_class->stop = GST_DEBUG_FUNCPTR (gst_file_src_stop);
   gstbasesrc_class->is_seekable = GST_DEBUG_FUNCPTR (gst_file_src_is_seekable);
   gstbasesrc_class->get_size = GST_DEBUG_FUNCPTR (gst_file_src_get_size);
+  gstbasesrc_class->create = GST_DEBUG_FUNCPTR (gst_file_src_create);
   gstbasesrc_class->fill = GST_DEBUG_FUNCPTR (gst_file_src_fill);
 
   if (sizeof (off_t) < 8) {
@@ -210,6 +262,17 @@ gst_file_src_init (GstFileSrc * src)
 
   src->is_regular = FALSE;
 
+  src->use_mmap = DEFAULT_USE_MMAP;
+  src->mapsize = DEFAULT_MMAPSIZE;
+  src->using_mmap = FALSE;
+  src->mmap_allocator = NULL;
+  src->mapping = NULL;
+
+  src->read_ahead = DEFAULT_READ_AHEAD;
+  src->ra = NULL;
+  src->ra_hits = 0;
+  src->ra_misses = 0;
+
   gst_base_src_set_blocksize (GST_BASE_SRC (src), DEFAULT_BLOCKSIZE);
 }
 
@@ -282,6 +345,15 @@ gst_file_src_set_property (GObject * object, guint prop_id,
     case PROP_LOCATION:
       gst_file_src_set_location (src, g_value_get_string (value));
       break;
+    case PROP_USE_MMAP:
+      src->use_mmap = g_value_get_boolean (value);
+      break;
+    case PROP_MMAPSIZE:
+      src->mapsize = g_value_get_uint64 (value);
+      break;
+    case PROP_READ_AHEAD:
+      src->read_ahead = g_value_get_uint64 (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -302,12 +374,154 @@ gst_file_src_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_LOCATION:
       g_value_set_string (value, src->filename);
       break;
+    case PROP_USE_MMAP:
+      g_value_set_boolean (value, src->use_mmap);
+      break;
+    case PROP_MMAPSIZE:
+      g_value_set_uint64 (value, src->mapsize);
+      break;
+    case PROP_READ_AHEAD:
+      g_value_set_uint64 (value, src->read_ahead);
+      break;
+    case PROP_READ_AHEAD_HITS:
+    case PROP_READ_AHEAD_MISSES:
+    {
+      guint64 hits, misses;
+
+      GST_OBJECT_LOCK (src);
+      if (src->ra) {
+        gst_read_ahead_get_stats (src->ra, &hits, &misses);
+      } else {
+        hits = src->ra_hits;
+        misses = src->ra_misses;
+      }
+      GST_OBJECT_UNLOCK (src);
+
+      g_value_set_uint64 (value,
+          prop_id == PROP_READ_AHEAD_HITS ? hits : misses);
+      break;
+    }
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
   }
 }
 
+#ifdef HAVE_MMAP
+/*** MMAP ********************************************************************/
+
+/* map a window of the file that contains at least @length bytes starting
+ * at @offset. @length is clipped to the current file size. */
+static GstFileMapping *
+gst_file_src_map_window (GstFileSrc * src, guint64 offset, guint * length)
+{
+  GstFileMapping *mapping;
+  struct stat stat_results;
+  guint64 size, start, end, pagesize;
+
+  if (fstat (src->fd, &stat_results) < 0)
+    goto could_not_stat;
+
+  size = stat_results.st_size;
+
+  if (offset >= size)
+    goto eos;
+
+  if (offset + *length > size)
+    *length = size - offset;
+
+  /* windows must start on a page boundary */
+  pagesize = getpagesize ();
+  start = offset - (offset % pagesize);
+  end = start + MAX (src->mapsize, offset + *length - start);
+  end = MIN (end, size);
+
+  if (end - start > G_MAXSIZE)
+    goto too_big;
+
+  GST_LOG_OBJECT (src, "mapping window at offset %" G_GUINT64_FORMAT
+      ", size %" G_GUINT64_FORMAT, start, end - start);
+
+  mapping = gst_file_mapping_new (src->fd, start, end - start);
+  if (mapping == NULL)
+    goto mmap_failed;
+
+  return mapping;
+
+  /* ERRORS */
+could_not_stat:
+  {
+    GST_WARNING_OBJECT (src, "could not stat file: %s", g_strerror (errno));
+    return NULL;
+  }
+eos:
+  {
+    GST_DEBUG_OBJECT (src, "offset %" G_GUINT64_FORMAT " beyond end of file",
+        offset);
+    *length = 0;
+    return NULL;
+  }
+too_big:
+  {
+    GST_WARNING_OBJECT (src, "window of %" G_GUINT64_FORMAT " bytes is too "
+        "big to be mapped", end - start);
+    return NULL;
+  }
+mmap_failed:
+  {
+    GST_WARNING_OBJECT (src, "mmap failed: %s", g_strerror (errno));
+    return NULL;
+  }
+}
+
+static GstFlowReturn
+gst_file_src_create_mmap (GstFileSrc * src, guint64 offset, guint length,
+    GstBuffer ** buffer)
+{
+  GstFileMapping *mapping;
+  GstMemory *mem;
+  GstBuffer *buf;
+
+  mapping = src->mapping;
+
+  if (mapping == NULL || offset < mapping->offset
+      || offset + length > mapping->offset + mapping->size) {
+    /* not in the current window, map a new one. Buffers pushed before keep
+     * the old mapping alive as long as they need it */
+    if (mapping)
+      gst_file_mapping_unref (mapping);
+
+    src->mapping = mapping = gst_file_src_map_window (src, offset, &length);
+
+    if (mapping == NULL) {
+      if (length == 0)
+        return GST_FLOW_EOS;
+
+      GST_WARNING_OBJECT (src, "falling back to read()");
+      src->using_mmap = FALSE;
+      return GST_BASE_SRC_CLASS (parent_class)->create (GST_BASE_SRC_CAST
+          (src), offset, length, buffer);
+    }
+  }
+
+  GST_LOG_OBJECT (src, "wrapping %u bytes at offset 0x%" G_GINT64_MODIFIER
+      "x from mapping %p", length, offset, mapping->data);
+
+  mem = gst_file_mmap_memory_new (src->mmap_allocator, mapping,
+      offset - mapping->offset, length);
+
+  buf = gst_buffer_new ();
+  gst_buffer_append_memory (buf, mem);
+
+  GST_BUFFER_OFFSET (buf) = offset;
+  GST_BUFFER_OFFSET_END (buf) = offset + length;
+
+  *buffer = buf;
+
+  return GST_FLOW_OK;
+}
+#endif
+
 /***
  * read code below
  * that is to say, you shouldn't read the code below, but the code that reads
@@ -401,6 +615,59 @@ eos:
   }
 }
 
+static GstFlowReturn
+gst_file_src_create_read_ahead (GstFileSrc * src, guint64 offset,
+    guint length, GstBuffer ** buffer)
+{
+  GstFlowReturn ret;
+  GstBuffer *buf;
+
+  GST_LOG_OBJECT (src, "Reading %u bytes at offset 0x%" G_GINT64_MODIFIER "x",
+      length, offset);
+
+  ret = gst_read_ahead_read (src->ra, offset, length, &buf);
+  if (G_UNLIKELY (ret != GST_FLOW_OK))
+    goto read_failed;
+
+  GST_BUFFER_OFFSET (buf) = offset;
+  GST_BUFFER_OFFSET_END (buf) = offset + gst_buffer_get_size (buf);
+
+  *buffer = buf;
+
+  return GST_FLOW_OK;
+
+  /* ERROR */
+read_failed:
+  {
+    if (ret == GST_FLOW_EOS) {
+      GST_DEBUG ("EOS");
+    } else {
+      GST_ELEMENT_ERROR (src, RESOURCE, READ, (NULL), GST_ERROR_SYSTEM);
+    }
+    return ret;
+  }
+}
+
+static GstFlowReturn
+gst_file_src_create (GstBaseSrc * basesrc, guint64 offset, guint length,
+    GstBuffer ** buffer)
+{
+  GstFileSrc *src = GST_FILE_SRC_CAST (basesrc);
+
+#ifdef HAVE_MMAP
+  /* we can only wrap the mapping when we don't need to fill a buffer
+   * provided by downstream */
+  if (src->using_mmap && offset != -1 && length > 0 && *buffer == NULL)
+    return gst_file_src_create_mmap (src, offset, length, buffer);
+#endif
+
+  if (src->ra && offset != -1 && length > 0 && *buffer == NULL)
+    return gst_file_src_create_read_ahead (src, offset, length, buffer);
+
+  return GST_BASE_SRC_CLASS (parent_class)->create (basesrc, offset, length,
+      buffer);
+}
+
 static gboolean
 gst_file_src_is_seekable (GstBaseSrc * basesrc)
 {
@@ -491,6 +758,25 @@ gst_file_src_start (GstBaseSrc * basesrc)
 
   gst_base_src_set_dynamic_size (basesrc, src->seekable);
 
+#ifdef HAVE_MMAP
+  /* we can only mmap regular files */
+  if (src->use_mmap && src->is_regular) {
+    src->using_mmap = TRUE;
+    src->mmap_allocator = gst_file_mmap_allocator_new ();
+  }
+#endif
+
+  if (src->read_ahead > 0 && src->is_regular && !src->using_mmap) {
+    GstReadAhead *ra;
+
+    ra = gst_read_ahead_new (GST_OBJECT_CAST (src), src->fd, src->read_ahead);
+
+    GST_OBJECT_LOCK (src);
+    src->ra = ra;
+    src->ra_hits = src->ra_misses = 0;
+    GST_OBJECT_UNLOCK (src);
+  }
+
   return TRUE;
 
   /* ERROR */
@@ -545,12 +831,36 @@ gst_file_src_stop (GstBaseSrc * basesrc)
 {
   GstFileSrc *src = GST_FILE_SRC (basesrc);
 
+#ifdef HAVE_MMAP
+  /* buffers still in use keep their window mapped */
+  if (src->mapping) {
+    gst_file_mapping_unref (src->mapping);
+    src->mapping = NULL;
+  }
+  if (src->mmap_allocator) {
+    gst_object_unref (src->mmap_allocator);
+    src->mmap_allocator = NULL;
+  }
+#endif
+
+  if (src->ra) {
+    GstReadAhead *ra = src->ra;
+
+    GST_OBJECT_LOCK (src);
+    gst_read_ahead_get_stats (ra, &src->ra_hits, &src->ra_misses);
+    src->ra = NULL;
+    GST_OBJECT_UNLOCK (src);
+
+    gst_read_ahead_free (ra);
+  }
+
   /* close the file */
   close (src->fd);
 
   /* zero out a lot of our state */
   src->fd = 0;
   src->is_regular = FALSE;
+  src->using_mmap = FALSE;
 
   return TRUE;
 }
@@ -29,6 +29,9 @@
 #include <gst/gst.h>
 #include <gst/base/gstbasesrc.h>
 
+#include "gstfilemmap.h"
+#include "gstreadahead.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_FILE_SRC \
@@ -63,6 +66,17 @@ struct _GstFileSrc {
   gboolean seekable;                    /* whether the file is seekable */
   gboolean is_regular;                  /* whether it's a (symlink to a)
                                            regular file */
+
+  gboolean use_mmap;                    /* whether to mmap the file */
+  guint64 mapsize;                      /* size of the mmap windows */
+  gboolean using_mmap;                  /* whether we are mmapping */
+  GstAllocator *mmap_allocator;         /* allocator for the mapped memory */
+  GstFileMapping *mapping;              /* current mmap window */
+
+  guint64 read_ahead;                   /* read-ahead window in bytes */
+  GstReadAhead *ra;                     /* read-ahead engine when active */
+  guint64 ra_hits;                      /* read-ahead stats of the last run */
+  guint64 ra_misses;
 };
 
 struct _GstFileSrcClass {
@@ -105,6 +105,8 @@ static gboolean gst_identity_sink_event (GstBaseTransform * trans,
     GstEvent * event);
 static GstFlowReturn gst_identity_transform_ip (GstBaseTransform * trans,
     GstBuffer * buf);
+static GstFlowReturn gst_identity_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static gboolean gst_identity_start (GstBaseTransform * trans);
 static gboolean gst_identity_stop (GstBaseTransform * trans);
 static GstStateChangeReturn gst_identity_change_state (GstElement * element,
@@ -239,6 +241,8 @@ gst_identity_class_init (GstIdentityClass * klass)
 static void
 gst_identity_init (GstIdentity * identity)
 {
+  GstPad *sinkpad;
+
   identity->sleep_time = DEFAULT_SLEEP_TIME;
   identity->error_after = DEFAULT_ERROR_AFTER;
   identity->drop_probability = DEFAULT_DROP_PROBABILITY;
@@ -253,6 +257,33 @@ gst_identity_init (GstIdentity * identity)
   identity->signal_handoffs = DEFAULT_SIGNAL_HANDOFFS;
 
   gst_base_transform_set_gap_aware (GST_BASE_TRANSFORM_CAST (identity), TRUE);
+
+  sinkpad = GST_BASE_TRANSFORM_SINK_PAD (identity);
+  identity->chain_list = GST_PAD_CHAINLISTFUNC (sinkpad);
+  gst_pad_set_chain_list_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_identity_chain_list));
+}
+
+/* buffers that wait for the clock or sleep are pushed one by one, collecting
+ * them in a list would hold back the first ones until the last one is done */
+static GstFlowReturn
+gst_identity_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstIdentity *identity = GST_IDENTITY (parent);
+  GstFlowReturn ret = GST_FLOW_OK;
+  guint i, len;
+
+  if (!identity->sync && identity->sleep_time == 0)
+    return identity->chain_list (pad, parent, list);
+
+  len = gst_buffer_list_length (list);
+  for (i = 0; i < len && ret == GST_FLOW_OK; i++)
+    ret = GST_PAD_CHAINFUNC (pad) (pad, parent,
+        gst_buffer_ref (gst_buffer_list_get (list, i)));
+  gst_buffer_list_unref (list);
+
+  return ret;
 }
 
 static void
@@ -72,6 +72,8 @@ struct _GstIdentity {
   gchar 	*last_message;
   guint64        offset;
   gboolean       signal_handoffs;
+
+  GstPadChainListFunction chain_list;   /* of the base class */
 };
 
 struct _GstIdentityClass {
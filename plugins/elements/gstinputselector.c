@@ -210,6 +210,8 @@ static GstIterator *gst_selector_pad_iterate_linked_pads (GstPad * pad,
     GstObject * parent);
 static GstFlowReturn gst_selector_pad_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buf);
+static GstFlowReturn gst_selector_pad_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static void gst_selector_pad_cache_buffer (GstSelectorPad * selpad,
     GstBuffer * buffer);
 static void gst_selector_pad_free_cached_buffers (GstSelectorPad * selpad);
@@ -945,6 +947,106 @@ gst_input_selector_cleanup_old_cached_buffers (GstInputSelector * sel,
 #endif
 }
 
+/* must be called with the SELECTOR_LOCK. Waits while the selector is
+ * blocked and returns the active sinkpad, which becomes @selpad if there is
+ * none yet, or NULL when flushing. @prev_active_sinkpad is set to a ref of
+ * the active sinkpad before that. */
+static GstPad *
+gst_selector_pad_get_active (GstInputSelector * sel, GstSelectorPad * selpad,
+    GstPad ** prev_active_sinkpad)
+{
+  /* wait or check for flushing */
+  if (gst_input_selector_wait (sel, selpad))
+    return NULL;
+
+  GST_LOG_OBJECT (selpad, "getting active pad");
+
+  *prev_active_sinkpad =
+      sel->active_sinkpad ? gst_object_ref (sel->active_sinkpad) : NULL;
+  return gst_input_selector_activate_sinkpad (sel, GST_PAD_CAST (selpad));
+}
+
+/* update the position in the segment of @selpad with the timestamp of @buf */
+static void
+gst_selector_pad_update_position (GstSelectorPad * selpad, GstBuffer * buf)
+{
+  GstClockTime start_time;
+
+  start_time = GST_BUFFER_TIMESTAMP (buf);
+  if (GST_CLOCK_TIME_IS_VALID (start_time)) {
+    GST_LOG_OBJECT (selpad, "received start time %" GST_TIME_FORMAT,
+        GST_TIME_ARGS (start_time));
+    if (GST_BUFFER_DURATION_IS_VALID (buf))
+      GST_LOG_OBJECT (selpad, "received end time %" GST_TIME_FORMAT,
+          GST_TIME_ARGS (start_time + GST_BUFFER_DURATION (buf)));
+
+    GST_OBJECT_LOCK (selpad);
+    selpad->segment.position = start_time;
+    GST_OBJECT_UNLOCK (selpad);
+  }
+}
+
+/* called without the SELECTOR_LOCK before data of the active pad is pushed.
+ * Notifies a change of the active pad and forwards pending events. */
+static void
+gst_selector_pad_prepare_push (GstInputSelector * sel,
+    GstSelectorPad * selpad, GstPad * prev_active_sinkpad,
+    GstPad * active_sinkpad)
+{
+  if (prev_active_sinkpad != active_sinkpad) {
+    if (prev_active_sinkpad)
+      g_object_notify (G_OBJECT (prev_active_sinkpad), "active");
+    g_object_notify (G_OBJECT (active_sinkpad), "active");
+    g_object_notify (G_OBJECT (sel), "active-pad");
+  }
+
+  /* if we have a pending events, push them now */
+  if (G_UNLIKELY (prev_active_sinkpad != active_sinkpad
+          || selpad->events_pending)) {
+    gst_pad_sticky_events_foreach (GST_PAD_CAST (selpad), forward_sticky_events,
+        sel);
+    selpad->events_pending = FALSE;
+  }
+}
+
+/* mark @buf as discont if data was dropped on @selpad before */
+static GstBuffer *
+gst_selector_pad_mark_discont (GstSelectorPad * selpad, GstBuffer * buf)
+{
+  if (selpad->discont) {
+    buf = gst_buffer_make_writable (buf);
+
+    GST_DEBUG_OBJECT (selpad, "Marking discont buffer %p", buf);
+    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
+    selpad->discont = FALSE;
+  }
+  return buf;
+}
+
+/* must be called with the SELECTOR_LOCK, which is released. Called when data
+ * of a pad that is not active is dropped, returns what to return upstream. */
+static GstFlowReturn
+gst_selector_pad_drop (GstInputSelector * sel, GstSelectorPad * selpad,
+    GstPad * active_sinkpad)
+{
+  gboolean active_pad_pushed = GST_SELECTOR_PAD_CAST (active_sinkpad)->pushed;
+  GstFlowReturn res;
+
+  /* when we drop data, we're creating a discont on this pad */
+  selpad->discont = TRUE;
+  GST_INPUT_SELECTOR_UNLOCK (sel);
+
+  /* figure out what to return upstream */
+  GST_OBJECT_LOCK (selpad);
+  if (selpad->always_ok || !active_pad_pushed)
+    res = GST_FLOW_OK;
+  else
+    res = GST_FLOW_NOT_LINKED;
+  GST_OBJECT_UNLOCK (selpad);
+
+  return res;
+}
+
 static GstFlowReturn
 gst_selector_pad_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 {
@@ -953,7 +1055,6 @@ gst_selector_pad_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   GstPad *active_sinkpad;
   GstPad *prev_active_sinkpad = NULL;
   GstSelectorPad *selpad;
-  GstClockTime start_time;
 
   sel = GST_INPUT_SELECTOR (parent);
   selpad = GST_SELECTOR_PAD_CAST (pad);
@@ -963,18 +1064,13 @@ gst_selector_pad_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
       GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buf)));
 
   GST_INPUT_SELECTOR_LOCK (sel);
-  /* wait or check for flushing */
-  if (gst_input_selector_wait (sel, selpad)) {
+  active_sinkpad = gst_selector_pad_get_active (sel, selpad,
+      &prev_active_sinkpad);
+  if (active_sinkpad == NULL) {
     GST_INPUT_SELECTOR_UNLOCK (sel);
     goto flushing;
   }
 
-  GST_LOG_OBJECT (pad, "getting active pad");
-
-  prev_active_sinkpad =
-      sel->active_sinkpad ? gst_object_ref (sel->active_sinkpad) : NULL;
-  active_sinkpad = gst_input_selector_activate_sinkpad (sel, pad);
-
   /* In sync mode wait until the active pad has advanced
    * after the running time of the current buffer */
   if (sel->sync_streams) {
@@ -1030,18 +1126,7 @@ gst_selector_pad_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   }
 
   /* update the segment on the srcpad */
-  start_time = GST_BUFFER_TIMESTAMP (buf);
-  if (GST_CLOCK_TIME_IS_VALID (start_time)) {
-    GST_LOG_OBJECT (pad, "received start time %" GST_TIME_FORMAT,
-        GST_TIME_ARGS (start_time));
-    if (GST_BUFFER_DURATION_IS_VALID (buf))
-      GST_LOG_OBJECT (pad, "received end time %" GST_TIME_FORMAT,
-          GST_TIME_ARGS (start_time + GST_BUFFER_DURATION (buf)));
-
-    GST_OBJECT_LOCK (pad);
-    selpad->segment.position = start_time;
-    GST_OBJECT_UNLOCK (pad);
-  }
+  gst_selector_pad_update_position (selpad, buf);
 
   /* Ignore buffers from pads except the selected one */
   if (pad != active_sinkpad)
@@ -1053,32 +1138,14 @@ gst_selector_pad_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
 
   GST_INPUT_SELECTOR_UNLOCK (sel);
 
-  if (prev_active_sinkpad != active_sinkpad) {
-    if (prev_active_sinkpad)
-      g_object_notify (G_OBJECT (prev_active_sinkpad), "active");
-    g_object_notify (G_OBJECT (active_sinkpad), "active");
-    g_object_notify (G_OBJECT (sel), "active-pad");
-  }
-
-  /* if we have a pending events, push them now */
-  if (G_UNLIKELY (prev_active_sinkpad != active_sinkpad
-          || selpad->events_pending)) {
-    gst_pad_sticky_events_foreach (GST_PAD_CAST (selpad), forward_sticky_events,
-        sel);
-    selpad->events_pending = FALSE;
-  }
+  gst_selector_pad_prepare_push (sel, selpad, prev_active_sinkpad,
+      active_sinkpad);
 
   if (prev_active_sinkpad)
     gst_object_unref (prev_active_sinkpad);
   prev_active_sinkpad = NULL;
 
-  if (selpad->discont) {
-    buf = gst_buffer_make_writable (buf);
-
-    GST_DEBUG_OBJECT (pad, "Marking discont buffer %p", buf);
-    GST_BUFFER_FLAG_SET (buf, GST_BUFFER_FLAG_DISCONT);
-    selpad->discont = FALSE;
-  }
+  buf = gst_selector_pad_mark_discont (selpad, buf);
 
   /* forward */
   GST_LOG_OBJECT (pad, "Forwarding buffer %p with timestamp %" GST_TIME_FORMAT,
@@ -1118,22 +1185,9 @@ done:
   /* dropped buffers */
 ignore:
   {
-    gboolean active_pad_pushed = GST_SELECTOR_PAD_CAST (active_sinkpad)->pushed;
-
     GST_DEBUG_OBJECT (pad, "Pad not active, discard buffer %p", buf);
-    /* when we drop a buffer, we're creating a discont on this pad */
-    selpad->discont = TRUE;
-    GST_INPUT_SELECTOR_UNLOCK (sel);
+    res = gst_selector_pad_drop (sel, selpad, active_sinkpad);
     gst_buffer_unref (buf);
-
-    /* figure out what to return upstream */
-    GST_OBJECT_LOCK (selpad);
-    if (selpad->always_ok || !active_pad_pushed)
-      res = GST_FLOW_OK;
-    else
-      res = GST_FLOW_NOT_LINKED;
-    GST_OBJECT_UNLOCK (selpad);
-
     goto done;
   }
 flushing:
@@ -1145,6 +1199,104 @@ flushing:
   }
 }
 
+/* without stream synchronisation a list is forwarded as a whole, otherwise
+ * the buffers are handled one by one */
+static GstFlowReturn
+gst_selector_pad_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstInputSelector *sel;
+  GstFlowReturn res = GST_FLOW_OK;
+  GstPad *active_sinkpad;
+  GstPad *prev_active_sinkpad = NULL;
+  GstSelectorPad *selpad;
+  GstBuffer *buf;
+  guint i, len;
+
+  sel = GST_INPUT_SELECTOR (parent);
+  selpad = GST_SELECTOR_PAD_CAST (pad);
+
+  len = gst_buffer_list_length (list);
+  if (len == 0)
+    goto done;
+
+  GST_DEBUG_OBJECT (selpad, "entering chain for list %p of %u buffers", list,
+      len);
+
+  GST_INPUT_SELECTOR_LOCK (sel);
+  if (sel->sync_streams) {
+    GST_INPUT_SELECTOR_UNLOCK (sel);
+    goto per_buffer;
+  }
+
+  active_sinkpad = gst_selector_pad_get_active (sel, selpad,
+      &prev_active_sinkpad);
+  if (active_sinkpad == NULL) {
+    GST_INPUT_SELECTOR_UNLOCK (sel);
+    goto flushing;
+  }
+
+  /* update the segment on the srcpad with the last buffer */
+  gst_selector_pad_update_position (selpad,
+      gst_buffer_list_get (list, len - 1));
+
+  /* Ignore lists from pads except the selected one */
+  if (pad != active_sinkpad)
+    goto ignore;
+
+  GST_INPUT_SELECTOR_UNLOCK (sel);
+
+  gst_selector_pad_prepare_push (sel, selpad, prev_active_sinkpad,
+      active_sinkpad);
+
+  if (prev_active_sinkpad)
+    gst_object_unref (prev_active_sinkpad);
+  prev_active_sinkpad = NULL;
+
+  if (selpad->discont) {
+    list = gst_buffer_list_make_writable (list);
+    buf = gst_selector_pad_mark_discont (selpad,
+        gst_buffer_ref (gst_buffer_list_get (list, 0)));
+    gst_buffer_list_remove (list, 0, 1);
+    gst_buffer_list_insert (list, 0, buf);
+  }
+
+  res = gst_pad_push_list (sel->srcpad, list);
+  GST_LOG_OBJECT (pad, "List %p forwarded result=%d", list, res);
+
+  GST_INPUT_SELECTOR_LOCK (sel);
+  selpad->pushed = TRUE;
+  GST_INPUT_SELECTOR_UNLOCK (sel);
+
+  return res;
+
+per_buffer:
+  for (i = 0; i < len && res == GST_FLOW_OK; i++) {
+    buf = gst_buffer_ref (gst_buffer_list_get (list, i));
+    res = gst_selector_pad_chain (pad, parent, buf);
+  }
+  goto done;
+
+  /* dropped lists */
+ignore:
+  {
+    GST_DEBUG_OBJECT (pad, "Pad not active, discard list %p", list);
+    res = gst_selector_pad_drop (sel, selpad, active_sinkpad);
+    goto done;
+  }
+flushing:
+  {
+    GST_DEBUG_OBJECT (pad, "We are flushing, discard list %p", list);
+    res = GST_FLOW_FLUSHING;
+    goto done;
+  }
+done:
+  if (prev_active_sinkpad)
+    gst_object_unref (prev_active_sinkpad);
+  gst_buffer_list_unref (list);
+  return res;
+}
+
 static void gst_input_selector_dispose (GObject * object);
 static void gst_input_selector_finalize (GObject * object);
 
@@ -1693,6 +1845,8 @@ gst_input_selector_request_new_pad (GstElement * element,
       GST_DEBUG_FUNCPTR (gst_selector_pad_query));
   gst_pad_set_chain_function (sinkpad,
       GST_DEBUG_FUNCPTR (gst_selector_pad_chain));
+  gst_pad_set_chain_list_function (sinkpad,
+      GST_DEBUG_FUNCPTR (gst_selector_pad_chain_list));
   gst_pad_set_iterate_internal_links_function (sinkpad,
       GST_DEBUG_FUNCPTR (gst_selector_pad_iterate_linked_pads));
 
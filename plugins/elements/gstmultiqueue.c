@@ -143,6 +143,11 @@ struct _GstSingleQueue
    */
   gboolean pushed;
 
+  /* Protects the segments, positions and time level and the serialized
+   * query handoff, so that the data flow of one queue does not need the
+   * global lock */
+  GMutex lock;
+
   /* segments */
   GstSegment sink_segment;
   GstSegment src_segment;
@@ -167,9 +172,16 @@ struct _GstSingleQueue
   GstClockTime last_time;       /* Start running time of last pushed buffer */
   GCond turn;                   /* SingleQueue turn waiting conditional */
 
-  /* for serialized queries */
+  /* Protected by global lock, links into the GstMultiQueue indexes */
+  GList *waiter_link;
+  GList *not_linked_link;
+  GList *full_link;
+  gboolean starved;             /* TRUE while waiting for data */
+
+  /* for serialized queries, protected by the single queue lock */
   GCond query_handled;
   gboolean last_query;
+  gboolean query_done;
 };
 
 
@@ -193,8 +205,21 @@ static GstSingleQueue *gst_single_queue_new (GstMultiQueue * mqueue, guint id);
 static void gst_single_queue_free (GstSingleQueue * squeue);
 
 static void wake_up_next_non_linked (GstMultiQueue * mq);
-static void compute_high_id (GstMultiQueue * mq);
-static void compute_high_time (GstMultiQueue * mq);
+static void update_high_id (GstMultiQueue * mq);
+static void update_high_time (GstMultiQueue * mq);
+static gint compare_waiters (GstSingleQueue * a, GstSingleQueue * b,
+    GstMultiQueue * mq);
+static void gst_single_queue_set_srcresult (GstMultiQueue * mq,
+    GstSingleQueue * sq, GstFlowReturn result);
+static void gst_single_queue_set_starved (GstMultiQueue * mq,
+    GstSingleQueue * sq, gboolean starved);
+static void gst_single_queue_forget_full (GstMultiQueue * mq,
+    GstSingleQueue * sq);
+static void gst_single_queue_unblock_query (GstSingleQueue * sq);
+static void gst_multi_queue_add_waiter (GstMultiQueue * mq,
+    GstSingleQueue * sq);
+static void gst_multi_queue_remove_waiter (GstMultiQueue * mq,
+    GstSingleQueue * sq);
 static void single_queue_overrun_cb (GstDataQueue * dq, GstSingleQueue * sq);
 static void single_queue_underrun_cb (GstDataQueue * dq, GstSingleQueue * sq);
 
@@ -268,6 +293,16 @@ enum
   g_mutex_unlock (&q->qlock);                                            \
 } G_STMT_END
 
+/* The single queue lock can be taken with the global lock held, but never
+ * the other way around */
+#define GST_SINGLE_QUEUE_MUTEX_LOCK(sq) G_STMT_START {                        \
+  g_mutex_lock (&sq->lock);                                              \
+} G_STMT_END
+
+#define GST_SINGLE_QUEUE_MUTEX_UNLOCK(sq) G_STMT_START {                      \
+  g_mutex_unlock (&sq->lock);                                            \
+} G_STMT_END
+
 static void gst_multi_queue_finalize (GObject * object);
 static void gst_multi_queue_set_property (GObject * object,
     guint prop_id, const GValue * value, GParamSpec * pspec);
@@ -453,6 +488,13 @@ gst_multi_queue_init (GstMultiQueue * mqueue)
   mqueue->highid = -1;
   mqueue->high_time = GST_CLOCK_TIME_NONE;
 
+  g_queue_init (&mqueue->waiters);
+  g_queue_init (&mqueue->not_linked);
+  g_queue_init (&mqueue->full_queues);
+  mqueue->high_oldid = G_MAXUINT32;
+  mqueue->high_linked_time = GST_CLOCK_TIME_NONE;
+  mqueue->high_dirty = TRUE;
+
   g_mutex_init (&mqueue->qlock);
 }
 
@@ -465,6 +507,9 @@ gst_multi_queue_finalize (GObject * object)
   g_list_free (mqueue->queues);
   mqueue->queues = NULL;
   mqueue->queues_cookie++;
+  g_queue_clear (&mqueue->waiters);
+  g_queue_clear (&mqueue->not_linked);
+  g_queue_clear (&mqueue->full_queues);
 
   /* free/unref instance data */
   g_mutex_clear (&mqueue->qlock);
@@ -547,7 +592,11 @@ gst_multi_queue_set_property (GObject * object, guint prop_id,
       mq->high_percent = g_value_get_int (value);
       break;
     case PROP_SYNC_BY_RUNNING_TIME:
+      GST_MULTI_QUEUE_MUTEX_LOCK (mq);
       mq->sync_by_running_time = g_value_get_boolean (value);
+      /* waiters are sorted on what they wait for, which just changed */
+      g_queue_sort (&mq->waiters, (GCompareDataFunc) compare_waiters, mq);
+      GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
       break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -693,6 +742,8 @@ gst_multi_queue_release_pad (GstElement * element, GstPad * pad)
   /* remove it from the list */
   mqueue->queues = g_list_delete_link (mqueue->queues, tmp);
   mqueue->queues_cookie++;
+  mqueue->nbqueues--;
+  mqueue->high_dirty = TRUE;
 
   /* FIXME : recompute next-non-linked */
   GST_MULTI_QUEUE_MUTEX_UNLOCK (mqueue);
@@ -702,6 +753,15 @@ gst_multi_queue_release_pad (GstElement * element, GstPad * pad)
 
   gst_pad_set_active (sq->srcpad, FALSE);
   gst_pad_set_active (sq->sinkpad, FALSE);
+
+  /* the streaming thread is stopped now, drop what the queue still
+   * contributes to the global bookkeeping */
+  GST_MULTI_QUEUE_MUTEX_LOCK (mqueue);
+  gst_single_queue_set_srcresult (mqueue, sq, GST_FLOW_FLUSHING);
+  gst_single_queue_set_starved (mqueue, sq, FALSE);
+  gst_single_queue_forget_full (mqueue, sq);
+  GST_MULTI_QUEUE_MUTEX_UNLOCK (mqueue);
+
   gst_pad_set_element_private (sq->srcpad, NULL);
   gst_pad_set_element_private (sq->sinkpad, NULL);
   gst_element_remove_pad (element, sq->srcpad);
@@ -744,8 +804,7 @@ gst_multi_queue_change_state (GstElement * element, GstStateChange transition)
         sq->flushing = TRUE;
         g_cond_signal (&sq->turn);
 
-        sq->last_query = FALSE;
-        g_cond_signal (&sq->query_handled);
+        gst_single_queue_unblock_query (sq);
       }
       GST_MULTI_QUEUE_MUTEX_UNLOCK (mqueue);
       break;
@@ -775,7 +834,7 @@ gst_single_queue_flush (GstMultiQueue * mq, GstSingleQueue * sq, gboolean flush,
 
   if (flush) {
     GST_MULTI_QUEUE_MUTEX_LOCK (mq);
-    sq->srcresult = GST_FLOW_FLUSHING;
+    gst_single_queue_set_srcresult (mq, sq, GST_FLOW_FLUSHING);
     gst_data_queue_set_flushing (sq->queue, TRUE);
 
     sq->flushing = TRUE;
@@ -784,8 +843,7 @@ gst_single_queue_flush (GstMultiQueue * mq, GstSingleQueue * sq, gboolean flush,
     GST_LOG_OBJECT (mq, "SingleQueue %d : waking up eventually waiting task",
         sq->id);
     g_cond_signal (&sq->turn);
-    sq->last_query = FALSE;
-    g_cond_signal (&sq->query_handled);
+    gst_single_queue_unblock_query (sq);
     GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
 
     GST_LOG_OBJECT (mq, "SingleQueue %d : pausing task", sq->id);
@@ -794,12 +852,16 @@ gst_single_queue_flush (GstMultiQueue * mq, GstSingleQueue * sq, gboolean flush,
   } else {
     GST_MULTI_QUEUE_MUTEX_LOCK (mq);
     gst_single_queue_flush_queue (sq, full);
+    GST_SINGLE_QUEUE_MUTEX_LOCK (sq);
     gst_segment_init (&sq->sink_segment, GST_FORMAT_TIME);
     gst_segment_init (&sq->src_segment, GST_FORMAT_TIME);
+    sq->cur_time = 0;
+    GST_SINGLE_QUEUE_MUTEX_UNLOCK (sq);
     /* All pads start off not-linked for a smooth kick-off */
-    sq->srcresult = GST_FLOW_OK;
+    gst_single_queue_set_srcresult (mq, sq, GST_FLOW_OK);
+    gst_single_queue_set_starved (mq, sq, FALSE);
+    gst_single_queue_forget_full (mq, sq);
     sq->pushed = FALSE;
-    sq->cur_time = 0;
     sq->max_size.visible = mq->max_size.visible;
     sq->is_eos = FALSE;
     sq->nextid = 0;
@@ -811,6 +873,7 @@ gst_single_queue_flush (GstMultiQueue * mq, GstSingleQueue * sq, gboolean flush,
 
     /* Reset high time to be recomputed next */
     mq->high_time = GST_CLOCK_TIME_NONE;
+    mq->high_dirty = TRUE;
 
     sq->flushing = FALSE;
     GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
@@ -823,6 +886,7 @@ gst_single_queue_flush (GstMultiQueue * mq, GstSingleQueue * sq, gboolean flush,
   return result;
 }
 
+/* WITH LOCK TAKEN */
 static void
 update_buffering (GstMultiQueue * mq, GstSingleQueue * sq)
 {
@@ -897,7 +961,7 @@ update_buffering (GstMultiQueue * mq, GstSingleQueue * sq)
 
 /* calculate the diff between running time on the sink and src of the queue.
  * This is the total amount of time in the queue. 
- * WITH LOCK TAKEN */
+ * WITH SINGLE QUEUE LOCK TAKEN */
 static void
 update_time_level (GstMultiQueue * mq, GstSingleQueue * sq)
 {
@@ -935,12 +999,22 @@ update_time_level (GstMultiQueue * mq, GstSingleQueue * sq)
   else
     sq->cur_time = 0;
 
-  /* updating the time level can change the buffering state */
-  update_buffering (mq, sq);
-
   return;
 }
 
+/* updating the time level can change the buffering state, only take the
+ * global lock when that matters */
+static void
+update_buffering_unlocked (GstMultiQueue * mq, GstSingleQueue * sq)
+{
+  if (!mq->use_buffering)
+    return;
+
+  GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+  update_buffering (mq, sq);
+  GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+}
+
 /* take a SEGMENT event and apply the values to segment, updating the time
  * level of queue. */
 static void
@@ -959,7 +1033,7 @@ apply_segment (GstMultiQueue * mq, GstSingleQueue * sq, GstEvent * event,
     segment->stop = -1;
     segment->time = 0;
   }
-  GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+  GST_SINGLE_QUEUE_MUTEX_LOCK (sq);
 
   if (segment == &sq->sink_segment)
     sq->sink_tainted = TRUE;
@@ -972,7 +1046,9 @@ apply_segment (GstMultiQueue * mq, GstSingleQueue * sq, GstEvent * event,
   /* segment can update the time level of the queue */
   update_time_level (mq, sq);
 
-  GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+  GST_SINGLE_QUEUE_MUTEX_UNLOCK (sq);
+
+  update_buffering_unlocked (mq, sq);
 }
 
 /* take a buffer and update segment, updating the time level of the queue. */
@@ -980,7 +1056,7 @@ static void
 apply_buffer (GstMultiQueue * mq, GstSingleQueue * sq, GstClockTime timestamp,
     GstClockTime duration, GstSegment * segment)
 {
-  GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+  GST_SINGLE_QUEUE_MUTEX_LOCK (sq);
 
   /* if no timestamp is set, assume it's continuous with the previous 
    * time */
@@ -1003,7 +1079,9 @@ apply_buffer (GstMultiQueue * mq, GstSingleQueue * sq, GstClockTime timestamp,
 
   /* calc diff with other end */
   update_time_level (mq, sq);
-  GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+  GST_SINGLE_QUEUE_MUTEX_UNLOCK (sq);
+
+  update_buffering_unlocked (mq, sq);
 }
 
 static GstClockTime
@@ -1118,10 +1196,11 @@ gst_single_queue_push_one (GstMultiQueue * mq, GstSingleQueue * sq,
 
     res = gst_pad_peer_query (sq->srcpad, query);
 
-    GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+    GST_SINGLE_QUEUE_MUTEX_LOCK (sq);
     sq->last_query = res;
+    sq->query_done = TRUE;
     g_cond_signal (&sq->query_handled);
-    GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+    GST_SINGLE_QUEUE_MUTEX_UNLOCK (sq);
   } else {
     g_warning ("Unexpected object in singlequeue %u (refcounting problem?)",
         sq->id);
@@ -1239,6 +1318,9 @@ gst_multi_queue_loop (GstPad * pad)
    * we might need to wake some sleeping pad up, so there's extra work 
    * there too */
   GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+  /* we got data, so we are not waiting for any anymore */
+  gst_single_queue_set_starved (mq, sq, FALSE);
+
   if (sq->srcresult == GST_FLOW_NOT_LINKED
       || (sq->last_oldid == G_MAXUINT32) || (newid != (sq->last_oldid + 1))
       || sq->last_oldid > mq->highid) {
@@ -1257,16 +1339,22 @@ gst_multi_queue_loop (GstPad * pad)
     sq->next_time = next_time;
 
     /* Update the oldid (the last ID we output) for highid tracking */
-    if (sq->last_oldid != G_MAXUINT32)
+    if (sq->last_oldid != G_MAXUINT32) {
       sq->oldid = sq->last_oldid;
+      if (!mq->high_dirty && sq->srcresult != GST_FLOW_NOT_LINKED
+          && sq->srcresult != GST_FLOW_EOS && (mq->high_oldid == G_MAXUINT32
+              || sq->oldid > mq->high_oldid))
+        mq->high_oldid = sq->oldid;
+    }
 
     if (sq->srcresult == GST_FLOW_NOT_LINKED) {
       /* Go to sleep until it's time to push this buffer */
+      gst_multi_queue_add_waiter (mq, sq);
 
       /* Recompute the highid */
-      compute_high_id (mq);
+      update_high_id (mq);
       /* Recompute the high time */
-      compute_high_time (mq);
+      update_high_time (mq);
 
       while (((mq->sync_by_running_time && next_time != GST_CLOCK_TIME_NONE &&
                   (mq->high_time == GST_CLOCK_TIME_NONE
@@ -1288,12 +1376,13 @@ gst_multi_queue_loop (GstPad * pad)
         mq->numwaiting--;
 
         if (sq->flushing) {
+          gst_multi_queue_remove_waiter (mq, sq);
           GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
           goto out_flushing;
         }
 
         /* Recompute the high time */
-        compute_high_time (mq);
+        update_high_time (mq);
 
         GST_DEBUG_OBJECT (mq, "queue %d woken from sleeping for not-linked "
             "wakeup with newid %u, highid %u, next_time %" GST_TIME_FORMAT
@@ -1302,9 +1391,10 @@ gst_multi_queue_loop (GstPad * pad)
       }
 
       /* Re-compute the high_id in case someone else pushed */
-      compute_high_id (mq);
+      update_high_id (mq);
+      gst_multi_queue_remove_waiter (mq, sq);
     } else {
-      compute_high_id (mq);
+      update_high_id (mq);
       /* Wake up all non-linked pads */
       wake_up_next_non_linked (mq);
     }
@@ -1312,20 +1402,25 @@ gst_multi_queue_loop (GstPad * pad)
     sq->nextid = 0;
     sq->next_time = GST_CLOCK_TIME_NONE;
   }
-  GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
 
-  if (sq->flushing)
+  if (sq->flushing) {
+    GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
     goto out_flushing;
+  }
 
   GST_LOG_OBJECT (mq, "BEFORE PUSHING sq->srcresult: %s",
       gst_flow_get_name (sq->srcresult));
 
   /* Update time stats */
-  GST_MULTI_QUEUE_MUTEX_LOCK (mq);
   next_time = get_running_time (&sq->src_segment, object, FALSE);
   if (next_time != GST_CLOCK_TIME_NONE) {
     if (sq->last_time == GST_CLOCK_TIME_NONE || sq->last_time < next_time)
       sq->last_time = next_time;
+    if (!mq->high_dirty && sq->srcresult != GST_FLOW_NOT_LINKED
+        && sq->srcresult != GST_FLOW_EOS
+        && (mq->high_linked_time == GST_CLOCK_TIME_NONE
+            || mq->high_linked_time < next_time))
+      mq->high_linked_time = next_time;
     if (mq->high_time == GST_CLOCK_TIME_NONE || mq->high_time <= next_time) {
       /* Wake up all non-linked pads now that we advanced the high time */
       mq->high_time = next_time;
@@ -1349,35 +1444,44 @@ gst_multi_queue_loop (GstPad * pad)
   GST_MULTI_QUEUE_MUTEX_LOCK (mq);
   if (sq->pushed && sq->srcresult == GST_FLOW_OK
       && result == GST_FLOW_NOT_LINKED) {
-    GList *tmp;
+    GList *tmp, *next;
 
     GST_LOG_OBJECT (mq, "SingleQueue %d : Changed from active to non-active",
         sq->id);
 
-    compute_high_id (mq);
+    update_high_id (mq);
     do_update_buffering = TRUE;
 
     /* maybe no-one is waiting */
     if (mq->numwaiting > 0) {
-      /* Else figure out which singlequeue(s) need waking up */
-      for (tmp = mq->queues; tmp; tmp = g_list_next (tmp)) {
+      /* Else reset all the not-linked singlequeues */
+      for (tmp = mq->not_linked.head; tmp; tmp = next) {
         GstSingleQueue *sq2 = (GstSingleQueue *) tmp->data;
 
-        if (sq2->srcresult == GST_FLOW_NOT_LINKED) {
-          GST_LOG_OBJECT (mq, "Waking up singlequeue %d", sq2->id);
-          sq2->pushed = FALSE;
-          sq2->srcresult = GST_FLOW_OK;
-          g_cond_signal (&sq2->turn);
-        }
+        /* resetting the result takes it out of the not-linked list */
+        next = tmp->next;
+
+        GST_LOG_OBJECT (mq, "Waking up singlequeue %d", sq2->id);
+        sq2->pushed = FALSE;
+        gst_single_queue_set_srcresult (mq, sq2, GST_FLOW_OK);
+        g_cond_signal (&sq2->turn);
       }
     }
   }
 
   if (is_buffer)
     sq->pushed = TRUE;
-  sq->srcresult = result;
+  gst_single_queue_set_srcresult (mq, sq, result);
   sq->last_oldid = newid;
 
+  /* when a queue stopped being linked, the waiting not-linked queues might
+   * be allowed to go now */
+  if (mq->high_dirty && mq->numwaiting > 0) {
+    update_high_time (mq);
+    update_high_id (mq);
+    wake_up_next_non_linked (mq);
+  }
+
   if (do_update_buffering)
     update_buffering (mq, sq);
 
@@ -1399,11 +1503,10 @@ out_flushing:
 
     /* Need to make sure wake up any sleeping pads when we exit */
     GST_MULTI_QUEUE_MUTEX_LOCK (mq);
-    compute_high_time (mq);
-    compute_high_id (mq);
+    update_high_time (mq);
+    update_high_id (mq);
     wake_up_next_non_linked (mq);
-    sq->last_query = FALSE;
-    g_cond_signal (&sq->query_handled);
+    gst_single_queue_unblock_query (sq);
     GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
 
     /* upstream needs to see fatal result ASAP to shut things down,
@@ -1502,13 +1605,18 @@ gst_multi_queue_sink_activate_mode (GstPad * pad, GstObject * parent,
     case GST_PAD_MODE_PUSH:
       if (active) {
         /* All pads start off linked until they push one buffer */
-        sq->srcresult = GST_FLOW_OK;
+        if (mq)
+          gst_single_queue_set_srcresult (mq, sq, GST_FLOW_OK);
+        else
+          sq->srcresult = GST_FLOW_OK;
         sq->pushed = FALSE;
         gst_data_queue_set_flushing (sq->queue, FALSE);
       } else {
-        sq->srcresult = GST_FLOW_FLUSHING;
-        sq->last_query = FALSE;
-        g_cond_signal (&sq->query_handled);
+        if (mq)
+          gst_single_queue_set_srcresult (mq, sq, GST_FLOW_FLUSHING);
+        else
+          sq->srcresult = GST_FLOW_FLUSHING;
+        gst_single_queue_unblock_query (sq);
         gst_data_queue_set_flushing (sq->queue, TRUE);
 
         /* Wait until streaming thread has finished */
@@ -1611,7 +1719,7 @@ gst_multi_queue_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
     case GST_EVENT_EOS:
       sq->is_eos = TRUE;
       /* EOS affects the buffering state */
-      update_buffering (mq, sq);
+      update_buffering_unlocked (mq, sq);
       single_queue_overrun_cb (sq->queue, sq);
       break;
     case GST_EVENT_SEGMENT:
@@ -1658,7 +1766,7 @@ gst_multi_queue_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
         guint32 curid;
         GstMultiQueueItem *item;
 
-        GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+        GST_SINGLE_QUEUE_MUTEX_LOCK (sq);
         if (sq->srcresult != GST_FLOW_OK)
           goto out_flushing;
 
@@ -1678,15 +1786,25 @@ gst_multi_queue_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
           GST_DEBUG_OBJECT (mq,
               "SingleQueue %d : Enqueuing query %p of type %s with id %d",
               sq->id, query, GST_QUERY_TYPE_NAME (query), curid);
+          sq->query_done = FALSE;
+          /* pushing can block and call into the overrun handling, which
+           * takes the global lock, so don't hold our lock here */
+          GST_SINGLE_QUEUE_MUTEX_UNLOCK (sq);
           res = gst_data_queue_push (sq->queue, (GstDataQueueItem *) item);
-          g_cond_wait (&sq->query_handled, &mq->qlock);
-          res = sq->last_query;
+          GST_SINGLE_QUEUE_MUTEX_LOCK (sq);
+          if (res) {
+            while (!sq->query_done)
+              g_cond_wait (&sq->query_handled, &sq->lock);
+            res = sq->last_query;
+          } else {
+            gst_multi_queue_item_destroy (item);
+          }
         } else {
           GST_DEBUG_OBJECT (mq, "refusing query, we are buffering and the "
               "queue is not empty");
           res = FALSE;
         }
-        GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+        GST_SINGLE_QUEUE_MUTEX_UNLOCK (sq);
       } else {
         /* default handling */
         res = gst_pad_query_default (pad, parent, query);
@@ -1698,7 +1816,7 @@ gst_multi_queue_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
 out_flushing:
   {
     GST_DEBUG_OBJECT (mq, "Flushing");
-    GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
+    GST_SINGLE_QUEUE_MUTEX_UNLOCK (sq);
     return FALSE;
   }
 }
@@ -1744,7 +1862,7 @@ gst_multi_queue_src_event (GstPad * pad, GstObject * parent, GstEvent * event)
     case GST_EVENT_RECONFIGURE:
       GST_MULTI_QUEUE_MUTEX_LOCK (mq);
       if (sq->srcresult == GST_FLOW_NOT_LINKED) {
-        sq->srcresult = GST_FLOW_OK;
+        gst_single_queue_set_srcresult (mq, sq, GST_FLOW_OK);
         g_cond_signal (&sq->turn);
       }
       GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
@@ -1778,6 +1896,53 @@ gst_multi_queue_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
  * Next-non-linked functions
  */
 
+/* WITH LOCK TAKEN */
+static gint
+compare_waiters (GstSingleQueue * a, GstSingleQueue * b, GstMultiQueue * mq)
+{
+  /* waiters without a running time sort last */
+  if (mq->sync_by_running_time) {
+    if (a->next_time == b->next_time)
+      return 0;
+    return a->next_time < b->next_time ? -1 : 1;
+  }
+  if (a->nextid == b->nextid)
+    return 0;
+  return a->nextid < b->nextid ? -1 : 1;
+}
+
+/* WITH LOCK TAKEN */
+static void
+gst_multi_queue_add_waiter (GstMultiQueue * mq, GstSingleQueue * sq)
+{
+  GList *tmp;
+
+  /* new waiters usually wait for the highest id or time, so look for the
+   * insert position starting from the tail */
+  for (tmp = mq->waiters.tail; tmp; tmp = tmp->prev) {
+    if (compare_waiters (tmp->data, sq, mq) <= 0)
+      break;
+  }
+
+  if (tmp) {
+    g_queue_insert_after (&mq->waiters, tmp, sq);
+    sq->waiter_link = tmp->next;
+  } else {
+    g_queue_push_head (&mq->waiters, sq);
+    sq->waiter_link = mq->waiters.head;
+  }
+}
+
+/* WITH LOCK TAKEN */
+static void
+gst_multi_queue_remove_waiter (GstMultiQueue * mq, GstSingleQueue * sq)
+{
+  if (sq->waiter_link) {
+    g_queue_delete_link (&mq->waiters, sq->waiter_link);
+    sq->waiter_link = NULL;
+  }
+}
+
 /* WITH LOCK TAKEN */
 static void
 wake_up_next_non_linked (GstMultiQueue * mq)
@@ -1788,60 +1953,93 @@ wake_up_next_non_linked (GstMultiQueue * mq)
   if (mq->numwaiting < 1)
     return;
 
-  /* Else figure out which singlequeue(s) need waking up */
-  for (tmp = mq->queues; tmp; tmp = g_list_next (tmp)) {
+  /* Else wake up the waiters whose turn it is. They are sorted on what they
+   * wait for, so we can stop at the first one that has to keep waiting */
+  for (tmp = mq->waiters.head; tmp; tmp = tmp->next) {
     GstSingleQueue *sq = (GstSingleQueue *) tmp->data;
 
-    if (sq->srcresult == GST_FLOW_NOT_LINKED) {
-      if ((mq->sync_by_running_time && mq->high_time != GST_CLOCK_TIME_NONE
-              && sq->next_time != GST_CLOCK_TIME_NONE
-              && sq->next_time >= mq->high_time)
-          || (sq->nextid != 0 && sq->nextid <= mq->highid)) {
-        GST_LOG_OBJECT (mq, "Waking up singlequeue %d", sq->id);
-        g_cond_signal (&sq->turn);
-      }
+    /* not waiting for its turn anymore and about to leave */
+    if (sq->srcresult != GST_FLOW_NOT_LINKED)
+      continue;
+
+    if (mq->sync_by_running_time) {
+      if (mq->high_time == GST_CLOCK_TIME_NONE
+          || sq->next_time == GST_CLOCK_TIME_NONE
+          || sq->next_time >= mq->high_time)
+        break;
+    } else if (sq->nextid > mq->highid) {
+      break;
     }
+
+    GST_LOG_OBJECT (mq, "Waking up singlequeue %d", sq->id);
+    g_cond_signal (&sq->turn);
   }
 }
 
 /* WITH LOCK TAKEN */
 static void
-compute_high_id (GstMultiQueue * mq)
+recompute_high (GstMultiQueue * mq)
+{
+  /* Only the linked queues that are not EOS count */
+  GList *tmp;
+  guint32 highid = G_MAXUINT32;
+  GstClockTime highest = GST_CLOCK_TIME_NONE;
+
+  for (tmp = mq->queues; tmp; tmp = g_list_next (tmp)) {
+    GstSingleQueue *sq = (GstSingleQueue *) tmp->data;
+
+    GST_LOG_OBJECT (mq, "inspecting sq:%d , oldid:%d, last_time:%"
+        GST_TIME_FORMAT ", srcresult:%s", sq->id, sq->oldid,
+        GST_TIME_ARGS (sq->last_time), gst_flow_get_name (sq->srcresult));
+
+    if (sq->srcresult == GST_FLOW_NOT_LINKED
+        || sq->srcresult == GST_FLOW_EOS)
+      continue;
+
+    /* If we don't have a global highid, or the global highid is lower than
+     * this single queue's last outputted id, store the queue's one */
+    if ((highid == G_MAXUINT32) || (sq->oldid > highid))
+      highid = sq->oldid;
+    if (sq->last_time != GST_CLOCK_TIME_NONE
+        && (highest == GST_CLOCK_TIME_NONE || sq->last_time > highest))
+      highest = sq->last_time;
+  }
+
+  mq->high_oldid = highid;
+  mq->high_linked_time = highest;
+  mq->high_dirty = FALSE;
+}
+
+/* WITH LOCK TAKEN */
+static void
+update_high_id (GstMultiQueue * mq)
 {
   /* The high-id is either the highest id among the linked pads, or if all
    * pads are not-linked, it's the lowest not-linked pad */
   GList *tmp;
   guint32 lowest = G_MAXUINT32;
-  guint32 highid = G_MAXUINT32;
 
-  for (tmp = mq->queues; tmp; tmp = g_list_next (tmp)) {
+  if (mq->high_dirty)
+    recompute_high (mq);
+
+  for (tmp = mq->waiters.head; tmp; tmp = tmp->next) {
     GstSingleQueue *sq = (GstSingleQueue *) tmp->data;
 
-    GST_LOG_OBJECT (mq, "inspecting sq:%d , nextid:%d, oldid:%d, srcresult:%s",
-        sq->id, sq->nextid, sq->oldid, gst_flow_get_name (sq->srcresult));
+    if (sq->srcresult != GST_FLOW_NOT_LINKED)
+      continue;
 
-    if (sq->srcresult == GST_FLOW_NOT_LINKED) {
-      /* No need to consider queues which are not waiting */
-      if (sq->nextid == 0) {
-        GST_LOG_OBJECT (mq, "sq:%d is not waiting - ignoring", sq->id);
-        continue;
-      }
+    if (sq->nextid < lowest)
+      lowest = sq->nextid;
 
-      if (sq->nextid < lowest)
-        lowest = sq->nextid;
-    } else if (sq->srcresult != GST_FLOW_EOS) {
-      /* If we don't have a global highid, or the global highid is lower than
-       * this single queue's last outputted id, store the queue's one, 
-       * unless the singlequeue is at EOS (srcresult = EOS) */
-      if ((highid == G_MAXUINT32) || (sq->oldid > highid))
-        highid = sq->oldid;
-    }
+    /* sorted on nextid, the first one is the lowest */
+    if (!mq->sync_by_running_time)
+      break;
   }
 
-  if (highid == G_MAXUINT32 || lowest < highid)
+  if (mq->high_oldid == G_MAXUINT32 || lowest < mq->high_oldid)
     mq->highid = lowest;
   else
-    mq->highid = highid;
+    mq->highid = mq->high_oldid;
 
   GST_LOG_OBJECT (mq, "Highid is now : %u, lowest non-linked %u", mq->highid,
       lowest);
@@ -1849,45 +2047,82 @@ compute_high_id (GstMultiQueue * mq)
 
 /* WITH LOCK TAKEN */
 static void
-compute_high_time (GstMultiQueue * mq)
+update_high_time (GstMultiQueue * mq)
 {
-  /* The high-id is either the highest id among the linked pads, or if all
-   * pads are not-linked, it's the lowest not-linked pad */
-  GList *tmp;
-  GstClockTime highest = GST_CLOCK_TIME_NONE;
-  GstClockTime lowest = GST_CLOCK_TIME_NONE;
+  /* The high time is the highest start running time among the linked pads */
+  if (mq->high_dirty)
+    recompute_high (mq);
 
-  for (tmp = mq->queues; tmp; tmp = g_list_next (tmp)) {
-    GstSingleQueue *sq = (GstSingleQueue *) tmp->data;
+  mq->high_time = mq->high_linked_time;
 
-    GST_LOG_OBJECT (mq,
-        "inspecting sq:%d , next_time:%" GST_TIME_FORMAT ", last_time:%"
-        GST_TIME_FORMAT ", srcresult:%s", sq->id, GST_TIME_ARGS (sq->next_time),
-        GST_TIME_ARGS (sq->last_time), gst_flow_get_name (sq->srcresult));
+  GST_LOG_OBJECT (mq, "High time is now : %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (mq->high_time));
+}
 
-    if (sq->srcresult == GST_FLOW_NOT_LINKED) {
-      /* No need to consider queues which are not waiting */
-      if (sq->next_time == GST_CLOCK_TIME_NONE) {
-        GST_LOG_OBJECT (mq, "sq:%d is not waiting - ignoring", sq->id);
-        continue;
-      }
+/* WITH LOCK TAKEN */
+static void
+gst_single_queue_set_srcresult (GstMultiQueue * mq, GstSingleQueue * sq,
+    GstFlowReturn result)
+{
+  if (sq->srcresult == result)
+    return;
 
-      if (lowest == GST_CLOCK_TIME_NONE || sq->next_time < lowest)
-        lowest = sq->next_time;
-    } else if (sq->srcresult != GST_FLOW_EOS) {
-      /* If we don't have a global highid, or the global highid is lower than
-       * this single queue's last outputted id, store the queue's one, 
-       * unless the singlequeue is at EOS (srcresult = EOS) */
-      if (highest == GST_CLOCK_TIME_NONE || sq->last_time > highest)
-        highest = sq->last_time;
-    }
+  if (sq->srcresult == GST_FLOW_NOT_LINKED) {
+    g_queue_delete_link (&mq->not_linked, sq->not_linked_link);
+    sq->not_linked_link = NULL;
+    if (sq->starved)
+      mq->n_starved_linked++;
+  } else if (result == GST_FLOW_NOT_LINKED) {
+    g_queue_push_tail (&mq->not_linked, sq);
+    sq->not_linked_link = mq->not_linked.tail;
+    if (sq->starved)
+      mq->n_starved_linked--;
   }
 
-  mq->high_time = highest;
+  /* the set of linked queues the high id and time come from changed */
+  mq->high_dirty = TRUE;
+  sq->srcresult = result;
+}
 
-  GST_LOG_OBJECT (mq,
-      "High time is now : %" GST_TIME_FORMAT ", lowest non-linked %"
-      GST_TIME_FORMAT, GST_TIME_ARGS (mq->high_time), GST_TIME_ARGS (lowest));
+/* WITH LOCK TAKEN */
+static void
+gst_single_queue_set_starved (GstMultiQueue * mq, GstSingleQueue * sq,
+    gboolean starved)
+{
+  if (sq->starved == starved)
+    return;
+
+  if (starved) {
+    mq->n_starved++;
+    if (sq->srcresult != GST_FLOW_NOT_LINKED)
+      mq->n_starved_linked++;
+  } else {
+    mq->n_starved--;
+    if (sq->srcresult != GST_FLOW_NOT_LINKED)
+      mq->n_starved_linked--;
+  }
+  sq->starved = starved;
+}
+
+/* WITH LOCK TAKEN */
+static void
+gst_single_queue_forget_full (GstMultiQueue * mq, GstSingleQueue * sq)
+{
+  if (sq->full_link) {
+    g_queue_delete_link (&mq->full_queues, sq->full_link);
+    sq->full_link = NULL;
+  }
+}
+
+/* wake up a serialized query waiting for its result, it fails */
+static void
+gst_single_queue_unblock_query (GstSingleQueue * sq)
+{
+  GST_SINGLE_QUEUE_MUTEX_LOCK (sq);
+  sq->last_query = FALSE;
+  sq->query_done = TRUE;
+  g_cond_signal (&sq->query_handled);
+  GST_SINGLE_QUEUE_MUTEX_UNLOCK (sq);
 }
 
 #define IS_FILLED(q, format, value) (((q)->max_size.format) != 0 && \
@@ -1900,11 +2135,11 @@ static void
 single_queue_overrun_cb (GstDataQueue * dq, GstSingleQueue * sq)
 {
   GstMultiQueue *mq = sq->mqueue;
-  GList *tmp;
   GstDataQueueSize size;
   gboolean filled = TRUE;
-  gboolean all_not_linked = TRUE;
-  gboolean empty_found = FALSE;
+  gboolean all_not_linked;
+  gboolean empty_found;
+  guint n_not_linked, n_empty;
 
   gst_data_queue_get_level (sq->queue, &size);
 
@@ -1922,26 +2157,19 @@ single_queue_overrun_cb (GstDataQueue * dq, GstSingleQueue * sq)
     goto done;
   }
 
-  /* Search for empty or unlinked queues */
-  for (tmp = mq->queues; tmp; tmp = g_list_next (tmp)) {
-    GstSingleQueue *oq = (GstSingleQueue *) tmp->data;
+  /* Count the other empty or unlinked queues */
+  n_not_linked = mq->not_linked.length;
+  n_empty = mq->n_starved_linked;
+  if (sq->srcresult == GST_FLOW_NOT_LINKED)
+    n_not_linked--;
+  else if (sq->starved)
+    n_empty--;
 
-    if (oq == sq)
-      continue;
+  all_not_linked = (n_not_linked + 1 >= mq->nbqueues);
+  empty_found = (n_empty > 0);
 
-    if (oq->srcresult == GST_FLOW_NOT_LINKED) {
-      GST_LOG_OBJECT (mq, "Queue %d is not-linked", oq->id);
-      continue;
-    }
-
-    all_not_linked = FALSE;
-    GST_LOG_OBJECT (mq, "Checking Queue %d", oq->id);
-    if (gst_data_queue_is_empty (oq->queue)) {
-      GST_LOG_OBJECT (mq, "Queue %d is empty", oq->id);
-      empty_found = TRUE;
-      break;
-    }
-  }
+  GST_LOG_OBJECT (mq, "%u other queues are not-linked, %u are empty",
+      n_not_linked, n_empty);
 
   /* if hard limits are not reached then we allow one more buffer in the full
    * queue, but only if any of the other singelqueues are empty or all are
@@ -1960,6 +2188,11 @@ single_queue_overrun_cb (GstDataQueue * dq, GstSingleQueue * sq)
   }
 
 done:
+  /* remember that the queue is blocking so an underrun elsewhere can grow it */
+  if (filled && !sq->full_link) {
+    g_queue_push_tail (&mq->full_queues, sq);
+    sq->full_link = mq->full_queues.tail;
+  }
   GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
 
   /* Overrun is always forwarded, since this is blocking the upstream element */
@@ -1972,22 +2205,28 @@ done:
 static void
 single_queue_underrun_cb (GstDataQueue * dq, GstSingleQueue * sq)
 {
-  gboolean empty = TRUE;
+  gboolean empty;
   GstMultiQueue *mq = sq->mqueue;
-  GList *tmp;
+  GList *tmp, *next;
+
+  GST_MULTI_QUEUE_MUTEX_LOCK (mq);
+  gst_single_queue_set_starved (mq, sq, TRUE);
 
   if (sq->srcresult == GST_FLOW_NOT_LINKED) {
+    GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
     GST_LOG_OBJECT (mq, "Single Queue %d is empty but not-linked", sq->id);
     return;
   } else {
     GST_LOG_OBJECT (mq,
-        "Single Queue %d is empty, Checking other single queues", sq->id);
+        "Single Queue %d is empty, Checking full single queues", sq->id);
   }
 
-  GST_MULTI_QUEUE_MUTEX_LOCK (mq);
-  for (tmp = mq->queues; tmp; tmp = g_list_next (tmp)) {
+  /* only the queues that signalled an overrun can be blocked on being full */
+  for (tmp = mq->full_queues.head; tmp; tmp = next) {
     GstSingleQueue *oq = (GstSingleQueue *) tmp->data;
 
+    next = tmp->next;
+
     if (gst_data_queue_is_full (oq->queue)) {
       GstDataQueueSize size;
 
@@ -2000,9 +2239,11 @@ single_queue_underrun_cb (GstDataQueue * dq, GstSingleQueue * sq)
         gst_data_queue_limits_changed (oq->queue);
       }
     }
-    if (!gst_data_queue_is_empty (oq->queue))
-      empty = FALSE;
+    /* forget about the ones that are not blocked anymore */
+    if (!gst_data_queue_is_full (oq->queue))
+      gst_single_queue_forget_full (mq, oq);
   }
+  empty = (mq->n_starved >= mq->nbqueues);
   GST_MULTI_QUEUE_MUTEX_UNLOCK (mq);
 
   if (empty) {
@@ -2084,6 +2325,7 @@ gst_single_queue_free (GstSingleQueue * sq)
   g_object_unref (sq->queue);
   g_cond_clear (&sq->turn);
   g_cond_clear (&sq->query_handled);
+  g_mutex_clear (&sq->lock);
   g_free (sq);
 }
 
@@ -2149,6 +2391,7 @@ gst_single_queue_new (GstMultiQueue * mqueue, guint id)
   sq->next_time = GST_CLOCK_TIME_NONE;
   sq->last_time = GST_CLOCK_TIME_NONE;
   g_cond_init (&sq->turn);
+  g_mutex_init (&sq->lock);
   g_cond_init (&sq->query_handled);
 
   sq->sinktime = GST_CLOCK_TIME_NONE;
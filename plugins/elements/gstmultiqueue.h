@@ -71,9 +71,21 @@ struct _GstMultiQueue {
 
   GMutex   qlock;	/* Global queue lock (vs object lock or individual */
 			/* queues lock). Protects nbqueues, queues, global */
-			/* GstMultiQueueSize, counter and highid */
+			/* GstMultiQueueSize, counter, highid and the */
+			/* cross-queue bookkeeping below */
 
   gint numwaiting;	/* number of not-linked pads waiting */
+
+  GQueue waiters;	/* not-linked queues waiting for their turn, sorted */
+			/* on the id or running time they wait for */
+  GQueue not_linked;	/* all not-linked queues */
+  GQueue full_queues;	/* queues that signalled an overrun */
+  guint n_starved;	/* number of queues waiting for data */
+  guint n_starved_linked; /* number of linked queues waiting for data */
+
+  guint32 high_oldid;	/* highest id outputted by a linked queue */
+  GstClockTime high_linked_time; /* highest start running time of a linked queue */
+  gboolean high_dirty;	/* high_oldid and high_linked_time need recomputing */
 };
 
 struct _GstMultiQueueClass {
@@ -96,6 +96,8 @@ static void gst_output_selector_release_pad (GstElement * element,
     GstPad * pad);
 static GstFlowReturn gst_output_selector_chain (GstPad * pad,
     GstObject * parent, GstBuffer * buf);
+static GstFlowReturn gst_output_selector_chain_list (GstPad * pad,
+    GstObject * parent, GstBufferList * list);
 static GstStateChangeReturn gst_output_selector_change_state (GstElement *
     element, GstStateChange transition);
 static gboolean gst_output_selector_event (GstPad * pad, GstObject * parent,
@@ -155,6 +157,8 @@ gst_output_selector_init (GstOutputSelector * sel)
       "sink");
   gst_pad_set_chain_function (sel->sinkpad,
       GST_DEBUG_FUNCPTR (gst_output_selector_chain));
+  gst_pad_set_chain_list_function (sel->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_output_selector_chain_list));
   gst_pad_set_event_function (sel->sinkpad,
       GST_DEBUG_FUNCPTR (gst_output_selector_event));
   gst_pad_set_query_function (sel->sinkpad,
@@ -412,15 +416,13 @@ gst_output_selector_switch (GstOutputSelector * osel)
   return res;
 }
 
-static GstFlowReturn
-gst_output_selector_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+/* switches to the pending pad and keeps track of @last, the last buffer
+ * that is going to be pushed */
+static void
+gst_output_selector_prepare_push (GstOutputSelector * osel, GstBuffer * last)
 {
-  GstFlowReturn res;
-  GstOutputSelector *osel;
   GstClockTime position, duration;
 
-  osel = GST_OUTPUT_SELECTOR (parent);
-
   /*
    * The _switch function might push a buffer if 'resend-latest' is true.
    *
@@ -442,16 +444,19 @@ gst_output_selector_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     osel->latest_buffer = NULL;
   }
 
+  if (last == NULL)
+    return;
+
   if (osel->resend_latest) {
     /* Keep reference to latest buffer to resend it after switch */
-    osel->latest_buffer = gst_buffer_ref (buf);
+    osel->latest_buffer = gst_buffer_ref (last);
   }
 
   /* Keep track of last stop and use it in SEGMENT start after
      switching to a new src pad */
-  position = GST_BUFFER_TIMESTAMP (buf);
+  position = GST_BUFFER_TIMESTAMP (last);
   if (GST_CLOCK_TIME_IS_VALID (position)) {
-    duration = GST_BUFFER_DURATION (buf);
+    duration = GST_BUFFER_DURATION (last);
     if (GST_CLOCK_TIME_IS_VALID (duration)) {
       position += duration;
     }
@@ -459,6 +464,17 @@ gst_output_selector_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
         GST_TIME_ARGS (position));
     osel->segment.position = position;
   }
+}
+
+static GstFlowReturn
+gst_output_selector_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
+{
+  GstFlowReturn res;
+  GstOutputSelector *osel;
+
+  osel = GST_OUTPUT_SELECTOR (parent);
+
+  gst_output_selector_prepare_push (osel, buf);
 
   GST_LOG_OBJECT (osel, "pushing buffer to %" GST_PTR_FORMAT,
       osel->active_srcpad);
@@ -467,6 +483,30 @@ gst_output_selector_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
   return res;
 }
 
+static GstFlowReturn
+gst_output_selector_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list)
+{
+  GstFlowReturn res;
+  GstOutputSelector *osel;
+  GstBuffer *last = NULL;
+  guint len;
+
+  osel = GST_OUTPUT_SELECTOR (parent);
+
+  len = gst_buffer_list_length (list);
+  if (len > 0)
+    last = gst_buffer_list_get (list, len - 1);
+
+  gst_output_selector_prepare_push (osel, last);
+
+  GST_LOG_OBJECT (osel, "pushing list to %" GST_PTR_FORMAT,
+      osel->active_srcpad);
+  res = gst_pad_push_list (osel->active_srcpad, list);
+
+  return res;
+}
+
 static GstStateChangeReturn
 gst_output_selector_change_state (GstElement * element,
     GstStateChange transition)
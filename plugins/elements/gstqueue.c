@@ -53,6 +53,18 @@
  * the specified minimum thresholds require (by default: when the queue is
  * empty). The #GstQueue::overrun signal is emitted when the queue is filled
  * up. Both signals are emitted from the context of the streaming thread.
+ *
+ * When #GstQueue:lock-free is set, buffers are handed from the upstream
+ * thread to the queue thread without taking a lock as long as the queue is
+ * neither full nor empty. The queue thread spins for a short, adaptive amount
+ * of time before it goes to sleep on an empty queue. This mode is only used
+ * when the queue is not leaky, has no minimum thresholds and does not flush
+ * on EOS; these properties are checked when the queue starts.
+ *
+ * Buffer lists are kept in the queue as a whole and count for the number of
+ * buffers they contain. When #GstQueue:push-lists is set, the queue thread
+ * takes all buffers that are queued before the next event or query at once
+ * and pushes them downstream as one buffer list.
  */
 
 #include "gst/gst_private.h"
@@ -120,13 +132,22 @@ enum
   PROP_MIN_THRESHOLD_TIME,
   PROP_LEAKY,
   PROP_SILENT,
-  PROP_FLUSH_ON_EOS
+  PROP_FLUSH_ON_EOS,
+  PROP_LOCK_FREE,
+  PROP_PUSH_LISTS
 };
 
 /* default property values */
 #define DEFAULT_MAX_SIZE_BUFFERS  200   /* 200 buffers */
 #define DEFAULT_MAX_SIZE_BYTES    (10 * 1024 * 1024)    /* 10 MB       */
 #define DEFAULT_MAX_SIZE_TIME     GST_SECOND    /* 1 second    */
+#define DEFAULT_LOCK_FREE         FALSE
+#define DEFAULT_PUSH_LISTS        FALSE
+
+/* bounds for the number of times the srcpad thread polls an empty queue in
+ * lock-free mode before it goes to sleep */
+#define LF_SPIN_MIN               16
+#define LF_SPIN_MAX               4096
 
 #define GST_QUEUE_MUTEX_LOCK(q) G_STMT_START {                          \
   g_mutex_lock (&q->qlock);                                              \
@@ -195,6 +216,8 @@ static void gst_queue_get_property (GObject * object,
 
 static GstFlowReturn gst_queue_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static GstFlowReturn gst_queue_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * buffer_list);
 static GstFlowReturn gst_queue_push_one (GstQueue * queue);
 static void gst_queue_loop (GstPad * pad);
 
@@ -387,6 +410,35 @@ gst_queue_class_init (GstQueueClass * klass)
           "Discard all data in the queue when an EOS event is received", FALSE,
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  /**
+   * GstQueue:lock-free
+   *
+   * Pass buffers between the upstream thread and the queue thread without
+   * locking when possible. Only used when the queue is not leaky, has no
+   * minimum thresholds and does not flush on EOS.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_LOCK_FREE,
+      g_param_spec_boolean ("lock-free", "Lock free",
+          "Pass buffers between threads without locking when possible",
+          DEFAULT_LOCK_FREE,
+          G_PARAM_READWRITE | GST_PARAM_MUTABLE_READY |
+          G_PARAM_STATIC_STRINGS));
+
+  /**
+   * GstQueue:push-lists
+   *
+   * Take all buffers that are queued before the next event or query at once
+   * and push them downstream as one buffer list.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_PUSH_LISTS,
+      g_param_spec_boolean ("push-lists", "Push lists",
+          "Push all queued buffers downstream as one buffer list",
+          DEFAULT_PUSH_LISTS, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gobject_class->finalize = gst_queue_finalize;
 
   gst_element_class_set_static_metadata (gstelement_class,
@@ -404,6 +456,7 @@ gst_queue_class_init (GstQueueClass * klass)
   GST_DEBUG_REGISTER_FUNCPTR (gst_queue_handle_src_event);
   GST_DEBUG_REGISTER_FUNCPTR (gst_queue_handle_src_query);
   GST_DEBUG_REGISTER_FUNCPTR (gst_queue_chain);
+  GST_DEBUG_REGISTER_FUNCPTR (gst_queue_chain_list);
 }
 
 static void
@@ -412,6 +465,7 @@ gst_queue_init (GstQueue * queue)
   queue->sinkpad = gst_pad_new_from_static_template (&sinktemplate, "sink");
 
   gst_pad_set_chain_function (queue->sinkpad, gst_queue_chain);
+  gst_pad_set_chain_list_function (queue->sinkpad, gst_queue_chain_list);
   gst_pad_set_activatemode_function (queue->sinkpad,
       gst_queue_sink_activate_mode);
   gst_pad_set_event_function (queue->sinkpad, gst_queue_handle_sink_event);
@@ -456,6 +510,12 @@ gst_queue_init (GstQueue * queue)
 
   queue->newseg_applied_to_src = FALSE;
 
+  queue->lock_free = DEFAULT_LOCK_FREE;
+  queue->using_lock_free = FALSE;
+  queue->lf_queue = NULL;
+
+  queue->push_lists = DEFAULT_PUSH_LISTS;
+
   GST_DEBUG_OBJECT (queue,
       "initialized queue's not_empty & not_full conditions");
 }
@@ -477,6 +537,17 @@ gst_queue_finalize (GObject * object)
   }
   gst_queue_array_free (queue->queue);
 
+  if (queue->lf_queue) {
+    GstQueueItem *qitem;
+
+    while ((qitem = gst_atomic_queue_pop (queue->lf_queue))) {
+      if (!qitem->is_query)
+        gst_mini_object_unref (qitem->item);
+      g_slice_free (GstQueueItem, qitem);
+    }
+    gst_atomic_queue_unref (queue->lf_queue);
+  }
+
   g_mutex_clear (&queue->qlock);
   g_cond_clear (&queue->item_add);
   g_cond_clear (&queue->item_del);
@@ -485,6 +556,82 @@ gst_queue_finalize (GObject * object)
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+/* In lock-free mode sinktime is only written by the sinkpad thread and
+ * srctime only by the srcpad thread. The other side reads them without a
+ * lock, the sequence counter makes sure it never sees a half written value. */
+static inline void
+gst_queue_lf_set_time (volatile gint * seq, volatile GstClockTime * time,
+    GstClockTime value)
+{
+  g_atomic_int_inc (seq);
+  *time = value;
+  g_atomic_int_inc (seq);
+}
+
+static inline GstClockTime
+gst_queue_lf_get_time (volatile gint * seq, volatile GstClockTime * time)
+{
+  GstClockTime value;
+  gint s;
+
+  do {
+    s = g_atomic_int_get (seq);
+    value = *time;
+  } while ((s & 1) || g_atomic_int_get (seq) != s);
+
+  return value;
+}
+
+/* update the running time of one side of the queue in lock-free mode */
+static void
+gst_queue_lf_update_time (GstQueue * queue, GstSegment * segment, gboolean sink)
+{
+  GstClockTime time;
+
+  time = gst_segment_to_running_time (segment, GST_FORMAT_TIME,
+      segment->position);
+
+  if (sink)
+    gst_queue_lf_set_time (&queue->sink_seq, &queue->sinktime, time);
+  else
+    gst_queue_lf_set_time (&queue->src_seq, &queue->srctime, time);
+}
+
+/* the amount of time in the queue in lock-free mode, can be called from
+ * any thread */
+static guint64
+gst_queue_lf_time_level (GstQueue * queue)
+{
+  GstClockTime sink_time, src_time;
+
+  if (g_atomic_int_get (&queue->cur_level.buffers) == 0)
+    return 0;
+
+  sink_time = gst_queue_lf_get_time (&queue->sink_seq, &queue->sinktime);
+  src_time = gst_queue_lf_get_time (&queue->src_seq, &queue->srctime);
+
+  if (!GST_CLOCK_TIME_IS_VALID (sink_time))
+    return 0;
+  /* nothing left the queue yet */
+  if (!GST_CLOCK_TIME_IS_VALID (src_time))
+    src_time = 0;
+
+  return sink_time > src_time ? sink_time - src_time : 0;
+}
+
+/* get the current level, also in lock-free mode */
+static void
+gst_queue_get_level (GstQueue * queue, GstQueueSize * level)
+{
+  if (queue->using_lock_free) {
+    level->buffers = g_atomic_int_get (&queue->cur_level.buffers);
+    level->bytes = g_atomic_int_get (&queue->cur_level.bytes);
+    level->time = gst_queue_lf_time_level (queue);
+  } else {
+    *level = queue->cur_level;
+  }
+}
+
 /* calculate the diff between running time on the sink and src of the queue.
  * This is the total amount of time in the queue. */
 static void
@@ -519,6 +666,24 @@ update_time_level (GstQueue * queue)
     queue->cur_level.time = 0;
 }
 
+/* the position of segment changed, update the time level of the queue */
+static void
+apply_position (GstQueue * queue, GstSegment * segment, gboolean sink)
+{
+  if (queue->using_lock_free) {
+    gst_queue_lf_update_time (queue, segment, sink);
+    return;
+  }
+
+  if (sink)
+    queue->sink_tainted = TRUE;
+  else
+    queue->src_tainted = TRUE;
+
+  /* calc diff with other end */
+  update_time_level (queue);
+}
+
 /* take a SEGMENT event and apply the values to segment, updating the time
  * level of queue. */
 static void
@@ -537,15 +702,11 @@ apply_segment (GstQueue * queue, GstEvent * event, GstSegment * segment,
     segment->stop = -1;
     segment->time = 0;
   }
-  if (sink)
-    queue->sink_tainted = TRUE;
-  else
-    queue->src_tainted = TRUE;
 
   GST_DEBUG_OBJECT (queue, "configured SEGMENT %" GST_SEGMENT_FORMAT, segment);
 
   /* segment can update the time level of the queue */
-  update_time_level (queue);
+  apply_position (queue, segment, sink);
 }
 
 /* take a buffer and update segment, updating the time level of the queue. */
@@ -571,33 +732,157 @@ apply_buffer (GstQueue * queue, GstBuffer * buffer, GstSegment * segment,
       GST_TIME_ARGS (timestamp));
 
   segment->position = timestamp;
-  if (sink)
-    queue->sink_tainted = TRUE;
-  else
-    queue->src_tainted = TRUE;
 
+  apply_position (queue, segment, sink);
+}
 
-  /* calc diff with other end */
-  update_time_level (queue);
+static gboolean
+buffer_list_apply_time (GstBuffer ** buf, guint idx, gpointer user_data)
+{
+  GstClockTime *timestamp = user_data;
+
+  if (GST_BUFFER_TIMESTAMP_IS_VALID (*buf))
+    *timestamp = GST_BUFFER_TIMESTAMP (*buf);
+  if (GST_BUFFER_DURATION_IS_VALID (*buf))
+    *timestamp += GST_BUFFER_DURATION (*buf);
+
+  return TRUE;
 }
 
+/* take a buffer list and update segment with the end of its last buffer,
+ * updating the time level of the queue. */
 static void
-gst_queue_locked_flush (GstQueue * queue, gboolean full)
+apply_buffer_list (GstQueue * queue, GstBufferList * buffer_list,
+    GstSegment * segment, gboolean sink)
 {
-  while (!gst_queue_array_is_empty (queue->queue)) {
-    GstQueueItem *qitem = gst_queue_array_pop_head (queue->queue);
+  GstClockTime timestamp;
+
+  /* if no timestamp is set, assume it's continuous with the previous
+   * time */
+  timestamp = segment->position;
+  gst_buffer_list_foreach (buffer_list, buffer_list_apply_time, &timestamp);
+
+  GST_LOG_OBJECT (queue, "position updated to %" GST_TIME_FORMAT,
+      GST_TIME_ARGS (timestamp));
+
+  segment->position = timestamp;
 
-    /* Then lose another reference because we are supposed to destroy that
-       data when flushing */
-    if (!full && !qitem->is_query && GST_IS_EVENT (qitem->item)
-        && GST_EVENT_IS_STICKY (qitem->item)
-        && GST_EVENT_TYPE (qitem->item) != GST_EVENT_SEGMENT
-        && GST_EVENT_TYPE (qitem->item) != GST_EVENT_EOS) {
-      gst_pad_store_sticky_event (queue->srcpad, GST_EVENT_CAST (qitem->item));
+  apply_position (queue, segment, sink);
+}
+
+static gboolean
+buffer_list_calc_size (GstBuffer ** buf, guint idx, gpointer user_data)
+{
+  gsize *size = user_data;
+
+  *size += gst_buffer_get_size (*buf);
+
+  return TRUE;
+}
+
+static gboolean
+buffer_list_append (GstBuffer ** buf, guint idx, gpointer user_data)
+{
+  gst_buffer_list_add (GST_BUFFER_LIST_CAST (user_data), gst_buffer_ref (*buf));
+
+  return TRUE;
+}
+
+/* append a buffer or the buffers of a buffer list to buffer_list, takes
+ * ownership of data */
+static void
+gst_queue_list_append (GstBufferList * buffer_list, GstMiniObject * data)
+{
+  if (GST_IS_BUFFER_LIST (data)) {
+    gst_buffer_list_foreach (GST_BUFFER_LIST_CAST (data), buffer_list_append,
+        buffer_list);
+    gst_mini_object_unref (data);
+  } else {
+    gst_buffer_list_add (buffer_list, GST_BUFFER_CAST (data));
+  }
+}
+
+/* mark the first buffer of a buffer or buffer list as DISCONT */
+static GstMiniObject *
+gst_queue_mark_discont (GstQueue * queue, GstMiniObject * data)
+{
+  GstBufferList *buffer_list;
+  GstBuffer *buffer;
+
+  if (GST_IS_BUFFER_LIST (data)) {
+    buffer_list = gst_buffer_list_make_writable (GST_BUFFER_LIST_CAST (data));
+    if (gst_buffer_list_length (buffer_list) > 0) {
+      buffer = gst_buffer_list_get (buffer_list, 0);
+      buffer = gst_buffer_make_writable (gst_buffer_ref (buffer));
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+      gst_buffer_list_remove (buffer_list, 0, 1);
+      gst_buffer_list_insert (buffer_list, 0, buffer);
     }
-    if (!qitem->is_query)
-      gst_mini_object_unref (qitem->item);
-    g_slice_free (GstQueueItem, qitem);
+    data = GST_MINI_OBJECT_CAST (buffer_list);
+  } else {
+    buffer = gst_buffer_make_writable (GST_BUFFER_CAST (data));
+    GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+    data = GST_MINI_OBJECT_CAST (buffer);
+  }
+  GST_DEBUG_OBJECT (queue, "marked %" GST_PTR_FORMAT " as DISCONT", data);
+
+  return data;
+}
+
+/* TRUE when qitem holds a buffer or buffer list */
+static inline gboolean
+gst_queue_item_is_data (GstQueueItem * qitem)
+{
+  return qitem != NULL && !qitem->is_query &&
+      (GST_IS_BUFFER (qitem->item) || GST_IS_BUFFER_LIST (qitem->item));
+}
+
+static void
+gst_queue_drop_item (GstQueue * queue, GstQueueItem * qitem, gboolean full)
+{
+  /* Then lose another reference because we are supposed to destroy that
+     data when flushing */
+  if (!full && !qitem->is_query && GST_IS_EVENT (qitem->item)
+      && GST_EVENT_IS_STICKY (qitem->item)
+      && GST_EVENT_TYPE (qitem->item) != GST_EVENT_SEGMENT
+      && GST_EVENT_TYPE (qitem->item) != GST_EVENT_EOS) {
+    gst_pad_store_sticky_event (queue->srcpad, GST_EVENT_CAST (qitem->item));
+  }
+  if (!qitem->is_query)
+    gst_mini_object_unref (qitem->item);
+  g_slice_free (GstQueueItem, qitem);
+}
+
+/* drop all items in lock-free mode. This is called from the srcpad thread,
+ * the sinkpad thread might still add items so the level is updated for each
+ * item instead of cleared. */
+static void
+gst_queue_lf_drain (GstQueue * queue, gboolean full)
+{
+  GstQueueItem *qitem;
+
+  while ((qitem = gst_atomic_queue_pop (queue->lf_queue))) {
+    if (!qitem->is_query && GST_IS_BUFFER (qitem->item)) {
+      g_atomic_int_add (&queue->cur_level.bytes, -(gint) qitem->size);
+      g_atomic_int_add (&queue->cur_level.buffers, -1);
+    } else if (!qitem->is_query && GST_IS_BUFFER_LIST (qitem->item)) {
+      g_atomic_int_add (&queue->cur_level.bytes, -(gint) qitem->size);
+      g_atomic_int_add (&queue->cur_level.buffers,
+          -(gint) gst_buffer_list_length (GST_BUFFER_LIST_CAST (qitem->item)));
+    }
+    gst_queue_drop_item (queue, qitem, full);
+  }
+}
+
+static void
+gst_queue_locked_flush (GstQueue * queue, gboolean full)
+{
+  if (queue->using_lock_free) {
+    gst_queue_lf_drain (queue, full);
+  } else {
+    while (!gst_queue_array_is_empty (queue->queue))
+      gst_queue_drop_item (queue, gst_queue_array_pop_head (queue->queue),
+          full);
   }
   queue->last_query = FALSE;
   g_cond_signal (&queue->query_handled);
@@ -637,6 +922,28 @@ gst_queue_locked_enqueue_buffer (GstQueue * queue, gpointer item)
   GST_QUEUE_SIGNAL_ADD (queue);
 }
 
+static inline void
+gst_queue_locked_enqueue_buffer_list (GstQueue * queue, gpointer item)
+{
+  GstQueueItem *qitem;
+  GstBufferList *buffer_list = GST_BUFFER_LIST_CAST (item);
+  gsize bsize = 0;
+
+  gst_buffer_list_foreach (buffer_list, buffer_list_calc_size, &bsize);
+
+  /* add buffer list to the statistics */
+  queue->cur_level.buffers += gst_buffer_list_length (buffer_list);
+  queue->cur_level.bytes += bsize;
+  apply_buffer_list (queue, buffer_list, &queue->sink_segment, TRUE);
+
+  qitem = g_slice_new (GstQueueItem);
+  qitem->item = item;
+  qitem->is_query = FALSE;
+  qitem->size = bsize;
+  gst_queue_array_push_tail (queue->queue, qitem);
+  GST_QUEUE_SIGNAL_ADD (queue);
+}
+
 static inline void
 gst_queue_locked_enqueue_event (GstQueue * queue, gpointer item)
 {
@@ -678,6 +985,123 @@ gst_queue_locked_enqueue_event (GstQueue * queue, gpointer item)
   GST_QUEUE_SIGNAL_ADD (queue);
 }
 
+/* wake up the other thread in lock-free mode when it is waiting for us.
+ * The waiting thread sets the flag with a full barrier and checks the queue
+ * again before it sleeps, so the wakeup can't get lost. */
+static inline void
+gst_queue_lf_signal (GstQueue * queue, gboolean * waiting, GCond * cond)
+{
+  if (G_UNLIKELY (g_atomic_int_get (waiting))) {
+    GST_QUEUE_MUTEX_LOCK (queue);
+    g_cond_signal (cond);
+    GST_QUEUE_MUTEX_UNLOCK (queue);
+  }
+}
+
+/* enqueue a buffer or buffer list in lock-free mode, called without
+ * QUEUE_LOCK */
+static void
+gst_queue_lf_enqueue_data (GstQueue * queue, GstMiniObject * item,
+    gboolean is_list)
+{
+  GstQueueItem *qitem;
+  gsize bsize = 0;
+  guint n_buffers;
+
+  if (is_list) {
+    GstBufferList *buffer_list = GST_BUFFER_LIST_CAST (item);
+
+    gst_buffer_list_foreach (buffer_list, buffer_list_calc_size, &bsize);
+    n_buffers = gst_buffer_list_length (buffer_list);
+    apply_buffer_list (queue, buffer_list, &queue->sink_segment, TRUE);
+  } else {
+    GstBuffer *buffer = GST_BUFFER_CAST (item);
+
+    bsize = gst_buffer_get_size (buffer);
+    n_buffers = 1;
+    apply_buffer (queue, buffer, &queue->sink_segment, TRUE, TRUE);
+  }
+
+  qitem = g_slice_new (GstQueueItem);
+  qitem->item = item;
+  qitem->is_query = FALSE;
+  qitem->size = bsize;
+
+  /* account before the srcpad thread can dequeue it */
+  g_atomic_int_add (&queue->cur_level.buffers, (gint) n_buffers);
+  g_atomic_int_add (&queue->cur_level.bytes, (gint) bsize);
+  gst_atomic_queue_push (queue->lf_queue, qitem);
+
+  gst_queue_lf_signal (queue, &queue->waiting_add, &queue->item_add);
+}
+
+/* enqueue an event in lock-free mode, with QUEUE_LOCK so that it is
+ * serialized against the srcpad thread checking for EOS from downstream */
+static void
+gst_queue_lf_enqueue_event (GstQueue * queue, GstEvent * event)
+{
+  GstQueueItem *qitem;
+
+  switch (GST_EVENT_TYPE (event)) {
+    case GST_EVENT_EOS:
+      GST_CAT_LOG_OBJECT (queue_dataflow, queue, "got EOS from upstream");
+      queue->eos = TRUE;
+      break;
+    case GST_EVENT_SEGMENT:
+      apply_segment (queue, event, &queue->sink_segment, TRUE);
+      queue->unexpected = FALSE;
+      break;
+    default:
+      break;
+  }
+
+  qitem = g_slice_new (GstQueueItem);
+  qitem->item = GST_MINI_OBJECT_CAST (event);
+  qitem->is_query = FALSE;
+  gst_atomic_queue_push (queue->lf_queue, qitem);
+  GST_QUEUE_SIGNAL_ADD (queue);
+}
+
+/* take the item out of @qitem and update level stats in lock-free mode,
+ * called from the srcpad thread */
+static GstMiniObject *
+gst_queue_lf_dequeue (GstQueue * queue, GstQueueItem * qitem)
+{
+  GstMiniObject *item = qitem->item;
+
+  if (qitem->is_query) {
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+        "retrieved query %p from queue", item);
+  } else if (GST_IS_BUFFER (item)) {
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+        "retrieved buffer %p from queue", item);
+
+    apply_buffer (queue, GST_BUFFER_CAST (item), &queue->src_segment, TRUE,
+        FALSE);
+    g_atomic_int_add (&queue->cur_level.bytes, -(gint) qitem->size);
+    g_atomic_int_add (&queue->cur_level.buffers, -1);
+  } else if (GST_IS_BUFFER_LIST (item)) {
+    GstBufferList *buffer_list = GST_BUFFER_LIST_CAST (item);
+
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+        "retrieved buffer list %p from queue", item);
+
+    apply_buffer_list (queue, buffer_list, &queue->src_segment, FALSE);
+    g_atomic_int_add (&queue->cur_level.bytes, -(gint) qitem->size);
+    g_atomic_int_add (&queue->cur_level.buffers,
+        -(gint) gst_buffer_list_length (buffer_list));
+  } else if (GST_IS_EVENT (item)) {
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+        "retrieved event %p from queue", item);
+
+    if (GST_EVENT_TYPE (item) == GST_EVENT_SEGMENT)
+      apply_segment (queue, GST_EVENT_CAST (item), &queue->src_segment, FALSE);
+  }
+  g_slice_free (GstQueueItem, qitem);
+
+  return item;
+}
+
 /* dequeue an item from the queue and update level stats, with QUEUE_LOCK */
 static GstMiniObject *
 gst_queue_locked_dequeue (GstQueue * queue)
@@ -708,6 +1132,20 @@ gst_queue_locked_dequeue (GstQueue * queue)
     if (queue->cur_level.buffers == 0)
       queue->cur_level.time = 0;
 
+  } else if (GST_IS_BUFFER_LIST (item)) {
+    GstBufferList *buffer_list = GST_BUFFER_LIST_CAST (item);
+
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+        "retrieved buffer list %p from queue", buffer_list);
+
+    queue->cur_level.buffers -= gst_buffer_list_length (buffer_list);
+    queue->cur_level.bytes -= bufsize;
+    apply_buffer_list (queue, buffer_list, &queue->src_segment, FALSE);
+
+    /* if the queue is empty now, update the other side */
+    if (queue->cur_level.buffers == 0)
+      queue->cur_level.time = 0;
+
   } else if (GST_IS_EVENT (item)) {
     GstEvent *event = GST_EVENT_CAST (item);
 
@@ -815,7 +1253,10 @@ gst_queue_handle_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
         /* refuse more events on EOS */
         if (queue->eos)
           goto out_eos;
-        gst_queue_locked_enqueue_event (queue, event);
+        if (queue->using_lock_free)
+          gst_queue_lf_enqueue_event (queue, event);
+        else
+          gst_queue_locked_enqueue_event (queue, event);
         GST_QUEUE_MUTEX_UNLOCK (queue);
       } else {
         /* non-serialized events are forwarded downstream immediately */
@@ -861,7 +1302,10 @@ gst_queue_handle_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
         qitem = g_slice_new (GstQueueItem);
         qitem->item = GST_MINI_OBJECT_CAST (query);
         qitem->is_query = TRUE;
-        gst_queue_array_push_tail (queue->queue, qitem);
+        if (queue->using_lock_free)
+          gst_atomic_queue_push (queue->lf_queue, qitem);
+        else
+          gst_queue_array_push_tail (queue->queue, qitem);
         GST_QUEUE_SIGNAL_ADD (queue);
         g_cond_wait (&queue->query_handled, &queue->qlock);
         if (queue->srcresult != GST_FLOW_OK)
@@ -950,14 +1394,107 @@ gst_queue_leak_downstream (GstQueue * queue)
   }
 }
 
+static gboolean
+gst_queue_lf_is_filled (GstQueue * queue)
+{
+  return ((queue->max_size.buffers > 0 &&
+          (guint) g_atomic_int_get (&queue->cur_level.buffers) >=
+          queue->max_size.buffers) ||
+      (queue->max_size.bytes > 0 &&
+          (guint) g_atomic_int_get (&queue->cur_level.bytes) >=
+          queue->max_size.bytes) ||
+      (queue->max_size.time > 0 &&
+          gst_queue_lf_time_level (queue) >= queue->max_size.time));
+}
+
+/* wait until the srcpad thread made room in lock-free mode. Returns FALSE
+ * when we are flushing. */
+static gboolean
+gst_queue_lf_wait_del (GstQueue * queue)
+{
+  gboolean res;
+
+  GST_QUEUE_MUTEX_LOCK (queue);
+  while (queue->srcresult == GST_FLOW_OK && gst_queue_lf_is_filled (queue)) {
+    /* announce that we wait and check again, the other thread checks the
+     * flag after changing the queue */
+    g_atomic_int_set (&queue->waiting_del, TRUE);
+    if (!gst_queue_lf_is_filled (queue))
+      break;
+    STATUS (queue, queue->sinkpad, "wait for DEL");
+    g_cond_wait (&queue->item_del, &queue->qlock);
+  }
+  g_atomic_int_set (&queue->waiting_del, FALSE);
+  res = (queue->srcresult == GST_FLOW_OK);
+  GST_QUEUE_MUTEX_UNLOCK (queue);
+
+  return res;
+}
+
 static GstFlowReturn
-gst_queue_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+gst_queue_lf_chain (GstQueue * queue, GstMiniObject * obj, gboolean is_list)
+{
+  GstFlowReturn ret;
+
+  ret = (GstFlowReturn) g_atomic_int_get (&queue->srcresult);
+  if (G_UNLIKELY (ret != GST_FLOW_OK))
+    goto out_flushing;
+  /* eos is only changed from this thread */
+  if (G_UNLIKELY (queue->eos || g_atomic_int_get (&queue->unexpected)))
+    goto out_eos;
+
+  GST_CAT_LOG_OBJECT (queue_dataflow, queue, "received %s %p",
+      is_list ? "buffer list" : "buffer", obj);
+
+  if (G_UNLIKELY (gst_queue_lf_is_filled (queue))) {
+    if (!queue->silent)
+      g_signal_emit (queue, gst_queue_signals[SIGNAL_OVERRUN], 0);
+
+    GST_CAT_DEBUG_OBJECT (queue_dataflow, queue,
+        "queue is full, waiting for free space");
+    if (!gst_queue_lf_wait_del (queue)) {
+      ret = (GstFlowReturn) g_atomic_int_get (&queue->srcresult);
+      goto out_flushing;
+    }
+    GST_CAT_DEBUG_OBJECT (queue_dataflow, queue, "queue is not full");
+
+    if (!queue->silent)
+      g_signal_emit (queue, gst_queue_signals[SIGNAL_RUNNING], 0);
+  }
+
+  gst_queue_lf_enqueue_data (queue, obj, is_list);
+
+  return GST_FLOW_OK;
+
+  /* special conditions */
+out_flushing:
+  {
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+        "exit because task paused, reason: %s", gst_flow_get_name (ret));
+    gst_mini_object_unref (obj);
+
+    return ret;
+  }
+out_eos:
+  {
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue, "exit because we received EOS");
+    gst_mini_object_unref (obj);
+
+    return GST_FLOW_EOS;
+  }
+}
+
+static GstFlowReturn
+gst_queue_chain_buffer_or_list (GstPad * pad, GstObject * parent,
+    GstMiniObject * obj, gboolean is_list)
 {
   GstQueue *queue;
-  GstClockTime duration, timestamp;
 
   queue = GST_QUEUE_CAST (parent);
 
+  if (queue->using_lock_free)
+    return gst_queue_lf_chain (queue, obj, is_list);
+
   /* we have to lock the queue since we span threads */
   GST_QUEUE_MUTEX_LOCK_CHECK (queue, out_flushing);
   /* when we received EOS, we refuse any more data */
@@ -966,13 +1503,19 @@ gst_queue_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   if (queue->unexpected)
     goto out_unexpected;
 
-  timestamp = GST_BUFFER_TIMESTAMP (buffer);
-  duration = GST_BUFFER_DURATION (buffer);
+  if (!is_list) {
+    GstBuffer *buffer = GST_BUFFER_CAST (obj);
 
-  GST_CAT_LOG_OBJECT (queue_dataflow, queue, "received buffer %p of size %"
-      G_GSIZE_FORMAT ", time %" GST_TIME_FORMAT ", duration %"
-      GST_TIME_FORMAT, buffer, gst_buffer_get_size (buffer),
-      GST_TIME_ARGS (timestamp), GST_TIME_ARGS (duration));
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue, "received buffer %p of size %"
+        G_GSIZE_FORMAT ", time %" GST_TIME_FORMAT ", duration %"
+        GST_TIME_FORMAT, buffer, gst_buffer_get_size (buffer),
+        GST_TIME_ARGS (GST_BUFFER_TIMESTAMP (buffer)),
+        GST_TIME_ARGS (GST_BUFFER_DURATION (buffer)));
+  } else {
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+        "received buffer list %p with %u buffers", obj,
+        gst_buffer_list_length (GST_BUFFER_LIST_CAST (obj)));
+  }
 
   /* We make space available if we're "full" according to whatever
    * the user defined as "full". Note that this only applies to buffers.
@@ -1027,19 +1570,15 @@ gst_queue_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   }
 
   if (queue->tail_needs_discont) {
-    GstBuffer *subbuffer = gst_buffer_make_writable (buffer);
-
-    if (subbuffer) {
-      buffer = subbuffer;
-      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
-    } else {
-      GST_DEBUG_OBJECT (queue, "Could not mark buffer as DISCONT");
-    }
+    obj = gst_queue_mark_discont (queue, obj);
     queue->tail_needs_discont = FALSE;
   }
 
   /* put buffer in queue now */
-  gst_queue_locked_enqueue_buffer (queue, buffer);
+  if (is_list)
+    gst_queue_locked_enqueue_buffer_list (queue, obj);
+  else
+    gst_queue_locked_enqueue_buffer (queue, obj);
   GST_QUEUE_MUTEX_UNLOCK (queue);
 
   return GST_FLOW_OK;
@@ -1049,7 +1588,7 @@ out_unref:
   {
     GST_QUEUE_MUTEX_UNLOCK (queue);
 
-    gst_buffer_unref (buffer);
+    gst_mini_object_unref (obj);
 
     return GST_FLOW_OK;
   }
@@ -1060,7 +1599,7 @@ out_flushing:
     GST_CAT_LOG_OBJECT (queue_dataflow, queue,
         "exit because task paused, reason: %s", gst_flow_get_name (ret));
     GST_QUEUE_MUTEX_UNLOCK (queue);
-    gst_buffer_unref (buffer);
+    gst_mini_object_unref (obj);
 
     return ret;
   }
@@ -1069,7 +1608,7 @@ out_eos:
     GST_CAT_LOG_OBJECT (queue_dataflow, queue, "exit because we received EOS");
     GST_QUEUE_MUTEX_UNLOCK (queue);
 
-    gst_buffer_unref (buffer);
+    gst_mini_object_unref (obj);
 
     return GST_FLOW_EOS;
   }
@@ -1078,12 +1617,65 @@ out_unexpected:
     GST_CAT_LOG_OBJECT (queue_dataflow, queue, "exit because we received EOS");
     GST_QUEUE_MUTEX_UNLOCK (queue);
 
-    gst_buffer_unref (buffer);
+    gst_mini_object_unref (obj);
 
     return GST_FLOW_EOS;
   }
 }
 
+static GstFlowReturn
+gst_queue_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  return gst_queue_chain_buffer_or_list (pad, parent,
+      GST_MINI_OBJECT_CAST (buffer), FALSE);
+}
+
+static GstFlowReturn
+gst_queue_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * buffer_list)
+{
+  if (G_UNLIKELY (gst_buffer_list_length (buffer_list) == 0)) {
+    gst_buffer_list_unref (buffer_list);
+    return GST_FLOW_OK;
+  }
+
+  return gst_queue_chain_buffer_or_list (pad, parent,
+      GST_MINI_OBJECT_CAST (buffer_list), TRUE);
+}
+
+/* dequeue the buffers and buffer lists that follow data at the head of the
+ * queue and return them together with data as one buffer list. Events and
+ * queries end the batch so that they stay in order with the buffers. With
+ * QUEUE_LOCK */
+static GstMiniObject *
+gst_queue_locked_dequeue_batch (GstQueue * queue, GstMiniObject * data)
+{
+  GstBufferList *buffer_list;
+
+  if (!gst_queue_item_is_data (gst_queue_array_peek_head (queue->queue)))
+    return data;
+
+  buffer_list = gst_buffer_list_new ();
+  gst_queue_list_append (buffer_list, data);
+  do {
+    gst_queue_list_append (buffer_list, gst_queue_locked_dequeue (queue));
+  } while (gst_queue_item_is_data (gst_queue_array_peek_head (queue->queue)));
+
+  GST_CAT_LOG_OBJECT (queue_dataflow, queue, "batched %u buffers",
+      gst_buffer_list_length (buffer_list));
+
+  return GST_MINI_OBJECT_CAST (buffer_list);
+}
+
+static inline GstFlowReturn
+gst_queue_push_data (GstQueue * queue, GstMiniObject * data)
+{
+  if (GST_IS_BUFFER_LIST (data))
+    return gst_pad_push_list (queue->srcpad, GST_BUFFER_LIST_CAST (data));
+
+  return gst_pad_push (queue->srcpad, GST_BUFFER_CAST (data));
+}
+
 /* dequeue an item from the queue an push it downstream. This functions returns
  * the result of the push. */
 static GstFlowReturn
@@ -1097,25 +1689,17 @@ gst_queue_push_one (GstQueue * queue)
     goto no_item;
 
 next:
-  if (GST_IS_BUFFER (data)) {
-    GstBuffer *buffer;
-
-    buffer = GST_BUFFER_CAST (data);
+  if (GST_IS_BUFFER (data) || GST_IS_BUFFER_LIST (data)) {
+    if (queue->push_lists)
+      data = gst_queue_locked_dequeue_batch (queue, data);
 
     if (queue->head_needs_discont) {
-      GstBuffer *subbuffer = gst_buffer_make_writable (buffer);
-
-      if (subbuffer) {
-        buffer = subbuffer;
-        GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
-      } else {
-        GST_DEBUG_OBJECT (queue, "Could not mark buffer as DISCONT");
-      }
+      data = gst_queue_mark_discont (queue, data);
       queue->head_needs_discont = FALSE;
     }
 
     GST_QUEUE_MUTEX_UNLOCK (queue);
-    result = gst_pad_push (queue->srcpad, buffer);
+    result = gst_queue_push_data (queue, data);
 
     /* need to check for srcresult here as well */
     GST_QUEUE_MUTEX_LOCK_CHECK (queue, out_flushing);
@@ -1127,10 +1711,10 @@ next:
        * queue we can push, we set a flag to make the sinkpad refuse more
        * buffers with an EOS return value. */
       while ((data = gst_queue_locked_dequeue (queue))) {
-        if (GST_IS_BUFFER (data)) {
+        if (GST_IS_BUFFER (data) || GST_IS_BUFFER_LIST (data)) {
           GST_CAT_LOG_OBJECT (queue_dataflow, queue,
               "dropping EOS buffer %p", data);
-          gst_buffer_unref (GST_BUFFER_CAST (data));
+          gst_mini_object_unref (data);
         } else if (GST_IS_EVENT (data)) {
           GstEvent *event = GST_EVENT_CAST (data);
           GstEventType type = GST_EVENT_TYPE (event);
@@ -1211,6 +1795,239 @@ out_flushing_query:
   }
 }
 
+/* pause the task after srcresult was set to an error, with QUEUE_LOCK. The
+ * lock is released. */
+static void
+gst_queue_locked_pause (GstQueue * queue)
+{
+  gboolean eos = queue->eos;
+  GstFlowReturn ret = queue->srcresult;
+
+  gst_pad_pause_task (queue->srcpad);
+  GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+      "pause task, reason:  %s", gst_flow_get_name (ret));
+  if (ret == GST_FLOW_FLUSHING) {
+    /* in lock-free mode the sinkpad thread doesn't take the lock, only drop
+     * the items, the rest is reset on FLUSH_STOP */
+    if (queue->using_lock_free)
+      gst_queue_lf_drain (queue, FALSE);
+    else
+      gst_queue_locked_flush (queue, FALSE);
+  } else {
+    GST_QUEUE_SIGNAL_DEL (queue);
+  }
+  GST_QUEUE_MUTEX_UNLOCK (queue);
+  /* let app know about us giving up if upstream is not expected to do so */
+  /* EOS is already taken care of elsewhere */
+  if (eos && (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS)) {
+    GST_ELEMENT_ERROR (queue, STREAM, FAILED,
+        (_("Internal data flow error.")),
+        ("streaming task paused, reason %s (%d)",
+            gst_flow_get_name (ret), ret));
+    gst_pad_push_event (queue->srcpad, gst_event_new_eos ());
+  }
+}
+
+/* get the next item in lock-free mode. When the queue is empty, poll it for
+ * a while before going to sleep: waking up a sleeping thread is much more
+ * expensive than a few checks when data arrives at a high rate. The amount
+ * of polling adapts to how often it was successful. Returns NULL when
+ * flushing. */
+static GstQueueItem *
+gst_queue_lf_pop (GstQueue * queue)
+{
+  GstQueueItem *qitem;
+  gint i;
+
+  if (G_UNLIKELY (g_atomic_int_get (&queue->srcresult) != GST_FLOW_OK))
+    return NULL;
+
+  if (G_LIKELY ((qitem = gst_atomic_queue_pop (queue->lf_queue))))
+    return qitem;
+
+  for (i = 0; i < queue->spin_limit; i++) {
+    if (gst_atomic_queue_length (queue->lf_queue) > 0 &&
+        (qitem = gst_atomic_queue_pop (queue->lf_queue))) {
+      queue->spin_limit = MIN (queue->spin_limit * 2, LF_SPIN_MAX);
+      return qitem;
+    }
+  }
+  if (queue->spin_limit > 0)
+    queue->spin_limit = MAX (queue->spin_limit / 2, LF_SPIN_MIN);
+
+  GST_CAT_DEBUG_OBJECT (queue_dataflow, queue, "queue is empty");
+  if (!queue->silent)
+    g_signal_emit (queue, gst_queue_signals[SIGNAL_UNDERRUN], 0);
+
+  GST_QUEUE_MUTEX_LOCK (queue);
+  while (queue->srcresult == GST_FLOW_OK) {
+    if ((qitem = gst_atomic_queue_pop (queue->lf_queue)))
+      break;
+    /* announce that we wait and check again, the other thread checks the
+     * flag after changing the queue */
+    g_atomic_int_set (&queue->waiting_add, TRUE);
+    if ((qitem = gst_atomic_queue_pop (queue->lf_queue)))
+      break;
+    STATUS (queue, queue->srcpad, "wait for ADD");
+    g_cond_wait (&queue->item_add, &queue->qlock);
+  }
+  g_atomic_int_set (&queue->waiting_add, FALSE);
+  GST_QUEUE_MUTEX_UNLOCK (queue);
+
+  if (qitem) {
+    GST_CAT_DEBUG_OBJECT (queue_dataflow, queue, "queue is not empty");
+    if (!queue->silent) {
+      g_signal_emit (queue, gst_queue_signals[SIGNAL_RUNNING], 0);
+      g_signal_emit (queue, gst_queue_signals[SIGNAL_PUSHING], 0);
+    }
+  }
+  return qitem;
+}
+
+/* like gst_queue_locked_dequeue_batch() in lock-free mode. Only the items
+ * that are queued now are taken so that a fast upstream can't keep us from
+ * pushing. */
+static GstMiniObject *
+gst_queue_lf_dequeue_batch (GstQueue * queue, GstMiniObject * data)
+{
+  GstBufferList *buffer_list;
+  GstQueueItem *qitem;
+  guint n_items;
+
+  /* we are the only consumer, the peeked item stays at the head */
+  qitem = gst_atomic_queue_peek (queue->lf_queue);
+  if (!gst_queue_item_is_data (qitem))
+    return data;
+
+  n_items = gst_atomic_queue_length (queue->lf_queue);
+  buffer_list = gst_buffer_list_new_sized (n_items + 1);
+  gst_queue_list_append (buffer_list, data);
+  do {
+    gst_atomic_queue_pop (queue->lf_queue);
+    gst_queue_list_append (buffer_list, gst_queue_lf_dequeue (queue, qitem));
+  } while (--n_items > 0 &&
+      gst_queue_item_is_data ((qitem =
+              gst_atomic_queue_peek (queue->lf_queue))));
+
+  GST_CAT_LOG_OBJECT (queue_dataflow, queue, "batched %u buffers",
+      gst_buffer_list_length (buffer_list));
+
+  return GST_MINI_OBJECT_CAST (buffer_list);
+}
+
+/* push an item downstream in lock-free mode, see gst_queue_push_one() */
+static GstFlowReturn
+gst_queue_lf_push_one (GstQueue * queue, GstQueueItem * qitem)
+{
+  GstFlowReturn result = GST_FLOW_OK;
+  GstMiniObject *data;
+
+  data = gst_queue_lf_dequeue (queue, qitem);
+  if (queue->push_lists && (GST_IS_BUFFER (data) || GST_IS_BUFFER_LIST (data)))
+    data = gst_queue_lf_dequeue_batch (queue, data);
+  gst_queue_lf_signal (queue, &queue->waiting_del, &queue->item_del);
+
+next:
+  if (GST_IS_BUFFER (data) || GST_IS_BUFFER_LIST (data)) {
+    result = gst_queue_push_data (queue, data);
+
+    if (result == GST_FLOW_EOS) {
+      GST_CAT_LOG_OBJECT (queue_dataflow, queue, "got EOS from downstream");
+      /* drop everything until EOS or SEGMENT. Take the lock so that no
+       * SEGMENT can be queued between checking for it and setting the
+       * unexpected flag */
+      GST_QUEUE_MUTEX_LOCK (queue);
+      while ((qitem = gst_atomic_queue_pop (queue->lf_queue))) {
+        data = gst_queue_lf_dequeue (queue, qitem);
+
+        if (GST_IS_BUFFER (data) || GST_IS_BUFFER_LIST (data)) {
+          GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+              "dropping EOS buffer %p", data);
+          gst_mini_object_unref (data);
+        } else if (GST_IS_EVENT (data)) {
+          GstEvent *event = GST_EVENT_CAST (data);
+          GstEventType type = GST_EVENT_TYPE (event);
+
+          if (type == GST_EVENT_EOS || type == GST_EVENT_SEGMENT) {
+            GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+                "pushing pushable event %s after EOS",
+                GST_EVENT_TYPE_NAME (event));
+            GST_QUEUE_SIGNAL_DEL (queue);
+            GST_QUEUE_MUTEX_UNLOCK (queue);
+            goto next;
+          }
+          GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+              "dropping EOS event %p", event);
+          gst_event_unref (event);
+        } else if (GST_IS_QUERY (data)) {
+          GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+              "dropping query %p because of EOS", data);
+          queue->last_query = FALSE;
+          g_cond_signal (&queue->query_handled);
+        }
+      }
+      queue->unexpected = TRUE;
+      GST_QUEUE_SIGNAL_DEL (queue);
+      GST_QUEUE_MUTEX_UNLOCK (queue);
+      result = GST_FLOW_OK;
+    }
+  } else if (GST_IS_EVENT (data)) {
+    GstEvent *event = GST_EVENT_CAST (data);
+    GstEventType type = GST_EVENT_TYPE (event);
+
+    gst_pad_push_event (queue->srcpad, event);
+
+    /* if we're EOS, return EOS so that the task pauses. */
+    if (type == GST_EVENT_EOS) {
+      GST_CAT_LOG_OBJECT (queue_dataflow, queue,
+          "pushed EOS event %p, return EOS", event);
+      result = GST_FLOW_EOS;
+    }
+  } else if (GST_IS_QUERY (data)) {
+    GstQuery *query = GST_QUERY_CAST (data);
+    gboolean ret;
+
+    ret = gst_pad_peer_query (queue->srcpad, query);
+    GST_QUEUE_MUTEX_LOCK (queue);
+    queue->last_query = (queue->srcresult == GST_FLOW_OK) ? ret : FALSE;
+    g_cond_signal (&queue->query_handled);
+    GST_QUEUE_MUTEX_UNLOCK (queue);
+    GST_CAT_LOG_OBJECT (queue_dataflow, queue, "did query %p, return %d",
+        query, ret);
+  }
+  return result;
+}
+
+static void
+gst_queue_lf_loop (GstQueue * queue)
+{
+  GstQueueItem *qitem;
+  GstFlowReturn ret;
+
+  qitem = gst_queue_lf_pop (queue);
+  if (G_UNLIKELY (qitem == NULL))
+    goto out_flushing;
+
+  ret = gst_queue_lf_push_one (queue, qitem);
+  if (G_LIKELY (ret == GST_FLOW_OK))
+    return;
+
+  GST_QUEUE_MUTEX_LOCK (queue);
+  /* keep the flushing state if we got flushed while pushing */
+  if (queue->srcresult == GST_FLOW_OK)
+    queue->srcresult = ret;
+  gst_queue_locked_pause (queue);
+  return;
+
+  /* ERRORS */
+out_flushing:
+  {
+    GST_QUEUE_MUTEX_LOCK (queue);
+    gst_queue_locked_pause (queue);
+    return;
+  }
+}
+
 static void
 gst_queue_loop (GstPad * pad)
 {
@@ -1219,6 +2036,11 @@ gst_queue_loop (GstPad * pad)
 
   queue = (GstQueue *) GST_PAD_PARENT (pad);
 
+  if (queue->using_lock_free) {
+    gst_queue_lf_loop (queue);
+    return;
+  }
+
   /* have to lock for thread-safety */
   GST_QUEUE_MUTEX_LOCK_CHECK (queue, out_flushing);
 
@@ -1256,26 +2078,7 @@ gst_queue_loop (GstPad * pad)
   /* ERRORS */
 out_flushing:
   {
-    gboolean eos = queue->eos;
-    GstFlowReturn ret = queue->srcresult;
-
-    gst_pad_pause_task (queue->srcpad);
-    GST_CAT_LOG_OBJECT (queue_dataflow, queue,
-        "pause task, reason:  %s", gst_flow_get_name (ret));
-    if (ret == GST_FLOW_FLUSHING)
-      gst_queue_locked_flush (queue, FALSE);
-    else
-      GST_QUEUE_SIGNAL_DEL (queue);
-    GST_QUEUE_MUTEX_UNLOCK (queue);
-    /* let app know about us giving up if upstream is not expected to do so */
-    /* EOS is already taken care of elsewhere */
-    if (eos && (ret == GST_FLOW_NOT_LINKED || ret < GST_FLOW_EOS)) {
-      GST_ELEMENT_ERROR (queue, STREAM, FAILED,
-          (_("Internal data flow error.")),
-          ("streaming task paused, reason %s (%d)",
-              gst_flow_get_name (ret), ret));
-      gst_pad_push_event (queue->srcpad, gst_event_new_eos ());
-    }
+    gst_queue_locked_pause (queue);
     return;
   }
 }
@@ -1339,17 +2142,19 @@ gst_queue_handle_src_query (GstPad * pad, GstObject * parent, GstQuery * query)
     {
       gint64 peer_pos;
       GstFormat format;
+      GstQueueSize level;
 
       /* get peer position */
       gst_query_parse_position (query, &format, &peer_pos);
+      gst_queue_get_level (queue, &level);
 
       /* FIXME: this code assumes that there's no discont in the queue */
       switch (format) {
         case GST_FORMAT_BYTES:
-          peer_pos -= queue->cur_level.bytes;
+          peer_pos -= level.bytes;
           break;
         case GST_FORMAT_TIME:
-          peer_pos -= queue->cur_level.time;
+          peer_pos -= level.time;
           break;
         default:
           GST_DEBUG_OBJECT (queue, "Can't adjust query in %s format, don't "
@@ -1435,6 +2240,33 @@ gst_queue_sink_activate_mode (GstPad * pad, GstObject * parent, GstPadMode mode,
   return result;
 }
 
+/* decide if we can use lock-free mode, called with QUEUE_LOCK when the queue
+ * is empty and not running */
+static void
+gst_queue_locked_configure_lock_free (GstQueue * queue)
+{
+  queue->using_lock_free = queue->lock_free &&
+      queue->leaky == GST_QUEUE_NO_LEAK && !queue->flush_on_eos &&
+      queue->min_threshold.buffers == 0 && queue->min_threshold.bytes == 0 &&
+      queue->min_threshold.time == 0;
+
+  if (queue->using_lock_free) {
+    if (queue->lf_queue == NULL)
+      queue->lf_queue = gst_atomic_queue_new (DEFAULT_MAX_SIZE_BUFFERS * 3 / 2);
+
+    /* polling only helps when the other thread can run at the same time */
+#if GLIB_CHECK_VERSION(2,36,0)
+    queue->spin_limit = g_get_num_processors () > 1 ? LF_SPIN_MIN : 0;
+#else
+    queue->spin_limit = LF_SPIN_MIN;
+#endif
+  } else if (queue->lock_free) {
+    GST_WARNING_OBJECT (queue, "lock-free mode can't be used with leaky, "
+        "flush-on-eos or min-threshold properties");
+  }
+  GST_DEBUG_OBJECT (queue, "using lock-free mode: %d", queue->using_lock_free);
+}
+
 static gboolean
 gst_queue_src_activate_mode (GstPad * pad, GstObject * parent, GstPadMode mode,
     gboolean active)
@@ -1451,6 +2283,7 @@ gst_queue_src_activate_mode (GstPad * pad, GstObject * parent, GstPadMode mode,
         queue->srcresult = GST_FLOW_OK;
         queue->eos = FALSE;
         queue->unexpected = FALSE;
+        gst_queue_locked_configure_lock_free (queue);
         result =
             gst_pad_start_task (pad, (GstTaskFunction) gst_queue_loop, pad,
             NULL);
@@ -1477,7 +2310,7 @@ gst_queue_src_activate_mode (GstPad * pad, GstObject * parent, GstPadMode mode,
 static void
 queue_capacity_change (GstQueue * queue)
 {
-  if (queue->leaky == GST_QUEUE_LEAK_DOWNSTREAM) {
+  if (queue->leaky == GST_QUEUE_LEAK_DOWNSTREAM && !queue->using_lock_free) {
     gst_queue_leak_downstream (queue);
   }
 
@@ -1541,6 +2374,12 @@ gst_queue_set_property (GObject * object,
     case PROP_FLUSH_ON_EOS:
       queue->flush_on_eos = g_value_get_boolean (value);
       break;
+    case PROP_LOCK_FREE:
+      queue->lock_free = g_value_get_boolean (value);
+      break;
+    case PROP_PUSH_LISTS:
+      queue->push_lists = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1554,18 +2393,21 @@ gst_queue_get_property (GObject * object,
     guint prop_id, GValue * value, GParamSpec * pspec)
 {
   GstQueue *queue = GST_QUEUE (object);
+  GstQueueSize level;
 
   GST_QUEUE_MUTEX_LOCK (queue);
 
+  gst_queue_get_level (queue, &level);
+
   switch (prop_id) {
     case PROP_CUR_LEVEL_BYTES:
-      g_value_set_uint (value, queue->cur_level.bytes);
+      g_value_set_uint (value, level.bytes);
       break;
     case PROP_CUR_LEVEL_BUFFERS:
-      g_value_set_uint (value, queue->cur_level.buffers);
+      g_value_set_uint (value, level.buffers);
       break;
     case PROP_CUR_LEVEL_TIME:
-      g_value_set_uint64 (value, queue->cur_level.time);
+      g_value_set_uint64 (value, level.time);
       break;
     case PROP_MAX_SIZE_BYTES:
       g_value_set_uint (value, queue->max_size.bytes);
@@ -1594,6 +2436,12 @@ gst_queue_get_property (GObject * object,
     case PROP_FLUSH_ON_EOS:
       g_value_set_boolean (value, queue->flush_on_eos);
       break;
+    case PROP_LOCK_FREE:
+      g_value_set_boolean (value, queue->lock_free);
+      break;
+    case PROP_PUSH_LISTS:
+      g_value_set_boolean (value, queue->push_lists);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -25,6 +25,7 @@
 #define __GST_QUEUE_H__
 
 #include <gst/gst.h>
+#include <gst/gstatomicqueue.h>
 #include <gst/base/gstqueuearray.h>
 
 G_BEGIN_DECLS
@@ -137,6 +138,18 @@ struct _GstQueue {
   gboolean last_query;
 
   gboolean flush_on_eos; /* flush on EOS */
+
+  /* lock-free mode: buffers are passed through lf_queue without taking
+   * qlock, levels are updated atomically and the running times of both
+   * sides are protected with the sink_seq/src_seq sequence counters */
+  gboolean lock_free;
+  gboolean using_lock_free;
+  GstAtomicQueue *lf_queue;
+  gint sink_seq, src_seq;
+  gint spin_limit;      /* adaptive spin count of the srcpad thread */
+
+  /* push all queued buffers downstream as one buffer list */
+  gboolean push_lists;
 };
 
 struct _GstQueueClass {
@@ -49,6 +49,12 @@
  * The temp-location property will be used to notify the application of the
  * allocated filename.
  *
+ * When buffering in a temp file without #GstQueue2:ring-buffer-max-size, and
+ * mmap() is available, data is read back by mapping windows of the file and
+ * pushed downstream in buffers pointing directly into the mapping, instead of
+ * being copied out of the file. Such buffers contain read-only memory that
+ * keeps the mapping alive until they are freed.
+ *
  * Last reviewed on 2009-07-10 (0.10.24)
  */
 
@@ -64,6 +70,8 @@
 #include "gst/glib-compat-private.h"
 
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
 
 #ifdef G_OS_WIN32
 #include <io.h>                 /* lseek, open, close, read */
@@ -75,6 +83,10 @@
 #include <unistd.h>
 #endif
 
+#ifndef O_BINARY
+#define O_BINARY (0)
+#endif
+
 static GstStaticPadTemplate sinktemplate = GST_STATIC_PAD_TEMPLATE ("sink",
     GST_PAD_SINK,
     GST_PAD_ALWAYS,
@@ -96,9 +108,14 @@ enum
 
 /* other defines */
 #define DEFAULT_BUFFER_SIZE 4096
+/* size of the windows of the temp file that are mapped for reading, a
+ * multiple of the page size */
+#define MMAP_WINDOW_SIZE (4 * 1024 * 1024)
 #define QUEUE_IS_USING_TEMP_FILE(queue) ((queue)->temp_template != NULL)
 #define QUEUE_IS_USING_RING_BUFFER(queue) ((queue)->ring_buffer_max_size != 0)  /* for consistency with the above macro */
 #define QUEUE_IS_USING_QUEUE(queue) (!QUEUE_IS_USING_TEMP_FILE(queue) && !QUEUE_IS_USING_RING_BUFFER (queue))
+/* data in a ring buffer file gets overwritten, so it can't be handed out */
+#define QUEUE_IS_USING_MMAP(queue) ((queue)->using_mmap && !QUEUE_IS_USING_RING_BUFFER (queue))
 
 #define QUEUE_MAX_BYTES(queue) MIN((queue)->max_level.bytes, (queue)->ring_buffer_max_size)
 
@@ -457,6 +474,10 @@ gst_queue2_init (GstQueue2 * queue)
   queue->temp_template = NULL;
   queue->temp_location = NULL;
   queue->temp_remove = DEFAULT_TEMP_REMOVE;
+  queue->temp_fd = -1;
+  queue->using_mmap = FALSE;
+  queue->mmap_allocator = NULL;
+  queue->mapping = NULL;
 
   queue->ring_buffer = NULL;
   queue->ring_buffer_max_size = DEFAULT_RING_BUFFER_MAX_SIZE;
@@ -493,6 +514,8 @@ gst_queue2_finalize (GObject * object)
   /* temp_file path cleanup  */
   g_free (queue->temp_template);
   g_free (queue->temp_location);
+  if (queue->mmap_allocator)
+    gst_object_unref (queue->mmap_allocator);
 
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -1149,57 +1172,90 @@ gst_queue2_have_data (GstQueue2 * queue, guint64 offset, guint length)
   return FALSE;
 }
 
-#ifdef HAVE_FSEEKO
-#define FSEEK_FILE(file,offset)  (fseeko (file, (off_t) offset, SEEK_SET) != 0)
-#elif defined (G_OS_UNIX) || defined (G_OS_WIN32)
-#define FSEEK_FILE(file,offset)  (lseek (fileno (file), (off_t) offset, SEEK_SET) == (off_t) -1)
+/* read up to @length bytes at @offset of the temp file, returns the number of
+ * bytes read, 0 at the end of the file or -1 on error */
+static gssize
+gst_queue2_pread (GstQueue2 * queue, guint8 * data, gsize length,
+    guint64 offset)
+{
+  gssize res;
+
+#ifdef HAVE_PREAD
+  do {
+    res = pread (queue->temp_fd, data, length, (off_t) offset);
+  } while (res < 0 && errno == EINTR);
+#else
+  if (lseek (queue->temp_fd, (off_t) offset, SEEK_SET) == (off_t) - 1)
+    return -1;
+
+  do {
+    res = read (queue->temp_fd, data, length);
+  } while (res < 0 && errno == EINTR);
+#endif
+
+  return res;
+}
+
+/* write all @length bytes at @offset of the temp file */
+static gboolean
+gst_queue2_pwrite (GstQueue2 * queue, const guint8 * data, gsize length,
+    guint64 offset)
+{
+#ifndef HAVE_PWRITE
+  if (lseek (queue->temp_fd, (off_t) offset, SEEK_SET) == (off_t) - 1)
+    return FALSE;
+#endif
+
+  while (length > 0) {
+    gssize res;
+
+#ifdef HAVE_PWRITE
+    res = pwrite (queue->temp_fd, data, length, (off_t) offset);
 #else
-#define FSEEK_FILE(file,offset)  (fseek (file, offset, SEEK_SET) != 0)
+    res = write (queue->temp_fd, data, length);
 #endif
+    if (res < 0 && errno == EINTR)
+      continue;
+    if (res <= 0)
+      return FALSE;
+
+    data += res;
+    length -= res;
+    offset += res;
+  }
+  return TRUE;
+}
 
 static GstFlowReturn
 gst_queue2_read_data_at_offset (GstQueue2 * queue, guint64 offset, guint length,
     guint8 * dst, gint64 * read_return)
 {
   guint8 *ring_buffer;
-  size_t res;
+  gssize res;
 
   ring_buffer = queue->ring_buffer;
 
-  if (QUEUE_IS_USING_TEMP_FILE (queue) && FSEEK_FILE (queue->temp_file, offset))
-    goto seek_failed;
-
   /* this should not block */
   GST_LOG_OBJECT (queue, "Reading %d bytes from offset %" G_GUINT64_FORMAT,
       length, offset);
   if (QUEUE_IS_USING_TEMP_FILE (queue)) {
-    res = fread (dst, 1, length, queue->temp_file);
+    res = gst_queue2_pread (queue, dst, length, offset);
   } else {
     memcpy (dst, ring_buffer + offset, length);
     res = length;
   }
 
-  GST_LOG_OBJECT (queue, "read %" G_GSIZE_FORMAT " bytes", res);
+  GST_LOG_OBJECT (queue, "read %" G_GSSIZE_FORMAT " bytes", res);
 
-  if (G_UNLIKELY (res < length)) {
-    if (!QUEUE_IS_USING_TEMP_FILE (queue))
-      goto could_not_read;
-    /* check for errors or EOF */
-    if (ferror (queue->temp_file))
-      goto could_not_read;
-    if (feof (queue->temp_file) && length > 0)
-      goto eos;
-  }
+  if (G_UNLIKELY (res < 0))
+    goto could_not_read;
+  if (G_UNLIKELY (res == 0 && length > 0))
+    goto eos;
 
   *read_return = res;
 
   return GST_FLOW_OK;
 
-seek_failed:
-  {
-    GST_ELEMENT_ERROR (queue, RESOURCE, SEEK, (NULL), GST_ERROR_SYSTEM);
-    return GST_FLOW_ERROR;
-  }
 could_not_read:
   {
     GST_ELEMENT_ERROR (queue, RESOURCE, READ, (NULL), GST_ERROR_SYSTEM);
@@ -1212,6 +1268,116 @@ eos:
   }
 }
 
+#ifdef HAVE_MMAP
+/*** MMAP ********************************************************************/
+
+/* map the window of the temp file around @offset. The window may extend past
+ * the end of the file, the writer fills it up as the download progresses and
+ * we only ever hand out the parts that were written already */
+static GstFileMapping *
+gst_queue2_map_window (GstQueue2 * queue, guint64 offset)
+{
+  GstFileMapping *mapping;
+  guint64 start;
+
+  start = offset - (offset % MMAP_WINDOW_SIZE);
+
+  GST_LOG_OBJECT (queue, "mapping window at offset %" G_GUINT64_FORMAT
+      ", size %d", start, MMAP_WINDOW_SIZE);
+
+  /* the temp file is never truncated while it is mapped, see
+   * gst_queue2_flush_temp_file() */
+  mapping = gst_file_mapping_new (queue->temp_fd, start, MMAP_WINDOW_SIZE);
+  if (mapping == NULL)
+    goto mmap_failed;
+
+  return mapping;
+
+  /* ERRORS */
+mmap_failed:
+  {
+    GST_WARNING_OBJECT (queue, "mmap failed: %s", g_strerror (errno));
+    return NULL;
+  }
+}
+
+/* append up to @length bytes at @offset of the temp file to @buf as memory
+ * pointing into the mapped file. Falls back to reading a copy of the data
+ * when the file can't be mapped. */
+static GstFlowReturn
+gst_queue2_map_data_at_offset (GstQueue2 * queue, guint64 offset,
+    guint length, GstBuffer * buf, gint64 * read_return)
+{
+  GstFileMapping *mapping;
+  GstMemory *mem;
+
+  mapping = queue->mapping;
+
+  if (mapping == NULL || offset < mapping->offset
+      || offset >= mapping->offset + mapping->size) {
+    /* not in the current window, map a new one. Buffers pushed before keep
+     * the old mapping alive as long as they need it */
+    if (mapping)
+      gst_file_mapping_unref (mapping);
+
+    queue->mapping = mapping = gst_queue2_map_window (queue, offset);
+
+    if (mapping == NULL)
+      goto fallback;
+  }
+
+  /* the rest is read from the next window */
+  length = MIN (length, mapping->offset + mapping->size - offset);
+
+  GST_LOG_OBJECT (queue, "wrapping %u bytes at offset %" G_GUINT64_FORMAT
+      " from mapping %p", length, offset, mapping->data);
+
+  mem = gst_file_mmap_memory_new (queue->mmap_allocator, mapping,
+      offset - mapping->offset, length);
+  gst_buffer_append_memory (buf, mem);
+
+  *read_return = length;
+
+  return GST_FLOW_OK;
+
+fallback:
+  {
+    GstMemory *copy;
+    GstMapInfo info;
+    GstFlowReturn ret;
+
+    GST_WARNING_OBJECT (queue, "falling back to read()");
+    queue->using_mmap = FALSE;
+
+    copy = gst_allocator_alloc (NULL, length, NULL);
+    gst_memory_map (copy, &info, GST_MAP_WRITE);
+    ret =
+        gst_queue2_read_data_at_offset (queue, offset, length, info.data,
+        read_return);
+    gst_memory_unmap (copy, &info);
+
+    if (ret == GST_FLOW_OK) {
+      gst_memory_resize (copy, 0, *read_return);
+      gst_buffer_append_memory (buf, copy);
+    } else {
+      gst_memory_unref (copy);
+    }
+    return ret;
+  }
+}
+
+static void
+gst_queue2_drop_mapping (GstQueue2 * queue)
+{
+  if (queue->mapping) {
+    gst_file_mapping_unref (queue->mapping);
+    queue->mapping = NULL;
+  }
+}
+#else
+#define gst_queue2_drop_mapping(queue)
+#endif
+
 static GstFlowReturn
 gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
     GstBuffer ** buffer)
@@ -1224,16 +1390,26 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
   guint64 rb_size;
   guint64 max_size;
   guint64 rpos;
+  gboolean use_mmap;
   GstFlowReturn ret = GST_FLOW_OK;
 
-  /* allocate the output buffer of the requested size */
-  if (*buffer == NULL)
+  /* when we can't fill a buffer we got passed, we either map the data or
+   * read it into a new buffer of the requested size */
+  use_mmap = (*buffer == NULL && QUEUE_IS_USING_MMAP (queue));
+
+  if (use_mmap)
+    buf = gst_buffer_new ();
+  else if (*buffer == NULL)
     buf = gst_buffer_new_allocate (NULL, length, NULL);
   else
     buf = *buffer;
 
-  gst_buffer_map (buf, &info, GST_MAP_WRITE);
-  data = info.data;
+  if (!use_mmap) {
+    gst_buffer_map (buf, &info, GST_MAP_WRITE);
+    data = info.data;
+  } else {
+    data = NULL;
+  }
 
   GST_DEBUG_OBJECT (queue, "Reading %u bytes from %" G_GUINT64_FORMAT, length,
       offset);
@@ -1326,9 +1502,16 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
     while (read_length > 0) {
       gint64 read_return;
 
-      ret =
-          gst_queue2_read_data_at_offset (queue, file_offset, block_length,
-          data, &read_return);
+#ifdef HAVE_MMAP
+      if (use_mmap)
+        ret =
+            gst_queue2_map_data_at_offset (queue, file_offset, block_length,
+            buf, &read_return);
+      else
+#endif
+        ret =
+            gst_queue2_read_data_at_offset (queue, file_offset, block_length,
+            data, &read_return);
       if (ret != GST_FLOW_OK)
         goto read_error;
 
@@ -1336,7 +1519,8 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
       if (QUEUE_IS_USING_RING_BUFFER (queue))
         file_offset %= rb_size;
 
-      data += read_return;
+      if (!use_mmap)
+        data += read_return;
       read_length -= read_return;
       block_length = read_length;
       remaining -= read_return;
@@ -1348,7 +1532,8 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
     GST_DEBUG_OBJECT (queue, "%u bytes left to read", remaining);
   }
 
-  gst_buffer_unmap (buf, &info);
+  if (!use_mmap)
+    gst_buffer_unmap (buf, &info);
   gst_buffer_resize (buf, 0, length);
 
   GST_BUFFER_OFFSET (buf) = offset;
@@ -1362,7 +1547,8 @@ gst_queue2_create_read (GstQueue2 * queue, guint64 offset, guint length,
 hit_eos:
   {
     GST_DEBUG_OBJECT (queue, "EOS hit and we don't have any requested data");
-    gst_buffer_unmap (buf, &info);
+    if (!use_mmap)
+      gst_buffer_unmap (buf, &info);
     if (*buffer == NULL)
       gst_buffer_unref (buf);
     return GST_FLOW_EOS;
@@ -1370,7 +1556,8 @@ hit_eos:
 out_flushing:
   {
     GST_DEBUG_OBJECT (queue, "we are flushing");
-    gst_buffer_unmap (buf, &info);
+    if (!use_mmap)
+      gst_buffer_unmap (buf, &info);
     if (*buffer == NULL)
       gst_buffer_unref (buf);
     return GST_FLOW_FLUSHING;
@@ -1378,7 +1565,8 @@ out_flushing:
 read_error:
   {
     GST_DEBUG_OBJECT (queue, "we have a read error");
-    gst_buffer_unmap (buf, &info);
+    if (!use_mmap)
+      gst_buffer_unmap (buf, &info);
     if (*buffer == NULL)
       gst_buffer_unref (buf);
     return ret;
@@ -1431,7 +1619,7 @@ gst_queue2_open_temp_location_file (GstQueue2 * queue)
   gint fd = -1;
   gchar *name = NULL;
 
-  if (queue->temp_file)
+  if (queue->temp_fd != -1)
     goto already_opened;
 
   GST_DEBUG_OBJECT (queue, "opening temp file %s", queue->temp_template);
@@ -1448,15 +1636,18 @@ gst_queue2_open_temp_location_file (GstQueue2 * queue)
   if (fd == -1)
     goto mkstemp_failed;
 
-  /* open the file for update/writing */
-  queue->temp_file = fdopen (fd, "wb+");
-  /* error creating file */
-  if (queue->temp_file == NULL)
-    goto open_failed;
+  /* the file is opened for update/writing */
+  queue->temp_fd = fd;
 
   g_free (queue->temp_location);
   queue->temp_location = name;
 
+#ifdef HAVE_MMAP
+  if (queue->mmap_allocator == NULL)
+    queue->mmap_allocator = gst_file_mmap_allocator_new ();
+  queue->using_mmap = TRUE;
+#endif
+
   GST_QUEUE2_MUTEX_UNLOCK (queue);
 
   /* we can't emit the notify with the lock */
@@ -1488,45 +1679,60 @@ mkstemp_failed:
     g_free (name);
     return FALSE;
   }
-open_failed:
-  {
-    GST_ELEMENT_ERROR (queue, RESOURCE, OPEN_READ,
-        (_("Could not open file \"%s\" for reading."), name), GST_ERROR_SYSTEM);
-    g_free (name);
-    if (fd != -1)
-      close (fd);
-    return FALSE;
-  }
 }
 
 static void
 gst_queue2_close_temp_location_file (GstQueue2 * queue)
 {
   /* nothing to do */
-  if (queue->temp_file == NULL)
+  if (queue->temp_fd == -1)
     return;
 
   GST_DEBUG_OBJECT (queue, "closing temp file");
 
-  fflush (queue->temp_file);
-  fclose (queue->temp_file);
+  /* buffers pushed before keep their mapping of the file alive */
+  gst_queue2_drop_mapping (queue);
+  queue->using_mmap = FALSE;
+
+  close (queue->temp_fd);
 
   if (queue->temp_remove)
     remove (queue->temp_location);
 
-  queue->temp_file = NULL;
+  queue->temp_fd = -1;
   clean_ranges (queue);
 }
 
 static void
 gst_queue2_flush_temp_file (GstQueue2 * queue)
 {
-  if (queue->temp_file == NULL)
+  if (queue->temp_fd == -1)
     return;
 
   GST_DEBUG_OBJECT (queue, "flushing temp file");
 
-  queue->temp_file = g_freopen (queue->temp_location, "wb+", queue->temp_file);
+  /* buffers pushed before might still point into the file, truncating it
+   * would make them fault. Start over with a new file in the same place, the
+   * old one goes away with its last mapping. */
+  gst_queue2_drop_mapping (queue);
+  close (queue->temp_fd);
+  g_unlink (queue->temp_location);
+
+  queue->temp_fd = g_open (queue->temp_location,
+      O_RDWR | O_CREAT | O_EXCL | O_BINARY, 0600);
+  if (queue->temp_fd == -1)
+    goto open_failed;
+
+  return;
+
+  /* ERRORS */
+open_failed:
+  {
+    GST_ELEMENT_ERROR (queue, RESOURCE, OPEN_WRITE,
+        (_("Could not open file \"%s\" for writing."), queue->temp_location),
+        GST_ERROR_SYSTEM);
+    return;
+  }
 }
 
 static void
@@ -1759,10 +1965,6 @@ gst_queue2_create_write (GstQueue2 * queue, GstBuffer * buffer)
       new_writing_pos = writing_pos + to_write;
     }
 
-    if (QUEUE_IS_USING_TEMP_FILE (queue)
-        && FSEEK_FILE (queue->temp_file, writing_pos))
-      goto seek_failed;
-
     if (new_writing_pos > writing_pos) {
       GST_INFO_OBJECT (queue,
           "writing %u bytes to range [%" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT
@@ -1770,7 +1972,7 @@ gst_queue2_create_write (GstQueue2 * queue, GstBuffer * buffer)
           queue->current->writing_pos, queue->current->rb_writing_pos);
       /* either not using ring buffer or no wrapping, just write */
       if (QUEUE_IS_USING_TEMP_FILE (queue)) {
-        if (fwrite (data, to_write, 1, queue->temp_file) != 1)
+        if (!gst_queue2_pwrite (queue, data, to_write, writing_pos))
           goto handle_error;
       } else {
         memcpy (ring_buffer + writing_pos, data, to_write);
@@ -1811,20 +2013,17 @@ gst_queue2_create_write (GstQueue2 * queue, GstBuffer * buffer)
         GST_INFO_OBJECT (queue, "writing %u bytes", block_one);
         /* write data to end of ring buffer */
         if (QUEUE_IS_USING_TEMP_FILE (queue)) {
-          if (fwrite (data, block_one, 1, queue->temp_file) != 1)
+          if (!gst_queue2_pwrite (queue, data, block_one, writing_pos))
             goto handle_error;
         } else {
           memcpy (ring_buffer + writing_pos, data, block_one);
         }
       }
 
-      if (QUEUE_IS_USING_TEMP_FILE (queue) && FSEEK_FILE (queue->temp_file, 0))
-        goto seek_failed;
-
       if (block_two > 0) {
         GST_INFO_OBJECT (queue, "writing %u bytes", block_two);
         if (QUEUE_IS_USING_TEMP_FILE (queue)) {
-          if (fwrite (data + block_one, block_two, 1, queue->temp_file) != 1)
+          if (!gst_queue2_pwrite (queue, data + block_one, block_two, 0))
             goto handle_error;
         } else {
           memcpy (ring_buffer, data + block_one, block_two);
@@ -1870,12 +2069,6 @@ out_flushing:
     /* FIXME - GST_FLOW_EOS ? */
     return FALSE;
   }
-seek_failed:
-  {
-    GST_ELEMENT_ERROR (queue, RESOURCE, SEEK, (NULL), GST_ERROR_SYSTEM);
-    gst_buffer_unmap (buffer, &info);
-    return FALSE;
-  }
 handle_error:
   {
     switch (errno) {
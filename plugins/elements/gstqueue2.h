@@ -27,6 +27,8 @@
 #include <gst/gst.h>
 #include <stdio.h>
 
+#include "gstfilemmap.h"
+
 G_BEGIN_DECLS
 
 #define GST_TYPE_QUEUE2 \
@@ -138,7 +140,11 @@ struct _GstQueue2
   gboolean temp_location_set;
   gchar *temp_location;
   gboolean temp_remove;
-  FILE *temp_file;
+  gint temp_fd;
+  /* zero-copy reads from the temp file */
+  gboolean using_mmap;                  /* whether we are mmapping */
+  GstAllocator *mmap_allocator;         /* allocator for the mapped memory */
+  GstFileMapping *mapping;              /* current mmap window */
   /* list of downloaded areas and the current area */
   GstQueue2Range *ranges;
   GstQueue2Range *current;
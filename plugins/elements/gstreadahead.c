@@ -0,0 +1,575 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * gstreadahead.c: asynchronous read-ahead for file descriptors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* GstReadAhead reads a file descriptor in blocks of GST_READ_AHEAD_BLOCK_SIZE
+ * bytes from a background thread.
+ *
+ * When the reads of the element are sequential, the blocks of the configured
+ * window after the current read position are queued for the I/O thread so
+ * that they are ready by the time they are requested. Reads that are not
+ * contiguous with the previous one (seeks, pull mode demuxers) cancel the
+ * queued blocks and are served synchronously, while a small LRU of recently
+ * used blocks keeps ranges that are read repeatedly in memory.
+ *
+ * The returned buffers share the memory of the cached blocks, no data is
+ * copied.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include "config.h"
+#endif
+
+#include "gstreadahead.h"
+
+#include <sys/types.h>
+#include <fcntl.h>
+#ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+#endif
+#include <errno.h>
+
+GST_DEBUG_CATEGORY_STATIC (read_ahead_debug);
+#define GST_CAT_DEFAULT read_ahead_debug
+
+/* amount of blocks that are kept after they were used */
+#define LRU_BLOCKS      16
+
+typedef enum
+{
+  BLOCK_PENDING,                /* queued for the I/O thread */
+  BLOCK_READING,                /* being read */
+  BLOCK_AHEAD,                  /* read ahead, not used yet */
+  BLOCK_CACHED                  /* used, kept in the LRU */
+} BlockState;
+
+typedef struct
+{
+  guint64 index;
+  BlockState state;
+  /* link in the pending, ahead or lru queue, depending on the state */
+  GList link;
+
+  GstBuffer *buffer;            /* NULL when the read failed */
+  gint error;                   /* errno of the failed read */
+} Block;
+
+struct _GstReadAhead
+{
+  GstObject *parent;
+  gint fd;
+  guint window;                 /* in blocks */
+
+  GMutex lock;
+  GCond cond;                   /* signals the I/O thread */
+  GCond done_cond;              /* signals completed blocks */
+  GThread *thread;
+  gboolean running;
+
+  GHashTable *blocks;
+  GQueue pending;
+  GQueue ahead;
+  GQueue lru;
+
+  guint64 next_offset;
+
+  guint64 hits;
+  guint64 misses;
+};
+
+static void
+gst_read_ahead_init_debug (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized)) {
+    GST_DEBUG_CATEGORY_INIT (read_ahead_debug, "readahead", 0,
+        "File descriptor read-ahead");
+    g_once_init_leave (&initialized, 1);
+  }
+}
+
+static Block *
+block_new (guint64 index, BlockState state)
+{
+  Block *block;
+
+  block = g_slice_new0 (Block);
+  block->index = index;
+  block->state = state;
+  block->link.data = block;
+
+  return block;
+}
+
+static void
+block_free (Block * block)
+{
+  if (block->buffer)
+    gst_buffer_unref (block->buffer);
+  g_slice_free (Block, block);
+}
+
+static GQueue *
+gst_read_ahead_queue_for_state (GstReadAhead * ra, BlockState state)
+{
+  switch (state) {
+    case BLOCK_PENDING:
+      return &ra->pending;
+    case BLOCK_AHEAD:
+      return &ra->ahead;
+    case BLOCK_CACHED:
+      return &ra->lru;
+    default:
+      return NULL;
+  }
+}
+
+/* move @block to @state, adding it to the queue of its new state */
+static void
+gst_read_ahead_set_state (GstReadAhead * ra, Block * block, BlockState state)
+{
+  GQueue *queue;
+
+  if ((queue = gst_read_ahead_queue_for_state (ra, block->state)))
+    g_queue_unlink (queue, &block->link);
+
+  block->state = state;
+
+  if ((queue = gst_read_ahead_queue_for_state (ra, state)))
+    g_queue_push_tail_link (queue, &block->link);
+}
+
+static void
+gst_read_ahead_drop_block (GstReadAhead * ra, Block * block)
+{
+  GQueue *queue;
+
+  g_assert (block->state != BLOCK_READING);
+
+  if ((queue = gst_read_ahead_queue_for_state (ra, block->state)))
+    g_queue_unlink (queue, &block->link);
+
+  g_hash_table_remove (ra->blocks, &block->index);
+  block_free (block);
+}
+
+static void
+gst_read_ahead_trim_lru (GstReadAhead * ra)
+{
+  while (ra->lru.length > LRU_BLOCKS)
+    gst_read_ahead_drop_block (ra, ra->lru.head->data);
+}
+
+/* called without the lock */
+static GstBuffer *
+gst_read_ahead_read_block (GstReadAhead * ra, guint64 index, gint * error)
+{
+  GstBuffer *buffer;
+  GstMapInfo info;
+  gsize bytes_read = 0;
+  gssize ret;
+
+  buffer = gst_buffer_new_allocate (NULL, GST_READ_AHEAD_BLOCK_SIZE, NULL);
+  gst_buffer_map (buffer, &info, GST_MAP_WRITE);
+
+  while (bytes_read < info.size) {
+#ifdef HAVE_PREAD
+    ret = pread (ra->fd, info.data + bytes_read, info.size - bytes_read,
+        index * GST_READ_AHEAD_BLOCK_SIZE + bytes_read);
+#else
+    ret = -1;
+    errno = ENOSYS;
+#endif
+    if (G_UNLIKELY (ret < 0)) {
+      if (errno == EAGAIN || errno == EINTR)
+        continue;
+      goto read_error;
+    }
+    /* end of file */
+    if (ret == 0)
+      break;
+
+    bytes_read += ret;
+  }
+  gst_buffer_unmap (buffer, &info);
+
+  if (bytes_read != GST_READ_AHEAD_BLOCK_SIZE)
+    gst_buffer_resize (buffer, 0, bytes_read);
+
+  GST_LOG_OBJECT (ra->parent, "read block %" G_GUINT64_FORMAT ", %"
+      G_GSIZE_FORMAT " bytes", index, bytes_read);
+
+  return buffer;
+
+  /* ERRORS */
+read_error:
+  {
+    *error = errno;
+    GST_WARNING_OBJECT (ra->parent, "reading block %" G_GUINT64_FORMAT
+        " failed: %s", index, g_strerror (*error));
+    gst_buffer_unmap (buffer, &info);
+    gst_buffer_unref (buffer);
+    return NULL;
+  }
+}
+
+/* called with the lock, @block is in the READING state */
+static void
+gst_read_ahead_fetch (GstReadAhead * ra, Block * block, BlockState state)
+{
+  GstBuffer *buffer;
+  gint error = 0;
+
+  g_mutex_unlock (&ra->lock);
+  buffer = gst_read_ahead_read_block (ra, block->index, &error);
+  g_mutex_lock (&ra->lock);
+
+  block->buffer = buffer;
+  block->error = error;
+  gst_read_ahead_set_state (ra, block, state);
+
+  g_cond_broadcast (&ra->done_cond);
+}
+
+static gpointer
+gst_read_ahead_thread (GstReadAhead * ra)
+{
+  Block *block;
+
+  g_mutex_lock (&ra->lock);
+  while (ra->running) {
+    if (ra->pending.head == NULL) {
+      g_cond_wait (&ra->cond, &ra->lock);
+      continue;
+    }
+    block = ra->pending.head->data;
+    gst_read_ahead_set_state (ra, block, BLOCK_READING);
+    gst_read_ahead_fetch (ra, block, BLOCK_AHEAD);
+  }
+  g_mutex_unlock (&ra->lock);
+
+  return NULL;
+}
+
+/* forget about the blocks that were queued for a previous read position.
+ * Blocks that were already read ahead are kept in the LRU for as long as
+ * they fit. */
+static void
+gst_read_ahead_cancel (GstReadAhead * ra)
+{
+  while (ra->pending.head)
+    gst_read_ahead_drop_block (ra, ra->pending.head->data);
+
+  while (ra->ahead.head)
+    gst_read_ahead_set_state (ra, ra->ahead.head->data, BLOCK_CACHED);
+
+  gst_read_ahead_trim_lru (ra);
+}
+
+/* queue the blocks of the window starting at @offset */
+static void
+gst_read_ahead_schedule (GstReadAhead * ra, guint64 offset)
+{
+  guint64 first, index;
+  gboolean queued = FALSE;
+
+  first = offset / GST_READ_AHEAD_BLOCK_SIZE;
+
+  for (index = first; index < first + ra->window; index++) {
+    Block *block;
+
+    if (g_hash_table_lookup (ra->blocks, &index))
+      continue;
+
+    block = block_new (index, BLOCK_READING);
+    g_hash_table_insert (ra->blocks, &block->index, block);
+    gst_read_ahead_set_state (ra, block, BLOCK_PENDING);
+    queued = TRUE;
+  }
+
+  if (queued) {
+#ifdef HAVE_POSIX_FADVISE
+    posix_fadvise (ra->fd, first * GST_READ_AHEAD_BLOCK_SIZE,
+        ra->window * GST_READ_AHEAD_BLOCK_SIZE, POSIX_FADV_WILLNEED);
+#endif
+    g_cond_signal (&ra->cond);
+  }
+}
+
+/**
+ * gst_read_ahead_new:
+ * @parent: the object used for debugging
+ * @fd: a seekable file descriptor
+ * @window: the amount of bytes to read ahead
+ *
+ * Start reading ahead on @fd.
+ *
+ * Returns: a new #GstReadAhead or %NULL when the I/O thread could not be
+ * started.
+ */
+GstReadAhead *
+gst_read_ahead_new (GstObject * parent, gint fd, guint64 window)
+{
+  GstReadAhead *ra;
+  GError *err = NULL;
+
+  gst_read_ahead_init_debug ();
+
+#ifndef HAVE_PREAD
+  GST_WARNING_OBJECT (parent, "read-ahead is not supported on this platform");
+  return NULL;
+#endif
+
+  ra = g_slice_new0 (GstReadAhead);
+  ra->parent = parent;
+  ra->fd = fd;
+  ra->window = MAX (1, (window + GST_READ_AHEAD_BLOCK_SIZE - 1) /
+      GST_READ_AHEAD_BLOCK_SIZE);
+  g_mutex_init (&ra->lock);
+  g_cond_init (&ra->cond);
+  g_cond_init (&ra->done_cond);
+  ra->blocks = g_hash_table_new (g_int64_hash, g_int64_equal);
+  g_queue_init (&ra->pending);
+  g_queue_init (&ra->ahead);
+  g_queue_init (&ra->lru);
+  ra->running = TRUE;
+
+#ifdef HAVE_POSIX_FADVISE
+  posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  ra->thread = g_thread_try_new ("GstReadAhead",
+      (GThreadFunc) gst_read_ahead_thread, ra, &err);
+  if (ra->thread == NULL)
+    goto no_thread;
+
+  GST_DEBUG_OBJECT (parent, "reading ahead %u blocks on fd %d", ra->window,
+      fd);
+
+  return ra;
+
+  /* ERRORS */
+no_thread:
+  {
+    GST_WARNING_OBJECT (parent, "could not create read-ahead thread: %s",
+        err->message);
+    g_error_free (err);
+    ra->running = FALSE;
+    gst_read_ahead_free (ra);
+    return NULL;
+  }
+}
+
+/**
+ * gst_read_ahead_free:
+ * @ra: a #GstReadAhead
+ *
+ * Stop the I/O thread and free @ra. Buffers returned from
+ * gst_read_ahead_read() remain valid.
+ */
+void
+gst_read_ahead_free (GstReadAhead * ra)
+{
+  g_mutex_lock (&ra->lock);
+  ra->running = FALSE;
+  g_cond_signal (&ra->cond);
+  g_mutex_unlock (&ra->lock);
+
+  if (ra->thread)
+    g_thread_join (ra->thread);
+
+  /* no more blocks are being read now */
+  g_hash_table_foreach (ra->blocks, (GHFunc) block_free, NULL);
+  g_hash_table_destroy (ra->blocks);
+
+  g_mutex_clear (&ra->lock);
+  g_cond_clear (&ra->cond);
+  g_cond_clear (&ra->done_cond);
+
+  g_slice_free (GstReadAhead, ra);
+}
+
+/**
+ * gst_read_ahead_get_fd:
+ * @ra: a #GstReadAhead
+ *
+ * Returns: the file descriptor @ra reads from.
+ */
+gint
+gst_read_ahead_get_fd (GstReadAhead * ra)
+{
+  return ra->fd;
+}
+
+/**
+ * gst_read_ahead_read:
+ * @ra: a #GstReadAhead
+ * @offset: the offset to read from
+ * @length: the amount of bytes to read
+ * @buffer: (out): the result buffer
+ *
+ * Read @length bytes at @offset. Less than @length bytes are returned when
+ * the end of the file is reached.
+ *
+ * Returns: #GST_FLOW_OK, #GST_FLOW_EOS when @offset is at or beyond the end
+ * of the file or #GST_FLOW_ERROR with errno set when reading failed.
+ */
+GstFlowReturn
+gst_read_ahead_read (GstReadAhead * ra, guint64 offset, guint length,
+    GstBuffer ** buffer)
+{
+  GstBuffer *result = NULL;
+  guint64 pos, end;
+  gboolean sequential;
+  gint error;
+
+  g_mutex_lock (&ra->lock);
+
+  sequential = (offset == ra->next_offset);
+  if (!sequential) {
+    GST_DEBUG_OBJECT (ra->parent, "random access at offset %" G_GUINT64_FORMAT
+        ", expected %" G_GUINT64_FORMAT, offset, ra->next_offset);
+    gst_read_ahead_cancel (ra);
+  }
+
+  pos = offset;
+  end = offset + length;
+
+  while (pos < end) {
+    guint64 index, boff;
+    gsize bsize, n;
+    Block *block;
+
+    index = pos / GST_READ_AHEAD_BLOCK_SIZE;
+    block = g_hash_table_lookup (ra->blocks, &index);
+
+    if (block && block->state == BLOCK_READING) {
+      while (block->state == BLOCK_READING)
+        g_cond_wait (&ra->done_cond, &ra->lock);
+    }
+
+    if (block && block->state != BLOCK_PENDING && block->buffer &&
+        gst_buffer_get_size (block->buffer) < GST_READ_AHEAD_BLOCK_SIZE &&
+        index * GST_READ_AHEAD_BLOCK_SIZE +
+        gst_buffer_get_size (block->buffer) < end) {
+      /* the file ended in this block when it was read, it might have grown
+       * since then */
+      GST_LOG_OBJECT (ra->parent, "refreshing short block %" G_GUINT64_FORMAT,
+          index);
+      gst_read_ahead_drop_block (ra, block);
+      block = NULL;
+    }
+
+    /* each block counts once, when it is used for the first time */
+    if (block == NULL) {
+      ra->misses++;
+      block = block_new (index, BLOCK_READING);
+      g_hash_table_insert (ra->blocks, &block->index, block);
+      gst_read_ahead_fetch (ra, block, BLOCK_CACHED);
+    } else if (block->state == BLOCK_PENDING) {
+      /* the I/O thread did not get to it yet, read it ourselves */
+      ra->misses++;
+      gst_read_ahead_set_state (ra, block, BLOCK_READING);
+      gst_read_ahead_fetch (ra, block, BLOCK_CACHED);
+    } else {
+      if (block->state == BLOCK_AHEAD)
+        ra->hits++;
+      gst_read_ahead_set_state (ra, block, BLOCK_CACHED);
+    }
+
+    if (G_UNLIKELY (block->buffer == NULL))
+      goto read_error;
+
+    bsize = gst_buffer_get_size (block->buffer);
+    boff = pos - index * GST_READ_AHEAD_BLOCK_SIZE;
+
+    if (boff >= bsize)
+      break;
+
+    n = MIN (bsize - boff, end - pos);
+    if (result == NULL) {
+      result = gst_buffer_copy_region (block->buffer, GST_BUFFER_COPY_MEMORY,
+          boff, n);
+    } else {
+      result = gst_buffer_append (result,
+          gst_buffer_copy_region (block->buffer, GST_BUFFER_COPY_MEMORY, boff,
+              n));
+    }
+    pos += n;
+
+    if (bsize < GST_READ_AHEAD_BLOCK_SIZE)
+      break;
+  }
+  ra->next_offset = pos;
+
+  gst_read_ahead_trim_lru (ra);
+  if (sequential)
+    gst_read_ahead_schedule (ra, pos);
+  g_mutex_unlock (&ra->lock);
+
+  if (result == NULL)
+    goto eos;
+
+  *buffer = result;
+
+  return GST_FLOW_OK;
+
+  /* ERRORS */
+eos:
+  {
+    GST_DEBUG_OBJECT (ra->parent, "EOS at offset %" G_GUINT64_FORMAT, offset);
+    return GST_FLOW_EOS;
+  }
+read_error:
+  {
+    error = block->error;
+    /* don't keep the error around, a next read might succeed */
+    gst_read_ahead_drop_block (ra, block);
+    g_mutex_unlock (&ra->lock);
+
+    if (result)
+      gst_buffer_unref (result);
+
+    errno = error;
+    return GST_FLOW_ERROR;
+  }
+}
+
+/**
+ * gst_read_ahead_get_stats:
+ * @ra: a #GstReadAhead
+ * @hits: (out) (allow-none): the amount of blocks that were read ahead
+ * @misses: (out) (allow-none): the amount of blocks that had to be read
+ *   synchronously
+ *
+ * Get the statistics of @ra. A block is counted once when it is used for the
+ * first time, later reads from the cached block are not counted.
+ */
+void
+gst_read_ahead_get_stats (GstReadAhead * ra, guint64 * hits, guint64 * misses)
+{
+  g_mutex_lock (&ra->lock);
+  if (hits)
+    *hits = ra->hits;
+  if (misses)
+    *misses = ra->misses;
+  g_mutex_unlock (&ra->lock);
+}
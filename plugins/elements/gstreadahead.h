@@ -0,0 +1,53 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * gstreadahead.h: asynchronous read-ahead for file descriptors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __GST_READ_AHEAD_H__
+#define __GST_READ_AHEAD_H__
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GstReadAhead GstReadAhead;
+
+/* size of the blocks that are read and cached */
+#define GST_READ_AHEAD_BLOCK_SIZE  (64 * 1024)
+
+G_GNUC_INTERNAL
+GstReadAhead *  gst_read_ahead_new        (GstObject * parent, gint fd,
+                                           guint64 window);
+G_GNUC_INTERNAL
+void            gst_read_ahead_free       (GstReadAhead * ra);
+
+G_GNUC_INTERNAL
+gint            gst_read_ahead_get_fd     (GstReadAhead * ra);
+
+G_GNUC_INTERNAL
+GstFlowReturn   gst_read_ahead_read       (GstReadAhead * ra, guint64 offset,
+                                           guint length, GstBuffer ** buffer);
+
+G_GNUC_INTERNAL
+void            gst_read_ahead_get_stats  (GstReadAhead * ra, guint64 * hits,
+                                           guint64 * misses);
+
+G_END_DECLS
+
+#endif /* __GST_READ_AHEAD_H__ */
@@ -34,6 +34,14 @@
  * provide separate threads for each branch. Otherwise a blocked dataflow in one
  * branch would stall the other branches.
  *
+ * Normally the data is pushed to the src pads one after the other, so a branch
+ * that takes long to accept the data delays all branches after it. When
+ * #GstTee:parallel is set, the data is pushed to all src pads at the same time
+ * from a #GstTaskPool and tee only waits until all branches accepted it. With
+ * #GstTee:batch-size the buffers are first collected and then pushed to all
+ * branches together, every branch gets the buffers of a batch in order.
+ * Serialized events and queries push the pending buffers first.
+ *
  * <refsect2>
  * <title>Example launch line</title>
  * |[
@@ -84,6 +92,8 @@ gst_tee_pull_mode_get_type (void)
 #define DEFAULT_PROP_SILENT		TRUE
 #define DEFAULT_PROP_LAST_MESSAGE	NULL
 #define DEFAULT_PULL_MODE		GST_TEE_PULL_MODE_NEVER
+#define DEFAULT_PROP_PARALLEL		FALSE
+#define DEFAULT_PROP_BATCH_SIZE		1
 
 enum
 {
@@ -94,6 +104,8 @@ enum
   PROP_LAST_MESSAGE,
   PROP_PULL_MODE,
   PROP_ALLOC_PAD,
+  PROP_PARALLEL,
+  PROP_BATCH_SIZE
 };
 
 static GstStaticPadTemplate tee_src_template =
@@ -191,6 +203,8 @@ static gboolean gst_tee_src_activate_mode (GstPad * pad, GstObject * parent,
     GstPadMode mode, gboolean active);
 static GstFlowReturn gst_tee_src_get_range (GstPad * pad, GstObject * parent,
     guint64 offset, guint length, GstBuffer ** buf);
+static GstFlowReturn gst_tee_push_batch (GstTee * tee);
+static void gst_tee_clear_batch (GstTee * tee);
 
 static void
 gst_tee_dispose (GObject * object)
@@ -220,6 +234,10 @@ gst_tee_finalize (GObject * object)
 
   g_free (tee->last_message);
 
+  g_ptr_array_unref (tee->batch);
+  g_mutex_clear (&tee->push_lock);
+  g_cond_clear (&tee->push_cond);
+
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -265,6 +283,34 @@ gst_tee_class_init (GstTeeClass * klass)
   g_object_class_install_property (gobject_class, PROP_ALLOC_PAD,
       pspec_alloc_pad);
 
+  /**
+   * GstTee:parallel:
+   *
+   * Push the data to all src pads at the same time from a #GstTaskPool
+   * instead of one src pad after the other. Takes effect the next time the
+   * element goes to PAUSED.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_PARALLEL,
+      g_param_spec_boolean ("parallel", "Parallel",
+          "Push to all src pads at the same time", DEFAULT_PROP_PARALLEL,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+  /**
+   * GstTee:batch-size:
+   *
+   * The number of buffers or buffer lists to collect before pushing them to
+   * all src pads when #GstTee:parallel is set. The flow return of a batch is
+   * returned for the last buffer of the batch and for the buffers of the
+   * next batch until that one is pushed.
+   *
+   * Since: 1.4
+   */
+  g_object_class_install_property (gobject_class, PROP_BATCH_SIZE,
+      g_param_spec_uint ("batch-size", "Batch size",
+          "Number of buffers to push at once in parallel mode", 1, G_MAXUINT,
+          DEFAULT_PROP_BATCH_SIZE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   gst_element_class_set_static_metadata (gstelement_class,
       "Tee pipe fitting",
       "Generic",
@@ -301,6 +347,14 @@ gst_tee_init (GstTee * tee)
   tee->pad_indexes = g_hash_table_new (NULL, NULL);
 
   tee->last_message = NULL;
+
+  tee->parallel = DEFAULT_PROP_PARALLEL;
+  tee->batch_size = DEFAULT_PROP_BATCH_SIZE;
+  g_mutex_init (&tee->push_lock);
+  g_cond_init (&tee->push_cond);
+  tee->batch =
+      g_ptr_array_new_with_free_func ((GDestroyNotify) gst_mini_object_unref);
+  tee->batch_ret = GST_FLOW_OK;
 }
 
 static void
@@ -482,6 +536,12 @@ gst_tee_set_property (GObject * object, guint prop_id, const GValue * value,
       GST_OBJECT_UNLOCK (pad);
       break;
     }
+    case PROP_PARALLEL:
+      tee->parallel = g_value_get_boolean (value);
+      break;
+    case PROP_BATCH_SIZE:
+      tee->batch_size = g_value_get_uint (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -515,6 +575,12 @@ gst_tee_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_ALLOC_PAD:
       g_value_set_object (value, tee->allocpad);
       break;
+    case PROP_PARALLEL:
+      g_value_set_boolean (value, tee->parallel);
+      break;
+    case PROP_BATCH_SIZE:
+      g_value_set_uint (value, tee->batch_size);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -525,8 +591,17 @@ gst_tee_get_property (GObject * object, guint prop_id, GValue * value,
 static gboolean
 gst_tee_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 {
+  GstTee *tee = GST_TEE_CAST (parent);
   gboolean res;
 
+  /* keep the order with the data that was not pushed yet */
+  if (tee->pool) {
+    if (GST_EVENT_TYPE (event) == GST_EVENT_FLUSH_STOP)
+      gst_tee_clear_batch (tee);
+    else if (GST_EVENT_IS_SERIALIZED (event))
+      gst_tee_push_batch (tee);
+  }
+
   switch (GST_EVENT_TYPE (event)) {
     default:
       res = gst_pad_event_default (pad, parent, event);
@@ -539,8 +614,12 @@ gst_tee_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
 static gboolean
 gst_tee_sink_query (GstPad * pad, GstObject * parent, GstQuery * query)
 {
+  GstTee *tee = GST_TEE_CAST (parent);
   gboolean res;
 
+  if (tee->pool && GST_QUERY_IS_SERIALIZED (query))
+    gst_tee_push_batch (tee);
+
   switch (GST_QUERY_TYPE (query)) {
     default:
       res = gst_pad_query_default (pad, parent, query);
@@ -595,6 +674,164 @@ clear_pads (GstPad * pad, GstTee * tee)
   GST_TEE_PAD_CAST (pad)->result = GST_FLOW_NOT_LINKED;
 }
 
+typedef struct
+{
+  GstTee *tee;
+  GstPad *pad;
+} GstTeePushJob;
+
+/* pushes the collected data on one src pad, called from the task pool */
+static void
+gst_tee_push_job (GstTeePushJob * job)
+{
+  GstTee *tee = job->tee;
+  GstFlowReturn ret = GST_FLOW_OK;
+  gpointer data;
+  guint i;
+
+  for (i = 0; i < tee->batch->len; i++) {
+    data = g_ptr_array_index (tee->batch, i);
+    ret = gst_tee_do_push (tee, job->pad, data, GST_IS_BUFFER_LIST (data));
+
+    /* stop pushing on this pad when we have a fatal error */
+    if (G_UNLIKELY (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED))
+      break;
+  }
+
+  GST_LOG_OBJECT (tee, "Pushing %u items on %s:%s yielded result %s",
+      tee->batch->len, GST_DEBUG_PAD_NAME (job->pad), gst_flow_get_name (ret));
+
+  GST_OBJECT_LOCK (tee);
+  GST_TEE_PAD_CAST (job->pad)->pushed = TRUE;
+  GST_TEE_PAD_CAST (job->pad)->result = ret;
+  GST_OBJECT_UNLOCK (tee);
+
+  g_mutex_lock (&tee->push_lock);
+  if (--tee->pending == 0)
+    g_cond_signal (&tee->push_cond);
+  g_mutex_unlock (&tee->push_lock);
+}
+
+/* pushes the collected data on all src pads at the same time and waits until
+ * all pads are done. Called with the stream lock. */
+static GstFlowReturn
+gst_tee_push_batch (GstTee * tee)
+{
+  GstTeePushJob *jobs;
+  GList *pads;
+  GError *err = NULL;
+  GstFlowReturn ret, cret;
+  guint i, n_jobs = 0;
+
+  if (tee->batch->len == 0)
+    return tee->batch_ret;
+
+  GST_OBJECT_LOCK (tee);
+  pads = GST_ELEMENT_CAST (tee)->srcpads;
+
+  if (G_UNLIKELY (!pads))
+    goto no_pads;
+
+  /* mark all pads as 'not pushed on yet' */
+  g_list_foreach (pads, (GFunc) clear_pads, tee);
+
+  jobs = g_new (GstTeePushJob, GST_ELEMENT_CAST (tee)->numsrcpads);
+  for (; pads; pads = g_list_next (pads)) {
+    jobs[n_jobs].tee = tee;
+    jobs[n_jobs].pad = gst_object_ref (pads->data);
+    n_jobs++;
+  }
+  GST_OBJECT_UNLOCK (tee);
+
+  g_mutex_lock (&tee->push_lock);
+  tee->pending = n_jobs;
+  g_mutex_unlock (&tee->push_lock);
+
+  /* the last pad is pushed on from this thread */
+  for (i = 0; i < n_jobs - 1; i++) {
+    gst_task_pool_push (tee->pool, (GstTaskPoolFunction) gst_tee_push_job,
+        &jobs[i], &err);
+    if (G_UNLIKELY (err != NULL)) {
+      GST_WARNING_OBJECT (tee, "could not push in parallel: %s",
+          err->message);
+      g_clear_error (&err);
+      gst_tee_push_job (&jobs[i]);
+    }
+  }
+  gst_tee_push_job (&jobs[n_jobs - 1]);
+
+  g_mutex_lock (&tee->push_lock);
+  while (tee->pending > 0)
+    g_cond_wait (&tee->push_cond, &tee->push_lock);
+  g_mutex_unlock (&tee->push_lock);
+
+  /* combine the results like gst_tee_handle_data(), pads that were removed in
+   * the meantime don't count */
+  cret = GST_FLOW_NOT_LINKED;
+  GST_OBJECT_LOCK (tee);
+  for (pads = GST_ELEMENT_CAST (tee)->srcpads; pads; pads = g_list_next (pads)) {
+    GstTeePad *pad = GST_TEE_PAD_CAST (pads->data);
+
+    if (!pad->pushed)
+      continue;
+
+    ret = pad->result;
+    if (G_UNLIKELY (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED)) {
+      cret = ret;
+      break;
+    }
+    if (G_LIKELY (ret != GST_FLOW_NOT_LINKED))
+      cret = ret;
+  }
+  GST_OBJECT_UNLOCK (tee);
+
+  for (i = 0; i < n_jobs; i++)
+    gst_object_unref (jobs[i].pad);
+  g_free (jobs);
+
+  g_ptr_array_set_size (tee->batch, 0);
+  tee->batch_ret = cret;
+
+  return cret;
+
+  /* ERRORS */
+no_pads:
+  {
+    GST_OBJECT_UNLOCK (tee);
+    GST_DEBUG_OBJECT (tee, "there are no pads, return not-linked");
+    g_ptr_array_set_size (tee->batch, 0);
+    tee->batch_ret = GST_FLOW_NOT_LINKED;
+    return GST_FLOW_NOT_LINKED;
+  }
+}
+
+/* drops the collected data, called with the stream lock */
+static void
+gst_tee_clear_batch (GstTee * tee)
+{
+  g_ptr_array_set_size (tee->batch, 0);
+  tee->batch_ret = GST_FLOW_OK;
+}
+
+/* collects @data and pushes it when the batch is complete. Until then the
+ * result of the previous batch is returned. */
+static GstFlowReturn
+gst_tee_handle_data_parallel (GstTee * tee, gpointer data)
+{
+  guint batch_size;
+
+  g_ptr_array_add (tee->batch, data);
+
+  GST_OBJECT_LOCK (tee);
+  batch_size = tee->batch_size;
+  GST_OBJECT_UNLOCK (tee);
+
+  if (tee->batch->len < batch_size)
+    return tee->batch_ret;
+
+  return gst_tee_push_batch (tee);
+}
+
 static GstFlowReturn
 gst_tee_handle_data (GstTee * tee, gpointer data, gboolean is_list)
 {
@@ -605,6 +842,9 @@ gst_tee_handle_data (GstTee * tee, gpointer data, gboolean is_list)
   if (G_UNLIKELY (!tee->silent))
     gst_tee_do_message (tee, tee->sinkpad, data, is_list);
 
+  if (tee->pool)
+    return gst_tee_handle_data_parallel (tee, data);
+
   GST_OBJECT_LOCK (tee);
   pads = GST_ELEMENT_CAST (tee)->srcpads;
 
@@ -751,11 +991,54 @@ gst_tee_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
   return res;
 }
 
+/* sets up the task pool for pushing in parallel */
+static void
+gst_tee_start_parallel (GstTee * tee)
+{
+  GstTaskPool *pool;
+  GError *err = NULL;
+
+  pool = gst_task_pool_new ();
+  gst_task_pool_prepare (pool, &err);
+  if (err != NULL)
+    goto prepare_failed;
+
+  tee->batch_ret = GST_FLOW_OK;
+  tee->pool = pool;
+  return;
+
+  /* ERRORS */
+prepare_failed:
+  {
+    GST_WARNING_OBJECT (tee, "could not prepare task pool, pushing "
+        "sequentially: %s", err->message);
+    g_clear_error (&err);
+    gst_object_unref (pool);
+    return;
+  }
+}
+
+static void
+gst_tee_stop_parallel (GstTee * tee)
+{
+  if (tee->pool == NULL)
+    return;
+
+  /* make sure the streaming thread is not using the batch anymore */
+  GST_PAD_STREAM_LOCK (tee->sinkpad);
+  gst_tee_clear_batch (tee);
+  GST_PAD_STREAM_UNLOCK (tee->sinkpad);
+
+  gst_task_pool_cleanup (tee->pool);
+  gst_object_unref (tee->pool);
+  tee->pool = NULL;
+}
+
 static gboolean
 gst_tee_sink_activate_mode (GstPad * pad, GstObject * parent, GstPadMode mode,
     gboolean active)
 {
-  gboolean res;
+  gboolean res, parallel;
   GstTee *tee;
 
   tee = GST_TEE (parent);
@@ -768,7 +1051,13 @@ gst_tee_sink_activate_mode (GstPad * pad, GstObject * parent, GstPadMode mode,
 
       if (active && !tee->has_chain)
         goto no_chain;
+      parallel = tee->parallel;
       GST_OBJECT_UNLOCK (tee);
+
+      if (active && parallel)
+        gst_tee_start_parallel (tee);
+      else if (!active)
+        gst_tee_stop_parallel (tee);
       res = TRUE;
       break;
     }
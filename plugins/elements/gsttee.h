@@ -79,6 +79,17 @@ struct _GstTee {
   GstPadMode      sink_mode;
   GstTeePullMode  pull_mode;
   GstPad         *pull_pad;
+
+  gboolean        parallel;
+  guint           batch_size;
+
+  /* parallel pushing */
+  GstTaskPool    *pool;
+  GMutex          push_lock;
+  GCond           push_cond;
+  guint           pending;
+  GPtrArray      *batch;
+  GstFlowReturn   batch_ret;
 };
 
 struct _GstTeeClass {
@@ -72,6 +72,8 @@ static void gst_valve_get_property (GObject * object,
 
 static GstFlowReturn gst_valve_chain (GstPad * pad, GstObject * parent,
     GstBuffer * buffer);
+static GstFlowReturn gst_valve_chain_list (GstPad * pad, GstObject * parent,
+    GstBufferList * list);
 static gboolean gst_valve_event (GstPad * pad, GstObject * parent,
     GstEvent * event);
 static gboolean gst_valve_query (GstPad * pad, GstObject * parent,
@@ -126,6 +128,8 @@ gst_valve_init (GstValve * valve)
   valve->sinkpad = gst_pad_new_from_static_template (&sinktemplate, "sink");
   gst_pad_set_chain_function (valve->sinkpad,
       GST_DEBUG_FUNCPTR (gst_valve_chain));
+  gst_pad_set_chain_list_function (valve->sinkpad,
+      GST_DEBUG_FUNCPTR (gst_valve_chain_list));
   gst_pad_set_event_function (valve->sinkpad,
       GST_DEBUG_FUNCPTR (gst_valve_event));
   gst_pad_set_query_function (valve->sinkpad,
@@ -220,6 +224,43 @@ gst_valve_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
   return ret;
 }
 
+static GstFlowReturn
+gst_valve_chain_list (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  GstValve *valve = GST_VALVE (parent);
+  GstFlowReturn ret = GST_FLOW_OK;
+
+  if (g_atomic_int_get (&valve->drop)) {
+    gst_buffer_list_unref (list);
+    valve->discont = TRUE;
+  } else {
+    if (valve->discont && gst_buffer_list_length (list) > 0) {
+      GstBuffer *buffer;
+
+      list = gst_buffer_list_make_writable (list);
+      buffer = gst_buffer_ref (gst_buffer_list_get (list, 0));
+      buffer = gst_buffer_make_writable (buffer);
+      GST_BUFFER_FLAG_SET (buffer, GST_BUFFER_FLAG_DISCONT);
+      gst_buffer_list_remove (list, 0, 1);
+      gst_buffer_list_insert (list, 0, buffer);
+      valve->discont = FALSE;
+    }
+
+    if (valve->need_repush_sticky)
+      gst_valve_repush_sticky (valve);
+
+    ret = gst_pad_push_list (valve->srcpad, list);
+  }
+
+  /* Ignore errors if "drop" was changed while the thread was blocked
+   * downwards
+   */
+  if (g_atomic_int_get (&valve->drop))
+    ret = GST_FLOW_OK;
+
+  return ret;
+}
+
 
 static gboolean
 gst_valve_event (GstPad * pad, GstObject * parent, GstEvent * event)
@@ -1,7 +1,7 @@
 /* GStreamer
  * Copyright (C) 2005 Andy Wingo <wingo@pobox.com>
  *
- * caps.c: benchmark for caps creation and destruction
+ * caps.c: benchmark for caps creation, destruction and negotiation
  *
  * This library is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Library General Public
@@ -25,6 +25,9 @@
 
 #define NUM_CAPS 10000
 
+/* the number of caps operations in the negotiation benchmarks */
+#define NUM_OPS 100000
+
 #define AUDIO_FORMATS_ALL " { S8, U8, " \
     "S16LE, S16BE, U16LE, U16BE, " \
     "S24_32LE, S24_32BE, U24_32LE, U24_32BE, " \
@@ -40,12 +43,63 @@
   "rate = (int) [ 1, MAX ], " \
   "channels = (int) [ 1, MAX ]"
 
+#define FIXED_CAPS "audio/x-raw, format = (string) S16LE, " \
+  "rate = (int) 44100, channels = (int) 2, layout = (string) interleaved"
+
+#define VIDEO_CAPS "video/x-raw, " \
+  "format = (string) { I420, YV12, YUY2, UYVY, AYUV, RGBx, BGRx, xRGB }, " \
+  "width = (int) [ 1, MAX ], height = (int) [ 1, MAX ], " \
+  "framerate = (fraction) [ 0/1, MAX ]"
+
+#define FIXED_VIDEO_CAPS "video/x-raw, format = (string) AYUV, " \
+  "width = (int) 320, height = (int) 240, framerate = (fraction) 30/1"
+
+static void
+run_negotiation (const gchar * name, GstCaps * templ, GstCaps * fixed)
+{
+  GstClockTime start, end;
+  GstCaps *res;
+  gint i;
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_OPS; i++) {
+    res = gst_caps_intersect (templ, fixed);
+    gst_caps_unref (res);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - intersecting %d %s caps\n",
+      GST_TIME_ARGS (end - start), i, name);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_OPS; i++)
+    gst_caps_can_intersect (templ, fixed);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - checking %d %s caps for intersection\n",
+      GST_TIME_ARGS (end - start), i, name);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_OPS; i++)
+    gst_caps_is_subset (fixed, templ);
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - checking %d %s caps for subset\n",
+      GST_TIME_ARGS (end - start), i, name);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_OPS; i++) {
+    res = gst_caps_subtract (templ, fixed);
+    gst_caps_unref (res);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%" GST_TIME_FORMAT " - subtracting %d %s caps\n",
+      GST_TIME_ARGS (end - start), i, name);
+}
+
 
 gint
 main (gint argc, gchar * argv[])
 {
   GstCaps **capses;
-  GstCaps *protocaps;
+  GstCaps *protocaps, *fixed;
   GstClockTime start, end;
   gint i;
 
@@ -69,6 +123,17 @@ main (gint argc, gchar * argv[])
       GST_TIME_ARGS (end - start), i);
 
   g_free (capses);
+
+  /* the typical operations done on the caps during negotiation */
+  fixed = gst_caps_from_string (FIXED_CAPS);
+  run_negotiation ("audio", protocaps, fixed);
+  gst_caps_unref (fixed);
+  gst_caps_unref (protocaps);
+
+  protocaps = gst_caps_from_string (VIDEO_CAPS);
+  fixed = gst_caps_from_string (FIXED_VIDEO_CAPS);
+  run_negotiation ("video", protocaps, fixed);
+  gst_caps_unref (fixed);
   gst_caps_unref (protocaps);
 
   return 0;
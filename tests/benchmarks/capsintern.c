@@ -0,0 +1,123 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * capsintern.c: benchmark for interned caps
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Creates a large set of fixed caps with only a few different ones among
+ * them, like the caps events in a big application, and compares them with
+ * and without interning. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gst/gst.h>
+
+#define NUM_CAPS 100000
+
+static const gchar *formats[] = { "S16LE", "S32LE", "F32LE", "U8" };
+static const gint rates[] = { 8000, 16000, 22050, 32000, 44100, 48000, 96000 };
+
+static GstCaps *
+make_caps (gint i, gint num_distinct)
+{
+  gint n = i % num_distinct;
+
+  return gst_caps_new_simple ("audio/x-raw",
+      "format", G_TYPE_STRING, formats[n % G_N_ELEMENTS (formats)],
+      "rate", G_TYPE_INT, rates[n % G_N_ELEMENTS (rates)],
+      "channels", G_TYPE_INT, 1 + n / 28,
+      "layout", G_TYPE_STRING, "interleaved", NULL);
+}
+
+static void
+run_test (gint num_distinct, gboolean intern)
+{
+  GstCaps **caps;
+  GstClockTime start, end;
+  GHashTable *unique;
+  gint i, equal = 0;
+
+  caps = g_new (GstCaps *, NUM_CAPS);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_CAPS; i++) {
+    caps[i] = make_caps (i, num_distinct);
+    if (intern)
+      caps[i] = gst_caps_intern (caps[i]);
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%-8s: %" GST_TIME_FORMAT " - creating %d caps\n",
+      intern ? "interned" : "plain", GST_TIME_ARGS (end - start), i);
+
+  /* the number of caps that are kept in memory */
+  unique = g_hash_table_new (NULL, NULL);
+  for (i = 0; i < NUM_CAPS; i++)
+    g_hash_table_add (unique, caps[i]);
+  g_print ("%-8s: %u caps objects in memory\n",
+      intern ? "interned" : "plain", g_hash_table_size (unique));
+  g_hash_table_destroy (unique);
+
+  /* compare with the previous caps with the same content and with the next
+   * caps which is different */
+  start = gst_util_get_timestamp ();
+  for (i = num_distinct; i < NUM_CAPS - 1; i++) {
+    if (gst_caps_is_equal (caps[i], caps[i - num_distinct]))
+      equal++;
+    if (gst_caps_is_equal (caps[i], caps[i + 1]))
+      equal++;
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%-8s: %" GST_TIME_FORMAT " - %d comparisons, %d equal\n",
+      intern ? "interned" : "plain", GST_TIME_ARGS (end - start),
+      2 * (NUM_CAPS - 1 - num_distinct), equal);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_CAPS; i++)
+    gst_caps_unref (caps[i]);
+  end = gst_util_get_timestamp ();
+  g_print ("%-8s: %" GST_TIME_FORMAT " - destroying %d caps\n",
+      intern ? "interned" : "plain", GST_TIME_ARGS (end - start), i);
+
+  g_free (caps);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  gint num_distinct = 100;
+
+  gst_init (&argc, &argv);
+
+  if (argc > 2) {
+    g_print ("usage: %s [<num_distinct_caps>]\n", argv[0]);
+    exit (-1);
+  }
+
+  if (argc == 2)
+    num_distinct = atoi (argv[1]);
+
+  if (num_distinct <= 0 || num_distinct >= NUM_CAPS) {
+    g_print ("number of distinct caps must be between 0 and %d\n", NUM_CAPS);
+    exit (-2);
+  }
+
+  run_test (num_distinct, FALSE);
+  run_test (num_distinct, TRUE);
+
+  return 0;
+}
@@ -0,0 +1,191 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * datapath.c: benchmark for the per-buffer cost of the data path
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Pushes buffers into chains of identity, tee and ghost-padded elements of
+ * different lengths, with the chain split over a number of threads with
+ * queues, and prints the time per buffer. Run with
+ * GST_PAD_LATENCY_HISTOGRAM=1 GST_DEBUG=GST_PERFORMANCE:4 to get the time
+ * spent downstream of every pad in the debug log. */
+
+#include <gst/gst.h>
+
+#define NUM_BUFFERS 200000
+#define LIST_SIZE 64
+
+typedef enum
+{
+  TOPOLOGY_IDENTITY,
+  TOPOLOGY_GHOST,
+  TOPOLOGY_TEE
+} Topology;
+
+static const gchar *topology_names[] = { "identity", "ghost", "tee" };
+
+static const guint lengths[] = { 1, 8, 32 };
+static const guint threads[] = { 1, 2, 4 };
+
+static GstElement *
+make_stage (Topology topology)
+{
+  GstElement *element, *bin;
+  GstPad *pad;
+
+  switch (topology) {
+    case TOPOLOGY_TEE:
+      return gst_element_factory_make ("tee", NULL);
+    case TOPOLOGY_GHOST:
+      bin = gst_bin_new (NULL);
+      element = gst_element_factory_make ("identity", NULL);
+      g_object_set (element, "silent", TRUE, NULL);
+      gst_bin_add (GST_BIN (bin), element);
+      pad = gst_element_get_static_pad (element, "sink");
+      gst_element_add_pad (bin, gst_ghost_pad_new ("sink", pad));
+      gst_object_unref (pad);
+      pad = gst_element_get_static_pad (element, "src");
+      gst_element_add_pad (bin, gst_ghost_pad_new ("src", pad));
+      gst_object_unref (pad);
+      return bin;
+    case TOPOLOGY_IDENTITY:
+    default:
+      element = gst_element_factory_make ("identity", NULL);
+      g_object_set (element, "silent", TRUE, NULL);
+      return element;
+  }
+}
+
+static void
+run_test (Topology topology, guint length, guint n_threads, gboolean lists)
+{
+  GstElement *pipeline, *first = NULL, *prev = NULL, *element, *sink;
+  GstPad *src, *pad;
+  GstBuffer *buf;
+  GstBufferList *list = NULL;
+  GstSegment segment;
+  GstCaps *caps;
+  GstMessage *msg;
+  GstClockTime start, end;
+  gdouble per_buffer;
+  guint i, n_queues = 0;
+
+  pipeline = gst_pipeline_new (NULL);
+
+  for (i = 0; i < length; i++) {
+    /* split the chain in n_threads parts */
+    if (i > 0 && (i * n_threads) / length != ((i - 1) * n_threads) / length) {
+      element = gst_element_factory_make ("queue", NULL);
+      gst_bin_add (GST_BIN (pipeline), element);
+      gst_element_link (prev, element);
+      prev = element;
+      n_queues++;
+    }
+    element = make_stage (topology);
+    gst_bin_add (GST_BIN (pipeline), element);
+    if (prev)
+      gst_element_link (prev, element);
+    else
+      first = element;
+    prev = element;
+  }
+  /* short chains get the remaining threads at the end */
+  for (; n_queues < n_threads - 1; n_queues++) {
+    element = gst_element_factory_make ("queue", NULL);
+    gst_bin_add (GST_BIN (pipeline), element);
+    gst_element_link (prev, element);
+    prev = element;
+  }
+
+  sink = gst_element_factory_make ("fakesink", NULL);
+  g_object_set (sink, "sync", FALSE, "silent", TRUE, "enable-last-sample",
+      FALSE, NULL);
+  gst_bin_add (GST_BIN (pipeline), sink);
+  gst_element_link (prev, sink);
+
+  /* push into the first element from our own pad */
+  src = gst_pad_new ("src", GST_PAD_SRC);
+  pad = gst_element_get_static_pad (first, "sink");
+  gst_pad_link (src, pad);
+  gst_object_unref (pad);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  gst_pad_set_active (src, TRUE);
+
+  gst_pad_push_event (src, gst_event_new_stream_start ("datapath"));
+  caps = gst_caps_new_empty_simple ("foo/bar");
+  gst_pad_push_event (src, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (src, gst_event_new_segment (&segment));
+
+  buf = gst_buffer_new_allocate (NULL, 64, NULL);
+  if (lists) {
+    list = gst_buffer_list_new_sized (LIST_SIZE);
+    for (i = 0; i < LIST_SIZE; i++)
+      gst_buffer_list_add (list, gst_buffer_ref (buf));
+  }
+
+  start = gst_util_get_timestamp ();
+  if (lists) {
+    for (i = 0; i < NUM_BUFFERS; i += LIST_SIZE)
+      gst_pad_push_list (src, gst_buffer_list_ref (list));
+  } else {
+    for (i = 0; i < NUM_BUFFERS; i++)
+      gst_pad_push (src, gst_buffer_ref (buf));
+  }
+  gst_pad_push_event (src, gst_event_new_eos ());
+
+  msg = gst_bus_timed_pop_filtered (GST_ELEMENT_BUS (pipeline),
+      GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  end = gst_util_get_timestamp ();
+  gst_message_unref (msg);
+
+  per_buffer = (gdouble) (end - start) / i;
+  g_print ("%-8s length %3u threads %u %-7s: %8.1f ns/buffer "
+      "%12.0f buffers/s\n", topology_names[topology], length, n_threads,
+      lists ? "lists" : "buffers", per_buffer, 1e9 / per_buffer);
+
+  if (list)
+    gst_buffer_list_unref (list);
+  gst_buffer_unref (buf);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_pad_set_active (src, FALSE);
+  gst_object_unref (src);
+  gst_object_unref (pipeline);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint t, l, n;
+
+  gst_init (&argc, &argv);
+
+  for (t = TOPOLOGY_IDENTITY; t <= TOPOLOGY_TEE; t++) {
+    for (l = 0; l < G_N_ELEMENTS (lengths); l++) {
+      for (n = 0; n < G_N_ELEMENTS (threads); n++) {
+        run_test (t, lengths[l], threads[n], FALSE);
+        run_test (t, lengths[l], threads[n], TRUE);
+      }
+    }
+  }
+
+  return 0;
+}
@@ -17,16 +17,78 @@
  * Boston, MA 02110-1301, USA.
  */
 
+
+/* Creates and frees buffers from a number of threads at the same time and
+ * prints the hit rate of the buffer and memory caches. */
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <gst/gst.h>
 #include "gst/glib-compat-private.h"
 
 #define MAX_THREADS  1000
 
+/* buffers that are handed over to another thread at once in cross mode */
+#define BATCH        64
+
+typedef enum
+{
+  MODE_NEW,
+  MODE_ALLOCATE,
+  MODE_CROSS
+} TestMode;
+
 static guint64 nbbuffers;
 static GMutex mutex;
+static TestMode mode;
+
+/* batch of buffers left behind for another thread to free */
+static GMutex cross_lock;
+static GstBuffer **cross_batch;
 
+/* a few typical sizes of audio and compressed video buffers */
+static const gsize sizes[] = { 192, 1024, 4096, 1400, 3840, 16384 };
+
+static GstBuffer *
+new_buffer (guint64 nb)
+{
+  if (mode == MODE_NEW)
+    return gst_buffer_new ();
+
+  return gst_buffer_new_allocate (NULL, sizes[nb % G_N_ELEMENTS (sizes)],
+      NULL);
+}
+
+static void
+run_cross (guint64 n)
+{
+  GstBuffer **batch, **other;
+  guint64 nb;
+  gint i;
+
+  batch = g_new (GstBuffer *, BATCH);
+
+  for (nb = n; nb >= BATCH; nb -= BATCH) {
+    for (i = 0; i < BATCH; i++)
+      batch[i] = new_buffer (nb + i);
+
+    /* swap our batch with the one of another thread and free that one */
+    g_mutex_lock (&cross_lock);
+    other = cross_batch;
+    cross_batch = batch;
+    g_mutex_unlock (&cross_lock);
+
+    if (other) {
+      for (i = 0; i < BATCH; i++)
+        gst_buffer_unref (other[i]);
+      batch = other;
+    } else {
+      batch = g_new (GstBuffer *, BATCH);
+    }
+  }
+  g_free (batch);
+}
 
 static void *
 run_test (void *user_data)
@@ -43,9 +105,13 @@ run_test (void *user_data)
 
   g_assert (nbbuffers > 0);
 
-  for (nb = nbbuffers; nb; nb--) {
-    buf = gst_buffer_new ();
-    gst_buffer_unref (buf);
+  if (mode == MODE_CROSS) {
+    run_cross (nbbuffers);
+  } else {
+    for (nb = nbbuffers; nb; nb--) {
+      buf = new_buffer (nb);
+      gst_buffer_unref (buf);
+    }
   }
 
   end = gst_util_get_timestamp ();
@@ -58,25 +124,46 @@ run_test (void *user_data)
   return NULL;
 }
 
+static TestMode
+parse_mode (const gchar * str)
+{
+  if (str == NULL || !strcmp (str, "new"))
+    return MODE_NEW;
+  if (!strcmp (str, "allocate"))
+    return MODE_ALLOCATE;
+  if (!strcmp (str, "cross"))
+    return MODE_CROSS;
+
+  g_print ("unknown mode %s\n", str);
+  exit (-4);
+}
+
 gint
 main (gint argc, gchar * argv[])
 {
   GThread *threads[MAX_THREADS];
   gint num_threads;
-  gint t;
+  gint t, i;
   GstBuffer *tmp;
   GstClockTime start, end;
+  GstStructure *stats;
+  gchar *str;
 
   gst_init (&argc, &argv);
   g_mutex_init (&mutex);
 
-  if (argc != 3) {
-    g_print ("usage: %s <num_threads> <nbbuffers>\n", argv[0]);
+  if (argc != 3 && argc != 4) {
+    g_print ("usage: %s <num_threads> <nbbuffers> [new|allocate|cross]\n",
+        argv[0]);
+    g_print ("  new:      create and free buffers without memory\n");
+    g_print ("  allocate: create and free buffers with memory\n");
+    g_print ("  cross:    buffers with memory are freed by another thread\n");
     exit (-1);
   }
 
   num_threads = atoi (argv[1]);
   nbbuffers = atoi (argv[2]);
+  mode = parse_mode (argc == 4 ? argv[3] : NULL);
 
   if (num_threads <= 0 || num_threads > MAX_THREADS) {
     g_print ("number of threads must be between 0 and %d\n", MAX_THREADS);
@@ -121,8 +208,22 @@ main (gint argc, gchar * argv[])
       GST_TIME_ARGS ((end - start) / (num_threads * nbbuffers)),
       num_threads * nbbuffers);
 
+  stats = gst_allocator_get_cache_stats ();
+  str = gst_structure_to_string (stats);
+  g_print ("*** %s\n", str);
+  g_free (str);
+  gst_structure_free (stats);
+
+  if (cross_batch) {
+    for (i = 0; i < BATCH; i++)
+      gst_buffer_unref (cross_batch[i]);
+    g_free (cross_batch);
+  }
 
   gst_buffer_unref (tmp);
 
+  /* logs the cache statistics */
+  gst_deinit ();
+
   return 0;
 }
@@ -19,13 +19,31 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <gst/gst.h>
 #include <gst/glib-compat-private.h>
 
 #define MAX_THREADS  100
+#define MAX_WAITERS  10000
+
+/* the interval of the waits, the waiters are spread over it */
+#define INTERVAL     (10 * GST_MSECOND)
+
+typedef enum
+{
+  MODE_GET_TIME,
+  MODE_WAIT,
+  MODE_ASYNC,
+  MODE_PERIODIC
+} TestMode;
 
 static gboolean running = TRUE;
 static gint count = 0;
+static gint num_waiters;
+
+/* sum of the jitter of all waits */
+static GMutex jitter_lock;
+static GstClockTimeDiff total_jitter = 0;
 
 static void *
 run_test (void *user_data)
@@ -43,55 +61,196 @@ run_test (void *user_data)
   return NULL;
 }
 
+static GstClockTime
+get_start_time (GstClock * sysclock, gint index)
+{
+  return gst_clock_get_time (sysclock) + INTERVAL +
+      gst_util_uint64_scale_int (INTERVAL, index, num_waiters);
+}
+
+/* single shot sync waits, one thread per waiter */
+static void *
+run_wait_test (void *user_data)
+{
+  GstClock *sysclock = gst_system_clock_obtain ();
+  GstClockTime time;
+  GstClockTimeDiff jitter, sum = 0;
+  GstClockID id;
+  gint n = 0;
+
+  time = get_start_time (sysclock, GPOINTER_TO_INT (user_data));
+  id = gst_clock_new_single_shot_id (sysclock, time);
+
+  while (running) {
+    gst_clock_id_wait (id, &jitter);
+    sum += jitter;
+    n++;
+
+    time += INTERVAL;
+    gst_clock_single_shot_id_reinit (sysclock, id, time);
+  }
+  gst_clock_id_unref (id);
+  gst_object_unref (sysclock);
+
+  g_atomic_int_add (&count, n);
+  g_mutex_lock (&jitter_lock);
+  total_jitter += sum;
+  g_mutex_unlock (&jitter_lock);
+
+  g_thread_exit (NULL);
+  return NULL;
+}
+
+/* called from the clock thread for the async waits */
+static gboolean
+async_cb (GstClock * clock, GstClockTime time, GstClockID id,
+    gpointer user_data)
+{
+  GstClockTime now = gst_clock_get_time (clock);
+
+  g_atomic_int_inc (&count);
+  total_jitter += GST_CLOCK_DIFF (time, now);
+
+  /* schedule a new single shot wait for the next interval */
+  if (user_data && running) {
+    GstClockID next;
+
+    next = gst_clock_new_single_shot_id (clock, time + INTERVAL);
+    gst_clock_id_wait_async (next, async_cb, user_data, NULL);
+    gst_clock_id_unref (next);
+  }
+  return TRUE;
+}
+
+static TestMode
+parse_mode (const gchar * str)
+{
+  if (str == NULL || !strcmp (str, "get-time"))
+    return MODE_GET_TIME;
+  if (!strcmp (str, "wait"))
+    return MODE_WAIT;
+  if (!strcmp (str, "async"))
+    return MODE_ASYNC;
+  if (!strcmp (str, "periodic"))
+    return MODE_PERIODIC;
+
+  g_print ("unknown mode %s\n", str);
+  exit (-3);
+}
+
 gint
 main (gint argc, gchar * argv[])
 {
-  GThread *threads[MAX_THREADS];
-  gint num_threads;
+  GThread **threads = NULL;
+  GstClockID *ids = NULL;
+  gint num_threads = 0;
   gint t;
+  TestMode mode;
   GstClock *sysclock;
 
   gst_init (&argc, &argv);
 
-  if (argc != 2) {
-    g_print ("usage: %s <num_threads>\n", argv[0]);
+  if (argc != 2 && argc != 3) {
+    g_print ("usage: %s <num_threads> [get-time|wait|async|periodic]\n",
+        argv[0]);
+    g_print ("  get-time: <num_threads> threads call gst_clock_get_time()\n");
+    g_print ("  wait:     <num_threads> threads do single shot sync waits\n");
+    g_print ("  async:    <num_threads> chains of single shot async waits\n");
+    g_print ("  periodic: <num_threads> periodic async waits\n");
     exit (-1);
   }
 
-  num_threads = atoi (argv[1]);
+  num_waiters = atoi (argv[1]);
+  mode = parse_mode (argc == 3 ? argv[2] : NULL);
 
-  if (num_threads <= 0 || num_threads > MAX_THREADS) {
-    g_print ("number of threads must be between 0 and %d\n", MAX_THREADS);
+  if (mode == MODE_GET_TIME) {
+    if (num_waiters <= 0 || num_waiters > MAX_THREADS) {
+      g_print ("number of threads must be between 0 and %d\n", MAX_THREADS);
+      exit (-2);
+    }
+  } else if (num_waiters <= 0 || num_waiters > MAX_WAITERS) {
+    g_print ("number of waiters must be between 0 and %d\n", MAX_WAITERS);
     exit (-2);
   }
 
   sysclock = gst_system_clock_obtain ();
 
-  for (t = 0; t < num_threads; t++) {
-    GError *error = NULL;
+  switch (mode) {
+    case MODE_GET_TIME:
+    case MODE_WAIT:
+      num_threads = num_waiters;
+      threads = g_new (GThread *, num_threads);
 
-    threads[t] = g_thread_try_new ("clockstresstest", run_test,
-        sysclock, &error);
+      for (t = 0; t < num_threads; t++) {
+        GError *error = NULL;
 
-    if (error) {
-      printf ("ERROR: g_thread_try_new() %s\n", error->message);
-      exit (-1);
-    }
+        if (mode == MODE_GET_TIME)
+          threads[t] = g_thread_try_new ("clockstresstest", run_test,
+              sysclock, &error);
+        else
+          threads[t] = g_thread_try_new ("clockstresstest", run_wait_test,
+              GINT_TO_POINTER (t), &error);
+
+        if (error) {
+          printf ("ERROR: g_thread_try_new() %s\n", error->message);
+          exit (-1);
+        }
+      }
+      printf ("main(): Created %d threads.\n", t);
+      break;
+    case MODE_ASYNC:
+      for (t = 0; t < num_waiters; t++) {
+        GstClockID id;
+
+        id = gst_clock_new_single_shot_id (sysclock,
+            get_start_time (sysclock, t));
+        gst_clock_id_wait_async (id, async_cb, GINT_TO_POINTER (TRUE), NULL);
+        gst_clock_id_unref (id);
+      }
+      printf ("main(): Scheduled %d async waits.\n", t);
+      break;
+    case MODE_PERIODIC:
+      ids = g_new (GstClockID, num_waiters);
+
+      for (t = 0; t < num_waiters; t++) {
+        ids[t] = gst_clock_new_periodic_id (sysclock,
+            get_start_time (sysclock, t), INTERVAL);
+        gst_clock_id_wait_async (ids[t], async_cb, NULL, NULL);
+      }
+      printf ("main(): Scheduled %d periodic waits.\n", t);
+      break;
   }
-  printf ("main(): Created %d threads.\n", t);
 
   /* run for 5 seconds */
   g_usleep (G_USEC_PER_SEC * 5);
 
-  printf ("main(): Stopping threads...\n");
+  printf ("main(): Stopping...\n");
 
   running = FALSE;
 
   for (t = 0; t < num_threads; t++) {
     g_thread_join (threads[t]);
   }
+  g_free (threads);
 
-  g_print ("performed %d get_time operations\n", count);
+  if (ids) {
+    for (t = 0; t < num_waiters; t++) {
+      gst_clock_id_unschedule (ids[t]);
+      gst_clock_id_unref (ids[t]);
+    }
+    g_free (ids);
+  }
+
+  /* let the pending async waits finish */
+  if (mode == MODE_ASYNC)
+    g_usleep (2 * INTERVAL / GST_USECOND);
+
+  if (mode == MODE_GET_TIME) {
+    g_print ("performed %d get_time operations\n", count);
+  } else {
+    g_print ("performed %d wait operations, average jitter %" G_GINT64_FORMAT
+        " ns\n", count, count ? total_jitter / count : 0);
+  }
 
   gst_object_unref (sysclock);
 
@@ -18,93 +18,102 @@
  * Boston, MA 02110-1301, USA.
  */
 
+/* Waits on a set with <num_fds> socket fds of which a few are readable, while
+ * <num_threads> - 1 other threads add, remove and change fds in the set.
+ * The optional <poll_mode> is used for GST_POLL_MODE so that the different
+ * backends can be compared. */
+
 #include <stdio.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
 #include <gst/gst.h>
 #include "gst/glib-compat-private.h"
 
+#define MAX_THREADS  100
+#define MAX_FDS      10000
+
+/* one in this many fds has data to read */
+#define READABLE     100
+
+typedef struct
+{
+  GstPollFD fd;
+  gint peer;
+  gboolean added;
+} TestFD;
+
 static GstPoll *set;
-static GList *fds = NULL;
+static TestFD *fds;
+static gint num_fds;
 static GMutex fdlock;
-static GTimer *timer;
-
-#define MAX_THREADS  100
+static gboolean running = TRUE;
+static gint waits = 0;
 
 static void
 mess_some_more (void)
 {
-  GList *walk;
-  gint random;
-  gint removed = 0;
+  gint i, random;
 
   g_mutex_lock (&fdlock);
 
-  for (walk = fds; walk;) {
-    GstPollFD *fd = (GstPollFD *) walk->data;
-
-    walk = g_list_next (walk);
+  for (i = 0; i < num_fds; i++) {
+    TestFD *tfd = &fds[i];
 
     random = (gint) (10.0 * rand () / (RAND_MAX + 1.0));
+
+    if (!tfd->added) {
+      if (random == 0) {
+        gst_poll_add_fd (set, &tfd->fd);
+        gst_poll_fd_ctl_read (set, &tfd->fd, TRUE);
+        tfd->added = TRUE;
+      }
+      continue;
+    }
+
     switch (random) {
       case 0:
-      {
-        /*
-           GstPollFD *newfd = g_new0 (GstPollFD, 1);
-
-           gst_poll_add_fd (set, newfd);
-           fds = g_list_prepend (fds, newfd);
-         */
         break;
-      }
       case 1:
         if ((gint) (10.0 * rand () / (RAND_MAX + 1.0)) < 2) {
-          gst_poll_remove_fd (set, fd);
-          fds = g_list_remove (fds, fd);
-          g_free (fd);
-          removed++;
+          gst_poll_remove_fd (set, &tfd->fd);
+          tfd->added = FALSE;
         }
         break;
 
       case 2:
-        gst_poll_fd_ctl_write (set, fd, TRUE);
+        /* most sockets are always writable, keep that rare */
+        if ((gint) (10.0 * rand () / (RAND_MAX + 1.0)) < 1)
+          gst_poll_fd_ctl_write (set, &tfd->fd, TRUE);
         break;
       case 3:
-        gst_poll_fd_ctl_write (set, fd, FALSE);
+        gst_poll_fd_ctl_write (set, &tfd->fd, FALSE);
         break;
       case 4:
-        gst_poll_fd_ctl_read (set, fd, TRUE);
+        gst_poll_fd_ctl_read (set, &tfd->fd, TRUE);
         break;
       case 5:
-        gst_poll_fd_ctl_read (set, fd, FALSE);
+        gst_poll_fd_ctl_read (set, &tfd->fd, FALSE);
         break;
 
       case 6:
-        gst_poll_fd_has_closed (set, fd);
+        gst_poll_fd_has_closed (set, &tfd->fd);
         break;
       case 7:
-        gst_poll_fd_has_error (set, fd);
+        gst_poll_fd_has_error (set, &tfd->fd);
         break;
       case 8:
-        gst_poll_fd_can_read (set, fd);
+        gst_poll_fd_can_read (set, &tfd->fd);
         break;
       case 9:
-        gst_poll_fd_can_write (set, fd);
+        gst_poll_fd_can_write (set, &tfd->fd);
         break;
       default:
         g_assert_not_reached ();
         break;
     }
   }
-  if (g_list_length (fds) < 900) {
-    random = removed + (gint) (2.0 * rand () / (RAND_MAX + 1.0));
-    while (random) {
-      GstPollFD *newfd = g_new0 (GstPollFD, 1);
-
-      gst_poll_add_fd (set, newfd);
-      fds = g_list_prepend (fds, newfd);
-      random--;
-    }
-  }
 
   g_mutex_unlock (&fdlock);
 }
@@ -114,21 +123,16 @@ run_test (void *threadid)
 {
   gint id = GPOINTER_TO_INT (threadid);
 
-  while (TRUE) {
+  while (running) {
     if (id == 0) {
-      gint res = gst_poll_wait (set, 10);
+      gint res = gst_poll_wait (set, 10 * GST_MSECOND);
 
-      if (res < 0) {
+      if (res < 0 && errno != EBUSY) {
         g_print ("error %d %s\n", errno, g_strerror (errno));
       }
+      waits++;
     } else {
       mess_some_more ();
-      if (g_timer_elapsed (timer, NULL) > 0.5) {
-        g_mutex_lock (&fdlock);
-        g_print ("active fds :%u\n", g_list_length (fds));
-        g_timer_start (timer);
-        g_mutex_unlock (&fdlock);
-      }
       g_usleep (1);
     }
   }
@@ -140,23 +144,60 @@ gint
 main (gint argc, gchar * argv[])
 {
   GThread *threads[MAX_THREADS];
+  GstClockTime start, end;
+  const gchar *mode;
   gint num_threads;
-  gint t;
+  gint t, i;
+
+  if (argc < 2 || argc > 4) {
+    g_print ("usage: %s <num_threads> [<num_fds> [<poll_mode>]]\n", argv[0]);
+    g_print ("  poll_mode: auto, epoll, ppoll, poll, pselect or select\n");
+    exit (-1);
+  }
+
+  /* must be set before the first GstPoll is created */
+  mode = argc == 4 ? argv[3] : "auto";
+  g_setenv ("GST_POLL_MODE", mode, TRUE);
 
   gst_init (&argc, &argv);
 
   g_mutex_init (&fdlock);
-  timer = g_timer_new ();
-
-  if (argc != 2) {
-    g_print ("usage: %s <num_threads>\n", argv[0]);
-    exit (-1);
-  }
 
   num_threads = atoi (argv[1]);
+  num_fds = argc > 2 ? atoi (argv[2]) : 900;
+
+  if (num_threads <= 0 || num_threads > MAX_THREADS) {
+    g_print ("number of threads must be between 0 and %d\n", MAX_THREADS);
+    exit (-2);
+  }
+  if (num_fds <= 0 || num_fds > MAX_FDS) {
+    g_print ("number of fds must be between 0 and %d\n", MAX_FDS);
+    exit (-3);
+  }
 
   set = gst_poll_new (TRUE);
 
+  fds = g_new0 (TestFD, num_fds);
+  for (i = 0; i < num_fds; i++) {
+    gint sv[2];
+
+    if (socketpair (PF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+      g_print ("can't create socket pair %d: %s\n", i, g_strerror (errno));
+      exit (-4);
+    }
+    gst_poll_fd_init (&fds[i].fd);
+    fds[i].fd.fd = sv[0];
+    fds[i].peer = sv[1];
+
+    if (i % READABLE == 0 && write (sv[1], "R", 1) != 1)
+      g_print ("can't write to socket %d\n", i);
+
+    gst_poll_add_fd (set, &fds[i].fd);
+    gst_poll_fd_ctl_read (set, &fds[i].fd, TRUE);
+    fds[i].added = TRUE;
+  }
+
+  start = gst_util_get_timestamp ();
   for (t = 0; t < num_threads; t++) {
     GError *error = NULL;
 
@@ -170,9 +211,28 @@ main (gint argc, gchar * argv[])
   }
   printf ("main(): Created %d threads.\n", t);
 
+  /* run for 5 seconds */
+  g_usleep (G_USEC_PER_SEC * 5);
+
+  running = FALSE;
+  gst_poll_set_flushing (set, TRUE);
+
   for (t = 0; t < num_threads; t++) {
     g_thread_join (threads[t]);
   }
+  end = gst_util_get_timestamp ();
+
+  g_print ("%s: performed %d waits on %d fds, %" G_GUINT64_FORMAT
+      " ns per wait\n", mode, waits, num_fds,
+      waits ? (end - start) / waits : 0);
+
+  for (i = 0; i < num_fds; i++) {
+    if (fds[i].added)
+      gst_poll_remove_fd (set, &fds[i].fd);
+    close (fds[i].fd.fd);
+    close (fds[i].peer);
+  }
+  g_free (fds);
 
   gst_poll_free (set);
 
@@ -17,38 +17,99 @@
  * Boston, MA 02110-1301, USA.
  */
 
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <gst/gst.h>
 #include "gst/glib-compat-private.h"
 
 #define BUFFER_SIZE (1400)
+#define MAX_THREADS 100
+
+/* buffers that a producer holds on to before releasing them */
+#define IN_FLIGHT   4
+
+static GstBufferPool *pool;
+static guint64 nbuffers;
+static GMutex start_lock;
+
+static void *
+run_test (void *user_data)
+{
+  gboolean pooled = GPOINTER_TO_INT (user_data);
+  GstBuffer *bufs[IN_FLIGHT];
+  guint64 i;
+  gint j;
+
+  g_mutex_lock (&start_lock);
+  g_mutex_unlock (&start_lock);
+
+  for (i = 0; i < nbuffers; i += IN_FLIGHT) {
+    for (j = 0; j < IN_FLIGHT; j++) {
+      if (pooled)
+        gst_buffer_pool_acquire_buffer (pool, &bufs[j], NULL);
+      else
+        bufs[j] = gst_buffer_new_allocate (NULL, BUFFER_SIZE, NULL);
+    }
+    for (j = 0; j < IN_FLIGHT; j++)
+      gst_buffer_unref (bufs[j]);
+  }
+  return NULL;
+}
+
+/* run @num_threads producers and return the time it took */
+static GstClockTimeDiff
+run_producers (gint num_threads, gboolean pooled)
+{
+  GThread *threads[MAX_THREADS];
+  GstClockTime start, end;
+  gint t;
+
+  g_mutex_lock (&start_lock);
+  for (t = 0; t < num_threads; t++) {
+    threads[t] = g_thread_new ("poolstresstest", run_test,
+        GINT_TO_POINTER (pooled));
+  }
+  start = gst_util_get_timestamp ();
+  g_mutex_unlock (&start_lock);
+
+  for (t = 0; t < num_threads; t++)
+    g_thread_join (threads[t]);
+  end = gst_util_get_timestamp ();
+
+  return GST_CLOCK_DIFF (start, end);
+}
 
 gint
 main (gint argc, gchar * argv[])
 {
-  gint i;
   GstBuffer *tmp;
-  GstBufferPool *pool;
-  GstClockTime start, end;
   GstClockTimeDiff dur1, dur2;
-  guint64 nbuffers;
   GstStructure *conf;
+  gint num_threads = 1;
+  guint64 total;
 
   gst_init (&argc, &argv);
 
-  if (argc != 2) {
-    g_print ("usage: %s <nbuffers>\n", argv[0]);
+  if (argc != 2 && argc != 3) {
+    g_print ("usage: %s <nbuffers> [<num_threads>]\n", argv[0]);
     exit (-1);
   }
 
   nbuffers = atoi (argv[1]);
+  if (argc == 3)
+    num_threads = atoi (argv[2]);
 
   if (nbuffers <= 0) {
     g_print ("number of buffers must be greater than 0\n");
     exit (-3);
   }
 
+  if (num_threads <= 0 || num_threads > MAX_THREADS) {
+    g_print ("number of threads must be between 0 and %d\n", MAX_THREADS);
+    exit (-2);
+  }
+
   /* Let's just make sure the GstBufferClass is loaded ... */
   tmp = gst_buffer_new ();
   gst_buffer_unref (tmp);
@@ -61,29 +122,19 @@ main (gint argc, gchar * argv[])
 
   gst_buffer_pool_set_active (pool, TRUE);
 
+  total = ((nbuffers + IN_FLIGHT - 1) / IN_FLIGHT) * IN_FLIGHT * num_threads;
+
   /* allocate buffers directly */
-  start = gst_util_get_timestamp ();
-  for (i = 0; i < nbuffers; i++) {
-    tmp = gst_buffer_new_allocate (NULL, BUFFER_SIZE, NULL);
-    gst_buffer_unref (tmp);
-  }
-  end = gst_util_get_timestamp ();
-  dur1 = GST_CLOCK_DIFF (start, end);
+  dur1 = run_producers (num_threads, FALSE);
   g_print ("*** total %" GST_TIME_FORMAT " - average %" GST_TIME_FORMAT
-      "  - Done creating %" G_GUINT64_FORMAT " fresh buffers\n",
-      GST_TIME_ARGS (dur1), GST_TIME_ARGS (dur1 / nbuffers), nbuffers);
+      "  - Done creating %" G_GUINT64_FORMAT " fresh buffers in %d threads\n",
+      GST_TIME_ARGS (dur1), GST_TIME_ARGS (dur1 / total), total, num_threads);
 
   /* allocate buffers from the pool */
-  start = gst_util_get_timestamp ();
-  for (i = 0; i < nbuffers; i++) {
-    gst_buffer_pool_acquire_buffer (pool, &tmp, NULL);
-    gst_buffer_unref (tmp);
-  }
-  end = gst_util_get_timestamp ();
-  dur2 = GST_CLOCK_DIFF (start, end);
+  dur2 = run_producers (num_threads, TRUE);
   g_print ("*** total %" GST_TIME_FORMAT " - average %" GST_TIME_FORMAT
-      "  - Done creating %" G_GUINT64_FORMAT " pooled buffers\n",
-      GST_TIME_ARGS (dur2), GST_TIME_ARGS (dur2 / nbuffers), nbuffers);
+      "  - Done creating %" G_GUINT64_FORMAT " pooled buffers in %d threads\n",
+      GST_TIME_ARGS (dur2), GST_TIME_ARGS (dur2 / total), total, num_threads);
 
   g_print ("*** speedup %6.4lf\n", ((gdouble) dur1 / (gdouble) dur2));
 
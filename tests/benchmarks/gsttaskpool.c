@@ -0,0 +1,154 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Runs a number of tasks that each do a fixed amount of iterations, first
+ * on the default task pool and then on a #GstWorkerTaskPool. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gst/gst.h>
+
+#define MAX_TASKS  1000
+
+typedef struct
+{
+  GstTask *task;
+  GRecMutex lock;
+  gint iterations;
+  guint32 state;
+} TaskData;
+
+static GMutex done_lock;
+static GCond done_cond;
+static gint remaining;
+static gint iterations;
+
+static void
+task_func (TaskData * data)
+{
+  gint i;
+
+  /* a little bit of work per iteration */
+  for (i = 0; i < 64; i++)
+    data->state = data->state * 1664525 + 1013904223;
+
+  if (++data->iterations == iterations) {
+    gst_task_stop (data->task);
+
+    g_mutex_lock (&done_lock);
+    if (--remaining == 0)
+      g_cond_signal (&done_cond);
+    g_mutex_unlock (&done_lock);
+  }
+}
+
+static void
+run_test (GstTaskPool * pool, gint num_tasks, const gchar * name)
+{
+  TaskData *data;
+  GstClockTime start, end;
+  gint t;
+
+  data = g_new0 (TaskData, num_tasks);
+
+  for (t = 0; t < num_tasks; t++) {
+    g_rec_mutex_init (&data[t].lock);
+    data[t].state = t;
+    data[t].task = gst_task_new ((GstTaskFunction) task_func, &data[t], NULL);
+    gst_task_set_lock (data[t].task, &data[t].lock);
+    /* the task function doesn't block */
+    gst_task_set_cooperative (data[t].task, TRUE);
+    if (pool)
+      gst_task_set_pool (data[t].task, pool);
+  }
+
+  remaining = num_tasks;
+
+  start = gst_util_get_timestamp ();
+  for (t = 0; t < num_tasks; t++)
+    gst_task_start (data[t].task);
+
+  g_mutex_lock (&done_lock);
+  while (remaining > 0)
+    g_cond_wait (&done_cond, &done_lock);
+  g_mutex_unlock (&done_lock);
+  end = gst_util_get_timestamp ();
+
+  for (t = 0; t < num_tasks; t++) {
+    gst_task_join (data[t].task);
+    gst_object_unref (data[t].task);
+    g_rec_mutex_clear (&data[t].lock);
+  }
+  g_free (data);
+
+  g_print ("%-8s: total %" GST_TIME_FORMAT " - average %" GST_TIME_FORMAT
+      " per iteration\n", name, GST_TIME_ARGS (end - start),
+      GST_TIME_ARGS ((end - start) / ((guint64) num_tasks * iterations)));
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  GstTaskPool *pool;
+  gint num_tasks, num_workers = 0;
+
+  gst_init (&argc, &argv);
+
+  if (argc != 3 && argc != 4) {
+    g_print ("usage: %s <num_tasks> <iterations> [<num_workers>]\n", argv[0]);
+    exit (-1);
+  }
+
+  num_tasks = atoi (argv[1]);
+  iterations = atoi (argv[2]);
+  if (argc == 4)
+    num_workers = atoi (argv[3]);
+
+  if (num_tasks <= 0 || num_tasks > MAX_TASKS) {
+    g_print ("number of tasks must be between 0 and %d\n", MAX_TASKS);
+    exit (-2);
+  }
+
+  if (iterations <= 0) {
+    g_print ("number of iterations must be greater than 0\n");
+    exit (-3);
+  }
+
+  if (num_workers < 0) {
+    g_print ("number of workers must be positive\n");
+    exit (-4);
+  }
+
+  run_test (NULL, num_tasks, "default");
+
+  pool = gst_worker_task_pool_new (num_workers);
+  gst_task_pool_prepare (pool, NULL);
+  run_test (pool, num_tasks, "worker");
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+
+  pool = gst_worker_task_pool_new (num_workers);
+  g_object_set (pool, "cpu-affinity", TRUE, NULL);
+  gst_task_pool_prepare (pool, NULL);
+  run_test (pool, num_tasks, "affinity");
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * padpush.c: benchmark for pushing buffers over a pad link
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+/* Pushes buffers from a source pad to a sink pad with an empty chain
+ * function, once with a stable set of sticky events and once with a new
+ * segment event every few buffers. */
+
+#include <gst/gst.h>
+
+#define NUM_BUFFERS 1000000
+
+static GstFlowReturn
+chain_func (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  gst_buffer_unref (buffer);
+  return GST_FLOW_OK;
+}
+
+static gboolean
+event_func (GstPad * pad, GstObject * parent, GstEvent * event)
+{
+  gst_event_unref (event);
+  return TRUE;
+}
+
+static void
+push_segment (GstPad * src, gint64 start)
+{
+  GstSegment segment;
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  segment.start = start;
+  gst_pad_push_event (src, gst_event_new_segment (&segment));
+}
+
+static void
+run_test (guint segment_interval)
+{
+  GstPad *src, *sink;
+  GstBuffer *buf;
+  GstCaps *caps;
+  GstClockTime start, end;
+  guint i;
+
+  src = gst_pad_new ("src", GST_PAD_SRC);
+  sink = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_chain_function (sink, chain_func);
+  gst_pad_set_event_function (sink, event_func);
+  gst_pad_link (src, sink);
+  gst_pad_set_active (sink, TRUE);
+  gst_pad_set_active (src, TRUE);
+
+  gst_pad_push_event (src, gst_event_new_stream_start ("test"));
+  caps = gst_caps_new_empty_simple ("foo/bar");
+  gst_pad_push_event (src, gst_event_new_caps (caps));
+  gst_caps_unref (caps);
+  push_segment (src, 0);
+
+  buf = gst_buffer_new ();
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_BUFFERS; i++) {
+    if (segment_interval && i % segment_interval == 0)
+      push_segment (src, i);
+    gst_pad_push (src, gst_buffer_ref (buf));
+  }
+  end = gst_util_get_timestamp ();
+
+  if (segment_interval)
+    g_print ("%" GST_TIME_FORMAT " - pushed %d buffers, segment every %u\n",
+        GST_TIME_ARGS (end - start), NUM_BUFFERS, segment_interval);
+  else
+    g_print ("%" GST_TIME_FORMAT " - pushed %d buffers\n",
+        GST_TIME_ARGS (end - start), NUM_BUFFERS);
+
+  gst_buffer_unref (buf);
+  gst_pad_set_active (src, FALSE);
+  gst_pad_set_active (sink, FALSE);
+  gst_pad_unlink (src, sink);
+  gst_object_unref (src);
+  gst_object_unref (sink);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  gst_init (&argc, &argv);
+
+  run_test (0);
+  run_test (1000);
+  run_test (10);
+
+  return 0;
+}
@@ -0,0 +1,110 @@
+/* GStreamer
+ * Copyright (C) 2014 The GStreamer developers
+ *
+ * structure.c: benchmark for field access in structures of different sizes
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin St, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#include <gst/gst.h>
+
+#define NUM_OPS 1000000
+
+static const guint sizes[] = { 2, 4, 8, 16, 32, 64, 128 };
+
+static void
+run_test (guint n_fields)
+{
+  GstStructure *s;
+  GstClockTime start, end;
+  GQuark *quarks;
+  gchar **names;
+  guint i, found = 0;
+
+  names = g_new (gchar *, n_fields);
+  quarks = g_new (GQuark, n_fields);
+  for (i = 0; i < n_fields; i++) {
+    names[i] = g_strdup_printf ("field-%u", i);
+    quarks[i] = g_quark_from_string (names[i]);
+  }
+
+  start = gst_util_get_timestamp ();
+  s = gst_structure_new_empty ("test");
+  for (i = 0; i < n_fields; i++)
+    gst_structure_id_set (s, quarks[i], G_TYPE_INT, i, NULL);
+  end = gst_util_get_timestamp ();
+  g_print ("%3u fields: %" GST_TIME_FORMAT " - creating\n", n_fields,
+      GST_TIME_ARGS (end - start));
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_OPS; i++) {
+    if (gst_structure_id_get_value (s, quarks[i % n_fields]))
+      found++;
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%3u fields: %" GST_TIME_FORMAT " - %d id_get_value\n", n_fields,
+      GST_TIME_ARGS (end - start), NUM_OPS);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_OPS; i++) {
+    if (gst_structure_get_value (s, names[i % n_fields]))
+      found++;
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%3u fields: %" GST_TIME_FORMAT " - %d get_value\n", n_fields,
+      GST_TIME_ARGS (end - start), NUM_OPS);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_OPS; i++)
+    gst_structure_id_set (s, quarks[i % n_fields], G_TYPE_INT, i, NULL);
+  end = gst_util_get_timestamp ();
+  g_print ("%3u fields: %" GST_TIME_FORMAT " - %d id_set\n", n_fields,
+      GST_TIME_ARGS (end - start), NUM_OPS);
+
+  start = gst_util_get_timestamp ();
+  for (i = 0; i < NUM_OPS; i++) {
+    if (gst_structure_has_field (s, names[i % n_fields]))
+      found++;
+    /* and one that is missing */
+    if (gst_structure_has_field (s, "missing"))
+      found++;
+  }
+  end = gst_util_get_timestamp ();
+  g_print ("%3u fields: %" GST_TIME_FORMAT " - %d has_field\n", n_fields,
+      GST_TIME_ARGS (end - start), 2 * NUM_OPS);
+
+  if (found != 3 * NUM_OPS)
+    g_print ("found %u fields instead of %u\n", found, 3 * NUM_OPS);
+
+  gst_structure_free (s);
+  for (i = 0; i < n_fields; i++)
+    g_free (names[i]);
+  g_free (names);
+  g_free (quarks);
+}
+
+gint
+main (gint argc, gchar * argv[])
+{
+  guint i;
+
+  gst_init (&argc, &argv);
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    run_test (sizes[i]);
+
+  return 0;
+}
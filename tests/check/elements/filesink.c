@@ -276,6 +276,185 @@ GST_START_TEST (test_flush)
 
 GST_END_TEST;
 
+static GstBuffer *
+create_pattern_buffer (guint offset, guint size, guint n_mem)
+{
+  GstBuffer *buf = gst_buffer_new ();
+  guint i, j;
+
+  for (i = 0; i < n_mem; i++) {
+    GstMemory *mem;
+    GstMapInfo info;
+
+    mem = gst_allocator_alloc (NULL, size, NULL);
+    fail_unless (gst_memory_map (mem, &info, GST_MAP_WRITE));
+    for (j = 0; j < size; j++)
+      info.data[j] = (offset + i * size + j) & 0xff;
+    gst_memory_unmap (mem, &info);
+    gst_buffer_append_memory (buf, mem);
+  }
+  return buf;
+}
+
+GST_START_TEST (test_buffer_list)
+{
+  GstElement *filesink;
+  GstBufferList *list;
+  GstBuffer *buf;
+  gchar *tmp_fn, *data = NULL;
+  GstSegment segment;
+  gsize len;
+  guint i;
+
+  tmp_fn = create_temporary_file ();
+  if (tmp_fn == NULL)
+    return;
+  filesink = setup_filesink ();
+
+  GST_LOG ("using temp file '%s'", tmp_fn);
+  /* collect at least two buffers before writing */
+  g_object_set (filesink, "location", tmp_fn, "buffer-size", 1000, NULL);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_stream_start ("test")));
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+
+  /* a buffer with 3 memory blocks */
+  fail_unless_equals_int (gst_pad_push (mysrcpad,
+          create_pattern_buffer (0, 100, 3)), GST_FLOW_OK);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 300);
+
+  /* a list of 4 buffers with 2 memory blocks */
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 4; i++)
+    gst_buffer_list_add (list, create_pattern_buffer (300 + i * 200, 100, 2));
+  fail_unless_equals_int (gst_pad_push_list (mysrcpad, list), GST_FLOW_OK);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 1100);
+
+  /* and one more that stays queued until EOS. The data is copied, upstream
+   * gets the buffer back right away */
+  buf = create_pattern_buffer (1100, 50, 1);
+  fail_unless_equals_int (gst_pad_push (mysrcpad, gst_buffer_ref (buf)),
+      GST_FLOW_OK);
+  ASSERT_BUFFER_REFCOUNT (buf, "buf", 1);
+  gst_buffer_unref (buf);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 1150);
+
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  fail_unless (g_file_get_contents (tmp_fn, &data, &len, NULL));
+  fail_unless_equals_int (len, 1150);
+  for (i = 0; i < len; i++)
+    fail_unless_equals_int ((guint8) data[i], i & 0xff);
+  g_free (data);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+
+  cleanup_filesink (filesink);
+
+  g_remove (tmp_fn);
+  g_free (tmp_fn);
+}
+
+GST_END_TEST;
+
+/* writes 13000 bytes with O_DIRECT in blocks of 8192 bytes, optionally
+ * overwriting some of it after a seek, and checks the file contents. When
+ * the file system doesn't support O_DIRECT the normal path is checked. */
+static void
+check_o_direct (gboolean seek)
+{
+  GstElement *filesink;
+  GstBuffer *buf;
+  gchar *tmp_fn, *data = NULL;
+  GstSegment segment;
+  guint8 expected[13000];
+  gsize len;
+  guint i;
+
+  tmp_fn = create_temporary_file ();
+  if (tmp_fn == NULL)
+    return;
+  filesink = setup_filesink ();
+
+  GST_LOG ("using temp file '%s'", tmp_fn);
+  g_object_set (filesink, "location", tmp_fn, "o-direct", TRUE,
+      "buffer-size", 8192, NULL);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_PLAYING),
+      GST_STATE_CHANGE_ASYNC);
+
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_stream_start ("test")));
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_segment (&segment)));
+
+  for (i = 0; i < sizeof (expected); i++)
+    expected[i] = i & 0xff;
+
+  /* one full block and a partial one */
+  fail_unless_equals_int (gst_pad_push (mysrcpad,
+          create_pattern_buffer (0, 5000, 2)), GST_FLOW_OK);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 10000);
+
+  /* ends in the middle of the second block */
+  fail_unless_equals_int (gst_pad_push (mysrcpad,
+          create_pattern_buffer (10000, 3000, 1)), GST_FLOW_OK);
+  CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 13000);
+
+  if (seek) {
+    /* writes out the aligned part and the unaligned tail of the second
+     * block, after which the sink continues without O_DIRECT */
+    segment.start = 6000;
+    fail_unless (gst_pad_push_event (mysrcpad,
+            gst_event_new_segment (&segment)));
+    CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 6000);
+
+    buf = gst_buffer_new_allocate (NULL, 500, NULL);
+    gst_buffer_memset (buf, 0, 0xaa, 500);
+    memset (expected + 6000, 0xaa, 500);
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buf), GST_FLOW_OK);
+    CHECK_QUERY_POSITION (filesink, GST_FORMAT_BYTES, 6500);
+  }
+
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  fail_unless (g_file_get_contents (tmp_fn, &data, &len, NULL));
+  fail_unless_equals_int (len, sizeof (expected));
+  for (i = 0; i < len; i++)
+    fail_unless_equals_int ((guint8) data[i], expected[i]);
+  g_free (data);
+
+  fail_unless_equals_int (gst_element_set_state (filesink, GST_STATE_NULL),
+      GST_STATE_CHANGE_SUCCESS);
+
+  cleanup_filesink (filesink);
+
+  g_remove (tmp_fn);
+  g_free (tmp_fn);
+}
+
+GST_START_TEST (test_o_direct)
+{
+  check_o_direct (FALSE);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_o_direct_seek)
+{
+  check_o_direct (TRUE);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_coverage)
 {
   GstElement *filesink;
@@ -386,6 +565,9 @@ filesink_suite (void)
   tcase_add_test (tc_chain, test_uri_interface);
   tcase_add_test (tc_chain, test_seeking);
   tcase_add_test (tc_chain, test_flush);
+  tcase_add_test (tc_chain, test_buffer_list);
+  tcase_add_test (tc_chain, test_o_direct);
+  tcase_add_test (tc_chain, test_o_direct_seek);
 
   return s;
 }
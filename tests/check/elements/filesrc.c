@@ -23,6 +23,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
+#include <glib/gstdio.h>
 #include <gst/check/gstcheck.h>
 
 static gboolean have_eos = FALSE;
@@ -298,6 +299,189 @@ GST_START_TEST (test_pull)
 
 GST_END_TEST;
 
+GST_START_TEST (test_pull_mmap)
+{
+  GstElement *src;
+  GstPad *pad;
+  GstFlowReturn ret;
+  GstBuffer *buffer1, *buffer2;
+  GstMapInfo info1, info2;
+  gchar *data;
+  gsize size;
+
+  fail_unless (g_file_get_contents (TESTFILE, &data, &size, NULL));
+  fail_unless (size > 8192);
+
+  src = setup_filesrc ();
+
+  /* use a small window so that we need to map more than one */
+  g_object_set (G_OBJECT (src), "location", TESTFILE, "use-mmap", TRUE,
+      "mmapsize", (guint64) 4096, NULL);
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_READY) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to ready");
+
+  pad = gst_element_get_static_pad (src, "src");
+  fail_unless (pad != NULL);
+  fail_unless (gst_pad_activate_mode (pad, GST_PAD_MODE_PULL, TRUE));
+
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  buffer1 = NULL;
+  ret = gst_pad_get_range (pad, 0, 100, &buffer1);
+  fail_unless (ret == GST_FLOW_OK);
+  fail_unless (buffer1 != NULL);
+  fail_unless (gst_buffer_get_size (buffer1) == 100);
+  fail_unless (GST_MEMORY_IS_READONLY (gst_buffer_peek_memory (buffer1, 0)));
+  fail_unless (gst_memory_is_type (gst_buffer_peek_memory (buffer1, 0),
+          "FileMmap"));
+
+  /* crosses the end of the first window */
+  buffer2 = NULL;
+  ret = gst_pad_get_range (pad, 4050, 100, &buffer2);
+  fail_unless (ret == GST_FLOW_OK);
+  fail_unless (buffer2 != NULL);
+  fail_unless (gst_buffer_get_size (buffer2) == 100);
+
+  fail_unless (gst_buffer_map (buffer1, &info1, GST_MAP_READ));
+  fail_unless (gst_buffer_map (buffer2, &info2, GST_MAP_READ));
+  fail_unless (memcmp (info1.data, data, 100) == 0);
+  fail_unless (memcmp (info2.data, data + 4050, 100) == 0);
+  gst_buffer_unmap (buffer2, &info2);
+  gst_buffer_unmap (buffer1, &info1);
+  gst_buffer_unref (buffer2);
+
+  /* read at the end should be clipped */
+  buffer2 = NULL;
+  ret = gst_pad_get_range (pad, size - 10, 20, &buffer2);
+  fail_unless (ret == GST_FLOW_OK);
+  fail_unless (buffer2 != NULL);
+  fail_unless (gst_buffer_get_size (buffer2) == 10);
+  fail_unless (gst_buffer_map (buffer2, &info2, GST_MAP_READ));
+  fail_unless (memcmp (info2.data, data + size - 10, 10) == 0);
+  gst_buffer_unmap (buffer2, &info2);
+  gst_buffer_unref (buffer2);
+
+  buffer2 = NULL;
+  ret = gst_pad_get_range (pad, size, 10, &buffer2);
+  fail_unless (ret == GST_FLOW_EOS);
+
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  /* the mapping stays valid after the file was closed */
+  fail_unless (gst_buffer_map (buffer1, &info1, GST_MAP_READ));
+  fail_unless (memcmp (info1.data, data, 100) == 0);
+  gst_buffer_unmap (buffer1, &info1);
+  gst_buffer_unref (buffer1);
+
+  /* cleanup */
+  g_free (data);
+  gst_object_unref (pad);
+  cleanup_filesrc (src);
+}
+
+GST_END_TEST;
+
+/* the block size of gstreadahead.c */
+#define READ_AHEAD_BLOCK_SIZE (64 * 1024)
+
+GST_START_TEST (test_pull_read_ahead)
+{
+  GstElement *src;
+  GstPad *pad;
+  GstFlowReturn ret;
+  GstBuffer *buffer;
+  GstMapInfo info;
+  guint64 offset, hits, misses, hits2, misses2;
+  gchar *data, *filename;
+  gsize size, i;
+  gint fd;
+
+  /* a file of 8 complete blocks and a partial one */
+  size = 8 * READ_AHEAD_BLOCK_SIZE + 1000;
+  data = g_malloc (size);
+  for (i = 0; i < size; i++)
+    data[i] = i * 7 + i / 251;
+  fd = g_file_open_tmp ("gstreamer-filesrc-test-XXXXXX", &filename, NULL);
+  fail_unless (fd >= 0);
+  close (fd);
+  fail_unless (g_file_set_contents (filename, data, size, NULL));
+
+  src = setup_filesrc ();
+
+  g_object_set (G_OBJECT (src), "location", filename, "read-ahead",
+      (guint64) 4 * READ_AHEAD_BLOCK_SIZE, NULL);
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_READY) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to ready");
+
+  pad = gst_element_get_static_pad (src, "src");
+  fail_unless (pad != NULL);
+  fail_unless (gst_pad_activate_mode (pad, GST_PAD_MODE_PULL, TRUE));
+
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  /* read the complete file sequentially. After the first read the next
+   * blocks are read ahead, give the I/O thread some time for them */
+  for (offset = 0; offset < size; offset += 4096) {
+    buffer = NULL;
+    ret = gst_pad_get_range (pad, offset, 4096, &buffer);
+    fail_unless (ret == GST_FLOW_OK);
+    fail_unless (buffer != NULL);
+    fail_unless (gst_buffer_get_size (buffer) == MIN (4096, size - offset));
+    fail_unless (gst_buffer_map (buffer, &info, GST_MAP_READ));
+    fail_unless (memcmp (info.data, data + offset, info.size) == 0);
+    gst_buffer_unmap (buffer, &info);
+    gst_buffer_unref (buffer);
+
+    if (offset == 0)
+      g_usleep (G_USEC_PER_SEC / 10);
+  }
+
+  /* every block is counted once. At least the blocks that were queued by
+   * the first read were read ahead during the sleep */
+  g_object_get (src, "read-ahead-hits", &hits, "read-ahead-misses", &misses,
+      NULL);
+  fail_unless_equals_uint64 (hits + misses, 9);
+  fail_unless (hits >= 3);
+
+  /* random access goes through the cache and doesn't count again */
+  buffer = NULL;
+  ret = gst_pad_get_range (pad, 50, 50, &buffer);
+  fail_unless (ret == GST_FLOW_OK);
+  fail_unless (gst_buffer_map (buffer, &info, GST_MAP_READ));
+  fail_unless (info.size == 50);
+  fail_unless (memcmp (info.data, data + 50, 50) == 0);
+  gst_buffer_unmap (buffer, &info);
+  gst_buffer_unref (buffer);
+
+  g_object_get (src, "read-ahead-hits", &hits2, "read-ahead-misses", &misses2,
+      NULL);
+  fail_unless_equals_uint64 (hits2, hits);
+  fail_unless_equals_uint64 (misses2, misses);
+
+  buffer = NULL;
+  ret = gst_pad_get_range (pad, size, 10, &buffer);
+  fail_unless (ret == GST_FLOW_EOS);
+
+  fail_unless (gst_element_set_state (src,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  /* cleanup */
+  g_remove (filename);
+  g_free (filename);
+  g_free (data);
+  gst_object_unref (pad);
+  cleanup_filesrc (src);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_coverage)
 {
   GstElement *src;
@@ -530,6 +714,8 @@ filesrc_suite (void)
   tcase_add_test (tc_chain, test_seeking);
   tcase_add_test (tc_chain, test_reverse);
   tcase_add_test (tc_chain, test_pull);
+  tcase_add_test (tc_chain, test_pull_mmap);
+  tcase_add_test (tc_chain, test_pull_read_ahead);
   tcase_add_test (tc_chain, test_coverage);
   tcase_add_test (tc_chain, test_uri_interface);
   tcase_add_test (tc_chain, test_uri_query);
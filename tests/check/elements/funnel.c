@@ -135,6 +135,64 @@ GST_START_TEST (test_funnel_simple)
 
 GST_END_TEST;
 
+static gint listcount = 0;
+static GstFlowReturn list_ret = GST_FLOW_OK;
+
+static GstFlowReturn
+chain_list_count (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  listcount++;
+  bufcount += gst_buffer_list_length (list);
+
+  gst_buffer_list_unref (list);
+
+  return list_ret;
+}
+
+static GstBufferList *
+create_list (guint n)
+{
+  GstBufferList *list = gst_buffer_list_new ();
+  guint i;
+
+  for (i = 0; i < n; i++)
+    gst_buffer_list_add (list, gst_buffer_new ());
+  return list;
+}
+
+GST_START_TEST (test_funnel_list)
+{
+  struct TestData td;
+
+  setup_test_objects (&td, chain_ok);
+  gst_pad_set_chain_list_function (td.mysink, chain_list_count);
+
+  bufcount = 0;
+  listcount = 0;
+  list_ret = GST_FLOW_OK;
+
+  /* lists from both pads arrive downstream as a whole */
+  fail_unless (gst_pad_push_list (td.mysrc1, create_list (3)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push_list (td.mysrc2, create_list (2)) == GST_FLOW_OK);
+  fail_unless_equals_int (listcount, 2);
+  fail_unless_equals_int (bufcount, 5);
+
+  /* and buffers in between still as buffers */
+  fail_unless (gst_pad_push (td.mysrc1, gst_buffer_new ()) == GST_FLOW_OK);
+  fail_unless_equals_int (listcount, 2);
+  fail_unless_equals_int (bufcount, 6);
+
+  /* downstream errors go upstream */
+  list_ret = GST_FLOW_ERROR;
+  fail_unless (gst_pad_push_list (td.mysrc2,
+          create_list (2)) == GST_FLOW_ERROR);
+  fail_unless_equals_int (listcount, 3);
+
+  release_test_objects (&td);
+}
+
+GST_END_TEST;
+
 guint num_eos = 0;
 
 static gboolean
@@ -230,6 +288,7 @@ funnel_suite (void)
   tc_chain = tcase_create ("funnel simple");
   tcase_add_test (tc_chain, test_funnel_simple);
   tcase_add_test (tc_chain, test_funnel_eos);
+  tcase_add_test (tc_chain, test_funnel_list);
   suite_add_tcase (s, tc_chain);
 
   return s;
@@ -725,6 +725,148 @@ GST_START_TEST (test_sparse_stream)
 
 GST_END_TEST;
 
+GST_START_TEST (test_many_not_linked_streams)
+{
+  /* This test creates a multiqueue with many streams, most of them returning
+   * not-linked, and checks that all of them are drained up to EOS, also
+   * after the linked streams finished */
+  GstElement *pipe;
+  GstElement *mq;
+  GstPad *inputpads[32];
+  GstPad *sinkpads[32];
+  struct PadData pad_data[32];
+  guint32 max_linked_id;
+  guint32 eos_seen;
+  GMutex mutex;
+  GCond cond;
+  gint i;
+  const gint NPADS = 32;
+  const gint NLINKED = 4;
+  const gint NBUFFERS = 2000;
+  GstSegment segment;
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+
+  g_mutex_init (&mutex);
+  g_cond_init (&cond);
+
+  pipe = gst_bin_new ("testbin");
+
+  mq = gst_element_factory_make ("multiqueue", NULL);
+  fail_unless (mq != NULL);
+  gst_bin_add (GST_BIN (pipe), mq);
+
+  /* No limits */
+  g_object_set (mq,
+      "max-size-bytes", (guint) 0,
+      "max-size-buffers", (guint) 0,
+      "max-size-time", (guint64) 0,
+      "extra-size-bytes", (guint) 0,
+      "extra-size-buffers", (guint) 0, "extra-size-time", (guint64) 0, NULL);
+
+  for (i = 0; i < NPADS; i++) {
+    GstPad *mq_srcpad, *mq_sinkpad;
+    gchar *name;
+
+    name = g_strdup_printf ("dummysrc%d", i);
+    inputpads[i] = gst_pad_new (name, GST_PAD_SRC);
+    g_free (name);
+    gst_pad_set_query_function (inputpads[i], mq_dummypad_query);
+
+    mq_sinkpad = gst_element_get_request_pad (mq, "sink_%u");
+    fail_unless (mq_sinkpad != NULL);
+    fail_unless (gst_pad_link (inputpads[i], mq_sinkpad) == GST_PAD_LINK_OK);
+
+    gst_pad_set_active (inputpads[i], TRUE);
+
+    gst_pad_push_event (inputpads[i], gst_event_new_stream_start ("test"));
+    gst_pad_push_event (inputpads[i], gst_event_new_segment (&segment));
+
+    mq_srcpad = mq_sinkpad_to_srcpad (mq, mq_sinkpad);
+
+    name = g_strdup_printf ("dummysink%d", i);
+    sinkpads[i] = gst_pad_new (name, GST_PAD_SINK);
+    g_free (name);
+    gst_pad_set_chain_function (sinkpads[i], mq_dummypad_chain);
+    gst_pad_set_event_function (sinkpads[i], mq_dummypad_event);
+    gst_pad_set_query_function (sinkpads[i], mq_dummypad_query);
+
+    /* the ordering between linked and not-linked pads is racy to check, see
+     * test_output_order, only check that everything gets through */
+    pad_data[i].pad_num = i;
+    pad_data[i].max_linked_id_ptr = &max_linked_id;
+    pad_data[i].eos_count_ptr = &eos_seen;
+    pad_data[i].is_linked = (i < NLINKED ? TRUE : FALSE);
+    pad_data[i].n_linked = 0;
+    pad_data[i].cond = &cond;
+    pad_data[i].mutex = &mutex;
+    pad_data[i].first_buf = TRUE;
+    gst_pad_set_element_private (sinkpads[i], pad_data + i);
+
+    fail_unless (gst_pad_link (mq_srcpad, sinkpads[i]) == GST_PAD_LINK_OK);
+    gst_pad_set_active (sinkpads[i], TRUE);
+
+    gst_object_unref (mq_sinkpad);
+    gst_object_unref (mq_srcpad);
+  }
+
+  max_linked_id = 0;
+  eos_seen = 0;
+  gst_element_set_state (pipe, GST_STATE_PLAYING);
+
+  /* Push the buffers round-robin over all streams */
+  for (i = 0; i < NBUFFERS; i++) {
+    GstBuffer *buf;
+    GstFlowReturn ret;
+    GstMapInfo info;
+    gint cur_pad = i % NPADS;
+
+    buf = gst_buffer_new_and_alloc (4);
+    fail_unless (gst_buffer_map (buf, &info, GST_MAP_WRITE));
+    GST_WRITE_UINT32_BE (info.data, i + 1);
+    gst_buffer_unmap (buf, &info);
+    GST_BUFFER_TIMESTAMP (buf) = (i / NPADS) * GST_SECOND;
+
+    ret = gst_pad_push (inputpads[cur_pad], buf);
+    g_mutex_lock (&_check_lock);
+    fail_unless (ret == GST_FLOW_OK || ret == GST_FLOW_NOT_LINKED,
+        "Push on pad %d returned %d when FLOW_OK or NOT_LINKED was expected",
+        cur_pad, ret);
+    g_mutex_unlock (&_check_lock);
+  }
+  for (i = 0; i < NPADS; i++) {
+    gst_pad_push_event (inputpads[i], gst_event_new_eos ());
+  }
+
+  /* We wait until EOS has been pushed on all pads, including the not-linked
+   * ones */
+  g_mutex_lock (&mutex);
+  while (eos_seen < NPADS) {
+    g_cond_wait (&cond, &mutex);
+  }
+  g_mutex_unlock (&mutex);
+
+  /* Clean up */
+  for (i = 0; i < NPADS; i++) {
+    GstPad *mq_input = gst_pad_get_peer (inputpads[i]);
+
+    gst_pad_unlink (inputpads[i], mq_input);
+    gst_element_release_request_pad (mq, mq_input);
+    gst_object_unref (mq_input);
+    gst_object_unref (inputpads[i]);
+
+    gst_object_unref (sinkpads[i]);
+  }
+
+  gst_element_set_state (pipe, GST_STATE_NULL);
+  gst_object_unref (pipe);
+
+  g_cond_clear (&cond);
+  g_mutex_clear (&mutex);
+}
+
+GST_END_TEST;
+
 static Suite *
 multiqueue_suite (void)
 {
@@ -744,6 +886,7 @@ multiqueue_suite (void)
   tcase_skip_broken_test (tc_chain, test_output_order);
 
   tcase_add_test (tc_chain, test_sparse_stream);
+  tcase_add_test (tc_chain, test_many_not_linked_streams);
   return s;
 }
 
@@ -894,6 +894,192 @@ GST_START_TEST (test_queries_while_flushing)
 
 GST_END_TEST;
 
+GST_START_TEST (test_lock_free)
+{
+  GstSegment segment;
+  GstBuffer *buffer;
+  guint i, level;
+  GList *l;
+
+  g_object_set (G_OBJECT (queue), "max-size-buffers", 4, "lock-free", TRUE,
+      "silent", TRUE, NULL);
+  mysinkpad = gst_check_setup_sink_pad (queue, &sinktemplate);
+  gst_pad_set_event_function (mysinkpad, event_func);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_stream_start ("test")));
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_segment (&segment)));
+
+  /* more buffers than fit in the queue so that we also wait for space */
+  for (i = 0; i < 100; i++) {
+    buffer = gst_buffer_new_and_alloc (4);
+    GST_BUFFER_TIMESTAMP (buffer) = i * GST_MSECOND;
+    GST_BUFFER_DURATION (buffer) = GST_MSECOND;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+  }
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_eos ()));
+
+  g_mutex_lock (&check_mutex);
+  while (g_list_length (buffers) < 100)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  /* all buffers came out in order */
+  for (l = buffers, i = 0; l; l = l->next, i++)
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (l->data),
+        i * GST_MSECOND);
+
+  /* we refuse more data after EOS */
+  fail_unless_equals_int (gst_pad_push (mysrcpad, gst_buffer_new ()),
+      GST_FLOW_EOS);
+
+  g_object_get (queue, "current-level-buffers", &level, NULL);
+  fail_unless_equals_int (level, 0);
+  g_object_get (queue, "current-level-bytes", &level, NULL);
+  fail_unless_equals_int (level, 0);
+
+  /* flushing resets the queue */
+  fail_unless (gst_pad_push_event (mysrcpad, gst_event_new_flush_start ()));
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_flush_stop (TRUE)));
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_segment (&segment)));
+  fail_unless_equals_int (gst_pad_push (mysrcpad, gst_buffer_new ()),
+      GST_FLOW_OK);
+
+  g_mutex_lock (&check_mutex);
+  while (g_list_length (buffers) < 101)
+    g_cond_wait (&check_cond, &check_mutex);
+  g_mutex_unlock (&check_mutex);
+
+  GST_DEBUG ("stopping");
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+}
+
+GST_END_TEST;
+
+static GMutex blocked_mutex;
+static GCond blocked_cond;
+static gboolean blocked;
+static gint n_lists;
+
+static GstPadProbeReturn
+blocked_probe (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  g_mutex_lock (&blocked_mutex);
+  blocked = TRUE;
+  g_cond_signal (&blocked_cond);
+  g_mutex_unlock (&blocked_mutex);
+
+  return GST_PAD_PROBE_OK;
+}
+
+static GstFlowReturn
+chain_list_func (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  guint i;
+
+  g_mutex_lock (&check_mutex);
+  n_lists++;
+  g_mutex_unlock (&check_mutex);
+
+  for (i = 0; i < gst_buffer_list_length (list); i++)
+    gst_check_chain_func (pad, parent,
+        gst_buffer_ref (gst_buffer_list_get (list, i)));
+  gst_buffer_list_unref (list);
+
+  return GST_FLOW_OK;
+}
+
+GST_START_TEST (test_push_lists)
+{
+  GstSegment segment;
+  GstBuffer *buffer;
+  GstBufferList *list;
+  guint i, level;
+  GList *l;
+
+  g_object_set (G_OBJECT (queue), "push-lists", TRUE, "silent", TRUE, NULL);
+  mysinkpad = gst_check_setup_sink_pad (queue, &sinktemplate);
+  gst_pad_set_chain_list_function (mysinkpad, chain_list_func);
+  gst_pad_set_event_function (mysinkpad, event_func);
+  gst_pad_set_active (mysinkpad, TRUE);
+
+  qsrcpad = gst_element_get_static_pad (queue, "src");
+  probe_id = gst_pad_add_probe (qsrcpad,
+      GST_PAD_PROBE_TYPE_BLOCK | GST_PAD_PROBE_TYPE_BUFFER, blocked_probe,
+      NULL, NULL);
+
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_stream_start ("test")));
+  fail_unless (gst_pad_push_event (mysrcpad,
+          gst_event_new_segment (&segment)));
+
+  /* the first buffer blocks the queue thread */
+  buffer = gst_buffer_new_and_alloc (4);
+  GST_BUFFER_TIMESTAMP (buffer) = 0;
+  fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+
+  g_mutex_lock (&blocked_mutex);
+  while (!blocked)
+    g_cond_wait (&blocked_cond, &blocked_mutex);
+  g_mutex_unlock (&blocked_mutex);
+
+  /* queue buffers and a list, they count as single buffers */
+  for (i = 1; i < 6; i++) {
+    buffer = gst_buffer_new_and_alloc (4);
+    GST_BUFFER_TIMESTAMP (buffer) = i * GST_MSECOND;
+    fail_unless_equals_int (gst_pad_push (mysrcpad, buffer), GST_FLOW_OK);
+  }
+  list = gst_buffer_list_new ();
+  for (; i < 10; i++) {
+    buffer = gst_buffer_new_and_alloc (4);
+    GST_BUFFER_TIMESTAMP (buffer) = i * GST_MSECOND;
+    gst_buffer_list_add (list, buffer);
+  }
+  fail_unless_equals_int (gst_pad_push_list (mysrcpad, list), GST_FLOW_OK);
+
+  g_object_get (queue, "current-level-buffers", &level, NULL);
+  fail_unless_equals_int (level, 9);
+  g_object_get (queue, "current-level-bytes", &level, NULL);
+  fail_unless_equals_int (level, 36);
+
+  unblock_src ();
+
+  /* everything that was queued comes out as one list */
+  g_mutex_lock (&check_mutex);
+  while (g_list_length (buffers) < 10)
+    g_cond_wait (&check_cond, &check_mutex);
+  fail_unless_equals_int (n_lists, 1);
+  g_mutex_unlock (&check_mutex);
+
+  for (l = buffers, i = 0; l; l = l->next, i++)
+    fail_unless_equals_uint64 (GST_BUFFER_TIMESTAMP (l->data),
+        i * GST_MSECOND);
+
+  g_object_get (queue, "current-level-buffers", &level, NULL);
+  fail_unless_equals_int (level, 0);
+
+  GST_DEBUG ("stopping");
+  fail_unless (gst_element_set_state (queue,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+}
+
+GST_END_TEST;
+
 static Suite *
 queue_suite (void)
 {
@@ -913,6 +1099,8 @@ queue_suite (void)
   tcase_add_test (tc_chain, test_newsegment);
 #endif
   tcase_add_test (tc_chain, test_sticky_not_linked);
+  tcase_add_test (tc_chain, test_lock_free);
+  tcase_add_test (tc_chain, test_push_lists);
 
   return s;
 }
@@ -18,6 +18,10 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#ifdef HAVE_CONFIG_H
+# include <config.h>
+#endif
+
 #include <gst/check/gstcheck.h>
 
 static GstElement *
@@ -269,6 +273,66 @@ GST_START_TEST (test_filled_read)
 
 GST_END_TEST;
 
+GST_START_TEST (test_temp_file_read)
+{
+  GstElement *queue2;
+  GstBuffer *buffer;
+  GstPad *sinkpad, *srcpad;
+  GstSegment segment;
+  gchar *template;
+  guint8 data[16 * 1024];
+  guint i;
+
+  queue2 = gst_element_factory_make ("queue2", NULL);
+  sinkpad = gst_element_get_static_pad (queue2, "sink");
+  srcpad = gst_element_get_static_pad (queue2, "src");
+
+  template = g_build_filename (g_get_tmp_dir (), "queue2-test-XXXXXX", NULL);
+  g_object_set (queue2, "temp-template", template, "use-buffering", FALSE,
+      NULL);
+  g_free (template);
+
+  gst_pad_activate_mode (srcpad, GST_PAD_MODE_PULL, TRUE);
+  gst_element_set_state (queue2, GST_STATE_PLAYING);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_send_event (sinkpad, gst_event_new_stream_start ("test"));
+  gst_pad_send_event (sinkpad, gst_event_new_segment (&segment));
+
+  for (i = 0; i < sizeof (data); i++)
+    data[i] = i % 251;
+
+  buffer = gst_buffer_new_allocate (NULL, sizeof (data), NULL);
+  gst_buffer_fill (buffer, 0, data, sizeof (data));
+  fail_unless (gst_pad_chain (sinkpad, buffer) == GST_FLOW_OK);
+
+  buffer = NULL;
+  fail_unless (gst_pad_get_range (srcpad, 1000, 8 * 1024,
+          &buffer) == GST_FLOW_OK);
+  fail_unless_equals_int (gst_buffer_get_size (buffer), 8 * 1024);
+  fail_unless_equals_int (GST_BUFFER_OFFSET (buffer), 1000);
+  fail_unless (gst_buffer_memcmp (buffer, 0, data + 1000, 8 * 1024) == 0);
+
+#ifdef HAVE_MMAP
+  /* the data points into the mapped temp file instead of being copied */
+  fail_unless_equals_int (gst_buffer_n_memory (buffer), 1);
+  fail_unless (gst_memory_is_type (gst_buffer_peek_memory (buffer, 0),
+          "FileMmap"));
+#endif
+
+  /* the data stays valid after the temp file is closed and removed */
+  gst_element_set_state (queue2, GST_STATE_NULL);
+
+  fail_unless (gst_buffer_memcmp (buffer, 0, data + 1000, 8 * 1024) == 0);
+  gst_buffer_unref (buffer);
+
+  gst_object_unref (sinkpad);
+  gst_object_unref (srcpad);
+  gst_object_unref (queue2);
+}
+
+GST_END_TEST;
+
 
 static Suite *
 queue2_suite (void)
@@ -283,6 +347,7 @@ queue2_suite (void)
   tcase_add_test (tc_chain, test_simple_shutdown_while_running);
   tcase_add_test (tc_chain, test_simple_shutdown_while_running_ringbuffer);
   tcase_add_test (tc_chain, test_filled_read);
+  tcase_add_test (tc_chain, test_temp_file_read);
   return s;
 }
 
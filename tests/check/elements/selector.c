@@ -33,7 +33,7 @@ static GstStaticPadTemplate srctemplate = GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS_ANY);
 
-/* Data probe cb to drop everything but count buffers and events */
+/* Data probe cb to drop everything but count buffers, lists and events */
 static GstPadProbeReturn
 probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
 {
@@ -45,6 +45,8 @@ probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
 
   if (GST_IS_BUFFER (obj)) {
     count_type = "buffer_count";
+  } else if (GST_IS_BUFFER_LIST (obj)) {
+    count_type = "list_count";
   } else if (GST_IS_EVENT (obj)) {
     count_type = "event_count";
   } else {
@@ -56,8 +58,8 @@ probe_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
   count++;
   g_object_set_data (G_OBJECT (pad), count_type, GINT_TO_POINTER (count));
 
-  /* drop every buffer */
-  return GST_IS_BUFFER (obj) ? GST_PAD_PROBE_DROP : GST_PAD_PROBE_PASS;
+  /* drop every buffer and list */
+  return GST_IS_EVENT (obj) ? GST_PAD_PROBE_PASS : GST_PAD_PROBE_DROP;
 }
 
 /* Create and link output pad: selector:src%d ! output_pad */
@@ -396,6 +398,150 @@ GST_START_TEST (test_input_selector_buffer_count);
 
 GST_END_TEST;
 
+static GstBufferList *
+create_list (guint n)
+{
+  GstBufferList *list = gst_buffer_list_new ();
+  guint i;
+
+  for (i = 0; i < n; i++)
+    gst_buffer_list_add (list, gst_buffer_new ());
+  return list;
+}
+
+static gint list_count;
+
+/* collects the buffers of lists like the check sink pad does for buffers */
+static GstFlowReturn
+chain_list_collect (GstPad * pad, GstObject * parent, GstBufferList * list)
+{
+  guint i;
+
+  list_count++;
+  for (i = 0; i < gst_buffer_list_length (list); i++)
+    buffers =
+        g_list_append (buffers, gst_buffer_ref (gst_buffer_list_get (list, i)));
+  gst_buffer_list_unref (list);
+
+  return GST_FLOW_OK;
+}
+
+static void
+run_input_selector_list (gboolean sync_streams)
+{
+  GList *input_pads = NULL;
+  GstElement *sel = gst_check_setup_element ("input-selector");
+  GstPad *output_pad = gst_check_setup_sink_pad (sel, &sinktemplate);
+  GstPad *input_pad1, *input_pad2, *selpad;
+
+  g_object_set (sel, "sync-streams", sync_streams, NULL);
+  gst_pad_set_chain_list_function (output_pad, chain_list_collect);
+  gst_pad_set_active (output_pad, TRUE);
+  input_pad1 = setup_input_pad (sel);
+  input_pad2 = setup_input_pad (sel);
+  input_pads = g_list_append (input_pads, input_pad1);
+  input_pads = g_list_append (input_pads, input_pad2);
+
+  fail_unless (gst_element_set_state (sel,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+  push_newsegment_events (input_pads);
+
+  selpad = gst_pad_get_peer (input_pad1);
+  selector_set_active_pad (sel, selpad);
+  gst_object_unref (selpad);
+
+  /* the active pad forwards the buffers, as one list without stream
+   * synchronisation */
+  list_count = 0;
+  fail_unless (gst_pad_push_list (input_pad1, create_list (3)) == GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 3);
+  fail_unless_equals_int (list_count, sync_streams ? 0 : 1);
+  gst_check_drop_buffers ();
+
+  /* the other pad drops them */
+  fail_unless (gst_pad_push_list (input_pad2, create_list (3)) == GST_FLOW_OK);
+  fail_unless (buffers == NULL);
+
+  /* and marks the first buffer after a switch as DISCONT */
+  selpad = gst_pad_get_peer (input_pad2);
+  selector_set_active_pad (sel, selpad);
+  gst_object_unref (selpad);
+  fail_unless (gst_pad_push_list (input_pad2, create_list (2)) == GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 2);
+  fail_unless (GST_BUFFER_IS_DISCONT (buffers->data));
+  fail_if (GST_BUFFER_IS_DISCONT (buffers->next->data));
+  gst_check_drop_buffers ();
+
+  fail_unless (gst_element_set_state (sel,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  gst_pad_set_active (output_pad, FALSE);
+  gst_check_teardown_sink_pad (sel);
+  selector_set_active_pad (sel, NULL);
+  g_list_foreach (input_pads, (GFunc) cleanup_pad, sel);
+  g_list_free (input_pads);
+  gst_check_teardown_element (sel);
+}
+
+GST_START_TEST (test_input_selector_list)
+{
+  run_input_selector_list (FALSE);
+  run_input_selector_list (TRUE);
+}
+
+GST_END_TEST;
+
+/* lists go to the active pad as a whole */
+GST_START_TEST (test_output_selector_list)
+{
+  GList *input_pads = NULL, *output_pads = NULL;
+  GstElement *sel = gst_check_setup_element ("output-selector");
+  GstPad *input_pad = gst_check_setup_src_pad (sel, &srctemplate);
+  GstPad *output_pad1, *output_pad2, *selpad;
+
+  input_pads = g_list_append (input_pads, input_pad);
+  gst_pad_set_active (input_pad, TRUE);
+  output_pad1 = setup_output_pad (sel, NULL);
+  output_pad2 = setup_output_pad (sel, NULL);
+  output_pads = g_list_append (output_pads, output_pad1);
+  output_pads = g_list_append (output_pads, output_pad2);
+
+  fail_unless (gst_element_set_state (sel,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS,
+      "could not set to playing");
+  push_newsegment_events (input_pads);
+
+  selpad = gst_pad_get_peer (output_pad1);
+  selector_set_active_pad (sel, selpad);
+  gst_object_unref (selpad);
+  fail_unless (gst_pad_push_list (input_pad, create_list (3)) == GST_FLOW_OK);
+
+  selpad = gst_pad_get_peer (output_pad2);
+  selector_set_active_pad (sel, selpad);
+  gst_object_unref (selpad);
+  fail_unless (gst_pad_push_list (input_pad, create_list (2)) == GST_FLOW_OK);
+  fail_unless (gst_pad_push_list (input_pad, create_list (2)) == GST_FLOW_OK);
+
+  fail_unless_equals_int (GPOINTER_TO_INT (g_object_get_data (G_OBJECT
+              (output_pad1), "list_count")), 1);
+  fail_unless_equals_int (GPOINTER_TO_INT (g_object_get_data (G_OBJECT
+              (output_pad2), "list_count")), 2);
+  count_output_buffers (output_pads, 0);
+
+  fail_unless (gst_element_set_state (sel,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS, "could not set to null");
+
+  gst_pad_set_active (input_pad, FALSE);
+  gst_check_teardown_src_pad (sel);
+  g_list_foreach (output_pads, (GFunc) cleanup_pad, sel);
+  g_list_free (output_pads);
+  g_list_free (input_pads);
+  gst_check_teardown_element (sel);
+}
+
+GST_END_TEST;
+
 
 GST_START_TEST (test_output_selector_no_srcpad_negotiation);
 {
@@ -605,6 +751,8 @@ selector_suite (void)
   suite_add_tcase (s, tc_chain);
   tcase_add_test (tc_chain, test_output_selector_buffer_count);
   tcase_add_test (tc_chain, test_input_selector_buffer_count);
+  tcase_add_test (tc_chain, test_input_selector_list);
+  tcase_add_test (tc_chain, test_output_selector_list);
   tcase_add_test (tc_chain, test_output_selector_no_srcpad_negotiation);
 
   tc_chain = tcase_create ("output-selector-negotiation");
@@ -597,6 +597,148 @@ GST_START_TEST (test_flow_aggregation)
 
 GST_END_TEST;
 
+static GMutex parallel_lock;
+static GCond parallel_cond;
+static guint parallel_entered;
+
+/* only returns OK when the buffer arrives on the other pad at the same time */
+static GstFlowReturn
+_parallel_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  gint64 end_time;
+  gboolean ok = TRUE;
+
+  end_time = g_get_monotonic_time () + 5 * G_TIME_SPAN_SECOND;
+
+  g_mutex_lock (&parallel_lock);
+  parallel_entered++;
+  g_cond_broadcast (&parallel_cond);
+  while (ok && parallel_entered % 2 != 0)
+    ok = g_cond_wait_until (&parallel_cond, &parallel_lock, end_time);
+  g_mutex_unlock (&parallel_lock);
+
+  gst_buffer_unref (buffer);
+
+  return ok ? GST_FLOW_OK : GST_FLOW_ERROR;
+}
+
+static gboolean parallel_in_order;
+
+/* counts the buffers in the guint of the pad and checks their order */
+static GstFlowReturn
+_counting_chain (GstPad * pad, GstObject * parent, GstBuffer * buffer)
+{
+  guint *count = gst_pad_get_element_private (pad);
+
+  if (GST_BUFFER_OFFSET (buffer) != *count)
+    parallel_in_order = FALSE;
+  *count = *count + 1;
+  gst_buffer_unref (buffer);
+
+  return GST_FLOW_OK;
+}
+
+GST_START_TEST (test_parallel)
+{
+  GstPad *mysrc, *mysink1, *mysink2;
+  GstPad *teesink, *teesrc1, *teesrc2;
+  GstElement *tee;
+  GstBuffer *buffer;
+  GstSegment segment;
+  GstCaps *caps;
+  guint counts[2] = { 0, 0 };
+  guint i;
+
+  caps = gst_caps_new_empty_simple ("test/test");
+
+  tee = gst_element_factory_make ("tee", NULL);
+  fail_unless (tee != NULL);
+  g_object_set (tee, "parallel", TRUE, NULL);
+  teesink = gst_element_get_static_pad (tee, "sink");
+  fail_unless (teesink != NULL);
+  teesrc1 = gst_element_get_request_pad (tee, "src_%u");
+  fail_unless (teesrc1 != NULL);
+  teesrc2 = gst_element_get_request_pad (tee, "src_%u");
+  fail_unless (teesrc2 != NULL);
+
+  mysink1 = gst_pad_new ("mysink1", GST_PAD_SINK);
+  gst_pad_set_chain_function (mysink1, _parallel_chain);
+  gst_pad_set_element_private (mysink1, &counts[0]);
+  gst_pad_set_active (mysink1, TRUE);
+
+  mysink2 = gst_pad_new ("mysink2", GST_PAD_SINK);
+  gst_pad_set_chain_function (mysink2, _parallel_chain);
+  gst_pad_set_element_private (mysink2, &counts[1]);
+  gst_pad_set_active (mysink2, TRUE);
+
+  mysrc = gst_pad_new ("mysrc", GST_PAD_SRC);
+  gst_pad_set_active (mysrc, TRUE);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (mysrc, gst_event_new_stream_start ("test"));
+  gst_pad_set_caps (mysrc, caps);
+  gst_pad_push_event (mysrc, gst_event_new_segment (&segment));
+
+  fail_unless (gst_pad_link (mysrc, teesink) == GST_PAD_LINK_OK);
+  fail_unless (gst_pad_link (teesrc1, mysink1) == GST_PAD_LINK_OK);
+  fail_unless (gst_pad_link (teesrc2, mysink2) == GST_PAD_LINK_OK);
+
+  fail_unless (gst_element_set_state (tee,
+          GST_STATE_PLAYING) == GST_STATE_CHANGE_SUCCESS);
+
+  /* both pads must get the buffer at the same time */
+  for (i = 0; i < 3; i++) {
+    buffer = gst_buffer_new ();
+    fail_unless (gst_pad_push (mysrc, buffer) == GST_FLOW_OK);
+  }
+  fail_unless_equals_int (parallel_entered, 6);
+
+  /* one pad returning ERROR should result in ERROR */
+  gst_pad_set_chain_function (mysink1, _fake_chain);
+  gst_pad_set_chain_function (mysink2, _fake_chain_error);
+  fail_unless (gst_pad_push (mysrc, gst_buffer_new ()) == GST_FLOW_ERROR);
+
+  /* batches are pushed when complete or before serialized events, in
+   * order on every pad */
+  gst_pad_set_chain_function (mysink1, _counting_chain);
+  gst_pad_set_chain_function (mysink2, _counting_chain);
+  g_object_set (tee, "batch-size", 3, NULL);
+  parallel_in_order = TRUE;
+
+  for (i = 0; i < 4; i++) {
+    buffer = gst_buffer_new ();
+    GST_BUFFER_OFFSET (buffer) = i;
+    gst_pad_push (mysrc, buffer);
+    fail_unless_equals_int (counts[0], i < 2 ? 0 : 3);
+    fail_unless_equals_int (counts[1], i < 2 ? 0 : 3);
+  }
+  fail_unless (gst_pad_push_event (mysrc, gst_event_new_eos ()));
+  fail_unless_equals_int (counts[0], 4);
+  fail_unless_equals_int (counts[1], 4);
+  fail_unless (parallel_in_order);
+
+  fail_unless (gst_element_set_state (tee,
+          GST_STATE_NULL) == GST_STATE_CHANGE_SUCCESS);
+
+  fail_unless (gst_pad_unlink (mysrc, teesink) == TRUE);
+  fail_unless (gst_pad_unlink (teesrc1, mysink1) == TRUE);
+  fail_unless (gst_pad_unlink (teesrc2, mysink2) == TRUE);
+
+  gst_object_unref (teesink);
+  gst_object_unref (teesrc1);
+  gst_object_unref (teesrc2);
+  gst_element_release_request_pad (tee, teesrc1);
+  gst_element_release_request_pad (tee, teesrc2);
+  gst_object_unref (tee);
+
+  gst_object_unref (mysink1);
+  gst_object_unref (mysink2);
+  gst_object_unref (mysrc);
+  gst_caps_unref (caps);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_request_pads)
 {
   GstElement *tee;
@@ -641,6 +783,7 @@ tee_suite (void)
   tcase_add_test (tc_chain, test_release_while_second_buffer_alloc);
   tcase_add_test (tc_chain, test_internal_links);
   tcase_add_test (tc_chain, test_flow_aggregation);
+  tcase_add_test (tc_chain, test_parallel);
   tcase_add_test (tc_chain, test_request_pads);
 
   return s;
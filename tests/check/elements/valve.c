@@ -103,6 +103,72 @@ GST_START_TEST (test_valve_basic)
 
 GST_END_TEST;
 
+static GstBufferList *
+create_list (guint n)
+{
+  GstBufferList *list = gst_buffer_list_new ();
+  GstBuffer *buffer;
+  guint i;
+
+  for (i = 0; i < n; i++) {
+    buffer = gst_buffer_new ();
+    GST_BUFFER_OFFSET (buffer) = i;
+    gst_buffer_list_add (list, buffer);
+  }
+  return list;
+}
+
+GST_START_TEST (test_valve_list)
+{
+  GstElement *valve;
+  GstSegment segment;
+  GstBuffer *buffer;
+  GstPad *sink;
+  GstPad *src;
+
+  valve = gst_check_setup_element ("valve");
+
+  sink = gst_check_setup_sink_pad_by_name (valve, &sinktemplate, "src");
+  src = gst_check_setup_src_pad_by_name (valve, &srctemplate, "sink");
+  gst_pad_set_active (src, TRUE);
+  gst_pad_set_active (sink, TRUE);
+  gst_element_set_state (valve, GST_STATE_PLAYING);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  fail_unless (gst_pad_push_event (src, gst_event_new_stream_start ("test")));
+  fail_unless (gst_pad_push_event (src, gst_event_new_segment (&segment)));
+
+  /* lists go through as a whole */
+  g_object_set (valve, "drop", FALSE, NULL);
+  fail_unless (gst_pad_push_list (src, create_list (3)) == GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 3);
+  gst_check_drop_buffers ();
+
+  /* dropped lists return OK */
+  g_object_set (valve, "drop", TRUE, NULL);
+  fail_unless (gst_pad_push_list (src, create_list (3)) == GST_FLOW_OK);
+  fail_unless (buffers == NULL);
+
+  /* and the next list starts with a DISCONT buffer */
+  g_object_set (valve, "drop", FALSE, NULL);
+  fail_unless (gst_pad_push_list (src, create_list (2)) == GST_FLOW_OK);
+  fail_unless_equals_int (g_list_length (buffers), 2);
+  buffer = buffers->data;
+  fail_unless_equals_int (GST_BUFFER_OFFSET (buffer), 0);
+  fail_unless (GST_BUFFER_IS_DISCONT (buffer));
+  buffer = buffers->next->data;
+  fail_if (GST_BUFFER_IS_DISCONT (buffer));
+  gst_check_drop_buffers ();
+
+  gst_pad_set_active (src, FALSE);
+  gst_pad_set_active (sink, FALSE);
+  gst_check_teardown_src_pad (valve);
+  gst_check_teardown_sink_pad (valve);
+  gst_check_teardown_element (valve);
+}
+
+GST_END_TEST;
+
 static Suite *
 valve_suite (void)
 {
@@ -111,6 +177,7 @@ valve_suite (void)
 
   tc_chain = tcase_create ("valve_basic");
   tcase_add_test (tc_chain, test_valve_basic);
+  tcase_add_test (tc_chain, test_valve_list);
   suite_add_tcase (s, tc_chain);
 
   return s;
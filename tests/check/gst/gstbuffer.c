@@ -857,6 +857,92 @@ GST_START_TEST (test_fill)
 
 GST_END_TEST;
 
+#define N_THREAD_BUFFERS 1000
+
+static gpointer
+alloc_buffers_thread (gpointer data)
+{
+  GstBuffer **bufs = data;
+  gint i;
+
+  for (i = 0; i < N_THREAD_BUFFERS; i++) {
+    bufs[i] = gst_buffer_new_allocate (NULL, 1 + (i * 37) % 5000, NULL);
+    gst_buffer_memset (bufs[i], 0, i & 0xff, gst_buffer_get_size (bufs[i]));
+  }
+  return NULL;
+}
+
+GST_START_TEST (test_free_other_thread)
+{
+  GstBuffer **bufs;
+  GThread *thread;
+  GstMapInfo info;
+  gint i, j;
+
+  bufs = g_new0 (GstBuffer *, N_THREAD_BUFFERS);
+
+  /* allocated in one thread and freed in another */
+  thread = g_thread_new ("alloc", alloc_buffers_thread, bufs);
+  g_thread_join (thread);
+
+  for (i = 0; i < N_THREAD_BUFFERS; i++) {
+    fail_unless_equals_int (gst_buffer_get_size (bufs[i]), 1 + (i * 37) % 5000);
+    fail_unless (gst_buffer_map (bufs[i], &info, GST_MAP_READ));
+    for (j = 0; j < info.size; j++)
+      fail_unless_equals_int (info.data[j], i & 0xff);
+    gst_buffer_unmap (bufs[i], &info);
+    gst_buffer_unref (bufs[i]);
+  }
+
+  /* the freed blocks are reused by the next allocations */
+  alloc_buffers_thread (bufs);
+  for (i = 0; i < N_THREAD_BUFFERS; i++) {
+    fail_unless_equals_int (gst_buffer_get_size (bufs[i]), 1 + (i * 37) % 5000);
+    gst_buffer_unref (bufs[i]);
+  }
+  g_free (bufs);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_cache_stats)
+{
+  GstStructure *stats;
+  GstBuffer **bufs;
+  gboolean enabled;
+  guint64 hits, depot_bytes;
+  gint i;
+
+  /* sequential allocations are served from the thread cache */
+  for (i = 0; i < 100; i++)
+    gst_buffer_unref (gst_buffer_new_allocate (NULL, 100, NULL));
+
+  stats = gst_allocator_get_cache_stats ();
+  fail_unless (gst_structure_get (stats, "enabled", G_TYPE_BOOLEAN, &enabled,
+          "thread-hits", G_TYPE_UINT64, &hits, NULL));
+  gst_structure_free (stats);
+  if (enabled)
+    fail_unless (hits > 0);
+  else
+    fail_unless_equals_uint64 (hits, 0);
+
+  /* freeing a lot of memory at once must not keep all of it cached */
+  bufs = g_new0 (GstBuffer *, 4096);
+  for (i = 0; i < 4096; i++)
+    bufs[i] = gst_buffer_new_allocate (NULL, 4000, NULL);
+  for (i = 0; i < 4096; i++)
+    gst_buffer_unref (bufs[i]);
+  g_free (bufs);
+
+  stats = gst_allocator_get_cache_stats ();
+  fail_unless (gst_structure_get (stats, "depot-bytes", G_TYPE_UINT64,
+          &depot_bytes, NULL));
+  gst_structure_free (stats);
+  fail_unless (depot_bytes <= 4 * 1024 * 1024);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_buffer_suite (void)
 {
@@ -878,6 +964,8 @@ gst_buffer_suite (void)
   tcase_add_test (tc_chain, test_map_range);
   tcase_add_test (tc_chain, test_find);
   tcase_add_test (tc_chain, test_fill);
+  tcase_add_test (tc_chain, test_free_other_thread);
+  tcase_add_test (tc_chain, test_cache_stats);
 
   return s;
 }
@@ -126,6 +126,103 @@ GST_START_TEST (test_inactive_pool_returns_flushing)
 GST_END_TEST;
 
 
+static gpointer
+acquire_thread (gpointer data)
+{
+  GstBufferPool *pool = data;
+  GstBuffer *buf = NULL;
+  GstFlowReturn ret;
+
+  ret = gst_buffer_pool_acquire_buffer (pool, &buf, NULL);
+  if (ret != GST_FLOW_OK)
+    return GINT_TO_POINTER (ret);
+
+  return buf;
+}
+
+static gpointer
+release_thread (gpointer data)
+{
+  gst_buffer_unref (GST_BUFFER_CAST (data));
+
+  return NULL;
+}
+
+GST_START_TEST (test_acquire_waits_for_release)
+{
+  GstBufferPool *pool = create_pool (10, 0, 1);
+  GstBuffer *buf = NULL, *prev;
+  GThread *thread;
+
+  gst_buffer_pool_set_active (pool, TRUE);
+  gst_buffer_pool_acquire_buffer (pool, &buf, NULL);
+  prev = buf;
+
+  /* blocks until we release our buffer */
+  thread = g_thread_new ("acquire", acquire_thread, pool);
+  g_usleep (G_USEC_PER_SEC / 10);
+  gst_buffer_unref (buf);
+
+  buf = g_thread_join (thread);
+  fail_unless (buf == prev, "waiter didn't get the released buffer");
+
+  gst_buffer_unref (buf);
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+
+GST_START_TEST (test_flushing_wakes_up_waiter)
+{
+  GstBufferPool *pool = create_pool (10, 0, 1);
+  GstBuffer *buf = NULL;
+  GThread *thread;
+  gpointer res;
+
+  gst_buffer_pool_set_active (pool, TRUE);
+  gst_buffer_pool_acquire_buffer (pool, &buf, NULL);
+
+  thread = g_thread_new ("acquire", acquire_thread, pool);
+  g_usleep (G_USEC_PER_SEC / 10);
+  gst_buffer_pool_set_active (pool, FALSE);
+
+  res = g_thread_join (thread);
+  ck_assert_int_eq (GPOINTER_TO_INT (res), GST_FLOW_FLUSHING);
+
+  gst_buffer_unref (buf);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+
+GST_START_TEST (test_buffer_released_from_other_thread)
+{
+  GstBufferPool *pool = create_pool (10, 0, 0);
+  GstBuffer *buf, *prev;
+  GThread *thread;
+
+  gst_buffer_pool_set_active (pool, TRUE);
+
+  /* acquired and released in another thread */
+  thread = g_thread_new ("acquire", acquire_thread, pool);
+  prev = g_thread_join (thread);
+  thread = g_thread_new ("release", release_thread, prev);
+  g_thread_join (thread);
+
+  gst_buffer_pool_acquire_buffer (pool, &buf, NULL);
+  fail_unless (buf == prev, "got a fresh buffer instead of previous");
+
+  gst_buffer_unref (buf);
+  gst_buffer_pool_set_active (pool, FALSE);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+
 static Suite *
 gst_buffer_pool_suite (void)
 {
@@ -140,6 +237,9 @@ gst_buffer_pool_suite (void)
   tcase_add_test (tc_chain, test_buffer_out_of_order_reuse);
   tcase_add_test (tc_chain, test_pool_config_buffer_size);
   tcase_add_test (tc_chain, test_inactive_pool_returns_flushing);
+  tcase_add_test (tc_chain, test_acquire_waits_for_release);
+  tcase_add_test (tc_chain, test_flushing_wakes_up_waiter);
+  tcase_add_test (tc_chain, test_buffer_released_from_other_thread);
 
   return s;
 }
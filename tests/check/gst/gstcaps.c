@@ -1133,6 +1133,223 @@ GST_START_TEST (test_features)
 
 GST_END_TEST;
 
+GST_START_TEST (test_cache)
+{
+  GstCaps *c1, *c2, *ci1, *ci2;
+  guint64 hits, misses;
+
+  gst_caps_cache_set_size (16);
+
+  c1 = gst_caps_from_string ("video/x-raw, format=(string){ I420, YV12 }, "
+      "width=[ 1, MAX ]");
+  c2 = gst_caps_from_string ("video/x-raw, format=(string)I420, width=320");
+
+  /* writable caps are not cached */
+  ci1 = gst_caps_intersect (c1, c2);
+  gst_caps_unref (ci1);
+  fail_unless (gst_caps_is_writable (c1));
+  gst_caps_cache_get_stats (&hits, &misses);
+  fail_unless_equals_int (hits, 0);
+  fail_unless_equals_int (misses, 0);
+
+  /* shared caps are */
+  gst_caps_ref (c1);
+  gst_caps_ref (c2);
+
+  ci1 = gst_caps_intersect (c1, c2);
+  ci2 = gst_caps_intersect (c1, c2);
+  gst_caps_cache_get_stats (&hits, &misses);
+  fail_unless_equals_int (hits, 1);
+  fail_unless_equals_int (misses, 1);
+  fail_unless (ci1 == ci2);
+  fail_unless (gst_caps_is_equal (ci1, c2));
+  gst_caps_unref (ci1);
+  gst_caps_unref (ci2);
+
+  /* the other mode is cached separately */
+  ci1 = gst_caps_intersect_full (c1, c2, GST_CAPS_INTERSECT_FIRST);
+  fail_unless (gst_caps_is_equal (ci1, c2));
+  gst_caps_unref (ci1);
+  gst_caps_cache_get_stats (&hits, &misses);
+  fail_unless_equals_int (hits, 1);
+  fail_unless_equals_int (misses, 2);
+
+  fail_unless (gst_caps_is_subset (c2, c1));
+  fail_unless (gst_caps_is_subset (c2, c1));
+  fail_if (gst_caps_is_subset (c1, c2));
+  fail_if (gst_caps_is_subset (c1, c2));
+  fail_unless (gst_caps_can_intersect (c1, c2));
+  fail_unless (gst_caps_can_intersect (c1, c2));
+  gst_caps_cache_get_stats (&hits, &misses);
+  fail_unless_equals_int (hits, 4);
+  fail_unless_equals_int (misses, 5);
+
+  /* the cache keeps the caps from becoming writable */
+  gst_caps_unref (c1);
+  gst_caps_unref (c2);
+  fail_if (gst_caps_is_writable (c1));
+
+  gst_caps_cache_clear ();
+  fail_unless (gst_caps_is_writable (c1));
+  fail_unless (gst_caps_is_writable (c2));
+
+  gst_caps_cache_set_size (0);
+  gst_caps_unref (c1);
+  gst_caps_unref (c2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_intern)
+{
+  GstCaps *c1, *c2, *c3, *c4;
+
+  c1 = gst_caps_from_string ("audio/x-raw, format=(string)S16LE, "
+      "rate=(int)48000, channels=(int)2");
+  /* same caps with the fields in another order */
+  c2 = gst_caps_from_string ("audio/x-raw, channels=(int)2, "
+      "rate=(int)48000, format=(string)S16LE");
+  c3 = gst_caps_from_string ("audio/x-raw, format=(string)S16LE, "
+      "rate=(int)44100, channels=(int)2");
+
+  fail_if (gst_caps_is_interned (c1));
+
+  c1 = gst_caps_intern (c1);
+  fail_unless (gst_caps_is_interned (c1));
+  fail_if (gst_caps_is_writable (c1));
+
+  c2 = gst_caps_intern (c2);
+  fail_unless (c1 == c2);
+  fail_unless (gst_caps_is_equal (c1, c2));
+
+  c3 = gst_caps_intern (c3);
+  fail_unless (c1 != c3);
+  fail_if (gst_caps_is_equal (c1, c3));
+  fail_if (gst_caps_is_equal_fixed (c1, c3));
+  fail_if (gst_caps_is_strictly_equal (c1, c3));
+
+  /* writable copies are not interned */
+  c4 = gst_caps_make_writable (gst_caps_ref (c3));
+  fail_unless (c4 != c3);
+  fail_if (gst_caps_is_interned (c4));
+  fail_unless (gst_caps_is_equal (c4, c3));
+  gst_caps_set_simple (c4, "rate", G_TYPE_INT, 48000, NULL);
+  fail_unless (gst_caps_is_equal (c4, c1));
+  c4 = gst_caps_intern (c4);
+  fail_unless (c4 == c1);
+
+  /* caps that are not fixed are not interned */
+  c4 = gst_caps_from_string ("audio/x-raw, rate=(int)[ 1, 10 ]");
+  fail_unless (gst_caps_intern (c4) == c4);
+  fail_if (gst_caps_is_interned (c4));
+  gst_caps_unref (c4);
+
+  gst_caps_unref (c1);
+  gst_caps_unref (c1);
+  gst_caps_unref (c2);
+  gst_caps_unref (c3);
+}
+
+GST_END_TEST;
+
+/* caps that are equal but serialize differently are interned as one */
+GST_START_TEST (test_intern_equal_values)
+{
+  GstCaps *c1, *c2;
+
+  c1 = gst_caps_new_simple ("foo/bar", "d", G_TYPE_DOUBLE, 0.0, NULL);
+  c2 = gst_caps_new_simple ("foo/bar", "d", G_TYPE_DOUBLE, -0.0, NULL);
+  fail_unless (gst_caps_is_equal (c1, c2));
+  c1 = gst_caps_intern (c1);
+  c2 = gst_caps_intern (c2);
+  fail_unless (c1 == c2);
+  fail_unless (gst_caps_is_equal (c1, c2));
+  gst_caps_unref (c1);
+  gst_caps_unref (c2);
+
+  c1 = gst_caps_from_string ("foo/bar(memory:SystemMemory, meta:Foo), "
+      "a=(int)1");
+  c2 = gst_caps_from_string ("foo/bar(meta:Foo, memory:SystemMemory), "
+      "a=(int)1");
+  fail_unless (gst_caps_is_equal (c1, c2));
+  c1 = gst_caps_intern (c1);
+  c2 = gst_caps_intern (c2);
+  fail_unless (c1 == c2);
+  gst_caps_unref (c1);
+  gst_caps_unref (c2);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_binary)
+{
+  GstCaps *caps, *copy;
+  GBytes *bytes;
+  const guint8 *data;
+  gsize size, consumed = 0;
+
+  caps = gst_caps_from_string ("video/x-raw(memory:EGLImage, meta:Foo), "
+      "format=(string){ I420, NV12 }, width=(int)[ 1, 4096 ], "
+      "framerate=(fraction)[ 0/1, 120/1 ]; video/x-raw(ANY); "
+      "video/x-raw, format=(string)RGB, width=(int)320, height=(int)240");
+  fail_unless (caps != NULL);
+
+  bytes = gst_caps_to_bytes (caps);
+  fail_unless (bytes != NULL);
+  data = g_bytes_get_data (bytes, &size);
+  copy = gst_caps_from_bytes (data, size, &consumed);
+  fail_unless (copy != NULL);
+  fail_unless_equals_int (consumed, size);
+  fail_unless (gst_caps_is_strictly_equal (caps, copy));
+  gst_caps_unref (copy);
+  fail_unless (gst_caps_from_bytes (data, size / 2, NULL) == NULL);
+  g_bytes_unref (bytes);
+  gst_caps_unref (caps);
+
+  /* ANY and EMPTY */
+  caps = gst_caps_new_any ();
+  bytes = gst_caps_to_bytes (caps);
+  data = g_bytes_get_data (bytes, &size);
+  copy = gst_caps_from_bytes (data, size, NULL);
+  fail_unless (gst_caps_is_any (copy));
+  gst_caps_unref (copy);
+  g_bytes_unref (bytes);
+  gst_caps_unref (caps);
+
+  caps = gst_caps_new_empty ();
+  bytes = gst_caps_to_bytes (caps);
+  data = g_bytes_get_data (bytes, &size);
+  copy = gst_caps_from_bytes (data, size, NULL);
+  fail_unless (gst_caps_is_empty (copy));
+  gst_caps_unref (copy);
+  g_bytes_unref (bytes);
+  gst_caps_unref (caps);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_binary_invalid_features)
+{
+  /* video/x-raw without fields and with the existing name "video/x-raw" as
+   * its feature, which is not a valid feature name */
+  static const guint8 data[] = "GSTB\001C\000\001"
+      "\014video/x-raw\000\000" "\002\001\014video/x-raw";
+  static const guint8 valid[] = "GSTB\001C\000\001"
+      "\014video/x-raw\000\000" "\002\001\024memory:SystemMemory";
+  GstCaps *caps;
+
+  caps = gst_caps_from_string ("video/x-raw");
+  gst_caps_unref (caps);
+
+  caps = gst_caps_from_bytes (valid, sizeof (valid), NULL);
+  fail_unless (caps != NULL);
+  gst_caps_unref (caps);
+
+  fail_unless (gst_caps_from_bytes (data, sizeof (data), NULL) == NULL);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_caps_suite (void)
 {
@@ -1161,6 +1378,11 @@ gst_caps_suite (void)
   tcase_add_test (tc_chain, test_normalize);
   tcase_add_test (tc_chain, test_broken);
   tcase_add_test (tc_chain, test_features);
+  tcase_add_test (tc_chain, test_cache);
+  tcase_add_test (tc_chain, test_intern);
+  tcase_add_test (tc_chain, test_intern_equal_values);
+  tcase_add_test (tc_chain, test_binary);
+  tcase_add_test (tc_chain, test_binary_invalid_features);
 
   return s;
 }
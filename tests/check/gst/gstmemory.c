@@ -508,6 +508,60 @@ GST_START_TEST (test_map_resize)
 
 GST_END_TEST;
 
+GST_START_TEST (test_huge_pages)
+{
+  GstAllocator *alloc;
+  GstAllocationParams params;
+  GstMemory *mem;
+  GstMapInfo info;
+  gsize size = 4 * 1024 * 1024;
+
+  alloc = gst_allocator_find (GST_ALLOCATOR_SYSMEM_HUGE);
+  fail_unless (alloc != NULL);
+  fail_unless (g_str_equal (alloc->mem_type, GST_ALLOCATOR_SYSMEM));
+
+  /* small blocks are normal system memory */
+  mem = gst_allocator_alloc (alloc, 100, NULL);
+  fail_unless (mem != NULL);
+  fail_if (GST_MEMORY_FLAG_IS_SET (mem, GST_MEMORY_FLAG_HUGE_PAGES));
+  fail_unless (gst_memory_map (mem, &info, GST_MAP_WRITE));
+  fail_unless (info.size == 100);
+  memset (info.data, 0xaa, info.size);
+  gst_memory_unmap (mem, &info);
+  gst_memory_unref (mem);
+
+  /* large blocks might come from huge pages, either way they must be usable
+   * and zero filled when requested */
+  gst_allocation_params_init (&params);
+  params.flags = GST_MEMORY_FLAG_ZERO_PREFIXED | GST_MEMORY_FLAG_ZERO_PADDED;
+  params.prefix = 64;
+  params.padding = 64;
+  mem = gst_allocator_alloc (alloc, size, &params);
+  fail_unless (mem != NULL);
+  fail_unless (gst_memory_map (mem, &info, GST_MAP_WRITE));
+  fail_unless (info.size == size);
+  fail_unless (info.maxsize >= size + 64);
+  fail_unless (info.data[-1] == 0);
+  fail_unless (info.data[size] == 0);
+  memset (info.data, 0xaa, info.size);
+  gst_memory_unmap (mem, &info);
+  gst_memory_unref (mem);
+
+  /* the flag in the params selects huge pages from the system allocator */
+  gst_allocation_params_init (&params);
+  params.flags = GST_MEMORY_FLAG_HUGE_PAGES;
+  mem = gst_allocator_alloc (NULL, size, &params);
+  fail_unless (mem != NULL);
+  fail_unless (gst_memory_is_type (mem, GST_ALLOCATOR_SYSMEM));
+  fail_unless (gst_memory_map (mem, &info, GST_MAP_WRITE));
+  memset (info.data, 0x55, info.size);
+  gst_memory_unmap (mem, &info);
+  gst_memory_unref (mem);
+
+  gst_object_unref (alloc);
+}
+
+GST_END_TEST;
 
 static Suite *
 gst_memory_suite (void)
@@ -526,6 +580,7 @@ gst_memory_suite (void)
   tcase_add_test (tc_chain, test_map);
   tcase_add_test (tc_chain, test_map_nested);
   tcase_add_test (tc_chain, test_map_resize);
+  tcase_add_test (tc_chain, test_huge_pages);
 
   return s;
 }
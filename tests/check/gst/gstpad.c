@@ -1191,6 +1191,61 @@ GST_START_TEST (test_pad_probe_remove)
 
 GST_END_TEST;
 
+static GstPadProbeReturn
+probe_count_cb (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
+{
+  gint *count = user_data;
+
+  *count += 1;
+
+  return GST_PAD_PROBE_OK;
+}
+
+GST_START_TEST (test_pad_probe_mask)
+{
+  GstPad *src, *sink;
+  GstSegment segment;
+  gint n_buffers = 0, n_events = 0;
+  gulong id;
+
+  src = gst_pad_new ("src", GST_PAD_SRC);
+  sink = gst_pad_new ("sink", GST_PAD_SINK);
+  gst_pad_set_chain_function (sink, gst_check_chain_func);
+  fail_unless (gst_pad_link (src, sink) == GST_PAD_LINK_OK);
+  gst_pad_set_active (sink, TRUE);
+  gst_pad_set_active (src, TRUE);
+
+  gst_pad_add_probe (src, GST_PAD_PROBE_TYPE_BUFFER, probe_count_cb,
+      &n_buffers, NULL);
+  id = gst_pad_add_probe (src, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+      probe_count_cb, &n_events, NULL);
+  fail_unless (src->num_probes == 2);
+
+  gst_segment_init (&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event (src, gst_event_new_stream_start ("test"));
+  gst_pad_push_event (src, gst_event_new_segment (&segment));
+  fail_unless_equals_int (n_events, 2);
+  fail_unless_equals_int (n_buffers, 0);
+
+  fail_unless (gst_pad_push (src, gst_buffer_new ()) == GST_FLOW_OK);
+  fail_unless_equals_int (n_events, 2);
+  fail_unless_equals_int (n_buffers, 1);
+
+  /* the buffer probe is still called after removing the event probe */
+  gst_pad_remove_probe (src, id);
+  fail_unless (src->num_probes == 1);
+  gst_pad_push_event (src, gst_event_new_segment (&segment));
+  fail_unless (gst_pad_push (src, gst_buffer_new ()) == GST_FLOW_OK);
+  fail_unless_equals_int (n_events, 2);
+  fail_unless_equals_int (n_buffers, 2);
+
+  gst_check_drop_buffers ();
+  gst_object_unref (src);
+  gst_object_unref (sink);
+}
+
+GST_END_TEST;
+
 static GstPadProbeReturn
 probe_block_a (GstPad * pad, GstPadProbeInfo * info, gpointer user_data)
 {
@@ -1845,6 +1900,7 @@ gst_pad_suite (void)
   tcase_add_test (tc_chain, test_pad_blocking_with_probe_type_block);
   tcase_add_test (tc_chain, test_pad_blocking_with_probe_type_blocking);
   tcase_add_test (tc_chain, test_pad_probe_remove);
+  tcase_add_test (tc_chain, test_pad_probe_mask);
   tcase_add_test (tc_chain, test_pad_probe_block_add_remove);
   tcase_add_test (tc_chain, test_pad_probe_flush_events);
   tcase_add_test (tc_chain, test_queue_src_caps_notify_linked);
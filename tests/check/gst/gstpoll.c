@@ -20,6 +20,10 @@
  * Boston, MA 02110-1301, USA.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <unistd.h>
 #include <gst/check/gstcheck.h>
 
@@ -317,11 +321,29 @@ GST_START_TEST (test_poll_controllable)
 
 GST_END_TEST;
 
+#ifdef HAVE_SYS_EPOLL_H
+/* the mode is picked when a set is created */
+static void
+setup_epoll (void)
+{
+  g_setenv ("GST_POLL_MODE", "epoll", TRUE);
+}
+
+static void
+teardown_epoll (void)
+{
+  g_unsetenv ("GST_POLL_MODE");
+}
+#endif
+
 static Suite *
 gst_poll_suite (void)
 {
   Suite *s = suite_create ("GstPoll");
   TCase *tc_chain = tcase_create ("general");
+#ifdef HAVE_SYS_EPOLL_H
+  TCase *tc_epoll = tcase_create ("epoll");
+#endif
 
   /* turn off timeout */
   tcase_set_timeout (tc_chain, 60);
@@ -344,6 +366,20 @@ gst_poll_suite (void)
   tcase_skip_broken_test (tc_chain, test_poll_controllable);
 #endif
 
+#ifdef HAVE_SYS_EPOLL_H
+  /* run the same tests again on the epoll backend */
+  tcase_set_timeout (tc_epoll, 60);
+  tcase_add_checked_fixture (tc_epoll, setup_epoll, teardown_epoll);
+  suite_add_tcase (s, tc_epoll);
+
+  tcase_add_test (tc_epoll, test_poll_basic);
+  tcase_add_test (tc_epoll, test_poll_wait);
+  tcase_add_test (tc_epoll, test_poll_wait_stop);
+  tcase_add_test (tc_epoll, test_poll_wait_restart);
+  tcase_add_test (tc_epoll, test_poll_wait_flush);
+  tcase_add_test (tc_epoll, test_poll_controllable);
+#endif
+
   return s;
 }
 
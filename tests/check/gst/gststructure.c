@@ -607,6 +607,288 @@ GST_START_TEST (test_vararg_getters)
 
 GST_END_TEST;
 
+GST_START_TEST (test_many_fields)
+{
+  GstStructure *s, *copy;
+  gchar *name, *str;
+  gint i, val;
+
+  s = gst_structure_new_empty ("test");
+
+  /* add the fields in a different order than their names sort */
+  for (i = 99; i >= 0; i--) {
+    name = g_strdup_printf ("field%d", (i * 37) % 100);
+    gst_structure_set (s, name, G_TYPE_INT, i, NULL);
+    g_free (name);
+  }
+  fail_unless_equals_int (gst_structure_n_fields (s), 100);
+  fail_if (gst_structure_has_field (s, "field100"));
+
+  /* the order of the fields is kept */
+  for (i = 0; i < 100; i++) {
+    name = g_strdup_printf ("field%d", ((99 - i) * 37) % 100);
+    fail_unless_equals_string (gst_structure_nth_field_name (s, i), name);
+    fail_unless (gst_structure_get_int (s, name, &val));
+    fail_unless_equals_int (val, 99 - i);
+    g_free (name);
+  }
+
+  /* replace a value */
+  gst_structure_set (s, "field37", G_TYPE_INT, 1000, NULL);
+  fail_unless_equals_int (gst_structure_n_fields (s), 100);
+  fail_unless (gst_structure_get_int (s, "field37", &val));
+  fail_unless_equals_int (val, 1000);
+
+  /* remove every other field */
+  for (i = 0; i < 100; i += 2) {
+    name = g_strdup_printf ("field%d", i);
+    gst_structure_remove_field (s, name);
+    g_free (name);
+  }
+  fail_unless_equals_int (gst_structure_n_fields (s), 50);
+  for (i = 0; i < 100; i++) {
+    name = g_strdup_printf ("field%d", i);
+    fail_unless (gst_structure_has_field (s, name) == (i % 2 == 1));
+    g_free (name);
+  }
+
+  copy = gst_structure_copy (s);
+  fail_unless (gst_structure_is_equal (s, copy));
+  fail_unless (gst_structure_get_int (copy, "field37", &val));
+  fail_unless_equals_int (val, 1000);
+  gst_structure_free (copy);
+
+  str = gst_structure_to_string (s);
+  copy = gst_structure_from_string (str, NULL);
+  g_free (str);
+  fail_unless (copy != NULL);
+  fail_unless (gst_structure_is_equal (s, copy));
+  for (i = 0; i < 50; i++)
+    fail_unless_equals_string (gst_structure_nth_field_name (s, i),
+        gst_structure_nth_field_name (copy, i));
+  gst_structure_free (copy);
+
+  gst_structure_remove_all_fields (s);
+  fail_unless_equals_int (gst_structure_n_fields (s), 0);
+  fail_if (gst_structure_has_field (s, "field1"));
+  gst_structure_set (s, "field1", G_TYPE_INT, 1, NULL);
+  fail_unless (gst_structure_has_field (s, "field1"));
+
+  gst_structure_free (s);
+}
+
+GST_END_TEST;
+
+GST_START_TEST (test_binary)
+{
+  GstStructure *s, *copy;
+  GstDateTime *datetime;
+  GstBuffer *buf;
+  GDate *date;
+  GBytes *bytes;
+  const guint8 *data;
+  gsize size, consumed = 0;
+
+  s = gst_structure_from_string ("test, int=(int)-5, uint=(uint)7, "
+      "int64=(gint64)-1234567890123, uint64=(guint64)18446744073709551615, "
+      "bool=(boolean)true, float=(float)1.5, double=(double)-0.25, "
+      "string=(string)\"hello world\", fraction=(fraction)30000/1001, "
+      "range=(int)[ 0, 100, 2 ], range64=(gint64)[ -10, 10 ], "
+      "drange=(double)[ 0.5, 1.5 ], frange=(fraction)[ 1/2, 3/1 ], "
+      "list=(int){ 1, 2, 3 }, array=(string)< a, b >, "
+      "bitmask=(bitmask)0x3, nested=(structure)\"inner\\,\\ a\\=\\(int\\)1\\;\", "
+      "caps=(GstCaps)\"audio/x-raw\\,\\ rate\\=\\(int\\)44100\", "
+      "flags=(GstSeekFlags)GST_SEEK_FLAG_FLUSH;", NULL);
+  fail_unless (s != NULL);
+  fail_unless_equals_int (gst_structure_n_fields (s), 19);
+
+  /* a date, a buffer and a type without a binary representation */
+  date = g_date_new_dmy (1, G_DATE_MARCH, 2014);
+  buf = gst_buffer_new_allocate (NULL, 16, NULL);
+  gst_buffer_memset (buf, 0, 0xaa, 16);
+  datetime = gst_date_time_new (0.0, 2014, 3, 1, 10, 20, 30.0);
+  gst_structure_set (s, "date", G_TYPE_DATE, date, "buffer", GST_TYPE_BUFFER,
+      buf, "datetime", GST_TYPE_DATE_TIME, datetime, NULL);
+  g_date_free (date);
+  gst_buffer_unref (buf);
+  gst_date_time_unref (datetime);
+
+  bytes = gst_structure_to_bytes (s);
+  fail_unless (bytes != NULL);
+  data = g_bytes_get_data (bytes, &size);
+
+  copy = gst_structure_from_bytes (data, size, &consumed);
+  fail_unless (copy != NULL);
+  fail_unless_equals_int (consumed, size);
+  fail_unless (gst_structure_is_equal (s, copy));
+  gst_structure_free (copy);
+
+  /* truncated data must not be parsed */
+  fail_unless (gst_structure_from_bytes (data, size - 1, NULL) == NULL);
+  fail_unless (gst_structure_from_bytes (data, 4, NULL) == NULL);
+  /* and the data for other kinds neither */
+  fail_unless (gst_caps_from_bytes (data, size, NULL) == NULL);
+
+  g_bytes_unref (bytes);
+  gst_structure_free (s);
+}
+
+GST_END_TEST;
+
+/* the encoding of gstbinaryformat.c */
+#define TAG_INT 2
+#define TAG_FRACTION 15
+#define TAG_INT_RANGE 16
+#define TAG_FRACTION_RANGE 19
+#define TAG_SERIALIZED 255
+
+static void
+append_uint (GByteArray * array, guint64 val)
+{
+  do {
+    guint8 b = val & 0x7f;
+
+    val >>= 7;
+    if (val)
+      b |= 0x80;
+    g_byte_array_append (array, &b, 1);
+  } while (val);
+}
+
+static void
+append_int (GByteArray * array, gint64 val)
+{
+  append_uint (array, ((guint64) val << 1) ^ (val >> 63));
+}
+
+static void
+append_string (GByteArray * array, const gchar * str)
+{
+  append_uint (array, strlen (str) + 1);
+  g_byte_array_append (array, (const guint8 *) str, strlen (str) + 1);
+}
+
+/* the start of a structure named "test" with @n_fields fields, the fields
+ * are appended by the caller */
+static GByteArray *
+binary_structure_new (guint n_fields)
+{
+  GByteArray *array = g_byte_array_new ();
+
+  g_byte_array_append (array, (const guint8 *) "GSTB\001S", 6);
+  append_string (array, "test");
+  append_uint (array, n_fields);
+  return array;
+}
+
+static gboolean
+binary_structure_parses (GByteArray * array)
+{
+  GstStructure *s;
+
+  s = gst_structure_from_bytes (array->data, array->len, NULL);
+  g_byte_array_unref (array);
+  if (s == NULL)
+    return FALSE;
+  gst_structure_free (s);
+  return TRUE;
+}
+
+static gboolean
+binary_value_parses (guint8 tag, const gint64 * ints, guint n_ints)
+{
+  GByteArray *array = binary_structure_new (1);
+  guint i;
+
+  append_string (array, "field");
+  g_byte_array_append (array, &tag, 1);
+  for (i = 0; i < n_ints; i++)
+    append_int (array, ints[i]);
+  return binary_structure_parses (array);
+}
+
+static gboolean
+binary_serialized_parses (const gchar * type_name, const gchar * str)
+{
+  GByteArray *array = binary_structure_new (1);
+  guint8 tag = TAG_SERIALIZED;
+
+  append_string (array, "field");
+  g_byte_array_append (array, &tag, 1);
+  append_string (array, type_name);
+  append_string (array, str);
+  return binary_structure_parses (array);
+}
+
+GST_START_TEST (test_binary_malformed)
+{
+  const gint64 int_ok[] = { G_MAXINT };
+  const gint64 int_overflow[] = { (gint64) G_MAXINT + 1 };
+  const gint64 fraction_ok[] = { 1, 2 };
+  const gint64 fraction_zero[] = { 1, 0 };
+  const gint64 fraction_overflow[] = { 1, G_GINT64_CONSTANT (1) << 32 };
+  const gint64 fraction_minint[] = { G_MININT, 1 };
+  const gint64 range_ok[] = { 0, 10, 2 };
+  const gint64 range_step[] = { 0, 11, 2 };
+  const gint64 range_empty[] = { 10, 10, 1 };
+  const gint64 range_zero_step[] = { 0, 10, 0 };
+  const gint64 frange_ok[] = { 1, 2, 3, 1 };
+  const gint64 frange_equal[] = { 1, 2, 2, 4 };
+  const gint64 frange_reversed[] = { 3, 1, 1, 2 };
+  GByteArray *array;
+  gchar name[32];
+  guint i;
+
+  fail_unless (binary_value_parses (TAG_INT, int_ok, 1));
+  fail_if (binary_value_parses (TAG_INT, int_overflow, 1));
+
+  fail_unless (binary_value_parses (TAG_FRACTION, fraction_ok, 2));
+  fail_if (binary_value_parses (TAG_FRACTION, fraction_zero, 2));
+  fail_if (binary_value_parses (TAG_FRACTION, fraction_overflow, 2));
+  fail_if (binary_value_parses (TAG_FRACTION, fraction_minint, 2));
+
+  fail_unless (binary_value_parses (TAG_INT_RANGE, range_ok, 3));
+  fail_if (binary_value_parses (TAG_INT_RANGE, range_step, 3));
+  fail_if (binary_value_parses (TAG_INT_RANGE, range_empty, 3));
+  fail_if (binary_value_parses (TAG_INT_RANGE, range_zero_step, 3));
+
+  fail_unless (binary_value_parses (TAG_FRACTION_RANGE, frange_ok, 4));
+  fail_if (binary_value_parses (TAG_FRACTION_RANGE, frange_equal, 4));
+  fail_if (binary_value_parses (TAG_FRACTION_RANGE, frange_reversed, 4));
+
+  /* types that can't be put in a GValue */
+  fail_unless (binary_serialized_parses ("GstSeekType", "set"));
+  fail_if (binary_serialized_parses ("GstObject", "foo"));
+  fail_if (binary_serialized_parses ("GstURIHandler", "foo"));
+  fail_if (binary_serialized_parses ("void", "foo"));
+
+  /* names that are not valid */
+  array = g_byte_array_new ();
+  g_byte_array_append (array, (const guint8 *) "GSTB\001S", 6);
+  append_string (array, "1-binary-test");
+  append_uint (array, 0);
+  fail_if (binary_structure_parses (array));
+
+  array = binary_structure_new (1);
+  append_string (array, "binary test field");
+  append_uint (array, TAG_INT);
+  append_int (array, 1);
+  fail_if (binary_structure_parses (array));
+
+  /* only a limited number of new names per structure */
+  array = binary_structure_new (1000);
+  for (i = 0; i < 1000; i++) {
+    g_snprintf (name, sizeof (name), "binary-test-field-%u", i);
+    append_string (array, name);
+    append_uint (array, TAG_INT);
+    append_int (array, i);
+  }
+  fail_if (binary_structure_parses (array));
+  fail_unless (g_quark_try_string ("binary-test-field-999") == 0);
+}
+
+GST_END_TEST;
+
 static Suite *
 gst_structure_suite (void)
 {
@@ -628,6 +910,9 @@ gst_structure_suite (void)
   tcase_add_test (tc_chain, test_structure_nested);
   tcase_add_test (tc_chain, test_structure_nested_from_and_to_string);
   tcase_add_test (tc_chain, test_vararg_getters);
+  tcase_add_test (tc_chain, test_many_fields);
+  tcase_add_test (tc_chain, test_binary);
+  tcase_add_test (tc_chain, test_binary_malformed);
   return s;
 }
 
@@ -338,6 +338,66 @@ GST_START_TEST (test_async_order)
 
 GST_END_TEST;
 
+#define N_ASYNC_IDS 64
+
+GST_START_TEST (test_async_order_many)
+{
+  GstClock *clock;
+  GstClockID ids[N_ASYNC_IDS];
+  GList *cb_list = NULL, *walk;
+  GstClockTime base;
+  GstClockReturn result;
+  gint i;
+
+  clock = gst_system_clock_obtain ();
+  fail_unless (clock != NULL, "Could not create instance of GstSystemClock");
+
+  base = gst_clock_get_time (clock) + TIME_UNIT;
+
+  /* ids are added in a scrambled order, every pair of ids has the same time
+   * and should be notified in the order they were added */
+  for (i = 0; i < N_ASYNC_IDS; i++) {
+    gint slot = ((i / 2) * 7) % (N_ASYNC_IDS / 2);
+
+    ids[i] = gst_clock_new_single_shot_id (clock, base + slot * GST_MSECOND);
+  }
+  for (i = 0; i < N_ASYNC_IDS; i++) {
+    result = gst_clock_id_wait_async (ids[i], store_callback, &cb_list, NULL);
+    fail_unless (result == GST_CLOCK_OK, "Waiting did not return OK");
+  }
+
+  g_usleep ((TIME_UNIT + N_ASYNC_IDS * GST_MSECOND) / 1000 + G_USEC_PER_SEC);
+
+  g_mutex_lock (&store_lock);
+  fail_unless_equals_int (g_list_length (cb_list), N_ASYNC_IDS);
+  for (walk = cb_list; walk->next; walk = walk->next) {
+    GstClockTime t1 = GST_CLOCK_ENTRY_TIME ((GstClockEntry *) walk->data);
+    GstClockTime t2 = GST_CLOCK_ENTRY_TIME ((GstClockEntry *) walk->next->data);
+
+    fail_unless (t1 <= t2, "notifications out of order");
+    if (t1 == t2) {
+      gint pos1 = -1, pos2 = -1;
+
+      for (i = 0; i < N_ASYNC_IDS; i++) {
+        if (ids[i] == walk->data)
+          pos1 = i;
+        else if (ids[i] == walk->next->data)
+          pos2 = i;
+      }
+      fail_unless (pos1 < pos2, "ids with equal time out of order");
+    }
+  }
+  g_mutex_unlock (&store_lock);
+
+  for (i = 0; i < N_ASYNC_IDS; i++)
+    gst_clock_id_unref (ids[i]);
+  g_list_free (cb_list);
+
+  gst_object_unref (clock);
+}
+
+GST_END_TEST;
+
 struct test_async_sync_interaction_data
 {
   GMutex lock;
@@ -683,6 +743,7 @@ gst_systemclock_suite (void)
   tcase_add_test (tc_chain, test_periodic_shot);
   tcase_add_test (tc_chain, test_periodic_multi);
   tcase_add_test (tc_chain, test_async_order);
+  tcase_add_test (tc_chain, test_async_order_many);
   tcase_add_test (tc_chain, test_async_sync_interaction);
   tcase_add_test (tc_chain, test_diff);
   tcase_add_test (tc_chain, test_mixed);
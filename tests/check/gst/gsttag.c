@@ -574,6 +574,9 @@ GST_START_TEST (test_serialization)
   GstBuffer *b1, *b2;
   GstSample *s1, *s2;
   GstCaps *c2;
+  GBytes *bytes;
+  const guint8 *data;
+  gsize size, consumed = 0;
   gchar *s;
 
   b1 = gst_buffer_new_allocate (NULL, 1, NULL);
@@ -601,6 +604,19 @@ GST_START_TEST (test_serialization)
   gst_tag_list_unref (tags2);
   g_free (s);
 
+  gst_tag_list_set_scope (tags, GST_TAG_SCOPE_GLOBAL);
+  bytes = gst_tag_list_to_bytes (tags);
+  fail_unless (bytes != NULL);
+  data = g_bytes_get_data (bytes, &size);
+  tags2 = gst_tag_list_new_from_bytes (data, size, &consumed);
+  fail_unless (tags2 != NULL);
+  fail_unless_equals_int (consumed, size);
+  fail_unless (gst_tag_list_is_equal (tags, tags2));
+  fail_unless_equals_int (gst_tag_list_get_scope (tags2),
+      GST_TAG_SCOPE_GLOBAL);
+  gst_tag_list_unref (tags2);
+  g_bytes_unref (bytes);
+
   gst_sample_unref (s1);
   gst_sample_unref (s2);
   gst_tag_list_unref (tags);
@@ -178,6 +178,208 @@ GST_START_TEST (test_no_lock)
 
 GST_END_TEST;
 
+static gint worker_count;
+
+static void
+task_func_count (void *data)
+{
+  g_mutex_lock (&task_lock);
+  worker_count++;
+  g_cond_signal (&task_cond);
+  g_mutex_unlock (&task_lock);
+}
+
+GST_START_TEST (test_worker_pool)
+{
+  GstTaskPool *pool;
+  GstTask *t;
+  gint count;
+
+  pool = gst_worker_task_pool_new (2);
+  fail_unless (GST_IS_WORKER_TASK_POOL (pool));
+  gst_task_pool_prepare (pool, NULL);
+
+  t = gst_task_new (task_func_count, NULL, NULL);
+  fail_if (t == NULL);
+  gst_task_set_cooperative (t, TRUE);
+  gst_task_set_pool (t, pool);
+
+  g_rec_mutex_init (&task_mutex);
+  gst_task_set_lock (t, &task_mutex);
+
+  g_cond_init (&task_cond);
+  g_mutex_init (&task_lock);
+  worker_count = 0;
+
+  fail_unless (gst_task_start (t));
+
+  g_mutex_lock (&task_lock);
+  while (worker_count < 100)
+    g_cond_wait (&task_cond, &task_lock);
+  g_mutex_unlock (&task_lock);
+
+  /* after pausing and taking the stream lock, the function is not called
+   * anymore */
+  fail_unless (gst_task_pause (t));
+  g_rec_mutex_lock (&task_mutex);
+  g_rec_mutex_unlock (&task_mutex);
+  g_mutex_lock (&task_lock);
+  count = worker_count;
+  g_mutex_unlock (&task_lock);
+  g_usleep (G_USEC_PER_SEC / 100);
+  g_mutex_lock (&task_lock);
+  fail_unless_equals_int (worker_count, count);
+  g_mutex_unlock (&task_lock);
+
+  /* the task is scheduled again when it is started */
+  fail_unless (gst_task_start (t));
+  g_mutex_lock (&task_lock);
+  while (worker_count < count + 100)
+    g_cond_wait (&task_cond, &task_lock);
+  g_mutex_unlock (&task_lock);
+
+  /* join a paused task */
+  fail_unless (gst_task_pause (t));
+  fail_unless (gst_task_join (t));
+  fail_unless (gst_task_get_state (t) == GST_TASK_STOPPED);
+
+  gst_object_unref (t);
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+static GThread *entered_thread;
+static gboolean thread_mismatch;
+
+static void
+task_enter_func (GstTask * task, GThread * thread, gpointer user_data)
+{
+  fail_unless (entered_thread == NULL);
+  entered_thread = thread;
+}
+
+static void
+task_leave_func (GstTask * task, GThread * thread, gpointer user_data)
+{
+  if (entered_thread != thread || thread != g_thread_self ())
+    thread_mismatch = TRUE;
+  entered_thread = NULL;
+}
+
+/* a cooperative task enters and leaves around every iteration, on the thread
+ * that runs the iteration */
+GST_START_TEST (test_worker_pool_enter_leave)
+{
+  GstTaskPool *pool;
+  GstTask *t;
+
+  pool = gst_worker_task_pool_new (2);
+  gst_task_pool_prepare (pool, NULL);
+
+  t = gst_task_new (task_func_count, NULL, NULL);
+  gst_task_set_cooperative (t, TRUE);
+  gst_task_set_pool (t, pool);
+  gst_task_set_enter_callback (t, task_enter_func, NULL, NULL);
+  gst_task_set_leave_callback (t, task_leave_func, NULL, NULL);
+
+  g_rec_mutex_init (&task_mutex);
+  gst_task_set_lock (t, &task_mutex);
+
+  g_cond_init (&task_cond);
+  g_mutex_init (&task_lock);
+  worker_count = 0;
+  entered_thread = NULL;
+  thread_mismatch = FALSE;
+
+  fail_unless (gst_task_start (t));
+  g_mutex_lock (&task_lock);
+  while (worker_count < 100)
+    g_cond_wait (&task_cond, &task_lock);
+  g_mutex_unlock (&task_lock);
+
+  fail_unless (gst_task_join (t));
+  fail_unless (entered_thread == NULL);
+  fail_if (thread_mismatch);
+
+  gst_object_unref (t);
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
+static GMutex block_lock;
+static GCond block_cond;
+static gint blocked;
+static gboolean unblock;
+
+static void
+task_func_block (void *data)
+{
+  g_mutex_lock (&block_lock);
+  blocked++;
+  g_cond_broadcast (&block_cond);
+  while (!unblock)
+    g_cond_wait (&block_cond, &block_lock);
+  g_mutex_unlock (&block_lock);
+
+  gst_task_pause (*(GstTask **) data);
+}
+
+/* tasks that are not cooperative don't use the workers, so they can all
+ * block at the same time on a pool with a single worker */
+GST_START_TEST (test_worker_pool_blocking)
+{
+  GstTaskPool *pool;
+  GstTask *t1, *t2;
+  GRecMutex mutex1, mutex2;
+
+  pool = gst_worker_task_pool_new (1);
+  gst_task_pool_prepare (pool, NULL);
+
+  t1 = gst_task_new (task_func_block, &t1, NULL);
+  gst_task_set_pool (t1, pool);
+  g_rec_mutex_init (&mutex1);
+  gst_task_set_lock (t1, &mutex1);
+
+  t2 = gst_task_new (task_func_block, &t2, NULL);
+  gst_task_set_pool (t2, pool);
+  g_rec_mutex_init (&mutex2);
+  gst_task_set_lock (t2, &mutex2);
+
+  g_mutex_init (&block_lock);
+  g_cond_init (&block_cond);
+  blocked = 0;
+  unblock = FALSE;
+
+  fail_unless (gst_task_start (t1));
+  fail_unless (gst_task_start (t2));
+
+  g_mutex_lock (&block_lock);
+  while (blocked < 2)
+    g_cond_wait (&block_cond, &block_lock);
+  unblock = TRUE;
+  g_cond_broadcast (&block_cond);
+  g_mutex_unlock (&block_lock);
+
+  fail_unless (gst_task_join (t1));
+  fail_unless (gst_task_join (t2));
+
+  gst_object_unref (t1);
+  gst_object_unref (t2);
+  g_rec_mutex_clear (&mutex1);
+  g_rec_mutex_clear (&mutex2);
+
+  gst_task_pool_cleanup (pool);
+  gst_object_unref (pool);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_create)
 {
   GstTask *t;
@@ -203,6 +405,9 @@ gst_task_suite (void)
   tcase_add_test (tc_chain, test_lock);
   tcase_add_test (tc_chain, test_lock_start);
   tcase_add_test (tc_chain, test_join);
+  tcase_add_test (tc_chain, test_worker_pool);
+  tcase_add_test (tc_chain, test_worker_pool_enter_leave);
+  tcase_add_test (tc_chain, test_worker_pool_blocking);
 
   return s;
 }
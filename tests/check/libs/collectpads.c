@@ -540,6 +540,210 @@ GST_START_TEST (test_collect_eos)
 
 GST_END_TEST;
 
+static GstClockTimeDiff lateness1, lateness2;
+static GstClockTime live_end;
+
+static GstFlowReturn
+live_collected_cb (GstCollectPads * pads, gpointer user_data)
+{
+  gboolean done;
+
+  /* only look at the first output */
+  g_mutex_lock (&lock);
+  done = collected;
+  g_mutex_unlock (&lock);
+  if (done)
+    return GST_FLOW_OK;
+
+  fail_unless (gst_collect_pads_get_live_window (pads, NULL, &live_end));
+  lateness1 = gst_collect_pads_get_lateness (pads, (GstCollectData *) data1);
+  lateness2 = gst_collect_pads_get_lateness (pads, (GstCollectData *) data2);
+
+  return collected_cb (pads, user_data);
+}
+
+GST_START_TEST (test_collect_live)
+{
+  GstElement *pipeline;
+  GstBuffer *buf1;
+  GThread *thread1;
+
+  pipeline = gst_pipeline_new (NULL);
+
+  gst_collect_pads_set_function (collect, live_collected_cb, NULL);
+  gst_collect_pads_set_live (collect, pipeline, 20 * GST_MSECOND, 0);
+
+  data1 = (TestData *) gst_collect_pads_add_pad (collect,
+      sinkpad1, sizeof (TestData), NULL, TRUE);
+  fail_unless (data1 != NULL);
+
+  data2 = (TestData *) gst_collect_pads_add_pad (collect,
+      sinkpad2, sizeof (TestData), NULL, TRUE);
+  fail_unless (data2 != NULL);
+
+  buf1 = gst_buffer_new ();
+  GST_BUFFER_PTS (buf1) = 0;
+  GST_BUFFER_DURATION (buf1) = GST_SECOND;
+
+  gst_collect_pads_start (collect);
+
+  /* the buffer is handed over without waiting for the other pad */
+  data1->pad = srcpad1;
+  data1->buffer = gst_buffer_ref (buf1);
+  thread1 = g_thread_try_new ("gst-check", push_buffer, data1, NULL);
+  g_thread_join (thread1);
+
+  /* nothing happens until there is a clock */
+  g_usleep (G_USEC_PER_SEC / 10);
+  fail_unless_collected (FALSE);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  /* sinkpad2 never gets data but does not stall the output */
+  fail_unless_collected (TRUE);
+  fail_unless (outbuf1 == buf1);
+  fail_unless (outbuf2 == NULL);
+
+  /* sinkpad1 has data for a second, sinkpad2 has nothing */
+  fail_unless (GST_CLOCK_TIME_IS_VALID (live_end));
+  fail_unless_equals_int64 (lateness1, 0);
+  fail_unless_equals_int64 (lateness2, live_end);
+
+  gst_collect_pads_stop (collect);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  gst_buffer_unref (outbuf1);
+  gst_buffer_unref (buf1);
+}
+
+GST_END_TEST;
+
+/* a serialized event after a buffer waits until the buffer was collected */
+GST_START_TEST (test_collect_live_event_order)
+{
+  GstElement *pipeline;
+  GstBuffer *buf1;
+  GThread *thread1;
+
+  pipeline = gst_pipeline_new (NULL);
+
+  gst_collect_pads_set_function (collect, live_collected_cb, NULL);
+  gst_collect_pads_set_live (collect, pipeline, 20 * GST_MSECOND, 0);
+
+  data1 = (TestData *) gst_collect_pads_add_pad (collect,
+      sinkpad1, sizeof (TestData), NULL, TRUE);
+  fail_unless (data1 != NULL);
+
+  data2 = (TestData *) gst_collect_pads_add_pad (collect,
+      sinkpad2, sizeof (TestData), NULL, TRUE);
+  fail_unless (data2 != NULL);
+
+  buf1 = gst_buffer_new ();
+  GST_BUFFER_PTS (buf1) = 0;
+  GST_BUFFER_DURATION (buf1) = GST_SECOND;
+
+  gst_collect_pads_start (collect);
+
+  data1->pad = srcpad1;
+  data1->buffer = gst_buffer_ref (buf1);
+  thread1 = g_thread_try_new ("gst-check", push_buffer, data1, NULL);
+  g_thread_join (thread1);
+
+  /* without a clock the buffer is not collected and the EOS waits */
+  data1->event = gst_event_new_eos ();
+  thread1 = g_thread_try_new ("gst-check", push_event, data1, NULL);
+  g_usleep (G_USEC_PER_SEC / 10);
+  fail_unless_collected (FALSE);
+  fail_if (GST_COLLECT_PADS_STATE_IS_SET (&data1->data,
+          GST_COLLECT_PADS_STATE_EOS));
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  fail_unless_collected (TRUE);
+  fail_unless (outbuf1 == buf1);
+  g_thread_join (thread1);
+  fail_unless (GST_COLLECT_PADS_STATE_IS_SET (&data1->data,
+          GST_COLLECT_PADS_STATE_EOS));
+
+  gst_collect_pads_stop (collect);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+
+  gst_buffer_unref (outbuf1);
+  gst_buffer_unref (buf1);
+}
+
+GST_END_TEST;
+
+static gboolean in_callback, release_callback;
+
+/* blocks in the first output until the test releases it */
+static GstFlowReturn
+blocking_collected_cb (GstCollectPads * pads, gpointer user_data)
+{
+  g_mutex_lock (&lock);
+  if (!in_callback) {
+    in_callback = TRUE;
+    g_cond_broadcast (&cond);
+    while (!release_callback)
+      g_cond_wait (&cond, &lock);
+  }
+  g_mutex_unlock (&lock);
+
+  return GST_FLOW_OK;
+}
+
+/* clipping in the chain function does not wait for the callback */
+GST_START_TEST (test_collect_live_clip)
+{
+  GstElement *pipeline;
+  GThread *thread1;
+
+  pipeline = gst_pipeline_new (NULL);
+  in_callback = FALSE;
+  release_callback = FALSE;
+
+  gst_collect_pads_set_function (collect, blocking_collected_cb, NULL);
+  gst_collect_pads_set_clip_function (collect,
+      gst_collect_pads_clip_running_time, NULL);
+  gst_collect_pads_set_live (collect, pipeline, 20 * GST_MSECOND, 0);
+
+  data1 = (TestData *) gst_collect_pads_add_pad (collect,
+      sinkpad1, sizeof (TestData), NULL, TRUE);
+  fail_unless (data1 != NULL);
+
+  data2 = (TestData *) gst_collect_pads_add_pad (collect,
+      sinkpad2, sizeof (TestData), NULL, TRUE);
+  fail_unless (data2 != NULL);
+
+  gst_collect_pads_start (collect);
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  g_mutex_lock (&lock);
+  while (!in_callback)
+    g_cond_wait (&cond, &lock);
+  g_mutex_unlock (&lock);
+
+  /* returns while the callback is still blocked */
+  data1->pad = srcpad1;
+  data1->buffer = gst_buffer_new ();
+  GST_BUFFER_PTS (data1->buffer) = 0;
+  thread1 = g_thread_try_new ("gst-check", push_buffer, data1, NULL);
+  g_thread_join (thread1);
+
+  g_mutex_lock (&lock);
+  release_callback = TRUE;
+  g_cond_broadcast (&cond);
+  g_mutex_unlock (&lock);
+
+  gst_collect_pads_stop (collect);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+}
+
+GST_END_TEST;
+
 GST_START_TEST (test_collect_twice)
 {
   GstBuffer *buf1, *buf2;
@@ -1021,6 +1225,9 @@ gst_collect_pads_suite (void)
   tcase_add_test (general, test_collect);
   tcase_add_test (general, test_collect_eos);
   tcase_add_test (general, test_collect_twice);
+  tcase_add_test (general, test_collect_live);
+  tcase_add_test (general, test_collect_live_event_order);
+  tcase_add_test (general, test_collect_live_clip);
 
   buffers = tcase_create ("buffers");
   suite_add_tcase (suite, buffers);
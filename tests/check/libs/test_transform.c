@@ -68,7 +68,10 @@ static GstCaps *(*klass_transform_caps) (GstBaseTransform * trans,
 static gboolean (*klass_transform_size) (GstBaseTransform * trans,
     GstPadDirection direction, GstCaps * caps, gsize size, GstCaps * othercaps,
     gsize * othersize) = NULL;
+static GstFlowReturn (*klass_transform_list) (GstBaseTransform * trans,
+    GstBufferList * list) = NULL;
 static gboolean klass_passthrough_on_same_caps = FALSE;
+static gboolean klass_frame_independent = FALSE;
 
 static GstStaticPadTemplate *sink_template = &gst_test_trans_sink_template;
 static GstStaticPadTemplate *src_template = &gst_test_trans_src_template;
@@ -91,6 +94,7 @@ gst_test_trans_class_init (GstTestTransClass * klass)
       gst_static_pad_template_get (src_template));
 
   trans_class->passthrough_on_same_caps = klass_passthrough_on_same_caps;
+  trans_class->frame_independent = klass_frame_independent;
   if (klass_transform_ip != NULL)
     trans_class->transform_ip = klass_transform_ip;
   if (klass_transform != NULL)
@@ -101,6 +105,8 @@ gst_test_trans_class_init (GstTestTransClass * klass)
     trans_class->transform_size = klass_transform_size;
   if (klass_set_caps != NULL)
     trans_class->set_caps = klass_set_caps;
+  if (klass_transform_list != NULL)
+    trans_class->transform_list = klass_transform_list;
 }
 
 static void
@@ -274,6 +274,293 @@ GST_START_TEST (basetransform_chain_ip1)
 
 GST_END_TEST;
 
+static gint transform_ip_list_count;
+
+static GstFlowReturn
+transform_ip_list (GstBaseTransform * trans, GstBuffer * buf)
+{
+  transform_ip_list_count++;
+
+  return GST_FLOW_OK;
+}
+
+/* in-place on a buffer list, every buffer should be transformed and pushed
+ * downstream */
+GST_START_TEST (basetransform_chain_ip_list)
+{
+  TestTransData *trans;
+  GstBufferList *list;
+  GstBuffer *buffer;
+  GstFlowReturn res;
+  gint i;
+
+  klass_transform_ip = transform_ip_list;
+  trans = gst_test_trans_new ();
+
+  gst_test_trans_push_segment (trans);
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 3; i++)
+    gst_buffer_list_add (list, gst_buffer_new_and_alloc (20));
+
+  transform_ip_list_count = 0;
+  res = gst_pad_push_list (trans->srcpad, list);
+  fail_unless (res == GST_FLOW_OK);
+  fail_unless_equals_int (transform_ip_list_count, 3);
+
+  for (i = 0; i < 3; i++) {
+    buffer = gst_test_trans_pop (trans);
+    fail_unless (buffer != NULL);
+    fail_unless (gst_buffer_get_size (buffer) == 20);
+    gst_buffer_unref (buffer);
+  }
+  fail_unless (gst_test_trans_pop (trans) == NULL);
+
+  gst_test_trans_free (trans);
+}
+
+GST_END_TEST;
+
+static GstFlowReturn
+transform_ip_list_drop_error (GstBaseTransform * trans, GstBuffer * buf)
+{
+  transform_ip_list_count++;
+
+  if (GST_BUFFER_OFFSET (buf) == 1)
+    return GST_BASE_TRANSFORM_FLOW_DROPPED;
+  if (GST_BUFFER_OFFSET (buf) == 3)
+    return GST_FLOW_ERROR;
+
+  return GST_FLOW_OK;
+}
+
+/* in-place on a buffer list where a buffer in the middle is dropped and a
+ * later one fails. The buffers before the error are pushed, the one after a
+ * drop is marked DISCONT and the buffers after the error are not
+ * transformed */
+GST_START_TEST (basetransform_chain_ip_list_drop_error)
+{
+  TestTransData *trans;
+  GstBufferList *list;
+  GstBuffer *buffer;
+  GstFlowReturn res;
+  gint i;
+
+  klass_transform_ip = transform_ip_list_drop_error;
+  trans = gst_test_trans_new ();
+
+  gst_test_trans_push_segment (trans);
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 5; i++) {
+    buffer = gst_buffer_new_and_alloc (20);
+    GST_BUFFER_OFFSET (buffer) = i;
+    gst_buffer_list_add (list, buffer);
+  }
+
+  transform_ip_list_count = 0;
+  res = gst_pad_push_list (trans->srcpad, list);
+  fail_unless (res == GST_FLOW_ERROR);
+  fail_unless_equals_int (transform_ip_list_count, 4);
+
+  buffer = gst_test_trans_pop (trans);
+  fail_unless (buffer != NULL);
+  fail_unless_equals_int (GST_BUFFER_OFFSET (buffer), 0);
+  gst_buffer_unref (buffer);
+
+  buffer = gst_test_trans_pop (trans);
+  fail_unless (buffer != NULL);
+  fail_unless_equals_int (GST_BUFFER_OFFSET (buffer), 2);
+  fail_unless (GST_BUFFER_IS_DISCONT (buffer));
+  gst_buffer_unref (buffer);
+
+  fail_unless (gst_test_trans_pop (trans) == NULL);
+
+  gst_test_trans_free (trans);
+}
+
+GST_END_TEST;
+
+static gint transform_list_calls;
+
+/* drops the buffers with odd offsets and the whole list when its first
+ * buffer has offset 100 */
+static GstFlowReturn
+transform_list_odd (GstBaseTransform * trans, GstBufferList * list)
+{
+  guint i;
+
+  transform_list_calls++;
+
+  if (GST_BUFFER_OFFSET (gst_buffer_list_get (list, 0)) == 100)
+    return GST_BASE_TRANSFORM_FLOW_DROPPED;
+
+  for (i = 0; i < gst_buffer_list_length (list);) {
+    if (GST_BUFFER_OFFSET (gst_buffer_list_get (list, i)) % 2)
+      gst_buffer_list_remove (list, i, 1);
+    else
+      i++;
+  }
+
+  return GST_FLOW_OK;
+}
+
+/* a subclass with transform_list gets the whole list in one call and its
+ * output list is pushed. A dropped list marks the next output DISCONT */
+GST_START_TEST (basetransform_chain_transform_list)
+{
+  TestTransData *trans;
+  GstBufferList *list;
+  GstBuffer *buffer;
+  GstFlowReturn res;
+  gint i;
+
+  klass_transform_ip = transform_ip_list;
+  klass_transform_list = transform_list_odd;
+  trans = gst_test_trans_new ();
+
+  gst_test_trans_push_segment (trans);
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 4; i++) {
+    buffer = gst_buffer_new_and_alloc (20);
+    GST_BUFFER_OFFSET (buffer) = i;
+    gst_buffer_list_add (list, buffer);
+  }
+
+  transform_list_calls = 0;
+  transform_ip_list_count = 0;
+  res = gst_pad_push_list (trans->srcpad, list);
+  fail_unless (res == GST_FLOW_OK);
+  fail_unless_equals_int (transform_list_calls, 1);
+  fail_unless_equals_int (transform_ip_list_count, 0);
+
+  for (i = 0; i < 4; i += 2) {
+    buffer = gst_test_trans_pop (trans);
+    fail_unless (buffer != NULL);
+    fail_unless_equals_int (GST_BUFFER_OFFSET (buffer), i);
+    gst_buffer_unref (buffer);
+  }
+  fail_unless (gst_test_trans_pop (trans) == NULL);
+
+  /* the whole list is dropped */
+  list = gst_buffer_list_new ();
+  buffer = gst_buffer_new_and_alloc (20);
+  GST_BUFFER_OFFSET (buffer) = 100;
+  gst_buffer_list_add (list, buffer);
+  res = gst_pad_push_list (trans->srcpad, list);
+  fail_unless (res == GST_FLOW_OK);
+  fail_unless_equals_int (transform_list_calls, 2);
+  fail_unless (gst_test_trans_pop (trans) == NULL);
+
+  /* and the next output is DISCONT */
+  list = gst_buffer_list_new ();
+  buffer = gst_buffer_new_and_alloc (20);
+  GST_BUFFER_OFFSET (buffer) = 4;
+  gst_buffer_list_add (list, buffer);
+  res = gst_pad_push_list (trans->srcpad, list);
+  fail_unless (res == GST_FLOW_OK);
+
+  buffer = gst_test_trans_pop (trans);
+  fail_unless (buffer != NULL);
+  fail_unless_equals_int (GST_BUFFER_OFFSET (buffer), 4);
+  fail_unless (GST_BUFFER_IS_DISCONT (buffer));
+  gst_buffer_unref (buffer);
+
+  gst_test_trans_free (trans);
+}
+
+GST_END_TEST;
+
+static GstFlowReturn
+transform_ip_parallel (GstBaseTransform * trans, GstBuffer * buf)
+{
+  /* make the first buffers the slowest ones */
+  g_usleep ((16 - GST_BUFFER_OFFSET (buf)) * 1000);
+
+  return GST_FLOW_OK;
+}
+
+/* frame independent in-place transform with several threads, the buffers
+ * should come out in order and before serialized events */
+GST_START_TEST (basetransform_chain_parallel)
+{
+  TestTransData *trans;
+  GstBuffer *buffer;
+  GstFlowReturn res;
+  guint i;
+
+  klass_transform_ip = transform_ip_parallel;
+  klass_frame_independent = TRUE;
+  trans = gst_test_trans_new ();
+
+  /* the number of threads is picked up on activation */
+  gst_element_set_state (trans->trans, GST_STATE_READY);
+  gst_base_transform_set_max_threads (GST_BASE_TRANSFORM (trans->trans), 4);
+  fail_unless_equals_int (gst_base_transform_get_max_threads
+      (GST_BASE_TRANSFORM (trans->trans)), 4);
+  gst_element_set_state (trans->trans, GST_STATE_PAUSED);
+
+  gst_test_trans_push_segment (trans);
+
+  for (i = 0; i < 16; i++) {
+    buffer = gst_buffer_new_and_alloc (20);
+    GST_BUFFER_OFFSET (buffer) = i;
+    res = gst_test_trans_push (trans, buffer);
+    fail_unless (res == GST_FLOW_OK);
+  }
+
+  /* EOS pushes out everything that is still being transformed */
+  fail_unless (gst_pad_push_event (trans->srcpad, gst_event_new_eos ()));
+
+  for (i = 0; i < 16; i++) {
+    buffer = gst_test_trans_pop (trans);
+    fail_unless (buffer != NULL);
+    fail_unless_equals_int (GST_BUFFER_OFFSET (buffer), i);
+    gst_buffer_unref (buffer);
+  }
+  fail_unless (gst_test_trans_pop (trans) == NULL);
+
+  gst_test_trans_free (trans);
+}
+
+GST_END_TEST;
+
+/* a transformed buffer is pushed when it is done, it doesn't wait for the
+ * next buffer or event */
+GST_START_TEST (basetransform_chain_parallel_latency)
+{
+  TestTransData *trans;
+  GstBuffer *buffer;
+  GstFlowReturn res;
+
+  klass_transform_ip = transform_ip_parallel;
+  klass_frame_independent = TRUE;
+  trans = gst_test_trans_new ();
+
+  gst_element_set_state (trans->trans, GST_STATE_READY);
+  gst_base_transform_set_max_threads (GST_BASE_TRANSFORM (trans->trans), 4);
+  gst_element_set_state (trans->trans, GST_STATE_PAUSED);
+
+  gst_test_trans_push_segment (trans);
+
+  buffer = gst_buffer_new_and_alloc (20);
+  GST_BUFFER_OFFSET (buffer) = 15;
+  res = gst_test_trans_push (trans, buffer);
+  fail_unless (res == GST_FLOW_OK);
+
+  /* the transform takes 1ms */
+  g_usleep (G_USEC_PER_SEC / 10);
+  buffer = gst_test_trans_pop (trans);
+  fail_unless (buffer != NULL);
+  fail_unless_equals_int (GST_BUFFER_OFFSET (buffer), 15);
+  gst_buffer_unref (buffer);
+
+  gst_test_trans_free (trans);
+}
+
+GST_END_TEST;
+
 static gboolean set_caps_1_called;
 
 static gboolean
@@ -555,7 +842,58 @@ GST_START_TEST (basetransform_chain_ct1)
 
 GST_END_TEST;
 
-static GstStaticPadTemplate src_template_ct2 = GST_STATIC_PAD_TEMPLATE ("src",
+/* copy transform on a buffer list, every buffer gets its own output buffer
+ * and the output keeps the order of the input */
+GST_START_TEST (basetransform_chain_ct_list)
+{
+  TestTransData *trans;
+  GstBufferList *list;
+  GstBuffer *buffer;
+  GstFlowReturn res;
+  GstCaps *incaps;
+  gint i;
+
+  sink_template = &sink_template_ct1;
+  klass_transform = transform_ct1;
+  klass_set_caps = set_caps_ct1;
+  klass_transform_caps = transform_caps_ct1;
+  klass_transform_size = transform_size_ct1;
+
+  trans = gst_test_trans_new ();
+
+  incaps = gst_caps_new_empty_simple ("baz/x-foo");
+  gst_test_trans_setcaps (trans, incaps);
+  gst_test_trans_push_segment (trans);
+
+  list = gst_buffer_list_new ();
+  for (i = 0; i < 3; i++) {
+    buffer = gst_buffer_new_and_alloc (20);
+    GST_BUFFER_OFFSET (buffer) = i;
+    gst_buffer_list_add (list, buffer);
+  }
+
+  transform_ct1_called = FALSE;
+  res = gst_pad_push_list (trans->srcpad, list);
+  fail_unless (res == GST_FLOW_OK);
+  fail_unless (transform_ct1_called == TRUE);
+
+  for (i = 0; i < 3; i++) {
+    buffer = gst_test_trans_pop (trans);
+    fail_unless (buffer != NULL);
+    fail_unless (gst_buffer_get_size (buffer) == 40);
+    fail_unless_equals_int (GST_BUFFER_OFFSET (buffer), i);
+    gst_buffer_unref (buffer);
+  }
+  fail_unless (gst_test_trans_pop (trans) == NULL);
+
+  gst_caps_unref (incaps);
+
+  gst_test_trans_free (trans);
+}
+
+GST_END_TEST;
+
+static GstStaticPadTemplate src_template_ct2 =GST_STATIC_PAD_TEMPLATE ("src",
     GST_PAD_SRC,
     GST_PAD_ALWAYS,
     GST_STATIC_CAPS ("baz/x-foo; foo/x-bar")
@@ -893,8 +1231,14 @@ gst_basetransform_suite (void)
   /* in place */
   tcase_add_test (tc, basetransform_chain_ip1);
   tcase_add_test (tc, basetransform_chain_ip2);
+  tcase_add_test (tc, basetransform_chain_ip_list);
+  tcase_add_test (tc, basetransform_chain_ip_list_drop_error);
+  tcase_add_test (tc, basetransform_chain_transform_list);
+  tcase_add_test (tc, basetransform_chain_parallel);
+  tcase_add_test (tc, basetransform_chain_parallel_latency);
   /* copy transform */
   tcase_add_test (tc, basetransform_chain_ct1);
+  tcase_add_test (tc, basetransform_chain_ct_list);
   tcase_add_test (tc, basetransform_chain_ct2);
   tcase_add_test (tc, basetransform_chain_ct3);
 